@@ -0,0 +1,109 @@
+#include "credcache.h"
+
+#include <sys/random.h>
+#include <functional>
+
+#include "../log/log.h"
+
+CredCache& CredCache::getInstance() {
+    static CredCache cache;
+    return cache;
+}
+
+void CredCache::Init(int ttlSec, int negativeTtlSec, size_t capacity) {
+    Clear();
+    ttl_ = std::chrono::seconds(ttlSec > 0 ? ttlSec : 0);
+    negativeTtl_ = std::chrono::seconds(negativeTtlSec > 0 ? negativeTtlSec : 0);
+    shardCapacity_ = capacity / SHARDS > 0 ? capacity / SHARDS : 1;
+    enabled_.store(ttlSec > 0, std::memory_order_relaxed);
+    LOG_INFO("CredCache Init | ttl: {}s, negative ttl: {}s, capacity: {}", ttlSec, negativeTtlSec, shardCapacity_ * SHARDS);
+}
+
+CredCache::Shard& CredCache::ShardOf_(const std::string& name) {
+    return shards_[std::hash<std::string>{}(name) % SHARDS];
+}
+
+Sha256::Digest CredCache::Digest_(const uint8_t* salt, const std::string& password) {
+    Sha256 h;
+    h.Update(salt, SALT_SIZE);
+    h.Update(password);
+    return h.Final();
+}
+
+CredCache::Result CredCache::Lookup(const std::string& name, const std::string& password) {
+    if(!Enabled()) return Result::MISS;
+    Entry entry;
+    {
+        Shard& shard = ShardOf_(name);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto it = shard.map.find(name);
+        if(it == shard.map.end() or it->second.expire <= std::chrono::steady_clock::now()) {
+            if(it != shard.map.end()) shard.map.erase(it);
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return Result::MISS;
+        }
+        entry = it->second;
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    if(!entry.exists) return Result::UNKNOWN;
+    // 摘要在锁外计算；逐字节异或比较，耗时与第几个字节不同无关
+    Sha256::Digest d = Digest_(entry.salt, password);
+    uint8_t diff = 0;
+    for(size_t i = 0; i < d.size(); i++) diff |= d[i] ^ entry.digest[i];
+    return diff == 0 ? Result::MATCH : Result::MISMATCH;
+}
+
+void CredCache::Insert_(const std::string& name, Entry&& entry) {
+    Shard& shard = ShardOf_(name);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    if(shard.map.size() >= shardCapacity_ and !shard.map.count(name)) {
+        // 分片已满：先清掉过期条目，仍然满时随意淘汰一个
+        TimePoint now = std::chrono::steady_clock::now();
+        std::erase_if(shard.map, [now](const auto& kv) { return kv.second.expire <= now; });
+        if(shard.map.size() >= shardCapacity_) shard.map.erase(shard.map.begin());
+    }
+    shard.map.insert_or_assign(name, std::move(entry));
+}
+
+void CredCache::Put(const std::string& name, const std::string& password) {
+    if(!Enabled()) return;
+    Entry entry;
+    entry.exists = true;
+    if(getrandom(entry.salt, SALT_SIZE, 0) != static_cast<ssize_t>(SALT_SIZE)) {
+        LOG_WARN("CredCache: getrandom failed, {} not cached", name);
+        return;
+    }
+    entry.digest = Digest_(entry.salt, password);
+    entry.expire = std::chrono::steady_clock::now() + ttl_;
+    Insert_(name, std::move(entry));
+}
+
+void CredCache::PutUnknown(const std::string& name) {
+    if(!Enabled() or negativeTtl_.count() == 0) return;
+    Entry entry;
+    entry.exists = false;
+    entry.expire = std::chrono::steady_clock::now() + negativeTtl_;
+    Insert_(name, std::move(entry));
+}
+
+void CredCache::Invalidate(const std::string& name) {
+    Shard& shard = ShardOf_(name);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    shard.map.erase(name);
+}
+
+void CredCache::Clear() {
+    for(Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        shard.map.clear();
+    }
+}
+
+size_t CredCache::Size() {
+    size_t n = 0;
+    for(Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        n += shard.map.size();
+    }
+    return n;
+}
@@ -0,0 +1,84 @@
+#ifndef CREDCACHE_H
+#define CREDCACHE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "sha256.h"
+
+/*
+    登录凭据缓存：用户名 -> 加盐密码摘要，命中时登录/注册不访问数据库。
+    - 按用户名哈希分为 SHARDS 个分片，各自一把锁，Reactor 与 DB 通道线程并发访问互不争用；
+    - 只保存 SHA-256(随机盐 || 密码)，进程内存中没有明文密码；
+    - 正向条目 ttl 秒后过期；数据库中不存在的用户名记为负向条目（negative_ttl 秒），
+      重复的未知用户登录也不会落到数据库；
+    - 注册成功后直接写入新用户的条目，注册失败时删除条目，下次重新查库。
+    条目过期前数据库中的改动（如后台改密码）不可见，TTL 即最大不一致时间。
+*/
+class CredCache {
+public:
+    static constexpr size_t SHARDS = 16;
+    static constexpr size_t SALT_SIZE = 16;
+
+    enum class Result {
+        MISS,     // 没有有效条目，需要查库
+        MATCH,    // 用户存在且密码相同
+        MISMATCH, // 用户存在但密码不同
+        UNKNOWN   // 用户不存在（负向条目）
+    };
+
+    static CredCache& getInstance();
+
+    // ttlSec 为 0 时关闭缓存；capacity 为条目总数上限
+    void Init(int ttlSec, int negativeTtlSec, size_t capacity);
+    bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    Result Lookup(const std::string& name, const std::string& password);
+    // 查库得知用户存在，password 为库中的密码
+    void Put(const std::string& name, const std::string& password);
+    // 查库得知用户不存在
+    void PutUnknown(const std::string& name);
+    void Invalidate(const std::string& name);
+    void Clear();
+
+    uint64_t Hits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t Misses() const { return misses_.load(std::memory_order_relaxed); }
+    size_t Size();
+
+private:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    struct Entry {
+        bool exists = false;
+        uint8_t salt[SALT_SIZE];
+        Sha256::Digest digest;
+        TimePoint expire;
+    };
+    // 独占缓存行，避免相邻分片的锁互相伪共享
+    struct alignas(64) Shard {
+        std::mutex mtx;
+        std::unordered_map<std::string, Entry> map;
+    };
+
+    CredCache() = default;
+    ~CredCache() = default;
+    CredCache(const CredCache&) = delete;
+    CredCache& operator=(const CredCache&) = delete;
+
+    Shard& ShardOf_(const std::string& name);
+    void Insert_(const std::string& name, Entry&& entry);
+    static Sha256::Digest Digest_(const uint8_t* salt, const std::string& password);
+
+    std::atomic<bool> enabled_{false};
+    std::chrono::seconds ttl_{0}, negativeTtl_{0};
+    size_t shardCapacity_ = 0;
+    std::array<Shard, SHARDS> shards_;
+    std::atomic<uint64_t> hits_{0}, misses_{0};
+};
+
+#endif /* CREDCACHE_H */
@@ -0,0 +1,160 @@
+#include "memuserstore.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../log/log.h"
+
+static constexpr char USER_MAGIC[8] = {'W', 'S', 'U', 'S', 'E', 'R', '0', '1'};
+static constexpr size_t HEADER_SIZE = 128; // 文件头占一个槽位，槽位从 128 字节处开始
+
+struct UserFileHeader {
+    char magic[8];
+    uint32_t slotSize;
+    uint32_t slotCount;
+};
+
+uint64_t MemUserStore::Hash_(std::string_view name) {
+    uint64_t h = 14695981039346656037ULL;
+    for(unsigned char c : name) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool MemUserStore::Open(const std::string& file, size_t capacity) {
+    Close();
+    size_t slotCount = std::max<size_t>(capacity / SHARDS, 8) * SHARDS;
+    void* addr = MAP_FAILED;
+    if(file.empty()) {
+        addr = mmap(nullptr, HEADER_SIZE + slotCount * sizeof(Slot), PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    } else {
+        int fd = open(file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if(fd < 0) {
+            LOG_ERROR("MemUserStore: open {} failed", file);
+            return false;
+        }
+        struct stat st;
+        UserFileHeader header{};
+        bool ok = fstat(fd, &st) == 0;
+        if(ok and st.st_size > 0) {
+            // 已有文件：校验后沿用文件中的槽位数，槽位与分片的对应关系不变
+            ok = static_cast<size_t>(st.st_size) >= HEADER_SIZE and
+                 pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) and
+                 memcmp(header.magic, USER_MAGIC, sizeof(USER_MAGIC)) == 0 and
+                 header.slotSize == sizeof(Slot) and header.slotCount > 0 and header.slotCount % SHARDS == 0 and
+                 static_cast<size_t>(st.st_size) == HEADER_SIZE + header.slotCount * sizeof(Slot);
+            if(!ok) LOG_ERROR("MemUserStore: {} is not a user store file, refuse to overwrite it", file);
+            slotCount = header.slotCount;
+        } else if(ok) {
+            memcpy(header.magic, USER_MAGIC, sizeof(USER_MAGIC));
+            header.slotSize = sizeof(Slot);
+            header.slotCount = static_cast<uint32_t>(slotCount);
+            // 扩展出的部分全部为零（空闲槽位）
+            ok = ftruncate(fd, HEADER_SIZE + slotCount * sizeof(Slot)) == 0 and
+                 pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+        }
+        if(ok) {
+            addr = mmap(nullptr, HEADER_SIZE + slotCount * sizeof(Slot), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+    }
+    if(addr == MAP_FAILED) return false;
+    map_ = addr;
+    mapLen_ = HEADER_SIZE + slotCount * sizeof(Slot);
+    persisted_ = !file.empty();
+    slotCount_ = slotCount;
+    shardCapacity_ = slotCount / SHARDS;
+    slots_ = reinterpret_cast<Slot*>(static_cast<char*>(addr) + HEADER_SIZE);
+    for(size_t s = 0; s < SHARDS; s++) {
+        std::unique_lock<std::shared_mutex> lock(shards_[s].mtx);
+        shards_[s].count = 0;
+        for(size_t i = s * shardCapacity_; i < (s + 1) * shardCapacity_; i++) {
+            if(slots_[i].nameLen > 0) shards_[s].count++;
+        }
+    }
+    LOG_INFO("MemUserStore Open | file: {}, capacity: {}, users: {}", file.empty() ? "none" : file, slotCount_, Size());
+    return true;
+}
+
+void MemUserStore::Close() {
+    if(!map_) return;
+    for(Shard& shard : shards_) shard.mtx.lock();
+    if(persisted_) msync(map_, mapLen_, MS_SYNC);
+    munmap(map_, mapLen_);
+    map_ = nullptr;
+    slots_ = nullptr;
+    slotCount_ = shardCapacity_ = mapLen_ = 0;
+    for(Shard& shard : shards_) {
+        shard.count = 0;
+        shard.mtx.unlock();
+    }
+}
+
+size_t MemUserStore::Size() {
+    size_t n = 0;
+    for(Shard& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mtx);
+        n += shard.count;
+    }
+    return n;
+}
+
+MemUserStore::Slot* MemUserStore::Probe_(std::string_view name, uint64_t hash, bool& found) {
+    Slot* base = slots_ + (hash % SHARDS) * shardCapacity_;
+    size_t i = (hash / SHARDS) % shardCapacity_;
+    for(size_t n = 0; n < shardCapacity_; n++) {
+        Slot& slot = base[i];
+        if(slot.nameLen == 0) {
+            found = false;
+            return &slot;
+        }
+        if(std::string_view(slot.name, std::min<size_t>(slot.nameLen, NAME_CAP)) == name) {
+            found = true;
+            return &slot;
+        }
+        if(++i == shardCapacity_) i = 0;
+    }
+    found = false;
+    return nullptr;
+}
+
+UserStore::Status MemUserStore::Lookup(const std::string& name, std::string& password) {
+    if(!slots_) return Status::FAILED;
+    uint64_t hash = Hash_(name);
+    Shard& shard = shards_[hash % SHARDS];
+    std::shared_lock<std::shared_mutex> lock(shard.mtx);
+    bool found = false;
+    Slot* slot = Probe_(name, hash, found);
+    if(!found) return Status::NOT_FOUND;
+    password.assign(slot->pwd, std::min<size_t>(slot->pwdLen, PWD_CAP));
+    return Status::OK;
+}
+
+UserStore::Status MemUserStore::Insert(const std::string& name, const std::string& password) {
+    if(!slots_ or name.empty() or name.size() > NAME_CAP or password.size() > PWD_CAP) return Status::FAILED;
+    uint64_t hash = Hash_(name);
+    Shard& shard = shards_[hash % SHARDS];
+    std::unique_lock<std::shared_mutex> lock(shard.mtx);
+    bool found = false;
+    Slot* slot = Probe_(name, hash, found);
+    if(found) return Status::EXISTS;
+    // 装载率过高时线性探测的链条变长，预留 1/8 空槽位
+    if(!slot or (shard.count + 1) * 8 > shardCapacity_ * 7) {
+        LOG_ERROR("MemUserStore: shard is full ({} users), raise user_store_capacity", shard.count);
+        return Status::FAILED;
+    }
+    memcpy(slot->pwd, password.data(), password.size());
+    slot->pwdLen = static_cast<uint8_t>(password.size());
+    memcpy(slot->name, name.data(), name.size());
+    slot->nameLen = static_cast<uint8_t>(name.size()); // 最后写入长度，槽位才算被占用
+    shard.count++;
+    return Status::OK;
+}
@@ -0,0 +1,72 @@
+#ifndef MEMUSERSTORE_H
+#define MEMUSERSTORE_H
+
+#include <array>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+#include "userstore.h"
+
+/*
+    内存用户表：开放寻址（线性探测）哈希表直接放在 MAP_SHARED 映射的文件中，文件就是快照。
+    - 按用户名哈希分为 SHARDS 个分片，每个分片独占文件中连续的一段槽位、一把读写锁，
+      查找只取读锁，多个线程并发登录互不阻塞；
+    - 新增用户直接写入映射页，进程退出或崩溃后由内核写回文件，Close 时 msync 落盘；
+      重启后 Open 映射同一文件即可使用，不需要加载过程；
+    - 哈希函数固定为 FNV-1a，与编译器和标准库无关，文件跨版本可用；
+    - 只有新增没有删除，分片装载率达到 7/8 时拒绝新增（FAILED），容量在首次创建文件时确定。
+    file 为空时只使用匿名内存，不持久化。
+*/
+class MemUserStore : public UserStore {
+public:
+    static constexpr size_t SHARDS = 16;
+    static constexpr size_t NAME_CAP = 63; // 用户名、密码的最大长度
+    static constexpr size_t PWD_CAP = 63;
+
+    MemUserStore() = default;
+    ~MemUserStore() override { Close(); }
+    MemUserStore(const MemUserStore&) = delete;
+    MemUserStore& operator=(const MemUserStore&) = delete;
+
+    // capacity 为槽位总数（已有文件沿用文件中的槽位数）；文件存在但不是用户表时返回 false，不覆盖
+    bool Open(const std::string& file, size_t capacity);
+    void Close();
+    size_t Size();
+    size_t Capacity() const { return slotCount_; }
+
+    const char* Name() const override { return "memory"; }
+    bool Remote() const override { return false; }
+    Status Lookup(const std::string& name, std::string& password) override;
+    Status Insert(const std::string& name, const std::string& password) override;
+
+private:
+    // 文件中的一个槽位；nameLen 为 0 表示空闲
+    struct Slot {
+        uint8_t nameLen;
+        uint8_t pwdLen;
+        char name[NAME_CAP];
+        char pwd[PWD_CAP];
+    };
+    static_assert(sizeof(Slot) == 128, "Slot should stay two cache lines");
+
+    struct alignas(64) Shard {
+        std::shared_mutex mtx;
+        size_t count = 0;
+    };
+
+    static uint64_t Hash_(std::string_view name);
+    // 在分片内查找 name 所在的槽位，不存在时返回探测到的第一个空槽位；分片已满且不存在时返回 nullptr
+    Slot* Probe_(std::string_view name, uint64_t hash, bool& found);
+
+    std::array<Shard, SHARDS> shards_;
+    Slot* slots_ = nullptr;
+    size_t slotCount_ = 0;
+    size_t shardCapacity_ = 0;
+    void* map_ = nullptr;
+    size_t mapLen_ = 0;
+    bool persisted_ = false;
+};
+
+#endif /* MEMUSERSTORE_H */
@@ -0,0 +1,82 @@
+#include "mysqluserstore.h"
+
+#include <cstring>
+
+#include "../pool/sqlconnRAII.h"
+#include "../pool/sqlstmt.h"
+#include "../pool/regbatcher.h"
+#include "../log/log.h"
+
+MySqlUserStore& MySqlUserStore::getInstance() {
+    static MySqlUserStore store;
+    return store;
+}
+
+// 在借到的连接上查询 params[0] 用户的密码
+static UserStore::Status SelectPassword(MYSQL* sql, MYSQL_BIND* params, std::string& password) {
+    using Status = UserStore::Status;
+    MYSQL_STMT* stmt = SqlExecute(sql, SqlStmtId::USER_PASSWORD, params);
+    if(!stmt) return Status::FAILED;
+
+    char pwd[64] = {0}; // 数据库中存储的密码，表结构为 char(50)
+    unsigned long pwdLen = 0;
+    MYSQL_BIND result;
+    memset(&result, 0, sizeof(result));
+    result.buffer_type = MYSQL_TYPE_STRING;
+    result.buffer = pwd;
+    result.buffer_length = sizeof(pwd);
+    result.length = &pwdLen;
+    Status status = Status::FAILED;
+    if(!mysql_stmt_bind_result(stmt, &result)) {
+        int rc = mysql_stmt_fetch(stmt);
+        if(rc == 0) {
+            password.assign(pwd, pwdLen);
+            status = Status::OK;
+        } else if(rc == MYSQL_DATA_TRUNCATED) {
+            // 库中的密码比缓冲区长，与只含字母数字下划线的合法密码不可能相同，返回截断后仍不会匹配的值
+            password.assign(pwd, sizeof(pwd));
+            status = Status::OK;
+        } else if(rc == MYSQL_NO_DATA) {
+            status = Status::NOT_FOUND;
+        }
+    }
+    mysql_stmt_free_result(stmt);
+    return status;
+}
+
+UserStore::Status MySqlUserStore::Lookup(const std::string& name, std::string& password) {
+    MYSQL* sql = nullptr;
+    SqlConnRAII raii(&sql, &SqlConnPool::getInstance()); // 从连接池中获取数据库连接，函数返回时归还
+    if(!sql) return Status::UNAVAILABLE; // 等待连接超时
+
+    // 预处理语句：用户名以二进制参数发送，不拼接 SQL
+    MYSQL_BIND param[1];
+    SqlBindString(param[0], name);
+    return SelectPassword(sql, param, password);
+}
+
+UserStore::Status MySqlUserStore::Insert(const std::string& name, const std::string& password) {
+    // 开启批量注册时，注册与其他并发的注册合并为一个事务提交，不借用连接池的连接
+    RegisterBatcher& batcher = RegisterBatcher::getInstance();
+    if(batcher.Enabled()) {
+        switch(batcher.Register(name, password)) {
+        case RegisterBatcher::Result::CREATED: return Status::OK;
+        case RegisterBatcher::Result::EXISTS:  return Status::EXISTS;
+        case RegisterBatcher::Result::BUSY:    return Status::UNAVAILABLE;
+        default:                               return Status::FAILED;
+        }
+    }
+    MYSQL* sql = nullptr;
+    SqlConnRAII raii(&sql, &SqlConnPool::getInstance());
+    if(!sql) return Status::UNAVAILABLE;
+
+    // 查重与插入使用同一个连接
+    MYSQL_BIND param[2];
+    SqlBindString(param[0], name);
+    SqlBindString(param[1], password);
+    std::string existing;
+    Status found = SelectPassword(sql, param, existing);
+    if(found == Status::OK) return Status::EXISTS;
+    if(found != Status::NOT_FOUND) return Status::FAILED;
+    return SqlExecute(sql, SqlStmtId::USER_INSERT, param) ? Status::OK : Status::FAILED;
+}
@@ -0,0 +1,20 @@
+#ifndef MYSQLUSERSTORE_H
+#define MYSQLUSERSTORE_H
+
+#include "userstore.h"
+
+// MySQL 后端：从 SqlConnPool 借连接执行预处理语句；RegisterBatcher 开启时注册交给批处理线程合并提交
+class MySqlUserStore : public UserStore {
+public:
+    static MySqlUserStore& getInstance();
+
+    const char* Name() const override { return "mysql"; }
+    bool Remote() const override { return true; }
+    Status Lookup(const std::string& name, std::string& password) override;
+    Status Insert(const std::string& name, const std::string& password) override;
+
+private:
+    MySqlUserStore() = default;
+};
+
+#endif /* MYSQLUSERSTORE_H */
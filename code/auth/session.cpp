@@ -0,0 +1,270 @@
+#include "session.h"
+
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+#include <sys/stat.h>
+
+#include "../log/log.h"
+
+static constexpr char SESSION_MAGIC[8] = {'W', 'S', 'S', 'E', 'S', 'S', '0', '1'};
+static constexpr size_t HEADER_SIZE = 128; // 文件头占一个槽位，槽位从 128 字节处开始
+
+struct SessionFileHeader {
+    char magic[8];
+    uint32_t slotSize;
+    uint32_t slotCount;
+};
+
+static const char HEX[] = "0123456789abcdef";
+
+static int HexValue(char c) {
+    if(c >= '0' and c <= '9') return c - '0';
+    if(c >= 'a' and c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static bool ValidToken(std::string_view token) {
+    if(token.size() != SessionStore::TOKEN_LEN) return false;
+    for(char c : token) {
+        if(HexValue(c) < 0) return false;
+    }
+    return true;
+}
+
+SessionStore& SessionStore::getInstance() {
+    static SessionStore store;
+    return store;
+}
+
+// 会话 ID 本身是随机数，直接取第一个字节分片；持久化槽位按分片划分，重启后同一 ID 仍落在同一分片
+size_t SessionStore::ShardIndex_(std::string_view token) const {
+    return static_cast<size_t>(HexValue(token[0]) * 16 + HexValue(token[1])) % SHARDS;
+}
+
+SessionStore::Shard& SessionStore::ShardOf_(std::string_view token) {
+    return shards_[ShardIndex_(token)];
+}
+
+bool SessionStore::Init(int ttlSec, size_t capacity, const std::string& file) {
+    Close();
+    ttl_ = ttlSec > 0 ? ttlSec : 0;
+    shardCapacity_ = capacity / SHARDS > 0 ? capacity / SHARDS : 1;
+    if(!Enabled()) return true;
+    if(!file.empty()) {
+        if(!OpenFile_(file)) {
+            LOG_ERROR("SessionStore: open {} failed, sessions are not persisted", file);
+            return false;
+        }
+        Restore_();
+    }
+    LOG_INFO("SessionStore Init | ttl: {}s, capacity: {}, file: {}, restored: {}",
+             ttl_, shardCapacity_ * SHARDS, file.empty() ? "none" : file, Size());
+    return true;
+}
+
+bool SessionStore::OpenFile_(const std::string& file) {
+    int fd = open(file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if(fd < 0) return false;
+    struct stat st;
+    if(fstat(fd, &st) < 0) {
+        close(fd);
+        return false;
+    }
+    // 槽位数取分片数的整数倍；已有文件沿用文件中的槽位数，保证槽位与分片的对应关系不变
+    size_t slotCount = shardCapacity_ * SHARDS;
+    SessionFileHeader header{};
+    bool valid = static_cast<size_t>(st.st_size) >= HEADER_SIZE and
+                 pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) and
+                 memcmp(header.magic, SESSION_MAGIC, sizeof(SESSION_MAGIC)) == 0 and
+                 header.slotSize == sizeof(Slot) and header.slotCount > 0 and header.slotCount % SHARDS == 0 and
+                 static_cast<size_t>(st.st_size) == HEADER_SIZE + header.slotCount * sizeof(Slot);
+    if(valid) {
+        slotCount = header.slotCount;
+    } else {
+        if(st.st_size > 0) LOG_WARN("SessionStore: {} is not a session file, recreate it", file);
+        memcpy(header.magic, SESSION_MAGIC, sizeof(SESSION_MAGIC));
+        header.slotSize = sizeof(Slot);
+        header.slotCount = static_cast<uint32_t>(slotCount);
+        // 先截断为 0 再扩展，槽位全部为零（空闲）
+        if(ftruncate(fd, 0) < 0 or ftruncate(fd, HEADER_SIZE + slotCount * sizeof(Slot)) < 0 or
+           pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+            close(fd);
+            return false;
+        }
+    }
+    size_t len = HEADER_SIZE + slotCount * sizeof(Slot);
+    void* addr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED) return false;
+    mapLen_ = len;
+    slotCount_ = slotCount;
+    slots_ = reinterpret_cast<Slot*>(static_cast<char*>(addr) + HEADER_SIZE);
+    shardCapacity_ = slotCount / SHARDS;
+    return true;
+}
+
+void SessionStore::Restore_() {
+    int64_t now = time(nullptr);
+    for(size_t s = 0; s < SHARDS; s++) {
+        Shard& shard = shards_[s];
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        // 倒序压入，分配时从小号槽位开始
+        for(size_t i = (s + 1) * shardCapacity_; i-- > s * shardCapacity_; ) {
+            Slot& slot = slots_[i];
+            std::string token(TOKEN_LEN, '0');
+            for(size_t b = 0; b < TOKEN_BYTES; b++) {
+                token[b * 2] = HEX[slot.token[b] >> 4];
+                token[b * 2 + 1] = HEX[slot.token[b] & 0xf];
+            }
+            if(slot.expire > now and slot.userLen <= USER_CAP and ShardIndex_(token) == s) {
+                Session session;
+                session.user.assign(slot.user, slot.userLen);
+                session.expire = slot.expire;
+                session.slot = static_cast<uint32_t>(i);
+                shard.map.emplace(std::move(token), std::move(session));
+            } else {
+                slot.expire = 0;
+                shard.freeSlots.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+}
+
+void SessionStore::Close() {
+    for(Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        shard.map.clear();
+        shard.freeSlots.clear();
+    }
+    if(slots_) {
+        void* addr = reinterpret_cast<char*>(slots_) - HEADER_SIZE;
+        msync(addr, mapLen_, MS_ASYNC);
+        munmap(addr, mapLen_);
+        slots_ = nullptr;
+        slotCount_ = mapLen_ = 0;
+    }
+}
+
+void SessionStore::WriteSlot_(uint32_t idx, const std::string& token, const Session& s) {
+    Slot& slot = slots_[idx];
+    for(size_t b = 0; b < TOKEN_BYTES; b++) {
+        slot.token[b] = static_cast<uint8_t>(HexValue(token[b * 2]) * 16 + HexValue(token[b * 2 + 1]));
+    }
+    slot.userLen = static_cast<uint8_t>(s.user.size());
+    memcpy(slot.user, s.user.data(), s.user.size());
+    slot.expire = s.expire; // 最后写过期时间，槽位此时才算占用
+}
+
+void SessionStore::Erase_(Shard& shard, SessionMap::iterator it) {
+    if(it->second.slot != UINT32_MAX) {
+        slots_[it->second.slot].expire = 0;
+        shard.freeSlots.push_back(it->second.slot);
+    }
+    shard.map.erase(it);
+}
+
+std::string SessionStore::Create(const std::string& user) {
+    if(!Enabled()) return "";
+    uint8_t raw[TOKEN_BYTES];
+    if(getrandom(raw, sizeof(raw), 0) != static_cast<ssize_t>(sizeof(raw))) {
+        LOG_ERROR("SessionStore: getrandom failed");
+        return "";
+    }
+    std::string token(TOKEN_LEN, '0');
+    for(size_t b = 0; b < TOKEN_BYTES; b++) {
+        token[b * 2] = HEX[raw[b] >> 4];
+        token[b * 2 + 1] = HEX[raw[b] & 0xf];
+    }
+    int64_t now = time(nullptr);
+    Session session;
+    session.user = user;
+    session.expire = now + ttl_;
+
+    Shard& shard = ShardOf_(token);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    if(shard.map.size() >= shardCapacity_) {
+        // 分片已满：先清掉过期会话，仍然满时淘汰一个
+        for(auto it = shard.map.begin(); it != shard.map.end(); ) {
+            auto next = std::next(it);
+            if(it->second.expire <= now) Erase_(shard, it);
+            it = next;
+        }
+        if(shard.map.size() >= shardCapacity_) Erase_(shard, shard.map.begin());
+    }
+    // 用户名超过槽位容量的会话只保存在内存中
+    if(slots_ and user.size() <= USER_CAP and !shard.freeSlots.empty()) {
+        session.slot = shard.freeSlots.back();
+        shard.freeSlots.pop_back();
+        WriteSlot_(session.slot, token, session);
+    }
+    shard.map.emplace(token, std::move(session));
+    return token;
+}
+
+std::optional<std::string> SessionStore::Lookup(std::string_view token) {
+    if(!Enabled() or !ValidToken(token)) return std::nullopt;
+    Shard& shard = ShardOf_(token);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.map.find(token);
+    if(it == shard.map.end()) return std::nullopt;
+    if(it->second.expire <= time(nullptr)) {
+        Erase_(shard, it);
+        return std::nullopt;
+    }
+    return it->second.user;
+}
+
+void SessionStore::Destroy(std::string_view token) {
+    if(!Enabled() or !ValidToken(token)) return;
+    Shard& shard = ShardOf_(token);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.map.find(token);
+    if(it != shard.map.end()) Erase_(shard, it);
+}
+
+size_t SessionStore::SweepNext() {
+    if(!Enabled()) return 0;
+    Shard& shard = shards_[sweepCursor_];
+    sweepCursor_ = (sweepCursor_ + 1) % SHARDS;
+    int64_t now = time(nullptr);
+    size_t n = 0;
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    for(auto it = shard.map.begin(); it != shard.map.end(); ) {
+        auto next = std::next(it);
+        if(it->second.expire <= now) {
+            Erase_(shard, it);
+            n++;
+        }
+        it = next;
+    }
+    return n;
+}
+
+size_t SessionStore::Size() {
+    size_t n = 0;
+    for(Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        n += shard.map.size();
+    }
+    return n;
+}
+
+std::string_view SessionStore::TokenFromCookie(std::string_view cookie) {
+    const std::string_view name(COOKIE_NAME);
+    size_t pos = 0;
+    while(pos < cookie.size()) {
+        while(pos < cookie.size() and (cookie[pos] == ' ' or cookie[pos] == ';')) pos++;
+        size_t end = cookie.find(';', pos);
+        if(end == std::string_view::npos) end = cookie.size();
+        std::string_view pair = cookie.substr(pos, end - pos);
+        if(pair.size() > name.size() and pair.compare(0, name.size(), name) == 0 and pair[name.size()] == '=') {
+            return pair.substr(name.size() + 1);
+        }
+        pos = end;
+    }
+    return {};
+}
@@ -0,0 +1,103 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <array>
+#include <functional>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+    会话存储：登录成功后签发随机会话 ID（Cookie WSSESSION），之后的页面请求凭 Cookie 在内存中校验，
+    不再提交账号密码、也不访问数据库。
+    - 会话 ID 为 getrandom 生成的 16 字节随机数（32 位十六进制）；
+    - 按会话 ID 分为 SHARDS 个分片，各自一把锁；查找只在一个分片内做一次哈希查找；
+    - 会话在 ttl 秒后过期：查找时发现过期即删除，另由主 Reactor 的定时器每 SWEEP_INTERVAL_MS
+      轮流清理一个分片，清理工作量有界；
+    - 可选持久化（session_file）：会话写入 MAP_SHARED 映射文件中的定长槽位，每个分片独占一段槽位，
+      进程重启后 Init 扫描文件恢复未过期的会话；过期时间用墙上时间，跨重启仍然有效。
+*/
+class SessionStore {
+public:
+    static constexpr size_t SHARDS = 16;
+    static constexpr size_t TOKEN_BYTES = 16;
+    static constexpr size_t TOKEN_LEN = TOKEN_BYTES * 2;
+    static constexpr size_t USER_CAP = 103; // 持久化槽位中用户名的最大长度
+    static constexpr int SWEEP_INTERVAL_MS = 1000;
+    static constexpr const char* COOKIE_NAME = "WSSESSION";
+
+    static SessionStore& getInstance();
+
+    // ttlSec 为 0 时关闭会话；file 非空时持久化到该文件（capacity 个槽位），返回 false 表示打开文件失败
+    bool Init(int ttlSec, size_t capacity, const std::string& file = "");
+    void Close();
+    bool Enabled() const { return ttl_ > 0; }
+    int Ttl() const { return ttl_; }
+
+    // 为 user 创建会话，返回会话 ID；失败返回空串
+    std::string Create(const std::string& user);
+    // 有效会话返回用户名
+    std::optional<std::string> Lookup(std::string_view token);
+    void Destroy(std::string_view token);
+    // 清理下一个分片中的过期会话，返回清理的个数
+    size_t SweepNext();
+    size_t Size();
+
+    // 从 Cookie 请求头中取出会话 ID，没有时返回空视图
+    static std::string_view TokenFromCookie(std::string_view cookie);
+
+private:
+    // 持久化文件中的一个槽位；expire 为 0 表示空闲
+    struct Slot {
+        uint8_t token[TOKEN_BYTES];
+        int64_t expire;   // 过期时间（Unix 秒）
+        uint8_t userLen;
+        char user[USER_CAP];
+    };
+    static_assert(sizeof(Slot) == 128, "Slot should stay two cache lines");
+
+    struct Session {
+        std::string user;
+        int64_t expire = 0;
+        uint32_t slot = UINT32_MAX; // 持久化槽位，未持久化为 UINT32_MAX
+    };
+    // 支持以 string_view 查找，校验 Cookie 时不构造 std::string
+    struct TokenHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+    using SessionMap = std::unordered_map<std::string, Session, TokenHash, std::equal_to<>>;
+    struct alignas(64) Shard {
+        std::mutex mtx;
+        SessionMap map;
+        std::vector<uint32_t> freeSlots; // 本分片空闲的持久化槽位
+    };
+
+    SessionStore() = default;
+    ~SessionStore() { Close(); }
+    SessionStore(const SessionStore&) = delete;
+    SessionStore& operator=(const SessionStore&) = delete;
+
+    Shard& ShardOf_(std::string_view token);
+    size_t ShardIndex_(std::string_view token) const;
+    bool OpenFile_(const std::string& file);
+    void Restore_();
+    // 以下调用方持有分片锁
+    void Erase_(Shard& shard, SessionMap::iterator it);
+    void WriteSlot_(uint32_t slot, const std::string& token, const Session& s);
+
+    int ttl_ = 0;
+    size_t shardCapacity_ = 0;
+    std::array<Shard, SHARDS> shards_;
+    size_t sweepCursor_ = 0; // 只在主 Reactor 线程使用
+
+    Slot* slots_ = nullptr;  // 持久化映射，为空表示不持久化
+    size_t slotCount_ = 0;
+    size_t mapLen_ = 0;
+};
+
+#endif /* SESSION_H */
@@ -0,0 +1,38 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+    SHA-256（FIPS 180-4），用于凭据缓存中的加盐密码摘要，不依赖 OpenSSL。
+    用法：Update 若干次后 Final 取摘要；一次性计算用 Sha256::Hash。
+*/
+class Sha256 {
+public:
+    static constexpr size_t DIGEST_SIZE = 32;
+    using Digest = std::array<uint8_t, DIGEST_SIZE>;
+
+    Sha256() { Reset(); }
+
+    void Reset();
+    void Update(const void* data, size_t len);
+    void Update(std::string_view s) { Update(s.data(), s.size()); }
+    Digest Final(); // 之后需 Reset 才能再次使用
+
+    static Digest Hash(std::string_view s);
+    static std::string Hex(const Digest& d);
+
+private:
+    void Transform_(const uint8_t* block);
+
+    uint32_t state_[8];
+    uint64_t bits_ = 0;   // 已输入的总位数
+    uint8_t block_[64];
+    size_t blockLen_ = 0;
+};
+
+#endif /* SHA256_H */
@@ -0,0 +1,133 @@
+#include "sqliteuserstore.h"
+
+#include <sqlite3.h>
+
+#include "../log/log.h"
+
+static const char SCHEMA[] =
+    "CREATE TABLE IF NOT EXISTS user(username TEXT PRIMARY KEY NOT NULL, password TEXT NOT NULL) WITHOUT ROWID";
+static const char SELECT_SQL[] = "SELECT password FROM user WHERE username = ?";
+static const char INSERT_SQL[] = "INSERT OR IGNORE INTO user(username, password) VALUES(?, ?)";
+
+bool SqliteUserStore::Open(const std::string& file, size_t handles) {
+    Close();
+    file_ = file;
+    // 第一个句柄负责切换 WAL 与建表（journal_mode 写入数据库文件，之后的连接自动使用 WAL）
+    Handle* h = OpenHandle_(true);
+    if(!h) return false;
+    open_ = true;
+    Release_(h);
+    for(size_t i = 1; i < handles; i++) {
+        if(!(h = OpenHandle_())) break; // 预开失败不影响使用，用到时再开
+        Release_(h);
+    }
+    LOG_INFO("SqliteUserStore Open | file: {}, handles: {}, sqlite {}", file_, idle_.size(), sqlite3_libversion());
+    return true;
+}
+
+void SqliteUserStore::Close() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for(Handle* h : idle_) CloseHandle_(h);
+    idle_.clear();
+    open_ = false;
+}
+
+SqliteUserStore::Handle* SqliteUserStore::OpenHandle_(bool first) {
+    Handle* h = new Handle;
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX;
+    // synchronous 是连接级设置，每个句柄都要设置
+    const char* setup = first ?
+        "PRAGMA journal_mode = WAL;"
+        "PRAGMA synchronous = NORMAL;" : "PRAGMA synchronous = NORMAL;";
+    if(sqlite3_open_v2(file_.c_str(), &h->db, flags, nullptr) != SQLITE_OK or
+       sqlite3_busy_timeout(h->db, INSERT_BUSY_MS) != SQLITE_OK or
+       sqlite3_exec(h->db, setup, nullptr, nullptr, nullptr) != SQLITE_OK or
+       (first and sqlite3_exec(h->db, SCHEMA, nullptr, nullptr, nullptr) != SQLITE_OK) or
+       sqlite3_prepare_v3(h->db, SELECT_SQL, -1, SQLITE_PREPARE_PERSISTENT, &h->select, nullptr) != SQLITE_OK or
+       sqlite3_prepare_v3(h->db, INSERT_SQL, -1, SQLITE_PREPARE_PERSISTENT, &h->insert, nullptr) != SQLITE_OK) {
+        LOG_ERROR("SqliteUserStore: open {} failed: {}", file_, h->db ? sqlite3_errmsg(h->db) : "out of memory");
+        CloseHandle_(h);
+        return nullptr;
+    }
+    return h;
+}
+
+void SqliteUserStore::CloseHandle_(Handle* h) {
+    sqlite3_finalize(h->select);
+    sqlite3_finalize(h->insert);
+    sqlite3_close(h->db);
+    delete h;
+}
+
+SqliteUserStore::Handle* SqliteUserStore::Acquire_() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if(!open_) return nullptr;
+        if(!idle_.empty()) {
+            Handle* h = idle_.back();
+            idle_.pop_back();
+            return h;
+        }
+    }
+    return OpenHandle_();
+}
+
+void SqliteUserStore::Release_(Handle* h) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if(open_) idle_.push_back(h);
+    else CloseHandle_(h); // 使用期间已经 Close
+}
+
+UserStore::Status SqliteUserStore::Lookup(const std::string& name, std::string& password) {
+    Handle* h = Acquire_();
+    if(!h) return Status::FAILED;
+    sqlite3_stmt* stmt = h->select;
+    // 查询在 Reactor 上执行，不等待锁
+    sqlite3_busy_timeout(h->db, 0);
+    sqlite3_bind_text(stmt, 1, name.data(), static_cast<int>(name.size()), SQLITE_STATIC);
+    Status status;
+    switch(sqlite3_step(stmt)) {
+    case SQLITE_ROW:
+        password.assign(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)), sqlite3_column_bytes(stmt, 0));
+        status = Status::OK;
+        break;
+    case SQLITE_DONE:
+        status = Status::NOT_FOUND;
+        break;
+    case SQLITE_BUSY:
+        status = Status::UNAVAILABLE; // 调用方改到 DB 通道重试，仍失败时返回 503
+        break;
+    default:
+        LOG_WARN("SqliteUserStore: lookup failed: {}", sqlite3_errmsg(h->db));
+        status = Status::FAILED;
+    }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    Release_(h);
+    return status;
+}
+
+UserStore::Status SqliteUserStore::Insert(const std::string& name, const std::string& password) {
+    Handle* h = Acquire_();
+    if(!h) return Status::FAILED;
+    sqlite3_stmt* stmt = h->insert;
+    sqlite3_busy_timeout(h->db, INSERT_BUSY_MS);
+    sqlite3_bind_text(stmt, 1, name.data(), static_cast<int>(name.size()), SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, password.data(), static_cast<int>(password.size()), SQLITE_STATIC);
+    Status status;
+    switch(sqlite3_step(stmt)) {
+    case SQLITE_DONE:
+        status = sqlite3_changes(h->db) > 0 ? Status::OK : Status::EXISTS;
+        break;
+    case SQLITE_BUSY:
+        status = Status::UNAVAILABLE; // 等待写锁超过 busy_timeout
+        break;
+    default:
+        LOG_WARN("SqliteUserStore: insert failed: {}", sqlite3_errmsg(h->db));
+        status = Status::FAILED;
+    }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    Release_(h);
+    return status;
+}
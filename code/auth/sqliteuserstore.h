@@ -0,0 +1,62 @@
+#ifndef SQLITEUSERSTORE_H
+#define SQLITEUSERSTORE_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "userstore.h"
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+/*
+    嵌入式 SQLite 用户表：数据库文件在本机，不需要数据库服务。
+    - WAL 模式 + synchronous=NORMAL：读不阻塞写，提交只追加 WAL 不做 fsync（检查点时才刷盘），
+      查找与新增都在微秒级；
+    - 每个句柄是一个独立的 SQLite 连接（NOMUTEX），带着 prepare 好的查询/插入语句；
+      Open 时预先打开若干句柄，调用线程从空闲链表中取一个独占使用，用完放回，
+      没有空闲句柄时才新开一个，Reactor 上的查询不在请求路径上打开数据库；
+    - 查询在 Reactor 上执行，不等待锁（busy_timeout 为 0），遇到锁竞争返回 UNAVAILABLE；
+      新增要等待写锁（最多 INSERT_BUSY_MS），因此 InsertMayBlock 为 true，注册在 DB 通道执行；
+    - username 为主键，INSERT OR IGNORE 后以 sqlite3_changes 判断用户名是否已被占用。
+*/
+class SqliteUserStore : public UserStore {
+public:
+    SqliteUserStore() = default;
+    ~SqliteUserStore() override { Close(); }
+    SqliteUserStore(const SqliteUserStore&) = delete;
+    SqliteUserStore& operator=(const SqliteUserStore&) = delete;
+
+    // 打开（不存在时创建）数据库文件并建表，预先打开 handles 个句柄（至少一个）
+    bool Open(const std::string& file, size_t handles = 1);
+    void Close();
+
+    const char* Name() const override { return "sqlite"; }
+    bool Remote() const override { return false; }
+    bool InsertMayBlock() const override { return true; }
+    Status Lookup(const std::string& name, std::string& password) override;
+    Status Insert(const std::string& name, const std::string& password) override;
+
+private:
+    struct Handle {
+        sqlite3* db = nullptr;
+        sqlite3_stmt* select = nullptr;
+        sqlite3_stmt* insert = nullptr;
+    };
+
+    Handle* Acquire_();
+    void Release_(Handle* h);
+    static constexpr int INSERT_BUSY_MS = 1000; // 新增等待写锁的上限，超过返回 UNAVAILABLE
+
+    // first 为 true 时负责切换 WAL 与建表
+    Handle* OpenHandle_(bool first = false);
+    static void CloseHandle_(Handle* h);
+
+    std::string file_;
+    std::mutex mtx_;
+    std::vector<Handle*> idle_;
+    bool open_ = false;
+};
+
+#endif /* SQLITEUSERSTORE_H */
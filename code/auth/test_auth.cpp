@@ -0,0 +1,319 @@
+#include "sha256.h"
+#include "credcache.h"
+#include "session.h"
+#include "memuserstore.h"
+#include "sqliteuserstore.h"
+#include "../log/log.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sqlite3.h>
+
+// 测试1：SHA-256 标准测试向量（FIPS 180-2 附录 B）
+void testSha256() {
+    LOG_INFO("=== Test 1: SHA-256 ===");
+    assert(Sha256::Hex(Sha256::Hash("")) ==
+           "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    assert(Sha256::Hex(Sha256::Hash("abc")) ==
+           "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    assert(Sha256::Hex(Sha256::Hash("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq")) ==
+           "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    // 分多次 Update 与一次性计算结果相同，跨越 64 字节块边界
+    std::string million(1000000, 'a');
+    Sha256 h;
+    for(size_t i = 0; i < million.size(); i += 997) {
+        h.Update(million.data() + i, std::min<size_t>(997, million.size() - i));
+    }
+    assert(Sha256::Hex(h.Final()) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    LOG_INFO("✓ Test 1 passed!");
+}
+
+// 测试2：正向/负向条目、失效与过期
+void testCredCache() {
+    LOG_INFO("=== Test 2: Credential Cache ===");
+    CredCache& cache = CredCache::getInstance();
+    cache.Init(1, 1, 1024);
+    using R = CredCache::Result;
+
+    assert(cache.Lookup("alice", "pw1") == R::MISS);
+    cache.Put("alice", "pw1");
+    assert(cache.Lookup("alice", "pw1") == R::MATCH);
+    assert(cache.Lookup("alice", "pw2") == R::MISMATCH);
+
+    cache.PutUnknown("bob");
+    assert(cache.Lookup("bob", "x") == R::UNKNOWN);
+    // 注册成功后覆盖负向条目
+    cache.Put("bob", "x");
+    assert(cache.Lookup("bob", "x") == R::MATCH);
+    cache.Invalidate("bob");
+    assert(cache.Lookup("bob", "x") == R::MISS);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    assert(cache.Lookup("alice", "pw1") == R::MISS);
+    assert(cache.Size() == 0); // 过期条目在查找时删除
+
+    // ttl = 0 关闭缓存
+    cache.Init(0, 0, 1024);
+    cache.Put("alice", "pw1");
+    assert(cache.Lookup("alice", "pw1") == R::MISS);
+    LOG_INFO("✓ Test 2 passed!");
+}
+
+// 测试3：容量上限与多线程并发
+void testCredCacheConcurrent() {
+    LOG_INFO("=== Test 3: Capacity & Concurrency ===");
+    CredCache& cache = CredCache::getInstance();
+    cache.Init(60, 60, 256);
+    for(int i = 0; i < 10000; i++) cache.Put("user" + std::to_string(i), "pw");
+    assert(cache.Size() <= 256);
+
+    cache.Init(60, 60, 65536);
+    const int users = 1000, threads = 4, rounds = 200000;
+    for(int i = 0; i < users; i++) cache.Put("user" + std::to_string(i), "pw" + std::to_string(i));
+    std::atomic<int> wrong{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            for(int i = 0; i < rounds; i++) {
+                int u = (i * 7 + t) % users;
+                if(cache.Lookup("user" + std::to_string(u), "pw" + std::to_string(u)) != CredCache::Result::MATCH) wrong++;
+            }
+        });
+    }
+    for(auto& w : workers) w.join();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    assert(wrong == 0);
+    LOG_INFO("{} lookups by {} threads: {} ns/lookup", threads * rounds, threads, ns / (threads * rounds));
+    std::cout << "CredCache: " << ns / (threads * rounds) << " ns/lookup (" << threads << " threads)" << std::endl;
+    LOG_INFO("✓ Test 3 passed!");
+}
+
+// 测试4：会话签发、Cookie 解析、过期清理
+void testSession() {
+    LOG_INFO("=== Test 4: Session Store ===");
+    SessionStore& store = SessionStore::getInstance();
+    store.Init(1, 1024);
+    std::string a = store.Create("alice");
+    std::string b = store.Create("bob");
+    assert(a.size() == SessionStore::TOKEN_LEN and a != b);
+    assert(store.Lookup(a) == "alice" and store.Lookup(b) == "bob");
+    assert(!store.Lookup("0123456789abcdef0123456789abcdef"));
+    assert(!store.Lookup("not-a-token"));
+
+    std::string cookie = "theme=dark; WSSESSION=" + a + "; lang=zh";
+    assert(SessionStore::TokenFromCookie(cookie) == a);
+    assert(SessionStore::TokenFromCookie("WSSESSION=" + b) == b);
+    assert(SessionStore::TokenFromCookie("XWSSESSION=" + b).empty());
+
+    store.Destroy(b);
+    assert(!store.Lookup(b));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    size_t swept = 0;
+    for(size_t i = 0; i < SessionStore::SHARDS; i++) swept += store.SweepNext();
+    assert(swept == 1 and store.Size() == 0);
+
+    // 容量上限
+    store.Init(60, 64);
+    for(int i = 0; i < 1000; i++) store.Create("user" + std::to_string(i));
+    assert(store.Size() <= 64);
+
+    // ttl = 0 不签发会话
+    store.Init(0, 1024);
+    assert(store.Create("alice").empty());
+    LOG_INFO("✓ Test 4 passed!");
+}
+
+// 测试5：持久化文件，重新 Init（模拟重启）后会话仍然有效，空闲槽位可复用
+void testSessionPersist() {
+    LOG_INFO("=== Test 5: Session Persistence ===");
+    const char* file = "log/test_sessions.bin";
+    unlink(file);
+    SessionStore& store = SessionStore::getInstance();
+    assert(store.Init(60, 4096, file));
+    std::vector<std::string> tokens;
+    for(int i = 0; i < 100; i++) tokens.push_back(store.Create("user" + std::to_string(i)));
+    store.Destroy(tokens[0]);
+    store.Close();
+
+    assert(store.Init(60, 256, file)); // 沿用文件中的槽位数（4096）
+    assert(store.Size() == 99);
+    assert(!store.Lookup(tokens[0]));
+    for(int i = 1; i < 100; i++) assert(store.Lookup(tokens[i]) == "user" + std::to_string(i));
+    for(int i = 0; i < 100; i++) store.Create("more" + std::to_string(i));
+    assert(store.Size() == 199);
+    store.Close();
+
+    // 不是会话文件时重建
+    FILE* fp = fopen(file, "w");
+    fputs("garbage", fp);
+    fclose(fp);
+    assert(store.Init(60, 256, file));
+    assert(store.Size() == 0);
+
+    // 查找耗时
+    std::string t = store.Create("alice");
+    const int rounds = 1000000;
+    auto start = std::chrono::steady_clock::now();
+    int found = 0;
+    for(int i = 0; i < rounds; i++) found += store.Lookup(t).has_value();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    assert(found == rounds);
+    std::cout << "SessionStore: " << ns / rounds << " ns/lookup" << std::endl;
+    store.Init(0, 0);
+    unlink(file);
+    LOG_INFO("✓ Test 5 passed!");
+}
+
+// 多线程并发查找，返回平均每次查找的纳秒数
+static long long BenchLookup(UserStore& store, int users, int threads, int rounds) {
+    std::atomic<int> wrong{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            std::string pwd;
+            for(int i = 0; i < rounds; i++) {
+                int u = (i * 7 + t) % users;
+                if(store.Lookup("user" + std::to_string(u), pwd) != UserStore::Status::OK or
+                   pwd != "pw" + std::to_string(u)) wrong++;
+            }
+        });
+    }
+    for(auto& w : workers) w.join();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    assert(wrong == 0);
+    return ns / (threads * rounds);
+}
+
+// 用户存储后端的公共行为：新增、重复新增、查找、并发新增同名用户只有一个成功
+static void CheckUserStore(UserStore& store) {
+    using S = UserStore::Status;
+    std::string pwd;
+    assert(store.Lookup("alice", pwd) == S::NOT_FOUND);
+    assert(store.Insert("alice", "pw1") == S::OK);
+    assert(store.Insert("alice", "other") == S::EXISTS);
+    assert(store.Lookup("alice", pwd) == S::OK and pwd == "pw1");
+
+    std::atomic<int> created{0};
+    std::vector<std::thread> workers;
+    for(int t = 0; t < 8; t++) {
+        workers.emplace_back([&]() {
+            if(store.Insert("racer", "pw") == S::OK) created++;
+        });
+    }
+    for(auto& w : workers) w.join();
+    assert(created == 1);
+    assert(!store.Remote());
+}
+
+// 测试6：内存用户表，mmap 文件快照在重新打开（模拟重启）后仍然有效
+void testMemUserStore() {
+    LOG_INFO("=== Test 6: Memory User Store ===");
+    const char* file = "log/test_users.bin";
+    unlink(file);
+    {
+        MemUserStore store;
+        assert(store.Open(file, 4096));
+        CheckUserStore(store);
+        for(int i = 0; i < 1000; i++) {
+            assert(store.Insert("user" + std::to_string(i), "pw" + std::to_string(i)) == UserStore::Status::OK);
+        }
+        assert(store.Size() == 1002);
+    }
+    MemUserStore store;
+    assert(store.Open(file, 256)); // 沿用文件中的容量
+    assert(store.Capacity() == 4096 and store.Size() == 1002);
+    std::string pwd;
+    assert(store.Lookup("user999", pwd) == UserStore::Status::OK and pwd == "pw999");
+    // 装载率上限：4096 个槽位最多 7/8
+    int inserted = 0;
+    for(int i = 0; i < 4096; i++) {
+        if(store.Insert("fill" + std::to_string(i), "x") == UserStore::Status::OK) inserted++;
+    }
+    assert(store.Size() == 1002 + static_cast<size_t>(inserted));
+    assert(store.Size() <= 4096 * 7 / 8 and store.Size() + 16 * 8 > 4096 * 7 / 8);
+    // 超长用户名
+    assert(store.Insert(std::string(MemUserStore::NAME_CAP + 1, 'a'), "x") == UserStore::Status::FAILED);
+    std::cout << "MemUserStore: " << BenchLookup(store, 1000, 4, 200000) << " ns/lookup (4 threads)" << std::endl;
+    store.Close();
+
+    // 不是用户表文件时拒绝打开，也不覆盖
+    FILE* fp = fopen(file, "w");
+    fputs("garbage", fp);
+    fclose(fp);
+    assert(!store.Open(file, 4096));
+    struct stat st;
+    assert(stat(file, &st) == 0 and st.st_size == 7);
+    unlink(file);
+
+    // 不指定文件时只在内存中
+    assert(store.Open("", 64));
+    CheckUserStore(store);
+    LOG_INFO("✓ Test 6 passed!");
+}
+
+// 测试7：嵌入式 SQLite 用户表
+void testSqliteUserStore() {
+    LOG_INFO("=== Test 7: SQLite User Store ===");
+    const char* file = "log/test_users.db";
+    for(const char* f : {file, "log/test_users.db-wal", "log/test_users.db-shm"}) unlink(f);
+    {
+        SqliteUserStore store;
+        assert(store.Open(file));
+        CheckUserStore(store);
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < 1000; i++) {
+            assert(store.Insert("user" + std::to_string(i), "pw" + std::to_string(i)) == UserStore::Status::OK);
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "SqliteUserStore: " << ns / 1000 << " ns/insert" << std::endl;
+    }
+    SqliteUserStore store;
+    assert(store.Open(file, 4)); // 重新打开后数据仍在
+    assert(!store.Remote() and store.InsertMayBlock()); // 注册走 DB 通道
+    std::string pwd;
+    assert(store.Lookup("user999", pwd) == UserStore::Status::OK and pwd == "pw999");
+    assert(store.Insert("user0", "x") == UserStore::Status::EXISTS);
+    {
+        // 另一个连接持有写锁时，查询既不等待也不失败（WAL 读不阻塞写），新增等满 busy_timeout 后返回 UNAVAILABLE
+        sqlite3* writer = nullptr;
+        assert(sqlite3_open(file, &writer) == SQLITE_OK);
+        assert(sqlite3_exec(writer, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr) == SQLITE_OK);
+        auto start = std::chrono::steady_clock::now();
+        assert(store.Lookup("user1", pwd) == UserStore::Status::OK and pwd == "pw1");
+        assert(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(50));
+        assert(store.Insert("locked", "x") == UserStore::Status::UNAVAILABLE);
+        sqlite3_exec(writer, "ROLLBACK", nullptr, nullptr, nullptr);
+        sqlite3_close(writer);
+    }
+    std::cout << "SqliteUserStore: " << BenchLookup(store, 1000, 4, 50000) << " ns/lookup (4 threads)" << std::endl;
+    store.Close();
+    for(const char* f : {file, "log/test_users.db-wal", "log/test_users.db-shm"}) unlink(f);
+    LOG_INFO("✓ Test 7 passed!");
+}
+
+int main() {
+    Logger::getInstance().initLogger("log/test_auth.log", LogLevel::INFO, 1024, 3);
+    LOG_INFO("Starting Auth Tests...");
+    LOG_INFO("===============================");
+
+    testSha256();
+    testCredCache();
+    testCredCacheConcurrent();
+    testSession();
+    testSessionPersist();
+    testMemUserStore();
+    testSqliteUserStore();
+
+    LOG_INFO("================================");
+    LOG_INFO("All tests passed successfully! ✓");
+    Logger::getInstance().shutdown();
+    std::cout << "Test completed. Check test_auth.log for details." << std::endl;
+    return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef USERSTORE_H
+#define USERSTORE_H
+
+#include <memory>
+#include <string>
+
+/*
+    用户存储后端：UserVerify 只通过本接口查询/新增用户，不直接依赖数据库。
+    - mysql（MySqlUserStore）：原有的 MySQL 连接池 + 预处理语句，开启批量注册时注册走 RegisterBatcher；
+    - sqlite（SqliteUserStore）：嵌入式 SQLite，WAL 模式，数据库文件在本机，不需要外部服务；
+    - memory（MemUserStore）：内存哈希表，表本身放在 MAP_SHARED 映射的文件中，进程重启后直接恢复。
+    本地后端（Remote 为 false）的查询是微秒级的，由 Reactor 直接调用，不投递到 DB 通道；
+    新增可能等待写锁的后端（InsertMayBlock 为 true，如 SQLite）的注册仍投递到 DB 通道。
+    后端在启动时由 SetActive 设置一次，之后只读；没有设置时使用 MySQL。
+*/
+class UserStore {
+public:
+    enum class Status {
+        OK,          // 查到用户 / 新增成功
+        NOT_FOUND,   // 用户不存在
+        EXISTS,      // 新增：用户名已被占用
+        UNAVAILABLE, // 后端暂时不可用（如等待数据库连接超时），调用方按过载处理
+        FAILED,      // 其他错误
+    };
+
+    virtual ~UserStore() = default;
+
+    virtual const char* Name() const = 0;
+    // 是否经网络访问外部服务；为 false 时在调用线程上直接执行，耗时在微秒级
+    virtual bool Remote() const = 0;
+    // 新增是否可能长时间等待（网络或写锁）；为 true 时注册不在 Reactor 上执行
+    virtual bool InsertMayBlock() const { return Remote(); }
+    // 查询用户的密码，OK 时写入 password
+    virtual Status Lookup(const std::string& name, std::string& password) = 0;
+    // 用户名未被占用时新增用户
+    virtual Status Insert(const std::string& name, const std::string& password) = 0;
+
+    // 当前使用的后端，没有设置时返回 nullptr（使用 MySQL）
+    static UserStore* Active() { return active_.get(); }
+    static void SetActive(std::unique_ptr<UserStore> store) { active_ = std::move(store); }
+
+private:
+    static inline std::unique_ptr<UserStore> active_;
+};
+
+#endif /* USERSTORE_H */
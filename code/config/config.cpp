@@ -3,6 +3,7 @@
 #include <fstream>
 #include <sstream>
 #include <cstring>
+#include <cstdio>
 #include <unistd.h>
 
 Config& Config::getInstance() {
@@ -80,18 +81,68 @@ void Config::parse_config_file(const std::string& filePath) {
             else if (key == "log_flush_interval") c_log_flush_interval = std::stoi(value);
             else if (key == "open_log") c_open_log = (value == "true" or value == "1");
             else if (key == "log_queue_size") c_log_queue_size = std::stoi(value);
+            else if (key == "log_format") c_log_binary = (value == "binary");
+            else if (key == "log_overflow") {
+                if (value == "drop_newest") c_log_overflow = 1;
+                else if (value == "drop_oldest") c_log_overflow = 2;
+                else if (value == "sample") c_log_overflow = 3;
+                else c_log_overflow = 0;
+            }
+            else if (key == "log_max_size") c_log_max_size = std::stoi(value);
+            else if (key == "log_max_files") c_log_max_files = std::stoi(value);
+            else if (key == "log_compress") c_log_compress = (value == "true" or value == "1");
+            else if (key == "log_sync_interval") c_log_sync_interval = std::stoi(value);
+            else if (key == "log_mmap_size") c_log_mmap_size = std::stoi(value);
+            else if (key == "access_log") c_access_log = value;
+            else if (key == "access_log_format") {
+                if (value == "json") c_access_log_format = 1;
+                else if (value == "binary") c_access_log_format = 2;
+                else c_access_log_format = 0;
+            }
+            else if (key == "log_sample_rates") {
+                std::sscanf(value.c_str(), "%d,%d,%d", &c_log_sample_rates[0], &c_log_sample_rates[1], &c_log_sample_rates[2]);
+            }
             else if (key == "opt_linger") c_isOptLinger = (value == "true" or value == "1");
             else if (key == "trigger_mode") c_trigMode = std::stoi(value);
             else if (key == "max_connections") c_maxConnection = std::stoi(value);
             else if (key == "log_level") c_log_level = std::stoi(value);
             else if (key == "max_body_size") c_max_body_size = std::stoi(value);
             else if (key == "connection_timeout") c_timeout = std::stoi(value);
+            else if (key == "conn_byte_budget") c_conn_byte_budget = std::stoi(value);
+            else if (key == "conn_request_budget") c_conn_request_budget = std::stoi(value);
             else if (key == "db_host") c_db_host = value;
             else if (key == "db_port") c_db_port = std::stoi(value);
             else if (key == "db_user") c_db_user = value;
             else if (key == "db_password") c_db_password = value;
             else if (key == "db_name") c_db_name = value;
+            else if (key == "cred_cache_ttl") c_cred_cache_ttl = std::stoi(value);
+            else if (key == "cred_cache_negative_ttl") c_cred_cache_negative_ttl = std::stoi(value);
+            else if (key == "cred_cache_size") c_cred_cache_size = std::stoi(value);
+            else if (key == "session_ttl") c_session_ttl = std::stoi(value);
+            else if (key == "session_capacity") c_session_capacity = std::stoi(value);
+            else if (key == "session_file") c_session_file = value;
+            else if (key == "user_store") c_user_store = value;
+            else if (key == "user_store_path") c_user_store_path = value;
+            else if (key == "user_store_capacity") c_user_store_capacity = std::stoi(value);
+            else if (key == "db_nonblocking") c_db_nonblocking = (value == "true" or value == "1");
             else if (key == "connection_pool_size") c_conn_pool_num = std::stoi(value);
+            else if (key == "db_pool_min") c_db_pool_min = std::stoi(value);
+            else if (key == "db_acquire_timeout") c_db_acquire_timeout = std::stoi(value);
+            else if (key == "db_idle_timeout") c_db_idle_timeout = std::stoi(value);
+            else if (key == "db_ping_interval") c_db_ping_interval = std::stoi(value);
+            else if (key == "register_batch_window") c_register_batch_window = std::stoi(value);
+            else if (key == "register_batch_size") c_register_batch_size = std::stoi(value);
+            else if (key == "lane_static_workers") c_lane_static_workers = std::stoi(value);
+            else if (key == "lane_static_queue") c_lane_static_queue = std::stoi(value);
+            else if (key == "lane_db_workers") c_lane_db_workers = std::stoi(value);
+            else if (key == "lane_db_queue") c_lane_db_queue = std::stoi(value);
+            else if (key == "lane_admin_workers") c_lane_admin_workers = std::stoi(value);
+            else if (key == "lane_admin_queue") c_lane_admin_queue = std::stoi(value);
+            else if (key == "reactor_cpus") c_reactor_cpus = value;
+            else if (key == "worker_cpus") c_worker_cpus = value;
+            else if (key == "log_cpu") c_log_cpu = std::stoi(value);
+            else if (key == "numa_local") c_numa_local = (value == "true" or value == "1");
+            else if (key == "incoming_cpu") c_incoming_cpu = (value == "true" or value == "1");
 
         }
     }
@@ -111,13 +162,46 @@ void Config::print_config() const {
     std::cout << "Log File: " << c_log_file << std::endl;
     std::cout << "Log Level: " << c_log_level << std::endl;
     std::cout << "Log Flush Interval: " << c_log_flush_interval << " seconds" << std::endl;
+    std::cout << "Log Format: " << (c_log_binary ? "binary" : "text") << std::endl;
+    std::cout << "Log Rotation: " << (c_log_max_size > 0 ? std::to_string(c_log_max_size) + " MB" : "daily")
+              << ", keep " << c_log_max_files << (c_log_compress ? ", gzip" : "")
+              << ", fdatasync every " << c_log_sync_interval << " ms" << std::endl;
+    if (c_log_mmap_size > 0) std::cout << "Log Ring File: " << c_log_file << ".ring, " << c_log_mmap_size << " MB" << std::endl;
+    static const char* OVERFLOW_NAMES[] = {"block", "drop_newest", "drop_oldest", "sample"};
+    std::cout << "Log Overflow: " << OVERFLOW_NAMES[c_log_overflow] << ", sample rates " << c_log_sample_rates[0]
+              << "," << c_log_sample_rates[1] << "," << c_log_sample_rates[2] << std::endl;
+    static const char* ACCESS_FORMAT_NAMES[] = {"clf", "json", "binary"};
+    std::cout << "Access Log: " << (c_access_log.empty() ? "disabled" : c_access_log + " (" + ACCESS_FORMAT_NAMES[c_access_log_format] + ")") << std::endl;
     std::cout << "Max Body Size: " << c_max_body_size / (1024 * 1024) << " MB" << std::endl;
     std::cout << "Connection Timeout: " << c_timeout << " seconds" << std::endl;
-    std::cout << "Connection Pool Num: " << c_conn_pool_num << std::endl;
+    std::cout << "Connection Budget: " << c_conn_byte_budget << " bytes, " << c_conn_request_budget << " requests per loop" << std::endl;
+    std::cout << "Connection Pool Num: " << c_db_pool_min << " - " << c_conn_pool_num
+              << ", acquire timeout " << c_db_acquire_timeout << " ms, idle timeout " << c_db_idle_timeout
+              << "s, ping interval " << c_db_ping_interval << "s" << std::endl;
+    std::cout << "Register Batch: window " << c_register_batch_window << " ms, max " << c_register_batch_size << std::endl;
     std::cout << "Database Host: " << c_db_host << std::endl;
     std::cout << "Database Port: " << c_db_port << std::endl;
     std::cout << "Database User: " << c_db_user << std::endl;
     // 不建议打印数据库密码哈 =.=
     // std::cout << "Database Password: " << db_password << std::endl; 
     std::cout << "Database Name: " << c_db_name << std::endl;
+    std::cout << "User Store: " << c_user_store;
+    if(c_user_store != "mysql") {
+        std::cout << ", file " << (c_user_store_path.empty() ? "default" : c_user_store_path);
+        if(c_user_store == "memory") std::cout << ", capacity " << c_user_store_capacity;
+    }
+    std::cout << std::endl;
+    std::cout << "Credential Cache: ttl " << c_cred_cache_ttl << "s, negative ttl " << c_cred_cache_negative_ttl
+              << "s, size " << c_cred_cache_size << std::endl;
+    std::cout << "Session: ttl " << c_session_ttl << "s, capacity " << c_session_capacity
+              << ", file " << (c_session_file.empty() ? "none" : c_session_file) << std::endl;
+    std::cout << "Database Nonblocking: " << (c_db_nonblocking ? "true" : "false") << std::endl;
+    std::cout << "Static Lane: " << c_lane_static_workers << " workers, queue " << c_lane_static_queue << std::endl;
+    std::cout << "DB Lane: " << c_lane_db_workers << " workers, queue " << c_lane_db_queue << std::endl;
+    std::cout << "Admin Lane: " << c_lane_admin_workers << " workers, queue " << c_lane_admin_queue << std::endl;
+    std::cout << "Reactor CPUs: " << (c_reactor_cpus.empty() ? "unpinned" : c_reactor_cpus) << std::endl;
+    std::cout << "Worker CPUs: " << (c_worker_cpus.empty() ? "unpinned" : c_worker_cpus) << std::endl;
+    std::cout << "Log CPU: " << c_log_cpu << std::endl;
+    std::cout << "NUMA Local: " << (c_numa_local ? "Yes" : "No") << std::endl;
+    std::cout << "Incoming CPU Steering: " << (c_incoming_cpu ? "Yes" : "No") << std::endl;
 }
\ No newline at end of file
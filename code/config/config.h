@@ -28,18 +28,61 @@ public:
 
     std::string c_log_file;    
     int c_log_level; // 0 : DEBUG 1 : INFO 2 : WARN 3 : ERROR
-    int c_log_queue_size; // 日志队列大小
+    int c_log_queue_size; // 日志队列大小（待刷盘的缓冲块数）
     bool c_open_log; // 是否开启日志
     int64_t c_log_flush_interval; // 日志刷新间隔
+    bool c_log_binary = false; // 二进制日志（log_format = binary），用 logdecode 还原为文本
+    int c_log_overflow = 0; // 日志队列满时：0 block 1 drop_newest 2 drop_oldest 3 sample
+    int c_log_sample_rates[3] = {100, 10, 1}; // sample 策略下 DEBUG / INFO / WARN 每多少行保留 1 行
+    int c_log_max_size = 0;       // 单个日志文件上限（MB），超过后滚动，0 表示只按日期滚动
+    int c_log_max_files = 0;      // 保留的旧日志文件个数，0 表示全部保留
+    bool c_log_compress = false;  // 旧日志文件在后台 gzip 压缩
+    int c_log_sync_interval = 0;  // fdatasync 间隔（毫秒），0 表示交给内核回写
+    int c_log_mmap_size = 0;      // 环形映射日志文件大小（MB），0 表示写普通日志文件
+    std::string c_access_log;     // 访问日志文件，为空表示不记录
+    int c_access_log_format = 0;  // 0 clf 1 json 2 binary
     int c_max_body_size; // 最大请求体大小 1MB
     int c_timeout; // 默认超时时间 60s
+    int c_conn_byte_budget = 65536; // 每个连接每轮事件循环最多读写的字节数
+    int c_conn_request_budget = 4;  // 每个连接每轮事件循环最多处理的请求数
 
-    int c_conn_pool_num; // 数据库连接池数量
+    int c_conn_pool_num; // 数据库连接池数量（最大连接数）
+    int c_db_pool_min = 0;            // 常驻连接数，0 表示固定为 connection_pool_size
+    int c_db_acquire_timeout = 1000;  // 等待数据库连接的最长时间（毫秒），超时返回 503；-1 表示一直等待
+    int c_db_idle_timeout = 60;       // 超过常驻数的空闲连接保留时间（秒），0 表示不收缩
+    int c_db_ping_interval = 30;      // 空闲连接健康检查间隔（秒），0 表示不检查
+    int c_register_batch_window = 2;  // 批量注册的合并窗口（毫秒），0 表示每个注册单独提交
+    int c_register_batch_size = 64;   // 一批最多合并的注册数
     std::string c_db_host;
     int c_db_port;
     std::string c_db_user;
     std::string c_db_password;
     std::string c_db_name;
+    std::string c_user_store = "mysql";  // 用户存储后端：mysql / sqlite / memory
+    std::string c_user_store_path;       // 本地后端的数据文件（sqlite 数据库 / memory 快照），为空时使用默认路径
+    int c_user_store_capacity = 65536;   // memory 后端的用户数上限（首次创建文件时确定）
+    int c_cred_cache_ttl = 300;          // 登录凭据缓存有效期（秒），0 表示关闭
+    int c_cred_cache_negative_ttl = 30;  // 不存在的用户名的缓存有效期（秒）
+    int c_cred_cache_size = 65536;       // 凭据缓存条目上限
+    int c_session_ttl = 1800;            // 会话有效期（秒），0 表示不签发会话
+    int c_session_capacity = 65536;      // 会话数上限
+    std::string c_session_file;          // 会话持久化文件，为空表示只保存在内存中
+    bool c_db_nonblocking = false; // 登录/注册在 Reactor 上用非阻塞 MySQL 接口执行（需 libmysqlclient 8.0.16+）
+
+    // 舱壁调度通道配置：工作线程数（并发上限）与等待队列长度
+    int c_lane_static_workers = 0; // 0 表示静态请求直接在 Reactor 线程处理
+    int c_lane_static_queue = 0;
+    int c_lane_db_workers = 8;     // 不宜超过数据库连接池大小
+    int c_lane_db_queue = 256;
+    int c_lane_admin_workers = 1;
+    int c_lane_admin_queue = 16;
+
+    // 线程放置：CPU 列表格式如 "0-3,8"，为空表示不绑核
+    std::string c_reactor_cpus;   // 从 Reactor 线程依次绑定的核心
+    std::string c_worker_cpus;    // 调度通道工作线程可运行的核心集合
+    int c_log_cpu = -1;           // 日志刷盘线程绑定的杂务核心，-1 表示不绑核
+    bool c_numa_local = true;     // Reactor 线程内存优先分配在本地 NUMA 节点
+    bool c_incoming_cpu = true;   // 按 SO_INCOMING_CPU 把连接交给同核心的 Reactor
 
     // 解析命令行参数
     void parse_args(int argc, char* argv[]);
@@ -0,0 +1,267 @@
+#include "httpconn.h"
+
+#include <chrono>
+#include <algorithm>
+#include <strings.h>
+
+#include "../config/config.h"
+#include "../log/accesslog.h"
+#include "../server/singleflight.h"
+
+std::atomic<int> HttpConn::userCount{0};
+
+HttpConn::REQUEST_STATE HttpConn::CheckRequest_(const Buffer& buff, size_t& length) {
+    static const char HEADER_END[] = "\r\n\r\n";
+    const char* begin = buff.peek();
+    const char* end = buff.begin_write_const();
+    const char* headerEnd = std::search(begin, end, HEADER_END, HEADER_END + 4);
+    if(headerEnd == end) {
+        return buff.readable_size() > MAX_HEADER_SIZE ? REQUEST_BAD : REQUEST_INCOMPLETE;
+    }
+    // 在请求头中查找 Content-Length（不区分大小写）
+    static const char CONTENT_LENGTH[] = "content-length:";
+    const size_t keyLen = sizeof(CONTENT_LENGTH) - 1;
+    size_t bodyLen = 0;
+    for(const char* p = begin; p + keyLen <= headerEnd; p++) {
+        if((p == begin or p[-1] == '\n') and strncasecmp(p, CONTENT_LENGTH, keyLen) == 0) {
+            const char* v = p + keyLen;
+            while(v < headerEnd and (*v == ' ' or *v == '\t')) v++;
+            if(v == headerEnd or *v < '0' or *v > '9') return REQUEST_BAD;
+            while(v < headerEnd and *v >= '0' and *v <= '9') {
+                bodyLen = bodyLen * 10 + (*v - '0');
+                if(bodyLen > static_cast<size_t>(Config::getInstance().c_max_body_size)) return REQUEST_BAD;
+                v++;
+            }
+            break;
+        }
+    }
+    size_t total = (headerEnd - begin) + 4 + bodyLen;
+    if(buff.readable_size() < total) return REQUEST_INCOMPLETE;
+    length = total;
+    return REQUEST_COMPLETE;
+}
+
+Task<HttpRequest::UserRecord> HttpConn::LookupUser_(EventLoop& loop, SqlLease& sql, const std::string& name, int timeoutMs) {
+    HttpRequest::UserRecord rec;
+    // 非阻塞接口没有预处理语句版本，只能拼接文本查询；
+    // ValidCredential 已限定用户名和密码只含字母、数字和下划线，不会被解释为 SQL
+    char query[256];
+    snprintf(query, sizeof(query), "SELECT username, password FROM user WHERE username = '%s' LIMIT 1", name.c_str());
+    if(!co_await AsyncSqlQuery(loop, sql.get(), query, timeoutMs)) {
+        if(!SqlConnUsable(sql.get())) sql.Discard();
+        co_return rec;
+    }
+    MYSQL_RES* res = co_await AsyncStoreResult(loop, sql.get(), timeoutMs);
+    if(!res) {
+        if(!SqlConnUsable(sql.get())) sql.Discard();
+        co_return rec;
+    }
+    rec.status = UserStore::Status::NOT_FOUND;
+    while(MYSQL_ROW row = mysql_fetch_row(res)) {
+        rec.status = UserStore::Status::OK;
+        rec.password = row[1];
+        HttpRequest::CacheLookupResult(name, row[1]);
+    }
+    if(rec.status == UserStore::Status::NOT_FOUND) HttpRequest::CacheLookupResult(name, nullptr);
+    mysql_free_result(res); // 结果集已完整读入内存，释放不涉及网络
+    co_return rec;
+}
+
+Task<std::optional<bool>> HttpConn::VerifyUser_(EventLoop& loop, const HttpRequest::AuthRequest& auth, int timeoutMs) {
+    if(!HttpRequest::ValidCredential(auth.name, auth.password)) co_return false;
+    // 等待连接的协程数与 DB 通道的等待队列共用一个上限
+    SqlLease sql = co_await AcquireSql(loop, static_cast<size_t>(Config::getInstance().c_lane_db_queue));
+    if(!sql) co_return std::nullopt;
+
+    // 登录：用户存在且密码相同；注册：用户名未被占用
+    HttpRequest::UserRecord rec = co_await LookupUser_(loop, sql, auth.name, timeoutMs);
+    if(auth.isLogin) co_return HttpRequest::CheckLogin(auth.name, auth.password, rec);
+    if(rec.status != UserStore::Status::NOT_FOUND) co_return false;
+
+    char query[256];
+    snprintf(query, sizeof(query), "INSERT INTO user(username, password) VALUES('%s', '%s')",
+             auth.name.c_str(), auth.password.c_str());
+    if(!co_await AsyncSqlQuery(loop, sql.get(), query, timeoutMs)) {
+        if(!SqlConnUsable(sql.get())) sql.Discard();
+        CredCache::getInstance().Invalidate(auth.name);
+        co_return false;
+    }
+    CredCache::getInstance().Put(auth.name, auth.password);
+    LOG_INFO("User {} registered", auth.name);
+    co_return true;
+}
+
+Task<std::optional<bool>> HttpConn::LoginUser_(EventLoop& loop, const HttpRequest::AuthRequest& auth, int timeoutMs) {
+    if(!HttpRequest::ValidCredential(auth.name, auth.password)) co_return false;
+    // 同一用户并发登录（如多个标签页同时打开）只查一次库，其余请求等待同一个结果
+    static SingleFlight<HttpRequest::UserRecord> flight;
+    auto load = [&loop, &auth, timeoutMs]() -> Task<HttpRequest::UserRecord> {
+        if(SqlConnPool::getInstance().IsNonblocking()) {
+            SqlLease sql = co_await AcquireSql(loop, static_cast<size_t>(Config::getInstance().c_lane_db_queue));
+            if(!sql) co_return HttpRequest::UserRecord{UserStore::Status::UNAVAILABLE, {}};
+            co_return co_await LookupUser_(loop, sql, auth.name, timeoutMs);
+        }
+        std::optional<HttpRequest::UserRecord> r = co_await DbQuery(loop, [&auth]() {
+            return HttpRequest::LookupUser(auth.name);
+        });
+        // 通道拒绝按后端不可用处理（503）
+        co_return r ? std::move(*r) : HttpRequest::UserRecord{UserStore::Status::UNAVAILABLE, {}};
+    };
+    HttpRequest::UserRecord rec = co_await flight.Do(loop, auth.name, load);
+    co_return HttpRequest::CheckLogin(auth.name, auth.password, rec);
+}
+
+Task<std::optional<std::shared_ptr<const HttpResponse::MappedFile>>> HttpConn::LoadFile_(EventLoop& loop, RequestLane lane, const std::string& file) {
+    using FileResult = std::optional<std::shared_ptr<const HttpResponse::MappedFile>>;
+    // 热点文件被并发请求时只 stat/mmap 一次，其余请求共享同一个映射；
+    // 管理请求与静态请求的路径不重叠，同一个 key 总在同一个通道加载
+    static SingleFlight<FileResult> flight;
+    auto load = [&loop, lane, &file]() -> Task<FileResult> {
+        // 通道有工作线程时在通道中加载，冷文件的读盘不阻塞 Reactor；
+        // lambda 只按引用捕获（见 Task 的说明），file 在整个加载期间有效
+        if(LaneScheduler::getInstance().Workers(lane) > 0) {
+            FileResult r = co_await RunInLane(loop, lane, [&file]() { return HttpResponse::LoadFile(file); });
+            // 静态通道已满时退回直接加载；管理通道拒绝时返回 503，不占用 Reactor
+            if(r or lane == RequestLane::ADMIN) co_return r;
+        }
+        co_return HttpResponse::LoadFile(file);
+    };
+    co_return co_await flight.Do(loop, file, load);
+}
+
+Task<std::optional<bool>> HttpConn::RegisterUser_(EventLoop& loop, const HttpRequest::AuthRequest& auth) {
+    if(!HttpRequest::ValidCredential(auth.name, auth.password)) co_return false;
+    RegisterBatcher::Result r = co_await AsyncRegister(loop, auth.name, auth.password);
+    co_return HttpRequest::OnRegisterResult(auth.name, auth.password, r);
+}
+
+Task<void> HttpConn::Serve(EventLoop& loop, int fd, sockaddr_in addr) {
+    Config& config = Config::getInstance();
+    const int timeoutMs = config.c_timeout > 0 ? config.c_timeout * 1000 : -1;
+    LOG_INFO("Client[{}]({}:{}) in, userCount: {}", fd, inet_ntoa(addr.sin_addr), ntohs(addr.sin_port), userCount.load());
+
+    Buffer readBuff, writeBuff;
+    HttpRequest request;
+    HttpResponse response;
+    request.SetAsyncAuth(true); // 鉴权在 DB 通道执行，不阻塞 Reactor
+    // 每轮事件循环的读写/请求额度，避免大上传或流水线请求独占 Reactor
+    FairnessBudget budget(loop, config.c_conn_byte_budget, config.c_conn_request_budget);
+
+    bool keepAlive = true;
+    while(keepAlive) {
+        // 1. 读到一个完整请求
+        size_t reqLen = 0;
+        REQUEST_STATE state;
+        bool peerClosed = false;
+        while((state = CheckRequest_(readBuff, reqLen)) == REQUEST_INCOMPLETE) {
+            ssize_t n = co_await AsyncRead(loop, fd, readBuff, timeoutMs, &budget);
+            if(n <= 0) {
+                peerClosed = true;
+                break;
+            }
+        }
+        if(peerClosed) break;
+
+        budget.ChargeRequest();
+        const bool accessLog = AccessLog::Enabled();
+        std::chrono::steady_clock::time_point start;
+        AccessRecord access;
+        if(accessLog) {
+            start = std::chrono::steady_clock::now();
+            access.timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            access.clientIp = addr.sin_addr.s_addr;
+        }
+
+        // 2. 解析：按完整请求切片解析，保证长连接上的下一个请求不被吞掉
+        int code = -1;
+        request.init();
+        if(state == REQUEST_BAD) {
+            code = 400;
+            readBuff.reset();
+        } else {
+            Buffer reqBuff(reqLen + 1);
+            reqBuff.append(readBuff.peek(), reqLen);
+            readBuff.skip(reqLen);
+            if(!request.parse(reqBuff)) code = 400;
+        }
+
+        // 3. 按请求类别分流：登录/注册在 DB 通道执行，通道饱和或等待数据库连接超时时返回 503；
+        //    其余请求的文件在第 4 步按 STATIC / ADMIN 通道加载
+        const RequestLane lane = code == -1 ? request.Lane() : RequestLane::STATIC;
+        if(lane == RequestLane::DB and request.AuthPending()) {
+            // 通道拒绝、等待数据库连接超时或批量注册队列已满都是 nullopt
+            // 账号与任务先放进具名局部变量再 co_await（见 Task 的说明）
+            std::optional<bool> ok;
+            if(request.AuthIsLogin()) {
+                HttpRequest::AuthRequest auth = request.TakeAuthRequest();
+                ok = co_await LoginUser_(loop, auth, timeoutMs);
+            } else if(RegisterBatcher::getInstance().Enabled()) {
+                HttpRequest::AuthRequest auth = request.TakeAuthRequest();
+                ok = co_await RegisterUser_(loop, auth);
+            } else if(SqlConnPool::getInstance().IsNonblocking()) {
+                HttpRequest::AuthRequest auth = request.TakeAuthRequest();
+                ok = co_await VerifyUser_(loop, auth, timeoutMs);
+            } else {
+                std::function<std::optional<bool>()> task = request.TakeAuthTask();
+                if(std::optional<std::optional<bool>> r = co_await DbQuery(loop, std::move(task))) ok = *r;
+            }
+            if(ok) request.OnAuthDone(*ok);
+            else code = 503;
+        }
+
+        // 4. 加载文件、构建响应并写回；鉴权结束后的结果页按静态文件加载
+        std::shared_ptr<const HttpResponse::MappedFile> file;
+        if(code == -1) {
+            std::string path = config.c_resource_root + request.path();
+            RequestLane fileLane = lane == RequestLane::ADMIN ? RequestLane::ADMIN : RequestLane::STATIC;
+            std::optional<std::shared_ptr<const HttpResponse::MappedFile>> loaded = co_await LoadFile_(loop, fileLane, path);
+            if(loaded) file = std::move(*loaded);
+            else code = 503;
+        }
+        keepAlive = (code == -1) and request.IsKeepAlive();
+        if(accessLog) {
+            access.SetMethod(request.method());
+            access.SetVersion(request.version());
+            access.SetPath(request.path());
+        }
+        response.Init(config.c_resource_root, request.path(), keepAlive, code);
+        // 登录成功：签发会话，之后的页面请求凭 Cookie 校验
+        if(!request.LoginUser().empty() and SessionStore::getInstance().Enabled()) {
+            std::string token = SessionStore::getInstance().Create(request.LoginUser());
+            if(!token.empty()) {
+                response.AddHeader("Set-Cookie", std::string(SessionStore::COOKIE_NAME) + "=" + token +
+                    "; Max-Age=" + std::to_string(SessionStore::getInstance().Ttl()) + "; Path=/; HttpOnly; SameSite=Lax");
+            }
+        }
+        if(file) response.SetFile(std::move(file));
+        writeBuff.reset();
+        response.MakeResponse(writeBuff);
+        // 大文件：写缓冲区中只有响应头，响应体用 sendfile 从页缓存直接发送；
+        // 小文件与错误页面已拷贝进写缓冲区，与响应头一次写出
+        const int bodyFd = response.SendfileFd();
+        const size_t bodyBytes = bodyFd >= 0 ? response.FileLen() : 0;
+        const size_t respBytes = writeBuff.readable_size() + bodyBytes;
+        ssize_t written = co_await AsyncWrite(loop, fd, writeBuff, timeoutMs, &budget);
+        if(written >= 0 and bodyFd >= 0) {
+            ssize_t sent = co_await AsyncSendfile(loop, fd, bodyFd, 0, bodyBytes, timeoutMs, &budget);
+            if(sent < 0 or static_cast<size_t>(sent) < bodyBytes) written = -1; // 文件被截断时长度已无法对上
+        }
+        response.UnmapFile(); // 发送完成后释放对共享文件的引用
+        if(accessLog) {
+            access.status = static_cast<uint16_t>(response.Code());
+            access.bytes = written < 0 ? 0 : static_cast<uint32_t>(std::min<size_t>(respBytes, UINT32_MAX));
+            access.latencyUs = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            AccessLog::getInstance().Record(access);
+        }
+        if(written < 0) break;
+        // 缓冲区中还有流水线请求但额度已用完时，让出给其他连接
+        if(keepAlive and budget.Exhausted()) co_await Yield(loop);
+    }
+
+    loop.Unregister(fd);
+    close(fd);
+    userCount.fetch_sub(1);
+    LOG_INFO("Client[{}] quit, userCount: {}", fd, userCount.load());
+}
@@ -0,0 +1,54 @@
+#ifndef HTTPCONN_H
+#define HTTPCONN_H
+
+#include <atomic>
+#include <string>
+#include <arpa/inet.h>
+
+#include "httprequest.h"
+#include "httpresponse.h"
+#include "../buffer/buffer.h"
+#include "../server/asyncio.h"
+#include "../server/asyncsql.h"
+
+/*
+    HttpConn 负责一个 HTTP 连接的完整生命周期，以协程形式顺序书写：
+        读到完整请求 → 解析并按 HttpRequest::Lane 分类 → 登录/注册在 DB 通道鉴权，
+        静态文件与管理请求分别在 STATIC / ADMIN 通道加载 → 构建响应 → 写回 → 长连接则继续
+    所有等待（读、写、数据库）都挂起协程而不阻塞 Reactor 线程。
+    连接池为非阻塞模式时，鉴权不经过 DB 通道的线程，直接在本 Reactor 上用非阻塞 MySQL 接口查询。
+*/
+class HttpConn {
+public:
+    static std::atomic<int> userCount; // 当前连接数
+
+    // 处理连接 fd 直到关闭，fd 由本函数负责关闭
+    static Task<void> Serve(EventLoop& loop, int fd, sockaddr_in addr);
+
+private:
+    enum REQUEST_STATE {
+        REQUEST_INCOMPLETE,
+        REQUEST_COMPLETE,
+        REQUEST_BAD,
+    };
+
+    // 检查缓冲区中是否已有一个完整请求（请求头 + Content-Length 长度的请求体）
+    static REQUEST_STATE CheckRequest_(const Buffer& buff, size_t& length);
+
+    // 在 Reactor 上非阻塞地完成登录/注册；等待连接的协程过多时返回 std::nullopt
+    static Task<std::optional<bool>> VerifyUser_(EventLoop& loop, const HttpRequest::AuthRequest& auth, int timeoutMs);
+    // 在借到的连接上用非阻塞接口查询用户并更新凭据缓存
+    static Task<HttpRequest::UserRecord> LookupUser_(EventLoop& loop, SqlLease& sql, const std::string& name, int timeoutMs);
+    // 登录：同一用户名的并发登录合并为一次查询（single-flight），查询在 DB 通道或非阻塞连接上执行
+    static Task<std::optional<bool>> LoginUser_(EventLoop& loop, const HttpRequest::AuthRequest& auth, int timeoutMs);
+    // 加载静态文件：同一文件的并发请求合并为一次 stat/mmap。lane 有工作线程时在通道中加载，
+    // 通道已满时静态通道退回在 Reactor 上直接加载，管理通道返回 std::nullopt（503）
+    static Task<std::optional<std::shared_ptr<const HttpResponse::MappedFile>>> LoadFile_(EventLoop& loop, RequestLane lane, const std::string& file);
+
+    // 注册交给批量注册线程，与并发的其他注册合并提交；协程挂起期间不占用 DB 通道的线程
+    static Task<std::optional<bool>> RegisterUser_(EventLoop& loop, const HttpRequest::AuthRequest& auth);
+
+    static constexpr size_t MAX_HEADER_SIZE = 64 * 1024;
+};
+
+#endif /* HTTPCONN_H */
@@ -1,5 +1,7 @@
 #include "httprequest.h"
 #include <algorithm>
+#include <cstring>
+#include <string_view>
 
 const std::unordered_set<std::string> HttpRequest::DEFAULT_HTML {
     "/login", "/register", "/index",
@@ -11,9 +13,16 @@ const std::unordered_map<std::string, int> HttpRequest::DEFAULT_HTML_TAG {
     {"/register.html", 0}, {"/login.html", 1},  
 };
 
+const std::unordered_set<std::string> HttpRequest::AUTH_HTML {
+    "/welcome.html",
+};
+
 void HttpRequest::init() {
     method_ = path_ = version_ = body_ = "";
     state_ = REQUEST_LINE;
+    authPending_ = false;
+    authIsLogin_ = false;
+    loginUser_.clear();
     header_.clear();
     post_.clear();
 }
@@ -25,6 +34,13 @@ bool HttpRequest::IsKeepAlive() const {
     }
     return false;
 }
+// 登录/注册表单提交需要访问数据库，/admin 前缀为管理请求，其余按静态资源处理
+RequestLane HttpRequest::Lane() const {
+    if(path_.compare(0, 6, "/admin") == 0) return RequestLane::ADMIN;
+    if(method_ == "POST" and DEFAULT_HTML_TAG.count(path_)) return RequestLane::DB;
+    return RequestLane::STATIC;
+}
+
 /**
  * @brief 解析HTTP请求的函数，基于状态机逐行解析请求行、请求头和请求体
  * @details HTTP请求的标准格式如下：
@@ -60,10 +76,28 @@ bool HttpRequest::parse(Buffer& buff) {
         if(line_end == buff.begin_write_const()) break;
         buff.retrieve_until(line_end + 2);
     }
+    if(state_ == FINISH and method_ == "GET") ApplySession_();
     LOG_DEBUG("[{}], [{}], [{}]", method_.c_str(), path_.c_str(), version_.c_str());
     return true;
 }
 
+std::string_view HttpRequest::SessionToken() const {
+    auto it = header_.find("Cookie");
+    if(it == header_.end()) return {};
+    return SessionStore::TokenFromCookie(it->second);
+}
+
+void HttpRequest::ApplySession_() {
+    SessionStore& sessions = SessionStore::getInstance();
+    if(!sessions.Enabled()) return;
+    bool loginPage = path_ == "/login.html";
+    if(!loginPage and !AUTH_HTML.count(path_)) return;
+    std::string_view token = SessionToken();
+    bool authed = !token.empty() and sessions.Lookup(token).has_value();
+    if(loginPage and authed) path_ = "/welcome.html";
+    else if(!loginPage and !authed) path_ = "/login.html";
+}
+
 // 请求行形式 ： GET / HTTP/1.1
 bool HttpRequest::ParseRequestLine_(const std::string line) {
     // 使用字符串查找代替正则表达式，提高效率
@@ -147,10 +181,32 @@ void HttpRequest::ParsePost_() {
             if(tag == 0 or tag == 1) {
                 // 设置是否为登录操作的标志
                 bool isLogin = (tag == 1);
-                // 验证用户名和密码
-                if(UserVerify(post_["username"], post_["password"], isLogin)) {
+                // 凭据非法或缓存命中时直接得出结果，不访问数据库
+                if(std::optional<bool> cached = VerifyCached_(post_["username"], post_["password"], isLogin)) {
+                    path_ = *cached ? "/welcome.html" : "/error.html";
+                    if(*cached and isLogin) loginUser_ = post_["username"];
+                    return;
+                }
+                // 异步鉴权模式下只记录，数据库访问交给线程池；本地用户存储直接查询，
+                // 但可能等待写锁的注册（如 SQLite）仍交给 DB 通道
+                UserStore& store = Store_();
+                bool defer = asyncAuth_ and (store.Remote() or (!isLogin and store.InsertMayBlock()));
+                std::optional<bool> ok;
+                if(!defer) {
+                    ok = UserVerify(post_["username"], post_["password"], isLogin);
+                    // 本地后端暂时不可用（如 SQLite 查询遇到锁竞争）时改到 DB 通道重试，仍不可用时返回 503
+                    defer = asyncAuth_ and !ok;
+                }
+                if(defer) {
+                    authPending_ = true;
+                    authIsLogin_ = isLogin;
+                    return;
+                }
+                // 验证用户名和密码（借不到数据库连接时按失败处理）
+                if(ok.value_or(false)) {
                     // 验证成功，重定向到欢迎页面
                     path_ = "/welcome.html";
+                    if(isLogin) loginUser_ = post_["username"];
                 } 
                 else {
                     // 验证失败，重定向到错误页面
@@ -281,7 +337,26 @@ std::string HttpRequest::GetPost(const char* key) const {
     return "";
 }
 
-bool HttpRequest::UserVerify(const std::string& name, const std::string& password, bool isLogin) {
+std::function<std::optional<bool>()> HttpRequest::TakeAuthTask() {
+    assert(authPending_);
+    // 按值捕获账号信息，任务在工作线程执行期间不访问 HttpRequest 对象
+    return [name = post_["username"], pwd = post_["password"], isLogin = authIsLogin_]() {
+        return UserVerify(name, pwd, isLogin);
+    };
+}
+
+void HttpRequest::OnAuthDone(bool ok) {
+    authPending_ = false;
+    if(ok and authIsLogin_) loginUser_ = post_["username"];
+    path_ = ok ? "/welcome.html" : "/error.html";
+}
+
+HttpRequest::AuthRequest HttpRequest::TakeAuthRequest() {
+    assert(authPending_);
+    return {post_["username"], post_["password"], authIsLogin_};
+}
+
+bool HttpRequest::ValidCredential(const std::string& name, const std::string& password) {
     if(name == "" or password == "") return false;
     // 验证用户名格式：只允许字母、数字和下划线
     for(char ch : name) {
@@ -303,69 +378,100 @@ bool HttpRequest::UserVerify(const std::string& name, const std::string& passwor
             return false;
         }
     }
-    LOG_INFO("User Verifying: {}", name);
-    MYSQL* sql = nullptr;
-    SqlConnRAII(&sql, &SqlConnPool::getInstance()); // 从连接池中获取数据库连接
-    assert(sql);
-    // 验证结果标记，默认FALSE
-    bool flag = false;
-    char query[256] = {0}; // 查询语句缓冲区
-    // MySQL字段结构指针（存储查询结果的字段信息）
-    // MYSQL_FIELD* fields = nullptr;
-    // MySQL结果集指针（存储查询返回的数据）
-    MYSQL_RES* res = nullptr;
-    // 注册场景默认标记为true（假设用户名未被占用，后续查询后修正）
-    if(!isLogin) flag = true;
-    // snprintf : 格式化字符串，将查询语句格式化到query中，此处有SQL注入风险，需注意
-    snprintf(query, 256, "SELECT username, password FROM user WHERE username = '%s' LIMIT 1",name.c_str());
-    LOG_DEBUG("{}", query); // 打印查询语句
+    return true;
+}
 
-    // 执行查询语句，如果失败则释放结果集并返回false，注意：mysql_query返回0表示成功
-    if(mysql_query(sql, query)) {
-        mysql_free_result(res);
+std::optional<bool> HttpRequest::VerifyCached_(const std::string& name, const std::string& password, bool isLogin) {
+    if(!ValidCredential(name, password)) return false;
+    switch(CredCache::getInstance().Lookup(name, password)) {
+    case CredCache::Result::MATCH:
+        LOG_DEBUG("User {} verified by cache", name);
+        return isLogin; // 注册：用户名已被占用
+    case CredCache::Result::MISMATCH:
         return false;
+    case CredCache::Result::UNKNOWN:
+        // 注册仍要查库插入，负向条目只用于拒绝登录
+        if(isLogin) return false;
+        return std::nullopt;
+    case CredCache::Result::MISS:
+        break;
     }
+    return std::nullopt;
+}
 
-    res = mysql_store_result(sql); // 执行查询并存储结果
-    // cnt = mysql_num_fields(res); // 获取查询结果中的字段数量
-    // fields = mysql_fetch_fields(res); // 获取字段信息
-
-    // 遍历查询结果
-    while(MYSQL_ROW row = mysql_fetch_row(res)) {
-        LOG_DEBUG("MYSQL ROW: {} {}", row[0], row[1]);
-        std::string pwd(row[1]); // 获取数据库中存储的密码
-        if(isLogin) {
-            if(password == pwd) flag = true; // 登录时，密码匹配则标记为true
-            else {
-                flag = false;
-                LOG_DEBUG("Password is wrong!");
-            }
-        } //  注册场景：查询到记录→用户名已存在，验证失败
-        else {
-            flag = false;
-            LOG_DEBUG("Username already exists!");
-        }
-    }       
-    mysql_free_result(res); // 释放结果集
-    // 注册行为，且用户名未被占用，则将用户名和密码插入数据库
-    if(!isLogin and flag) {
-        LOG_DEBUG("Registering user: {}", name);
-        bzero(query, 256); // 清空缓冲区
-        snprintf(query, 256, "INSERT INTO user(username, password) VALUES('%s', '%s')", name.c_str(), password.c_str());
-        LOG_DEBUG("{}", query);
-        if(mysql_query(sql, query)) {
-            LOG_DEBUG("Database insert user failed!");
-            flag = false;
-        }
-        else flag = true; 
-    }
-    // 无需手动释放，RAII机制会自动释放，手动释放可能造成资源重复释放
-    // SqlConnPool::getInstance().freeConnection(sql); // 释放数据库连接
-    LOG_INFO("User {} Verify Successful!!", name);
-    return flag;
+void HttpRequest::CacheLookupResult(const std::string& name, const char* dbPassword) {
+    if(dbPassword) CredCache::getInstance().Put(name, dbPassword);
+    else CredCache::getInstance().PutUnknown(name);
 }
 
+UserStore& HttpRequest::Store_() {
+    UserStore* store = UserStore::Active();
+    return store ? *store : MySqlUserStore::getInstance();
+}
 
+HttpRequest::UserRecord HttpRequest::LookupUser(const std::string& name) {
+    UserRecord rec;
+    rec.status = Store_().Lookup(name, rec.password);
+    if(rec.status == UserStore::Status::OK) CacheLookupResult(name, rec.password.c_str());
+    else if(rec.status == UserStore::Status::NOT_FOUND) CacheLookupResult(name, nullptr);
+    return rec;
+}
 
+std::optional<bool> HttpRequest::CheckLogin(const std::string& name, const std::string& pwd, const UserRecord& rec) {
+    switch(rec.status) {
+    case UserStore::Status::OK:
+        if(rec.password == pwd) {
+            LOG_INFO("User {} Verify Successful!!", name);
+            return true;
+        }
+        LOG_DEBUG("Password is wrong!");
+        return false;
+    case UserStore::Status::UNAVAILABLE:
+        return std::nullopt; // 等待数据库连接超时
+    default:
+        return false;
+    }
+}
 
+std::optional<bool> HttpRequest::UserVerify(const std::string& name, const std::string& password, bool isLogin) {
+    if(!ValidCredential(name, password)) return false;
+    LOG_INFO("User Verifying: {}", name);
+    if(isLogin) return CheckLogin(name, password, LookupUser(name));
+    // 注册行为：用户名未被占用时插入
+    LOG_DEBUG("Registering user: {}", name);
+    switch(Store_().Insert(name, password)) {
+    case UserStore::Status::OK:
+        CredCache::getInstance().Put(name, password);
+        LOG_INFO("User {} registered", name);
+        return true;
+    case UserStore::Status::EXISTS:
+        LOG_DEBUG("Username already exists!");
+        CredCache::getInstance().Invalidate(name); // 丢弃可能存在的负向条目
+        return false;
+    case UserStore::Status::UNAVAILABLE:
+        return std::nullopt;
+    default:
+        LOG_DEBUG("Database insert user failed!");
+        CredCache::getInstance().Invalidate(name);
+        return false;
+    }
+}
 
+std::optional<bool> HttpRequest::OnRegisterResult(const std::string& name, const std::string& pwd, RegisterBatcher::Result r) {
+    switch(r) {
+    case RegisterBatcher::Result::CREATED:
+        CredCache::getInstance().Put(name, pwd);
+        LOG_INFO("User {} registered", name);
+        return true;
+    case RegisterBatcher::Result::EXISTS:
+        LOG_DEBUG("Username already exists!");
+        CredCache::getInstance().Invalidate(name); // 库中已有该用户，丢弃可能存在的负向条目
+        return false;
+    case RegisterBatcher::Result::FAILED:
+        LOG_DEBUG("Database insert user failed!");
+        CredCache::getInstance().Invalidate(name);
+        return false;
+    default:
+        return std::nullopt;
+    }
+}
@@ -4,9 +4,16 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <string>
+#include <functional>
+#include <optional>
 #include <errno.h>
 
 #include "../pool/sqlconnRAII.h"
+#include "../pool/regbatcher.h"
+#include "../auth/mysqluserstore.h"
+#include "../auth/credcache.h"
+#include "../auth/session.h"
+#include "../pool/lanescheduler.h"
 #include "../log/log.h"
 #include "../buffer/buffer.h"
 
@@ -44,6 +51,44 @@ public:
     std::string GetPost(const std::string& key) const;
     std::string GetPost(const char* key) const;
     bool IsKeepAlive() const; // 是否长连接
+    // 路由阶段的请求分类，决定请求进入哪个调度通道
+    RequestLane Lane() const;
+
+    // 异步鉴权：开启后 parse 不再同步调用 UserVerify，而是记录待验证的账号，
+    // 由调用方通过 TakeAuthTask 投递到线程池执行（或取出 TakeAuthRequest 在 Reactor 上非阻塞查询），
+    // 结果经 OnAuthDone 写回
+    struct AuthRequest {
+        std::string name;
+        std::string password;
+        bool isLogin = false;
+    };
+    void SetAsyncAuth(bool on) { asyncAuth_ = on; }
+    bool AuthPending() const { return authPending_; }
+    bool AuthIsLogin() const { return authIsLogin_; }
+    // 任务返回 nullopt 表示没有借到数据库连接（连接池等待超时），调用方按过载处理
+    std::function<std::optional<bool>()> TakeAuthTask();
+    AuthRequest TakeAuthRequest();
+    void OnAuthDone(bool ok);
+    // 本次请求登录成功的用户名（用于签发会话），否则为空
+    const std::string& LoginUser() const { return loginUser_; }
+    // Cookie 中的会话 ID，没有时为空
+    std::string_view SessionToken() const;
+
+    // 用户名与密码只允许字母、数字和下划线
+    static bool ValidCredential(const std::string& name, const std::string& pwd);
+    // 查库后更新凭据缓存：dbPassword 为库中的密码，用户不存在时为 nullptr
+    static void CacheLookupResult(const std::string& name, const char* dbPassword);
+    // 查到的用户记录：登录时同一用户的并发请求共享一次查询（single-flight），各自比较密码
+    struct UserRecord {
+        UserStore::Status status = UserStore::Status::FAILED;
+        std::string password; // status 为 OK 时有效
+    };
+    // 查询用户并更新凭据缓存，可能阻塞（MySQL 后端）
+    static UserRecord LookupUser(const std::string& name);
+    // 用查到的记录校验登录；后端不可用时返回 nullopt
+    static std::optional<bool> CheckLogin(const std::string& name, const std::string& pwd, const UserRecord& rec);
+    // 批量注册的结果转为鉴权结果并更新凭据缓存；BUSY 返回 nullopt（按过载处理）
+    static std::optional<bool> OnRegisterResult(const std::string& name, const std::string& pwd, RegisterBatcher::Result r);
 
 private:
     // 解析HTTP请求行 
@@ -61,13 +106,24 @@ private:
     // 解析HTTP请求参数
     static int ConverHex(char ch);
 
-    // 验证用户名和密码
-    static bool UserVerify(const std::string& name, const std::string& pwd, bool isLogin);
+    // 验证用户名和密码；借不到数据库连接时返回 nullopt
+    static std::optional<bool> UserVerify(const std::string& name, const std::string& pwd, bool isLogin);
+    // 当前的用户存储后端，没有设置时为 MySQL
+    static UserStore& Store_();
+    // GET 请求按会话改写路径：已登录访问登录页直接进入欢迎页，未登录访问 AUTH_HTML 转到登录页
+    void ApplySession_();
+    // 不访问数据库就能得出的鉴权结果（凭据非法或凭据缓存命中），否则返回 nullopt
+    static std::optional<bool> VerifyCached_(const std::string& name, const std::string& pwd, bool isLogin);
     
     PARSE_STATE state_;
+    bool asyncAuth_ = false;   // 是否延迟鉴权（不在解析线程上访问数据库）
+    bool authPending_ = false; // 是否有待执行的鉴权任务
+    bool authIsLogin_ = false;
+    std::string loginUser_;
     std::string method_, path_, version_, body_; // 请求行 
     std::unordered_map<std::string,std::string> header_, post_;
     static const std::unordered_set<std::string> DEFAULT_HTML;
     static const std::unordered_map<std::string, int> DEFAULT_HTML_TAG;
+    static const std::unordered_set<std::string> AUTH_HTML; // 开启会话后需要登录才能访问的页面
 };
 #endif /* HTTPREQUEST_H */
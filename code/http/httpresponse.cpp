@@ -28,6 +28,7 @@ const std::unordered_map<int, std::string> HttpResponse::CODE_STATUS {
     { 403, "Forbidden"},
     { 404, "Not Found"},
     { 500, "Internal Server Error"},
+    { 503, "Service Unavailable"},
 };
 
 const std::unordered_map<int, std::string> HttpResponse::CODE_PATH {
@@ -35,6 +36,7 @@ const std::unordered_map<int, std::string> HttpResponse::CODE_PATH {
     { 403, "/403.html"},
     { 404, "/404.html"},
     { 500, "/500.html"},
+    { 503, "/503.html"},
 };
 
 HttpResponse::HttpResponse() {
@@ -49,6 +51,36 @@ HttpResponse::~HttpResponse() {
     UnmapFile();
 }
 
+HttpResponse::MappedFile::~MappedFile() {
+    if(data) munmap(data, st.st_size);
+    if(fd >= 0) close(fd);
+}
+
+std::shared_ptr<const HttpResponse::MappedFile> HttpResponse::LoadFile(const std::string& file) {
+    auto f = std::make_shared<MappedFile>();
+    if(stat(file.c_str(), &f->st) < 0 or S_ISDIR(f->st.st_mode)) {
+        f->code = 404;
+    } else if(!(f->st.st_mode & S_IROTH)) {
+        f->code = 403;
+    } else {
+        f->code = 200;
+        int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd >= 0 and f->st.st_size >= SENDFILE_MIN_SIZE) {
+            // sendfile 按调用方给出的偏移读取，不移动文件位置，多个连接可共享同一个 fd；
+            // readahead 把内容读入页缓存，发送时不在 Reactor 上等待磁盘
+            readahead(fd, 0, f->st.st_size);
+            f->fd = fd;
+            fd = -1;
+        } else if(fd >= 0 and f->st.st_size > 0) {
+            void* addr = mmap(0, f->st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+            if(addr != MAP_FAILED) f->data = static_cast<char*>(addr);
+        }
+        if(fd >= 0) close(fd);
+        // 打开或映射失败时 data 与 fd 均无效，由 AddBody_ 按原有方式重试并返回错误内容
+    }
+    return f;
+}
+
 void HttpResponse::Init(const std::string& srcDir, std::string& path, bool isKeepAlive, int code) {
     assert(srcDir != ""); // 断言srcDir不为空
     if(mmFile_) { UnmapFile();} // 如果mmFile_不为空，则解除映射
@@ -58,10 +90,23 @@ void HttpResponse::Init(const std::string& srcDir, std::string& path, bool isKee
     code_ = code;
     mmFile_ = nullptr;
     mmFileStat_ = {0};
+    file_.reset();
+    extraHeaders_.clear();
 };
 
+void HttpResponse::AddHeader(std::string_view key, std::string_view value) {
+    extraHeaders_.append(key);
+    extraHeaders_.append(": ");
+    extraHeaders_.append(value);
+    extraHeaders_.append("\r\n");
+}
+
 void HttpResponse::MakeResponse(Buffer& buff) {
-    if(code_ == -1)
+    if(code_ == -1 and file_) {
+        mmFileStat_ = file_->st;
+        code_ = file_->code;
+    }
+    else if(code_ == -1)
     {
         // stat()获取文件的元信息（大小、权限、类型等）并写入 mmFileStat_
         if(stat((srcDir_ + path_).c_str(), &mmFileStat_) < 0 or S_ISDIR(mmFileStat_.st_mode))
@@ -82,18 +127,23 @@ void HttpResponse::MakeResponse(Buffer& buff) {
 }
 
 char* HttpResponse::GetFile() {
-    return mmFile_;
+    return file_ ? file_->data : mmFile_;
 }
 
 size_t HttpResponse::FileLen() const {
     return mmFileStat_.st_size; // 返回文件大小
 }
 
+int HttpResponse::SendfileFd() const {
+    return (code_ == 200 and file_) ? file_->fd : -1;
+}
+
 // 当 HTTP 响应状态码为错误码（如 404/403/500）时，
 // 将请求路径替换为预设的错误页面路径，并重新获取错误页面的文件信息。
 void HttpResponse::ErrorHtml_() {
     if(CODE_PATH.count(code_)) {
         path_ = CODE_PATH.find(code_)->second;
+        file_.reset(); // 改为发送错误页面
         // 重新获取错误页面的文件信息，写入mmFileStat_
         stat((srcDir_ + path_).data(), &mmFileStat_);
     }
@@ -112,6 +162,10 @@ void HttpResponse::AddStateLine_(Buffer& buff) {
 }
 
 void HttpResponse::AddHeaders_(Buffer& buff) {
+    std::string_view date = WallClock::HttpDate();
+    buff.append("Date: ", 6);
+    buff.append(date.data(), date.size());
+    buff.append("\r\n", 2);
     buff.append("Connection: ");
     if(isKeepAlive_) {
        buff.append("keep-alive\r\n");
@@ -121,9 +175,22 @@ void HttpResponse::AddHeaders_(Buffer& buff) {
         buff.append("close\r\n");
     }
     buff.append("Content-Type: " + GetFileType_() + "\r\n");
+    if(!extraHeaders_.empty()) buff.append(extraHeaders_);
 }
 
 void HttpResponse::AddBody_(Buffer& buff) {
+    if(file_ and file_->fd >= 0) {
+        // 大文件：只写响应头，响应体由调用方经 SendfileFd 零拷贝发送
+        buff.append("Content-Length: " + std::to_string(file_->st.st_size) + "\r\n");
+        buff.append("\r\n");
+        return;
+    }
+    if(file_ and file_->data) {
+        buff.append("Content-Length: " + std::to_string(file_->st.st_size) + "\r\n");
+        buff.append("\r\n");
+        buff.append(file_->data, file_->st.st_size);
+        return;
+    }
     int srcFD = open((srcDir_ + path_).data(), O_RDONLY | O_CLOEXEC);
     if(srcFD == -1) {
         ErrorContent(buff, "File Not Found!");
@@ -147,6 +214,7 @@ void HttpResponse::UnmapFile() {
         munmap(mmFile_, mmFileStat_.st_size);
         mmFile_ = nullptr;
     }
+    file_.reset();
 }
 
 std::string HttpResponse::GetFileType_() {
@@ -1,17 +1,20 @@
 #ifndef HTTPRESPONSE_H
 #define HTTPRESPONSE_H
 
+#include <memory>
 #include <unordered_map>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include <string>
+#include <string_view>
 #include <assert.h>
 
 #include "../config/config.h"
 #include "../buffer/buffer.h"
 #include "../log/log.h"
+#include "../timer/clock.h"
 
 /**
  * @brief HTTP响应类，用于处理HTTP响应的构建和管理
@@ -19,16 +22,37 @@
 class HttpResponse {
 public:
     
+    // 不小于该长度的文件用 sendfile 发送响应体，更小的文件拷贝进写缓冲区与响应头一次写出
+    static constexpr off_t SENDFILE_MIN_SIZE = 16 * 1024;
+
+    // 加载好的静态文件：状态码与内容，多个响应共享，最后一个引用释放时 munmap / close
+    struct MappedFile {
+        int code = 404;         // 200 / 403 / 404，判定规则与 MakeResponse 相同
+        struct stat st = {};
+        char* data = nullptr;   // 200 且 0 < 长度 < SENDFILE_MIN_SIZE 时为映射的内容
+        int fd = -1;            // 200 且长度 >= SENDFILE_MIN_SIZE 时为打开的文件，响应体用 sendfile 发送
+        ~MappedFile();
+    };
+
     HttpResponse(); 
     ~HttpResponse();
 
+    // stat + open，小文件 mmap（MAP_POPULATE）、大文件 readahead，读盘在调用线程完成，可在任意线程调用
+    static std::shared_ptr<const MappedFile> LoadFile(const std::string& file);
+    // 使用预先加载的文件（Init 之后、MakeResponse 之前调用），MakeResponse 不再自己 stat/mmap
+    void SetFile(std::shared_ptr<const MappedFile> file) { file_ = std::move(file); }
+
     void Init(const std::string& srcDir, std::string& path, bool isKeepAlive = false, int code = -1);
     void MakeResponse(Buffer& buff);
     void UnmapFile(); // 解除文件的内存映射（释放 mmap 资源）
     char* GetFile();
     size_t FileLen() const;
+    // MakeResponse 之后：响应体需要调用方用 sendfile 发送时返回文件描述符（写缓冲区中只有响应头），否则返回 -1
+    int SendfileFd() const;
     void ErrorContent(Buffer& buff, std::string message);
     int Code() const {return code_;};
+    // 追加一个响应头（如 Set-Cookie），在 Init 之后、MakeResponse 之前调用
+    void AddHeader(std::string_view key, std::string_view value);
 
 
 private:
@@ -44,11 +68,13 @@ private:
 
     int code_; // HTTP 响应状态码（如 200、404、500）
     bool isKeepAlive_;
+    std::string extraHeaders_; // AddHeader 追加的响应头，已按 "key: value\r\n" 拼好
     std::string path_; // 请求的文件路径
     std::string srcDir_; // 网站根目录
     // mmap() 函数的作用是把磁盘文件直接映射到进程的虚拟内存空间，从而实现文件的高效读写
     char* mmFile_; // 内存映射的文件指针
     struct stat mmFileStat_; // 文件状态结构体（存储文件大小、类型等信息，通过 stat 函数获取）
+    std::shared_ptr<const MappedFile> file_; // SetFile 设置的共享文件，为空时由 MakeResponse 自己加载
     // 静态常量：文件后缀与 Content-Type 的映射（如 .html → text/html）
     static const std::unordered_map<std::string, std::string> SUFFIX_TYPE;
     // 静态常量：HTTP 状态码与状态描述的映射（如 200 → OK）
@@ -3,6 +3,7 @@
 #include "../buffer/buffer.h"
 #include <iostream>
 #include <cassert>
+#include <vector>
 
 void testBasicRequest() {
     LOG_INFO("=== Test 1: Basic GET Request ===");
@@ -305,6 +306,63 @@ void testKeepAlive() {
     LOG_INFO("✓ Test 10 passed!");
 }
 
+void testAsyncAuth() {
+    LOG_INFO("=== Test 13: Deferred User Verify ===");
+    Buffer buff;
+    HttpRequest request;
+    request.SetAsyncAuth(true);
+
+    // 用户名格式非法：解析时直接得出结果，不进入异步鉴权
+    std::string rawRequest = "POST /login.html HTTP/1.1\r\nHost: localhost:8080\r\nContent-Type: application/x-www-form-urlencoded\r\nContent-Length: 32\r\n\r\nusername=bad%21user&password=abc";
+    buff.append(rawRequest.c_str(), rawRequest.size());
+
+    bool result = request.parse(buff);
+    assert(result == true);
+    assert(request.AuthPending() == false);
+    assert(request.path() == "/error.html");
+
+    // 格式合法的账号：解析时不做鉴权，路径保持不变
+    Buffer buff2;
+    HttpRequest deferred;
+    deferred.SetAsyncAuth(true);
+    rawRequest = "POST /login.html HTTP/1.1\r\nHost: localhost:8080\r\nContent-Type: application/x-www-form-urlencoded\r\nContent-Length: 33\r\n\r\nusername=ghost_user&password=abc1";
+    buff2.append(rawRequest.c_str(), rawRequest.size());
+    result = deferred.parse(buff2);
+    assert(result == true);
+    assert(deferred.AuthPending() == true);
+    assert(deferred.path() == "/login.html");
+
+    // 任务在 DB 通道执行；这里不访问数据库，直接写回失败结果
+    auto task = deferred.TakeAuthTask();
+    assert(task);
+    deferred.OnAuthDone(false);
+    assert(deferred.AuthPending() == false);
+    assert(deferred.path() == "/error.html");
+    LOG_INFO("✓ Test 13 passed!");
+}
+
+void testRequestLane() {
+    LOG_INFO("=== Test 14: Request Lane Classification ===");
+    HttpRequest request;
+    request.SetAsyncAuth(true);
+    struct Case { std::string raw; RequestLane lane; };
+    std::vector<Case> cases = {
+        {"GET /index.html HTTP/1.1\r\nHost: localhost\r\n\r\n", RequestLane::STATIC},
+        {"GET /login.html HTTP/1.1\r\nHost: localhost\r\n\r\n", RequestLane::STATIC},
+        {"POST /login.html HTTP/1.1\r\nContent-Type: application/x-www-form-urlencoded\r\n\r\nusername=a&password=b", RequestLane::DB},
+        {"POST /register.html HTTP/1.1\r\nContent-Type: application/x-www-form-urlencoded\r\n\r\nusername=a&password=b", RequestLane::DB},
+        {"GET /admin/stats HTTP/1.1\r\nHost: localhost\r\n\r\n", RequestLane::ADMIN},
+    };
+    for(auto& c : cases) {
+        Buffer buff;
+        request.init();
+        buff.append(c.raw);
+        assert(request.parse(buff));
+        assert(request.Lane() == c.lane);
+    }
+    LOG_INFO("✓ Test 14 passed!");
+}
+
 int main() {
     // Initialize database connection pool
     Logger::getInstance().initLogger("log/httprequest.log",LogLevel::INFO,1024,3);
@@ -325,6 +383,8 @@ int main() {
         testEmptyBody();
         testInvalidRequest();
         testKeepAlive();
+        testAsyncAuth();
+        testRequestLane();
 
         LOG_INFO("================================");
         LOG_INFO("All tests passed successfully! ✓");
@@ -5,6 +5,8 @@
 #include <cassert>
 #include <fstream>
 #include <filesystem>
+#include <ctime>
+#include <cmath>
 
 // 辅助函数：创建测试文件
 void createTestFile(const std::string& path, const std::string& content) {
@@ -65,6 +67,15 @@ void testBasicHtmlResponse() {
     assert(responseStr.find("Index Page") != std::string::npos);
     // 检查Content-Length
     assert(responseStr.find("Content-Length:") != std::string::npos);
+    // 检查Date头：RFC 7231 IMF-fixdate，如 "Date: Sun, 06 Nov 1994 08:49:37 GMT"
+    size_t datePos = responseStr.find("\r\nDate: ");
+    assert(datePos != std::string::npos);
+    std::string date = responseStr.substr(datePos + 8, responseStr.find("\r\n", datePos + 2) - datePos - 8);
+    assert(date.size() == WallClock::HTTP_DATE_LEN);
+    assert(date[3] == ',' and date.substr(date.size() - 4) == " GMT");
+    std::tm tm{};
+    assert(strptime(date.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm) != nullptr);
+    assert(std::abs(timegm(&tm) - std::time(nullptr)) <= 2);
 
     LOG_INFO("✓ Test 1 passed!");
     cleanupTestResources(testDir);
@@ -438,6 +449,79 @@ void testNoExtensionFile() {
     cleanupTestResources(testDir);
 }
 
+// 测试13: 共享的文件映射，多个响应复用同一次 LoadFile 的结果
+void testSharedMappedFile() {
+    LOG_INFO("=== Test 13: Shared Mapped File ===");
+    std::string testDir = "test_resources";
+    setupTestResources(testDir);
+
+    std::shared_ptr<const HttpResponse::MappedFile> file = HttpResponse::LoadFile(testDir + "/test.html");
+    assert(file and file->code == 200 and file->data != nullptr);
+    assert(HttpResponse::LoadFile(testDir + "/nonexistent.html")->code == 404);
+
+    for(int i = 0; i < 2; i++) {
+        HttpResponse response;
+        Buffer buff;
+        std::string path = "/test.html";
+        response.Init(testDir, path, false, -1);
+        response.SetFile(file);
+        response.MakeResponse(buff);
+        std::string responseStr(buff.peek(), buff.readable_size());
+        assert(responseStr.find("HTTP/1.1 200 OK") != std::string::npos);
+        assert(responseStr.find("Test Page") != std::string::npos);
+        response.UnmapFile(); // 只释放本响应的引用
+    }
+    assert(file.use_count() == 1 and file->data != nullptr);
+
+    LOG_INFO("✓ Test 13 passed!");
+    cleanupTestResources(testDir);
+}
+
+// 测试14: 大文件不拷贝进写缓冲区，响应头之后由调用方用 sendfile 发送
+void testSendfileBody() {
+    LOG_INFO("=== Test 14: Sendfile Body For Large Files ===");
+    std::string testDir = "test_resources";
+    setupTestResources(testDir);
+    const std::string big(HttpResponse::SENDFILE_MIN_SIZE + 1000, 'x');
+    createTestFile(testDir + "/big.txt", big);
+
+    std::shared_ptr<const HttpResponse::MappedFile> file = HttpResponse::LoadFile(testDir + "/big.txt");
+    assert(file->code == 200 and file->fd >= 0 and file->data == nullptr);
+    HttpResponse response;
+    Buffer buff;
+    std::string path = "/big.txt";
+    response.Init(testDir, path, true, -1);
+    response.SetFile(file);
+    response.MakeResponse(buff);
+    std::string headers(buff.peek(), buff.readable_size());
+    assert(headers.find("Content-Length: " + std::to_string(big.size()) + "\r\n\r\n") != std::string::npos);
+    assert(headers.size() < 1024); // 只有响应头
+    assert(response.SendfileFd() == file->fd and response.FileLen() == big.size());
+    response.UnmapFile();
+
+    // 小文件仍拷贝进写缓冲区
+    HttpResponse small;
+    Buffer smallBuff;
+    path = "/test.html";
+    small.Init(testDir, path, false, -1);
+    small.SetFile(HttpResponse::LoadFile(testDir + "/test.html"));
+    small.MakeResponse(smallBuff);
+    assert(small.SendfileFd() == -1);
+    assert(std::string(smallBuff.peek(), smallBuff.readable_size()).find("Test Page") != std::string::npos);
+
+    // 错误页面不走 sendfile
+    HttpResponse missing;
+    Buffer missingBuff;
+    path = "/nonexistent.txt";
+    missing.Init(testDir, path, false, -1);
+    missing.SetFile(HttpResponse::LoadFile(testDir + "/nonexistent.txt"));
+    missing.MakeResponse(missingBuff);
+    assert(missing.Code() == 404 and missing.SendfileFd() == -1);
+
+    LOG_INFO("✓ Test 14 passed!");
+    cleanupTestResources(testDir);
+}
+
 int main() {
     // 初始化日志系统
     Logger::getInstance().initLogger("log/httpresponse.log", LogLevel::INFO, 1024, 3);
@@ -458,6 +542,8 @@ int main() {
         testCodeGetter();
         testReinitResponse();
         testNoExtensionFile();
+        testSharedMappedFile();
+        testSendfileBody();
 
         LOG_INFO("================================");
         LOG_INFO("All tests passed successfully! ✓");
@@ -0,0 +1,436 @@
+#include "accesslog.h"
+
+#include <ctime>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <charconv>
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#include <sys/uio.h>
+#include <sys/stat.h>
+
+namespace {
+
+constexpr char ACCESS_MAGIC[8] = {'W', 'S', 'A', 'C', 'C', 'E', 'S', '1'};
+constexpr size_t FILE_HEADER_SIZE = sizeof(ACCESS_MAGIC) + sizeof(uint32_t);
+
+// 下标即 AccessRecord::method
+constexpr const char* METHOD_NAMES[] = {"-", "GET", "POST", "HEAD", "PUT", "DELETE", "OPTIONS", "PATCH", "OTHER"};
+constexpr uint8_t METHOD_OTHER = 8;
+
+// 写线程按秒缓存时间部分，同一秒内的记录只做一次 localtime
+struct TimeCache {
+    time_t sec = -1;
+    char clf[32];   // 18/Oct/2026:14:03:05 +0800
+    char iso[32];   // 2026-10-18T14:03:05
+    char zone[8];   // +0800
+    size_t clfLen = 0;
+    size_t zoneLen = 0;
+};
+
+// 以下 Put* 直接写入 p 并返回写入后的位置，调用方保证空间足够（见 MAX_LINE）
+char* PutStr(char* p, std::string_view s) {
+    std::memcpy(p, s.data(), s.size());
+    return p + s.size();
+}
+
+// 按固定宽度写入十进制数，不足补 0
+char* PutFixed(char* p, int v, int width) {
+    for(int i = width - 1; i >= 0; i--, v /= 10) p[i] = static_cast<char>('0' + v % 10);
+    return p + width;
+}
+
+char* PutNumber(char* p, uint32_t v) {
+    return std::to_chars(p, p + 10, v).ptr;
+}
+
+const TimeCache& CachedTime(uint64_t timeNs) {
+    thread_local TimeCache cache;
+    time_t sec = static_cast<time_t>(timeNs / 1000000000);
+    if(sec != cache.sec) {
+        std::tm tm;
+        localtime_r(&sec, &tm);
+        // 月份名固定为英文，不受 locale 影响
+        static const char* MONTHS[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                       "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+        cache.zoneLen = std::strftime(cache.zone, sizeof(cache.zone), "%z", &tm);
+        // 逐字段按固定宽度写入："dd/Mon/yyyy:hh:mm:ss " 共 21 字节，加时区不超过 sizeof(clf)
+        char* p = cache.clf;
+        p = PutFixed(p, tm.tm_mday, 2);
+        *p++ = '/';
+        p = PutStr(p, MONTHS[tm.tm_mon]);
+        *p++ = '/';
+        p = PutFixed(p, tm.tm_year + 1900, 4);
+        *p++ = ':';
+        p = PutFixed(p, tm.tm_hour, 2);
+        *p++ = ':';
+        p = PutFixed(p, tm.tm_min, 2);
+        *p++ = ':';
+        p = PutFixed(p, tm.tm_sec, 2);
+        *p++ = ' ';
+        p = PutStr(p, std::string_view(cache.zone, cache.zoneLen));
+        cache.clfLen = p - cache.clf;
+        std::strftime(cache.iso, sizeof(cache.iso), "%Y-%m-%dT%H:%M:%S", &tm);
+        cache.sec = sec;
+    }
+    return cache;
+}
+
+const char* MethodName(uint8_t method) {
+    return method <= METHOD_OTHER ? METHOD_NAMES[method] : "-";
+}
+
+// ip 为网络字节序
+char* PutIp(char* p, uint32_t ip) {
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(&ip);
+    for(int i = 0; i < 4; i++) {
+        if(i > 0) *p++ = '.';
+        p = PutNumber(p, b[i]);
+    }
+    return p;
+}
+
+char* PutProtocol(char* p, uint8_t version) {
+    if(version == 0) return PutStr(p, "HTTP/-");
+    p = PutStr(p, "HTTP/");
+    *p++ = static_cast<char>('0' + version / 10 % 10);
+    *p++ = '.';
+    *p++ = static_cast<char>('0' + version % 10);
+    return p;
+}
+
+const char HEX[] = "0123456789abcdef";
+
+// CLF 与 Apache 一致：引号、反斜杠与不可打印字符转义为 \xhh
+char* PutClfEscaped(char* p, std::string_view s) {
+    for(unsigned char c : s) {
+        if(c < 0x20 or c >= 0x7f or c == '"' or c == '\\') {
+            *p++ = '\\';
+            *p++ = 'x';
+            *p++ = HEX[c >> 4];
+            *p++ = HEX[c & 0xf];
+        } else {
+            *p++ = static_cast<char>(c);
+        }
+    }
+    return p;
+}
+
+// 非 ASCII 字节也转义为 \u00hh：路径可能在多字节字符中间被截断，保证输出始终是合法 JSON
+char* PutJsonEscaped(char* p, std::string_view s) {
+    for(unsigned char c : s) {
+        if(c == '"' or c == '\\') {
+            *p++ = '\\';
+            *p++ = static_cast<char>(c);
+        } else if(c < 0x20 or c >= 0x7f) {
+            p = PutStr(p, "\\u00");
+            *p++ = HEX[c >> 4];
+            *p++ = HEX[c & 0xf];
+        } else {
+            *p++ = static_cast<char>(c);
+        }
+    }
+    return p;
+}
+
+// 一行的最大长度：路径每字节最多转义为 6 个字符，其余字段合计不超过 200 字节
+constexpr size_t MAX_LINE = AccessRecord::PATH_CAP * 6 + 200;
+// 文本格式每次写入的大小
+constexpr size_t TEXT_CHUNK = 256 * 1024;
+
+// 写出 iov 中的全部数据，每次最多 IOV_MAX 段，处理部分写入；磁盘错误时丢弃，避免写线程卡死
+void WriteAll(int fd, struct iovec* iov, size_t count) {
+    for(size_t begin = 0; begin < count; begin += IOV_MAX) {
+        struct iovec* cur = iov + begin;
+        int left = static_cast<int>(std::min<size_t>(IOV_MAX, count - begin));
+        while(left > 0) {
+            ssize_t n = ::writev(fd, cur, left);
+            if(n < 0) {
+                if(errno == EINTR) continue;
+                return;
+            }
+            while(left > 0 and static_cast<size_t>(n) >= cur->iov_len) {
+                n -= cur->iov_len;
+                cur++;
+                left--;
+            }
+            if(left > 0) {
+                cur->iov_base = static_cast<char*>(cur->iov_base) + n;
+                cur->iov_len -= n;
+            }
+        }
+    }
+}
+
+char* FormatLine(const AccessRecord& rec, AccessLogFormat format, char* p) {
+    const TimeCache& t = CachedTime(rec.timeNs);
+    std::string_view path(rec.path, std::min<size_t>(rec.pathLen, AccessRecord::PATH_CAP));
+    if(format == AccessLogFormat::JSON) {
+        int millis = static_cast<int>(rec.timeNs / 1000000 % 1000);
+        p = PutStr(p, "{\"time\":\"");
+        p = PutStr(p, std::string_view(t.iso, 19));
+        *p++ = '.';
+        p = PutFixed(p, millis, 3);
+        p = PutStr(p, std::string_view(t.zone, t.zoneLen));
+        p = PutStr(p, "\",\"remote\":\"");
+        p = PutIp(p, rec.clientIp);
+        p = PutStr(p, "\",\"method\":\"");
+        p = PutStr(p, MethodName(rec.method));
+        p = PutStr(p, "\",\"path\":\"");
+        p = PutJsonEscaped(p, path);
+        p = PutStr(p, "\",\"protocol\":\"");
+        p = PutProtocol(p, rec.version);
+        p = PutStr(p, "\",\"status\":");
+        p = PutNumber(p, rec.status);
+        p = PutStr(p, ",\"bytes\":");
+        p = PutNumber(p, rec.bytes);
+        p = PutStr(p, ",\"latency_us\":");
+        p = PutNumber(p, rec.latencyUs);
+        return PutStr(p, "}\n");
+    }
+    p = PutIp(p, rec.clientIp);
+    p = PutStr(p, " - - [");
+    p = PutStr(p, std::string_view(t.clf, t.clfLen));
+    p = PutStr(p, "] \"");
+    p = PutStr(p, MethodName(rec.method));
+    *p++ = ' ';
+    if(path.empty()) *p++ = '-';
+    else p = PutClfEscaped(p, path);
+    *p++ = ' ';
+    p = PutProtocol(p, rec.version);
+    p = PutStr(p, "\" ");
+    p = PutNumber(p, rec.status);
+    *p++ = ' ';
+    // CLF 中响应字节数为 0 时记为 "-"
+    if(rec.bytes > 0) p = PutNumber(p, rec.bytes);
+    else *p++ = '-';
+    *p++ = '\n';
+    return p;
+}
+
+} // namespace
+
+void AccessRecord::SetMethod(std::string_view m) {
+    method = 0;
+    if(m.empty()) return;
+    for(uint8_t i = 1; i < METHOD_OTHER; i++) {
+        if(m == METHOD_NAMES[i]) {
+            method = i;
+            return;
+        }
+    }
+    method = METHOD_OTHER;
+}
+
+void AccessRecord::SetVersion(std::string_view v) {
+    version = 0;
+    if(v.size() == 3 and v[1] == '.' and v[0] >= '0' and v[0] <= '9' and v[2] >= '0' and v[2] <= '9') {
+        version = static_cast<uint8_t>((v[0] - '0') * 10 + (v[2] - '0'));
+    }
+}
+
+void AccessRecord::SetPath(std::string_view p) {
+    pathLen = static_cast<uint8_t>(std::min(p.size(), PATH_CAP));
+    std::memcpy(path, p.data(), pathLen);
+}
+
+struct AccessLog::BatchHolder {
+    std::unique_ptr<Batch> batch;
+    ~BatchHolder() {
+        // Reactor 之外的线程退出时交出剩余记录；写线程已停止时直接丢弃
+        if(batch and batch->count > 0 and AccessLog::Enabled()) AccessLog::getInstance().hand_off(batch);
+    }
+};
+
+AccessLog& AccessLog::getInstance() {
+    static AccessLog instance;
+    return instance;
+}
+
+AccessLog::~AccessLog() {
+    Shutdown();
+}
+
+std::unique_ptr<AccessLog::Batch>& AccessLog::thread_batch() {
+    thread_local BatchHolder holder;
+    return holder.batch;
+}
+
+bool AccessLog::Init(const std::string& file, AccessLogFormat format, int queue_batches) {
+    if(Enabled()) return true;
+    if(fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    size_t slash = file.find_last_of('/');
+    if(slash != std::string::npos) mkdir(file.substr(0, slash).c_str(), 0755);
+    fd_ = open(file.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(fd_ < 0) return false;
+    format_ = format;
+    if(format_ == AccessLogFormat::BINARY) {
+        struct stat st;
+        if(fstat(fd_, &st) == 0 and st.st_size == 0) {
+            char header[FILE_HEADER_SIZE];
+            uint32_t recSize = sizeof(AccessRecord);
+            std::memcpy(header, ACCESS_MAGIC, sizeof(ACCESS_MAGIC));
+            std::memcpy(header + sizeof(ACCESS_MAGIC), &recSize, sizeof(recSize));
+            if(::write(fd_, header, sizeof(header)) != static_cast<ssize_t>(sizeof(header))) {
+                close(fd_);
+                fd_ = -1;
+                return false;
+            }
+        }
+    }
+    // 上一次运行留下的队列此时已被写线程取空，可以安全替换
+    queue_ = std::make_unique<MpscRing<std::unique_ptr<Batch>>>(std::max(queue_batches, 2));
+    dropped_.store(0, std::memory_order_relaxed);
+    enabled_.store(true, std::memory_order_release);
+    writer_ = std::thread(&AccessLog::writer_thread, this);
+    return true;
+}
+
+void AccessLog::Shutdown() {
+    if(!enabled_.exchange(false)) return;
+    // 写线程看到 enabled_ 为 false 后取空队列再退出
+    {
+        std::lock_guard<std::mutex> locker(wake_mtx_);
+        wake_cond_.notify_one();
+    }
+    if(writer_.joinable()) writer_.join();
+    FlushThread(); // 调用线程自己的残留批次（测试与非 Reactor 线程）
+    if(fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+std::unique_ptr<AccessLog::Batch> AccessLog::take_batch() {
+    {
+        std::lock_guard<std::mutex> locker(free_mtx_);
+        if(!free_batches_.empty()) {
+            std::unique_ptr<Batch> batch = std::move(free_batches_.back());
+            free_batches_.pop_back();
+            return batch;
+        }
+    }
+    return std::make_unique<Batch>();
+}
+
+void AccessLog::Record(const AccessRecord& rec) {
+    std::unique_ptr<Batch>& batch = thread_batch();
+    if(!batch) batch = take_batch();
+    batch->records[batch->count++] = rec;
+    if(batch->count == BATCH_RECORDS) hand_off(batch);
+}
+
+void AccessLog::FlushThread() {
+    std::unique_ptr<Batch>& batch = thread_batch();
+    if(!batch or batch->count == 0) return;
+    if(Enabled()) {
+        hand_off(batch);
+    } else if(fd_ >= 0 and writer_.get_id() == std::thread::id()) {
+        // 写线程已停止（Shutdown 中）：由调用线程直接写出
+        queue_->try_push(std::move(batch));
+        write_batches();
+    }
+}
+
+void AccessLog::hand_off(std::unique_ptr<Batch>& batch) {
+    if(!queue_->try_push(std::move(batch))) {
+        dropped_.fetch_add(batch->count, std::memory_order_relaxed);
+        batch->count = 0; // 复用这一批
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(writer_sleeping_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> locker(wake_mtx_);
+        wake_cond_.notify_one();
+    }
+}
+
+void AccessLog::write_batches() {
+    std::vector<std::unique_ptr<Batch>> batches;
+    queue_->drain([&batches](std::unique_ptr<Batch>& b) { batches.push_back(std::move(b)); }, SIZE_MAX);
+    if(batches.empty()) return;
+
+    if(format_ == AccessLogFormat::BINARY) {
+        std::vector<struct iovec> iov;
+        for(auto& b : batches) iov.push_back({b->records, b->count * sizeof(AccessRecord)});
+        WriteAll(fd_, iov.data(), iov.size());
+    } else {
+        // 格式化进复用的缓冲区，每攒够 TEXT_CHUNK 字节写一次：缓冲区常驻缓存，不随积压量增长、不再缺页
+        if(text_.capacity() < TEXT_CHUNK + MAX_LINE) text_.reserve(TEXT_CHUNK + MAX_LINE);
+        for(auto& b : batches) {
+            for(uint32_t i = 0; i < b->count; i++) {
+                Format(b->records[i], format_, text_);
+                if(text_.size() >= TEXT_CHUNK) {
+                    struct iovec iov = {text_.data(), text_.size()};
+                    WriteAll(fd_, &iov, 1);
+                    text_.clear();
+                }
+            }
+        }
+        if(!text_.empty()) {
+            struct iovec iov = {text_.data(), text_.size()};
+            WriteAll(fd_, &iov, 1);
+            text_.clear();
+        }
+    }
+    recycle(batches);
+}
+
+void AccessLog::recycle(std::vector<std::unique_ptr<Batch>>& batches) {
+    std::lock_guard<std::mutex> locker(free_mtx_);
+    for(auto& b : batches) {
+        if(free_batches_.size() >= MAX_FREE_BATCHES) break;
+        b->count = 0;
+        free_batches_.push_back(std::move(b));
+    }
+}
+
+void AccessLog::writer_thread() {
+    while(true) {
+        write_batches();
+        if(!Enabled()) {
+            write_batches(); // 停止前最后一次取空
+            break;
+        }
+        std::unique_lock<std::mutex> locker(wake_mtx_);
+        writer_sleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(queue_->empty() and Enabled()) {
+            wake_cond_.wait_for(locker, std::chrono::milliseconds(FLUSH_INTERVAL_MS));
+        }
+        writer_sleeping_.store(false, std::memory_order_relaxed);
+    }
+}
+
+void AccessLog::Format(const AccessRecord& rec, AccessLogFormat format, std::string& out) {
+    // 按最大行长扩展后直接写入，再截到实际长度，省去逐字符追加时的容量检查
+    const size_t old = out.size();
+    out.resize_and_overwrite(old + MAX_LINE, [&rec, format, old](char* buf, size_t) {
+        return static_cast<size_t>(FormatLine(rec, format, buf + old) - buf);
+    });
+}
+
+size_t AccessLog::Decode(const char* data, size_t len, AccessLogFormat format, std::ostream& out) {
+    if(len < FILE_HEADER_SIZE or std::memcmp(data, ACCESS_MAGIC, sizeof(ACCESS_MAGIC)) != 0) return 0;
+    uint32_t recSize;
+    std::memcpy(&recSize, data + sizeof(ACCESS_MAGIC), sizeof(recSize));
+    if(recSize != sizeof(AccessRecord)) return 0;
+    size_t n = 0;
+    std::string line;
+    // 文件尾部被截断的记录忽略
+    for(const char* p = data + FILE_HEADER_SIZE; p + recSize <= data + len; p += recSize, n++) {
+        AccessRecord rec;
+        std::memcpy(&rec, p, recSize);
+        line.clear();
+        Format(rec, format == AccessLogFormat::BINARY ? AccessLogFormat::CLF : format, line);
+        out << line;
+    }
+    return n;
+}
@@ -0,0 +1,119 @@
+#ifndef ACCESSLOG_H
+#define ACCESSLOG_H
+/*
+    访问日志，与运行日志（Logger）分开：每个请求一条定长记录，格式化推迟到写线程。
+    - Reactor 线程处理完请求后把 AccessRecord（128 字节，可平凡拷贝）拷贝进本线程的批次，
+      热路径没有格式化、没有锁，也不分配内存（写完的批次回收复用）；
+    - 批次写满 BATCH_RECORDS 条时经无锁环形队列整批交给写线程，未写满的批次由
+      Reactor 的定时器每 FLUSH_INTERVAL_MS 交出一次；
+    - 写线程把收到的批次格式化为 CLF / JSON 行，攒满一块写一次（二进制格式直接 writev 原始记录）；
+    - 队列满时丢弃整批并计数，访问日志永远不会拖慢 Reactor。
+
+    二进制文件格式：8 字节魔数 + u32 记录大小，之后是连续的 AccessRecord（本机字节序），
+    用 logdecode --access <文件> [clf|json] 还原为文本。
+*/
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+#include <condition_variable>
+
+#include "mpscring.h"
+
+enum class AccessLogFormat {
+    CLF = 0,    // Common Log Format：host - - [time] "method path protocol" status bytes
+    JSON = 1,   // 每行一个 JSON 对象，额外包含处理耗时
+    BINARY = 2  // 原始定长记录
+};
+
+// 一条访问记录。路径超过 PATH_CAP 的部分被截断
+struct AccessRecord {
+    static constexpr size_t PATH_CAP = 103;
+
+    uint64_t timeNs = 0;    // 读完请求时的墙上时间（ns）
+    uint32_t latencyUs = 0; // 读完请求到写完响应的耗时
+    uint32_t bytes = 0;     // 响应字节数（含响应头），超过 4GiB 时记为 UINT32_MAX
+    uint32_t clientIp = 0;  // 网络字节序
+    uint16_t status = 0;
+    uint8_t method = 0;     // GET / POST 等的编号（SetMethod 设置），0 表示请求行无法解析
+    uint8_t version = 0;    // HTTP 版本 * 10，如 11 表示 HTTP/1.1，0 表示未知
+    uint8_t pathLen = 0;
+    char path[PATH_CAP];
+
+    void SetMethod(std::string_view m);
+    void SetVersion(std::string_view v); // 形如 "1.1"
+    void SetPath(std::string_view p);
+};
+static_assert(sizeof(AccessRecord) == 128, "AccessRecord should stay two cache lines");
+
+class AccessLog {
+public:
+    // 每批记录数（64KB），写满后整批交给写线程
+    static constexpr size_t BATCH_RECORDS = 512;
+    // Reactor 交出未写满批次的间隔
+    static constexpr int FLUSH_INTERVAL_MS = 1000;
+
+    static AccessLog& getInstance();
+
+    // 打开访问日志文件并启动写线程；queue_batches 为等待写入的批次数上限
+    bool Init(const std::string& file, AccessLogFormat format, int queue_batches = 256);
+    // 写出所有已交出的批次并停止写线程；调用前各 Reactor 应已 FlushThread
+    void Shutdown();
+    static bool Enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // 以下两个接口在 Reactor 线程调用
+    // 追加一条记录到本线程批次，批次满时交给写线程
+    void Record(const AccessRecord& rec);
+    // 交出本线程未写满的批次
+    void FlushThread();
+
+    // 因队列满被丢弃的记录数
+    uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // 把一条记录渲染为一行文本（含换行）追加到 out；BINARY 按 CLF 渲染
+    static void Format(const AccessRecord& rec, AccessLogFormat format, std::string& out);
+    // 把二进制访问日志渲染为文本，返回记录条数；文件头不符时返回 0
+    static size_t Decode(const char* data, size_t len, AccessLogFormat format, std::ostream& out);
+
+private:
+    struct Batch {
+        uint32_t count = 0;
+        AccessRecord records[BATCH_RECORDS];
+    };
+    struct BatchHolder; // thread_local 持有者，线程退出时交出剩余记录
+
+    AccessLog() = default;
+    ~AccessLog();
+    AccessLog(const AccessLog&) = delete;
+    AccessLog& operator=(const AccessLog&) = delete;
+
+    static std::unique_ptr<Batch>& thread_batch();
+    std::unique_ptr<Batch> take_batch(); // 优先复用写完的批次，避免每批都分配并缺页
+    void recycle(std::vector<std::unique_ptr<Batch>>& batches);
+    void hand_off(std::unique_ptr<Batch>& batch); // 入队，队列满时丢弃
+    void writer_thread();
+    void write_batches(); // 写线程：取出队列中所有批次，格式化后分块写入（二进制格式一次 writev）
+
+    static inline std::atomic<bool> enabled_{false};
+    AccessLogFormat format_ = AccessLogFormat::CLF;
+    int fd_ = -1;
+    std::unique_ptr<MpscRing<std::unique_ptr<Batch>>> queue_;
+    std::atomic<uint64_t> dropped_{0};
+    // 写线程在队列为空时休眠，生产者看到 writer_sleeping_ 才去加锁通知
+    std::atomic<bool> writer_sleeping_{false};
+    std::mutex wake_mtx_;
+    std::condition_variable wake_cond_;
+    std::thread writer_;
+    std::string text_; // 写线程格式化文本的缓冲区，跨批次复用
+    // 写完的批次，Reactor 交出一批后从这里取下一批；每 BATCH_RECORDS 条请求才加一次锁
+    static constexpr size_t MAX_FREE_BATCHES = 64;
+    std::mutex free_mtx_;
+    std::vector<std::unique_ptr<Batch>> free_batches_;
+};
+
+#endif /* ACCESSLOG_H */
@@ -0,0 +1,214 @@
+#include "binlog.h"
+
+#include <ctime>
+#include <vector>
+#include <variant>
+#include <unordered_map>
+
+namespace binlog {
+
+namespace {
+
+// 顺序读取记录字段，越界时 ok 置为 false
+struct Reader {
+    const char* p;
+    const char* end;
+    bool ok = true;
+
+    template<class T>
+    T Get() {
+        T v{};
+        if(end - p < static_cast<ptrdiff_t>(sizeof(T))) {
+            ok = false;
+            return v;
+        }
+        std::memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+    std::string_view Bytes(size_t n) {
+        if(static_cast<size_t>(end - p) < n) {
+            ok = false;
+            return {};
+        }
+        std::string_view v(p, n);
+        p += n;
+        return v;
+    }
+};
+
+struct SiteInfo {
+    int level = 0;
+    std::string_view fmt;
+    std::string_view schema;
+};
+
+struct Session {
+    uint64_t wallNs = 0;
+    uint64_t steadyNs = 0;
+    std::unordered_map<uint32_t, SiteInfo> sites;
+};
+
+using Arg = std::variant<bool, char, int64_t, uint64_t, double, const void*, std::string_view>;
+
+const char* LevelName(int level) {
+    static const char* NAMES[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+    return (level >= 0 and level < 4) ? NAMES[level] : "UNKNOWN";
+}
+
+// 与 Logger::get_timestamp 相同的格式：YYYY-MM-DD HH:MM:SS.mmm
+std::string FormatTime(uint64_t wallNs) {
+    time_t sec = static_cast<time_t>(wallNs / 1000000000);
+    int millis = static_cast<int>(wallNs / 1000000 % 1000);
+    std::tm tm;
+    localtime_r(&sec, &tm);
+    char buf[32];
+    size_t n = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    std::snprintf(buf + n, sizeof(buf) - n, ".%03d", millis);
+    return buf;
+}
+
+std::string FormatArg(const Arg& arg, std::string_view spec) {
+    return std::visit([spec](auto v) -> std::string {
+        std::string f = "{:" + std::string(spec) + "}";
+        try {
+            return std::vformat(f, std::make_format_args(v));
+        } catch(const std::exception&) {
+            return std::vformat("{}", std::make_format_args(v)); // 格式说明与类型不符时退回默认格式
+        }
+    }, arg);
+}
+
+// 按 std::format 的替换字段语法渲染：支持 {}、{n}、{:spec}、{n:spec} 与 {{ }} 转义
+std::string Render(std::string_view fmt, const std::vector<Arg>& args) {
+    std::string out;
+    size_t next = 0;
+    for(size_t i = 0; i < fmt.size();) {
+        char c = fmt[i];
+        if(c == '{' and i + 1 < fmt.size() and fmt[i + 1] == '{') {
+            out += '{';
+            i += 2;
+        } else if(c == '}' and i + 1 < fmt.size() and fmt[i + 1] == '}') {
+            out += '}';
+            i += 2;
+        } else if(c == '{') {
+            size_t close = fmt.find('}', i);
+            if(close == std::string_view::npos) {
+                out.append(fmt.substr(i));
+                break;
+            }
+            std::string_view field = fmt.substr(i + 1, close - i - 1);
+            size_t colon = field.find(':');
+            std::string_view index = field.substr(0, colon);
+            std::string_view spec = colon == std::string_view::npos ? std::string_view() : field.substr(colon + 1);
+            size_t idx = next++;
+            if(!index.empty()) {
+                idx = 0;
+                for(char d : index) idx = idx * 10 + (d - '0');
+            }
+            if(idx < args.size()) out += FormatArg(args[idx], spec);
+            else out += "{?}";
+            i = close + 1;
+        } else {
+            out += c;
+            i++;
+        }
+    }
+    return out;
+}
+
+bool DecodeArgs(std::string_view schema, Reader& r, std::vector<Arg>& args) {
+    args.clear();
+    for(char tag : schema) {
+        switch(tag) {
+            case ARG_BOOL: args.emplace_back(r.Get<char>() != 0); break;
+            case ARG_CHAR: args.emplace_back(r.Get<char>()); break;
+            case ARG_INT: args.emplace_back(r.Get<int64_t>()); break;
+            case ARG_UINT: args.emplace_back(r.Get<uint64_t>()); break;
+            case ARG_DOUBLE: args.emplace_back(r.Get<double>()); break;
+            case ARG_POINTER: args.emplace_back(reinterpret_cast<const void*>(r.Get<uint64_t>())); break;
+            case ARG_STRING: {
+                uint32_t len = r.Get<uint32_t>();
+                args.emplace_back(r.Bytes(len));
+                break;
+            }
+            default: return false;
+        }
+    }
+    return r.ok;
+}
+
+// 依次访问每条记录，遇到截断或无法识别的记录时停止
+template<class OnSession, class OnSite, class OnEntry>
+void ForEachRecord(const char* data, size_t len, OnSession onSession, OnSite onSite, OnEntry onEntry) {
+    Reader r{data, data + len};
+    while(r.ok and r.p < r.end) {
+        uint8_t type = r.Get<uint8_t>();
+        if(type == RECORD_SESSION) {
+            std::string_view magic = r.Bytes(sizeof(MAGIC));
+            uint64_t wallNs = r.Get<uint64_t>();
+            uint64_t steadyNs = r.Get<uint64_t>();
+            if(!r.ok or magic != std::string_view(MAGIC, sizeof(MAGIC))) return;
+            onSession(wallNs, steadyNs);
+        } else if(type == RECORD_SITE) {
+            uint32_t id = r.Get<uint32_t>();
+            SiteInfo site;
+            site.level = r.Get<uint8_t>();
+            r.Get<uint32_t>(); // 行号，解码时不需要
+            site.fmt = r.Bytes(r.Get<uint16_t>());
+            r.Bytes(r.Get<uint16_t>()); // 文件名
+            site.schema = r.Bytes(r.Get<uint8_t>());
+            if(!r.ok) return;
+            onSite(id, site);
+        } else if(type == RECORD_ENTRY) {
+            uint32_t id = r.Get<uint32_t>();
+            uint64_t steadyNs = r.Get<uint64_t>();
+            uint32_t payloadLen = r.Get<uint32_t>();
+            std::string_view payload = r.Bytes(payloadLen);
+            if(!r.ok) return;
+            onEntry(id, steadyNs, payload);
+        } else {
+            return;
+        }
+    }
+}
+
+} // namespace
+
+size_t Decode(const char* data, size_t len, std::ostream& out) {
+    // 第一遍：收集每次运行的调用点信息。各线程的缓冲块交错写入，
+    // 调用点记录可能出现在使用它的日志之后，所以需要先扫描一遍
+    std::vector<Session> sessions(1); // 下标 0 用于第一条 SESSION 之前的记录
+    ForEachRecord(data, len,
+        [&](uint64_t wallNs, uint64_t steadyNs) { sessions.push_back({wallNs, steadyNs, {}}); },
+        [&](uint32_t id, const SiteInfo& site) { sessions.back().sites[id] = site; },
+        [](uint32_t, uint64_t, std::string_view) {});
+
+    // 第二遍：渲染日志
+    size_t decoded = 0;
+    size_t cur = 0;
+    std::vector<Arg> args;
+    ForEachRecord(data, len,
+        [&](uint64_t, uint64_t) { cur++; },
+        [](uint32_t, const SiteInfo&) {},
+        [&](uint32_t id, uint64_t steadyNs, std::string_view payload) {
+            const Session& s = sessions[cur];
+            auto it = s.sites.find(id);
+            if(it == s.sites.end()) {
+                out << "[binlog] unknown site id " << id << "\n";
+                return;
+            }
+            Reader r{payload.data(), payload.data() + payload.size()};
+            if(!DecodeArgs(it->second.schema, r, args)) {
+                out << "[binlog] corrupt entry for site id " << id << "\n";
+                return;
+            }
+            uint64_t wallNs = s.wallNs + (steadyNs - s.steadyNs);
+            out << FormatTime(wallNs) << " [" << LevelName(it->second.level) << "] "
+                << Render(it->second.fmt, args) << "\n";
+            decoded++;
+        });
+    return decoded;
+}
+
+} // namespace binlog
@@ -0,0 +1,163 @@
+#ifndef BINLOG_H
+#define BINLOG_H
+/*
+    二进制延迟格式化日志（参考 NanoLog）：
+    - 每个 LOG_* 调用点有一个静态的 LogSite（格式串、级别、文件、行号），首次执行时分配 id，
+      并由参数类型在编译期得到参数模式（每个参数一个类型标记）；
+    - 热路径只写入 id、steady_clock 时间戳与原始参数，不做 std::vformat 与时间格式化；
+    - 离线解码工具 logdecode 按记录中的调用点信息把二进制日志还原为文本格式。
+
+    文件由若干记录顺序组成（本机字节序）：
+    SESSION : u8 类型, 8 字节魔数, u64 墙上时间(ns), u64 steady 时间(ns)
+              每次打开日志文件时写入，同时标志一次进程运行（调用点 id 只在一次运行内有效）
+    SITE    : u8 类型, u32 id, u8 级别, u32 行号, u16 长度+格式串, u16 长度+文件名, u8 参数个数, 参数标记
+    ENTRY   : u8 类型, u32 id, u64 steady 时间(ns), u32 参数字节数, 参数
+    参数编码：bool/char 1 字节；整数、浮点、指针 8 字节；字符串 u32 长度 + 内容。
+    其他可格式化类型在调用时先格式化为字符串。
+*/
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <type_traits>
+#include <format>
+
+namespace binlog {
+
+enum RecordType : uint8_t {
+    RECORD_SESSION = 1,
+    RECORD_SITE = 2,
+    RECORD_ENTRY = 3
+};
+
+enum ArgTag : char {
+    ARG_BOOL = 'b',
+    ARG_CHAR = 'c',
+    ARG_INT = 'i',
+    ARG_UINT = 'u',
+    ARG_DOUBLE = 'd',
+    ARG_POINTER = 'p',
+    ARG_STRING = 's'
+};
+
+inline constexpr char MAGIC[8] = {'W', 'S', 'B', 'L', 'O', 'G', '1', '\0'};
+
+// 日志调用点，以常量初始化的静态对象存在于每个 LOG_* 宏展开处
+struct LogSite {
+    constexpr LogSite(int lvl, const char* f, const char* fl, int ln)
+        : level(lvl), fmt(f), file(fl), line(ln) {}
+
+    const int level;
+    const char* const fmt;
+    const char* const file;
+    const int line;
+    std::atomic<uint32_t> id{0}; // 0 表示尚未注册
+    const char* schema = nullptr; // 参数类型标记，注册时写入
+};
+
+// 参数在二进制记录中的表示：基本类型原样保存，字符串保存视图，其他类型先格式化为字符串
+template<class T>
+auto ToEncodable(const T& v) {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, bool> or std::is_same_v<D, char>) return v;
+    else if constexpr (std::is_integral_v<D> and std::is_signed_v<D>) return static_cast<int64_t>(v);
+    else if constexpr (std::is_integral_v<D>) return static_cast<uint64_t>(v);
+    else if constexpr (std::is_floating_point_v<D>) return static_cast<double>(v);
+    else if constexpr (std::is_array_v<T> and std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>) {
+        return std::string_view(v, strnlen(v, std::extent_v<T>)); // 字符数组不一定以 '\0' 结尾
+    }
+    else if constexpr (std::is_same_v<D, const char*> or std::is_same_v<D, char*>) {
+        return v ? std::string_view(v) : std::string_view("(null)");
+    }
+    else if constexpr (std::is_pointer_v<D>) return static_cast<const void*>(v);
+    else if constexpr (std::is_convertible_v<const T&, std::string_view>) return std::string_view(v);
+    else return std::format("{}", v);
+}
+
+template<class E>
+constexpr char TagOf() {
+    if constexpr (std::is_same_v<E, bool>) return ARG_BOOL;
+    else if constexpr (std::is_same_v<E, char>) return ARG_CHAR;
+    else if constexpr (std::is_same_v<E, int64_t>) return ARG_INT;
+    else if constexpr (std::is_same_v<E, uint64_t>) return ARG_UINT;
+    else if constexpr (std::is_same_v<E, double>) return ARG_DOUBLE;
+    else if constexpr (std::is_same_v<E, const void*>) return ARG_POINTER;
+    else return ARG_STRING;
+}
+
+// 参数模式：每个参数一个类型标记，以 '\0' 结尾，编译期生成
+template<class... Es>
+inline constexpr char SCHEMA[] = {TagOf<Es>()..., '\0'};
+
+template<class E>
+size_t EncodedSize(const E& v) {
+    if constexpr (std::is_same_v<E, bool> or std::is_same_v<E, char>) return 1;
+    else if constexpr (std::is_arithmetic_v<E> or std::is_pointer_v<E>) return 8;
+    else return sizeof(uint32_t) + v.size();
+}
+
+template<class E>
+char* Encode(char* p, const E& v) {
+    if constexpr (std::is_same_v<E, bool> or std::is_same_v<E, char>) {
+        *p = static_cast<char>(v);
+        return p + 1;
+    } else if constexpr (std::is_arithmetic_v<E>) {
+        std::memcpy(p, &v, 8);
+        return p + 8;
+    } else if constexpr (std::is_pointer_v<E>) {
+        uint64_t addr = reinterpret_cast<uintptr_t>(v);
+        std::memcpy(p, &addr, 8);
+        return p + 8;
+    } else {
+        uint32_t len = static_cast<uint32_t>(v.size());
+        std::memcpy(p, &len, sizeof(len));
+        std::memcpy(p + sizeof(len), v.data(), len);
+        return p + sizeof(len) + len;
+    }
+}
+
+// ENTRY 记录头部长度：类型 + id + 时间戳 + 参数字节数
+inline constexpr size_t ENTRY_HEADER_SIZE = 1 + 4 + 8 + 4;
+
+template<class T>
+void Put(std::string& out, T v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+// 生成 SESSION 记录，追加到 out
+inline void AppendSession(std::string& out, uint64_t wallNs, uint64_t steadyNs) {
+    Put<uint8_t>(out, RECORD_SESSION);
+    out.append(MAGIC, sizeof(MAGIC));
+    Put<uint64_t>(out, wallNs);
+    Put<uint64_t>(out, steadyNs);
+}
+
+// 生成 SITE 记录，追加到 out；格式串与文件名超过 64KB 的部分被截断
+inline void AppendSite(std::string& out, const LogSite& site) {
+    std::string_view fmt(site.fmt);
+    std::string_view file(site.file);
+    std::string_view schema(site.schema ? site.schema : "");
+    fmt = fmt.substr(0, UINT16_MAX);
+    file = file.substr(0, UINT16_MAX);
+    schema = schema.substr(0, UINT8_MAX);
+    Put<uint8_t>(out, RECORD_SITE);
+    Put<uint32_t>(out, site.id.load(std::memory_order_relaxed));
+    Put<uint8_t>(out, static_cast<uint8_t>(site.level));
+    Put<uint32_t>(out, static_cast<uint32_t>(site.line));
+    Put<uint16_t>(out, static_cast<uint16_t>(fmt.size()));
+    out.append(fmt);
+    Put<uint16_t>(out, static_cast<uint16_t>(file.size()));
+    out.append(file);
+    Put<uint8_t>(out, static_cast<uint8_t>(schema.size()));
+    out.append(schema);
+}
+
+// 把二进制日志解码为与文本模式相同格式的日志行，返回解码的条数；
+// 文件尾部被截断的记录会被忽略
+size_t Decode(const char* data, size_t len, std::ostream& out);
+
+} // namespace binlog
+
+#endif /* BINLOG_H */
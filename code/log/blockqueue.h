@@ -1,13 +1,19 @@
 #ifndef BLOCKQUEUE_H
 #define BLOCKQUEUE_H
 /*
-    BlockDeque是基于std::deque封装的线程安全阻塞队列，是异步日志的核心依赖，作用是：
-    主线程（生产者）：写日志时将日志字符串入队；
-    刷盘线程（消费者）：从队列取日志字符串写入文件；
-    核心特性：队列满时生产者阻塞、队列空时消费者阻塞，支持超时取数据、手动唤醒等。
+    BlockDeque是基于std::deque封装的线程安全阻塞队列，用于日志压缩任务等生产者/消费者场景：
+    生产者：把元素入队（支持移动与原地构造，不拷贝）；
+    消费者：取出元素处理，可以一次加锁批量取出 pop_n / drain_into；
+    核心特性：队列满时生产者阻塞、队列空时消费者阻塞，支持超时取数据（std::chrono 时长）、手动唤醒等。
+    只有队列从满变为不满时才唤醒一个生产者，避免每取一个元素都通知一次；
+    被唤醒的生产者入队后若队列仍不满且还有等待者，再接力唤醒下一个，保证空位不会被闲置。
 */
 #include <mutex>
 #include <deque>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <utility>
 #include <condition_variable>
 #include <sys/time.h>
 #include <atomic>
@@ -37,17 +43,49 @@ public:
 
     T back();
 
-    void push_front(const T& item);
+    // 入队，队列满时阻塞；队列已停止时返回 false
+    bool push_front(const T& item);
+    bool push_front(T&& item);
 
-    void push_back(const T& item);
+    bool push_back(const T& item);
+    bool push_back(T&& item);
 
+    template<class... Args>
+    bool emplace_back(Args&&... args);
+
+    // pop函数返回值表示是否成功取到元素（false表示队列已停止且无元素可取）
     bool pop(T& item);
 
+    // 带超时的pop，timeout单位为秒
     bool pop(T& item, int timeout);
 
+    template<class Rep, class Period>
+    bool pop(T& item, const std::chrono::duration<Rep, Period>& timeout);
+
+    // 一次加锁移出最多 max 个元素追加到 out，返回取出的个数；
+    // 队列空时阻塞（或最多等待 timeout），队列已停止或超时返回 0
+    size_t pop_n(std::vector<T>& out, size_t max);
+
+    template<class Rep, class Period>
+    size_t pop_n(std::vector<T>& out, size_t max, const std::chrono::duration<Rep, Period>& timeout);
+
+    // 不阻塞：移出当前所有元素追加到 out，返回取出的个数
+    size_t drain_into(std::vector<T>& out);
+
     void flush();
 
 private:
+    template<class U>
+    bool push_(U&& item, bool front);
+
+    // 调用方持有锁；返回 false 表示队列已停止
+    bool wait_for_space_(std::unique_lock<std::mutex>& locker);
+    // 入队后解锁并通知
+    void after_push_(std::unique_lock<std::mutex>& locker);
+
+    // 调用方持有锁且队列非空：移出最多 max 个元素，返回移出前队列是否已满
+    bool take_(std::vector<T>& out, size_t max);
+
     std::deque<T> deq_;
 
     size_t capacity_;
@@ -55,10 +93,12 @@ private:
     std::mutex mtx_;
 
     std::atomic<bool> is_running_;
-    
-    std::condition_variable condConsumer_; // 生产者条件变量（队列满时阻塞生产者）
 
-    std::condition_variable condProducer_; // 消费者条件变量（队列空时阻塞消费者）
+    size_t producerWaiting_ = 0; // 因队列满而等待的生产者数，受 mtx_ 保护
+
+    std::condition_variable condConsumer_; // 消费者条件变量（队列空时阻塞消费者）
+
+    std::condition_variable condProducer_; // 生产者条件变量（队列满时阻塞生产者）
 };
 
 // 模板定义不离头文件，实现放在头文件中
@@ -85,16 +125,22 @@ void BlockDeque<T>::stop() {
     condProducer_.notify_all();
 }
 
+// 唤醒一个等待中的消费者
 template<class T>
 void BlockDeque<T>::flush() {
-    condProducer_.notify_one();
+    condConsumer_.notify_one();
 }
 
 template<class T>
 void BlockDeque<T>::clear() {
-    std::unique_lock<std::mutex> locker(mtx_);
-    deq_.clear();
-}   
+    bool wasFull;
+    {
+        std::unique_lock<std::mutex> locker(mtx_);
+        wasFull = deq_.size() >= capacity_;
+        deq_.clear();
+    }
+    if(wasFull) condProducer_.notify_one();
+}
 
 template<class T>
 bool BlockDeque<T>::empty() {
@@ -133,64 +179,159 @@ T BlockDeque<T>::back() {
 }
 
 template<class T>
-void BlockDeque<T>::push_back(const T &item) {
-    std::unique_lock<std::mutex> locker(mtx_);
-    while(deq_.size() >= capacity_) {
-        condProducer_.wait(locker); // 队列满时阻塞生产者,直到消费者消费了一个元素并通知生产者
+bool BlockDeque<T>::wait_for_space_(std::unique_lock<std::mutex>& locker) {
+    // 队列满时阻塞生产者，直到消费者取走元素使队列不满
+    if(deq_.size() >= capacity_ and is_running_.load()) {
+        producerWaiting_++;
+        condProducer_.wait(locker, [this]() { return deq_.size() < capacity_ or !is_running_.load(); });
+        producerWaiting_--;
     }
-    deq_.push_back(item);
+    return is_running_.load();
+}
+
+template<class T>
+void BlockDeque<T>::after_push_(std::unique_lock<std::mutex>& locker) {
+    bool relay = producerWaiting_ > 0 and deq_.size() < capacity_;
+    locker.unlock();
+    if(relay) condProducer_.notify_one(); // 还有空位：接力唤醒下一个等待的生产者
     condConsumer_.notify_one(); // 通知消费者有新元素入队
 }
 
 template<class T>
-void BlockDeque<T>::push_front(const T &item) {
+template<class U>
+bool BlockDeque<T>::push_(U&& item, bool front) {
+    std::unique_lock<std::mutex> locker(mtx_);
+    if(!wait_for_space_(locker)) return false;
+    if(front) deq_.push_front(std::forward<U>(item));
+    else deq_.push_back(std::forward<U>(item));
+    after_push_(locker);
+    return true;
+}
+
+template<class T>
+bool BlockDeque<T>::push_back(const T &item) {
+    return push_(item, false);
+}
+
+template<class T>
+bool BlockDeque<T>::push_back(T &&item) {
+    return push_(std::move(item), false);
+}
+
+template<class T>
+bool BlockDeque<T>::push_front(const T &item) {
+    return push_(item, true);
+}
+
+template<class T>
+bool BlockDeque<T>::push_front(T &&item) {
+    return push_(std::move(item), true);
+}
+
+template<class T>
+template<class... Args>
+bool BlockDeque<T>::emplace_back(Args&&... args) {
     std::unique_lock<std::mutex> locker(mtx_);
-    while(deq_.size() >= capacity_) {
-        condProducer_.wait(locker);
+    if(!wait_for_space_(locker)) return false;
+    deq_.emplace_back(std::forward<Args>(args)...);
+    after_push_(locker);
+    return true;
+}
+
+template<class T>
+bool BlockDeque<T>::take_(std::vector<T>& out, size_t max) {
+    bool wasFull = deq_.size() >= capacity_;
+    size_t n = std::min(max, deq_.size());
+    for(size_t i = 0; i < n; i++) {
+        out.push_back(std::move(deq_.front()));
+        deq_.pop_front();
     }
-    deq_.push_front(item);
-    condConsumer_.notify_one(); // 通知消费者有新元素入队
+    return wasFull;
 }
 
-// pop函数返回值表示是否成功取到元素（false表示队列已停止且无元素可取）
 template<class T>
 bool BlockDeque<T>::pop(T &item) {
-    std::unique_lock<std::mutex> locker(mtx_);
-    while(deq_.empty()) {
-        // 队列空时阻塞消费者,直到生产者生产了一个元素并通知消费者
-        condConsumer_.wait(locker);
-        if(!is_running_.load()) {
-            return false; // 队列已停止且无元素可取
-        }
-        // 如果被唤醒但队列仍然空，继续等待
+    bool wasFull;
+    {
+        std::unique_lock<std::mutex> locker(mtx_);
+        // 先检查再等待：stop 之后调用的 pop 也能立即返回
+        condConsumer_.wait(locker, [this]() { return !deq_.empty() or !is_running_.load(); });
+        if(deq_.empty()) return false; // 队列已停止且无元素可取
+        wasFull = deq_.size() >= capacity_;
+        item = std::move(deq_.front());
+        deq_.pop_front();
     }
-    // 否则成功取到元素
-    item = deq_.front();
-    deq_.pop_front();
-    condProducer_.notify_one(); // 通知生产者有空间入队
+    if(wasFull) condProducer_.notify_one(); // 从满变为不满才唤醒生产者
     return true;
 }
 
-// 带超时的pop函数，返回值表示是否成功取到元素（false表示超时或队列已停止且无元素可取）
-// timeout单位为秒
-// 支持 “超时等待”：队列空时最多等timeout秒，超时则返回false；
+// 支持 “超时等待”：队列空时最多等 timeout，超时则返回false；
 // 避免消费者无限阻塞（比如日志系统退出时）。
 template<class T>
-bool BlockDeque<T>::pop(T &item, int timeout) {
-    std::unique_lock<std::mutex> locker(mtx_);
-    while(deq_.empty()) {
-        if(condConsumer_.wait_for(locker, std::chrono::seconds(timeout)) == std::cv_status::timeout) {
+template<class Rep, class Period>
+bool BlockDeque<T>::pop(T &item, const std::chrono::duration<Rep, Period>& timeout) {
+    bool wasFull;
+    {
+        std::unique_lock<std::mutex> locker(mtx_);
+        if(!condConsumer_.wait_for(locker, timeout, [this]() { return !deq_.empty() or !is_running_.load(); })) {
             return false; // 超时未取到元素
         }
-        if(!is_running_.load()) {
-            return false; // 队列已停止且无元素可取
-        }
-        // 如果被唤醒但队列仍然空，继续等待
+        if(deq_.empty()) return false; // 队列已停止且无元素可取
+        wasFull = deq_.size() >= capacity_;
+        item = std::move(deq_.front());
+        deq_.pop_front();
     }
-    item = deq_.front();
-    deq_.pop_front();
-    condProducer_.notify_one(); // 通知生产者有空间入队
+    if(wasFull) condProducer_.notify_one();
     return true;
 }
 
+template<class T>
+bool BlockDeque<T>::pop(T &item, int timeout) {
+    return pop(item, std::chrono::seconds(timeout));
+}
+
+template<class T>
+size_t BlockDeque<T>::pop_n(std::vector<T>& out, size_t max) {
+    size_t before = out.size();
+    bool wasFull;
+    {
+        std::unique_lock<std::mutex> locker(mtx_);
+        condConsumer_.wait(locker, [this]() { return !deq_.empty() or !is_running_.load(); });
+        if(deq_.empty()) return 0;
+        wasFull = take_(out, max);
+    }
+    if(wasFull) condProducer_.notify_one();
+    return out.size() - before;
+}
+
+template<class T>
+template<class Rep, class Period>
+size_t BlockDeque<T>::pop_n(std::vector<T>& out, size_t max, const std::chrono::duration<Rep, Period>& timeout) {
+    size_t before = out.size();
+    bool wasFull;
+    {
+        std::unique_lock<std::mutex> locker(mtx_);
+        if(!condConsumer_.wait_for(locker, timeout, [this]() { return !deq_.empty() or !is_running_.load(); })) {
+            return 0;
+        }
+        if(deq_.empty()) return 0;
+        wasFull = take_(out, max);
+    }
+    if(wasFull) condProducer_.notify_one();
+    return out.size() - before;
+}
+
+template<class T>
+size_t BlockDeque<T>::drain_into(std::vector<T>& out) {
+    size_t before = out.size();
+    bool wasFull;
+    {
+        std::unique_lock<std::mutex> locker(mtx_);
+        if(deq_.empty()) return 0;
+        wasFull = take_(out, deq_.size());
+    }
+    if(wasFull) condProducer_.notify_one();
+    return out.size() - before;
+}
+
 #endif /* BLOCKQUEUE_H */
@@ -1,9 +1,45 @@
 #include "log.h"
 
 #include <chrono>
-#include <iomanip>
 #include <iostream>
 #include <filesystem>
+#include <fcntl.h>
+#include <climits>
+#include <algorithm>
+#include <tuple>
+#include <cctype>
+#include <sys/uio.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <zlib.h>
+
+// 每个线程的一对缓冲块，由本线程与刷盘线程共享，用自旋锁保护：
+// 本线程每写一行加锁一次，只有刷盘线程定期收取或归还缓冲块时才会产生竞争
+struct Logger::ThreadBuffer {
+    std::atomic_flag locked = ATOMIC_FLAG_INIT;
+    std::unique_ptr<Buffer> current; // 正在写入的块
+    std::unique_ptr<Buffer> spare;   // 刷盘线程写完后归还的备用块
+    std::unique_ptr<Buffer> stalled; // 非阻塞策略下队列满时暂存的整块，下次交出或被刷盘线程直接收取
+    LineCount lines{};               // current 中各级别的行数
+    LineCount stalledLines{};
+    bool keep = false;               // current 中有不能丢弃的记录
+    bool exited = false;             // 线程已退出，刷盘线程收取后将其注销
+    std::array<uint32_t, 3> sampleSeq{}; // SAMPLE 策略下各级别的序号
+
+    void lock() {
+        while(locked.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+    }
+    void unlock() {
+        locked.clear(std::memory_order_release);
+    }
+};
+
+struct Logger::ThreadBufferHolder {
+    std::shared_ptr<ThreadBuffer> tb;
+    ~ThreadBufferHolder() {
+        if(tb) Logger::getInstance().retire(tb);
+    }
+};
 
 Logger& Logger::getInstance() {
     static Logger instance;
@@ -11,11 +47,12 @@ Logger& Logger::getInstance() {
 }
 
 void Logger::initLogger(const std::string& log_file,
-     LogLevel level, int max_queue_size, int64_t log_flush_interval) {
+     LogLevel level, int max_queue_size, int64_t log_flush_interval, bool binary) {
     if (is_running_.load()) {
         return; // 已经初始化
     }
     current_level_ = level;
+    binary_ = binary;
     log_file_ = log_file;
     LEAST_FLUSH_SEC_GAP = log_flush_interval;
 
@@ -25,10 +62,43 @@ void Logger::initLogger(const std::string& log_file,
         std::filesystem::create_directories(log_path.parent_path());
     }
 
+    mmap_ring_.reset();
+    if(mmap_size_ > 0 and !log_file.empty()) {
+        auto ring = std::make_unique<MmapRingFile>();
+        if(ring->Open(log_file_ + ".ring", mmap_size_)) {
+            mmap_ring_ = std::move(ring);
+            binary_ = false; // 环形文件只保存文本行：调用点记录可能已被覆盖，二进制日志无法解码
+        } else {
+            std::cerr << "Open ring log file " << log_file_ << ".ring failed, use regular log file" << std::endl;
+        }
+    }
+
     current_date_ = get_timestamp().substr(0, 10); // 取日期部分 YYYY-MM-DD
-    if(!log_file.empty()) log_stream_.open(log_file_, std::ios::app | std::ios::out);
+    struct stat st;
+    if(!log_file.empty() and ::stat(log_file_.c_str(), &st) == 0 and st.st_size > 0) {
+        // 已有的日志文件属于之前的某一天时，第一次刷盘即滚动，旧文件按其修改日期命名
+        std::tm tm;
+        localtime_r(&st.st_mtime, &tm);
+        char date[16];
+        std::strftime(date, sizeof(date), "%Y-%m-%d", &tm);
+        current_date_ = date;
+    }
+    if(!log_file.empty() and !mmap_ring_ and !open_log_file()) {
+        std::cerr << "Open log file " << log_file_ << " failed, log to stdout" << std::endl;
+    }
+    if(binary_ and log_fd_ < 0) {
+        std::cerr << "Binary log needs a log file, fall back to text" << std::endl;
+        binary_ = false;
+    }
+    if(binary_) write_binary_header();
+    last_sync_ = std::chrono::steady_clock::now();
+    if(rotation_.compress and log_fd_ >= 0) {
+        compress_queue_ = std::make_unique<BlockDeque<std::string>>(1024);
+        compress_running_.store(true);
+        compress_thread_ = std::thread(&Logger::compress_worker, this);
+    }
  
-    message_queue_ = std::make_unique<BlockDeque<std::string>>(max_queue_size);
+    message_queue_ = std::make_unique<MpscRing<Handoff>>(max_queue_size > 0 ? max_queue_size : 1024);
     is_running_.store(true);
     last_flush_time_ = std::chrono::steady_clock::now(); // 初始化上次刷新时间
     worker_thread_ = std::thread(&Logger::log_worker_thread, this);
@@ -41,9 +111,25 @@ Logger::~Logger() {
 void Logger::shutdown() {
     if(!is_running_.load()) return; // 已经关闭
     is_running_.store(false);
-    if(message_queue_) message_queue_->stop(); // 停止队列，唤醒所有等待的线程
+    wake_worker(); // 唤醒刷盘线程，它会把队列取空后退出
     if(worker_thread_.joinable()) worker_thread_.join(); // 等待刷盘线程退出
-    if(log_stream_.is_open()) log_stream_.close(); // 关闭日志文件流
+    // 此时本线程是唯一的消费者：收取各线程缓冲区与队列中剩余的块，全部写入后再关闭文件
+    if(message_queue_) {
+        sweep();
+        collect();
+        flush();
+    }
+    if(log_fd_ >= 0) {
+        if(rotation_.sync_interval_ms > 0) ::fdatasync(log_fd_);
+        ::close(log_fd_); // 关闭日志文件
+        log_fd_ = -1;
+    }
+    if(compress_thread_.joinable()) {
+        // 等待已滚动的旧文件压缩完成
+        compress_running_.store(false);
+        compress_thread_.join();
+        compress_queue_.reset();
+    }
 }
 
 void Logger::setLogLevel(LogLevel level) {
@@ -64,8 +150,381 @@ void Logger::log(LogLevel level, const std::string& msg) {
         }
         return;
     }
-    std::string line = get_timestamp() + " [" + get_level_name(level) + "] " + msg;
-    message_queue_->push_back(std::move(line)); // 将日志消息放入队列，异步写入
+    char timestamp[WallClock::TIMESTAMP_LEN];
+    WallClock::Timestamp(timestamp);
+    std::string levelName = get_level_name(level);
+    if(mmap_ring_) {
+        // 直接拷贝进共享映射，不经过线程缓冲区与刷盘线程
+        thread_local std::string line;
+        line.assign(timestamp, sizeof(timestamp));
+        line.append(" [").append(levelName).append("] ").append(msg).append("\n");
+        mmap_ring_->Append(line.data(), line.size());
+        return;
+    }
+    std::shared_ptr<ThreadBuffer>& tb = thread_buffer();
+    tb->lock();
+    if(!tb->current) {
+        // 线程退出过程中（其他 thread_local 析构时）仍在写日志，直接输出
+        tb->unlock();
+        std::string line = std::string(timestamp, sizeof(timestamp)) + " [" + levelName + "] " + msg + "\n";
+        std::fwrite(line.data(), 1, line.size(), stdout);
+        return;
+    }
+    if(!admit(*tb, level)) {
+        tb->unlock();
+        return;
+    }
+    Buffer& buff = *tb->current;
+    buff.append(timestamp, sizeof(timestamp));
+    buff.append(" [", 2);
+    buff.append(levelName);
+    buff.append("] ", 2);
+    buff.append(msg);
+    buff.append("\n", 1);
+    tb->lines[static_cast<int>(level)]++;
+    if(level >= LogLevel::ERROR) tb->keep = true;
+    // 写满，或错误日志需要尽快落盘时，整块交给刷盘线程
+    Handoff full;
+    if(buff.readable_size() >= THREAD_BUFFER_SIZE or level >= LogLevel::ERROR) full = swap_out(tb);
+    tb->unlock();
+    if(full.buffer) hand_off(std::move(full));
+}
+
+void Logger::append_record(LogLevel level, const char* data, size_t len, bool keep) {
+    std::shared_ptr<ThreadBuffer>& tb = thread_buffer();
+    tb->lock();
+    if(!tb->current) {
+        tb->unlock(); // 线程退出过程中的二进制日志无法输出到终端，丢弃
+        return;
+    }
+    if(!keep and !admit(*tb, level)) {
+        tb->unlock();
+        return;
+    }
+    Buffer& buff = *tb->current;
+    buff.append(data, len);
+    if(keep) tb->keep = true;
+    else tb->lines[static_cast<int>(level)]++;
+    if(level >= LogLevel::ERROR) tb->keep = true;
+    Handoff full;
+    if(buff.readable_size() >= THREAD_BUFFER_SIZE or level >= LogLevel::ERROR) full = swap_out(tb);
+    tb->unlock();
+    if(full.buffer) hand_off(std::move(full));
+}
+
+uint32_t Logger::register_site(binlog::LogSite& site, const char* schema) {
+    std::string& rec = record_scratch();
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> locker(site_mtx_);
+        id = site.id.load(std::memory_order_relaxed);
+        if(id != 0) return id; // 其他线程已注册，调用点记录由它写入
+        site.schema = schema;
+        sites_.push_back(&site);
+        id = static_cast<uint32_t>(sites_.size());
+        site.id.store(id, std::memory_order_release);
+        rec.clear();
+        binlog::AppendSite(rec, site);
+    }
+    // 调用点记录与随后的日志在同一线程缓冲块中，解码时总能找到；所在的块不能丢弃
+    append_record(LogLevel::DEBUG, rec.data(), rec.size(), true);
+    return id;
+}
+
+bool Logger::open_log_file() {
+    log_fd_ = ::open(log_file_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(log_fd_ < 0) return false;
+    struct stat st;
+    file_size_ = ::fstat(log_fd_, &st) == 0 ? st.st_size : 0;
+    return true;
+}
+
+std::string Logger::segment_path(const std::string& date, int index) const {
+    std::filesystem::path path(log_file_);
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), ".%03d", index);
+    std::filesystem::path name = path.stem();
+    name += "." + date + suffix;
+    name += path.extension();
+    return (path.parent_path() / name).string();
+}
+
+void Logger::rotate_if_needed(size_t incoming) {
+    if(log_fd_ < 0) return;
+    char now[WallClock::TIMESTAMP_LEN];
+    WallClock::Timestamp(now);
+    std::string_view today(now, 10);
+    bool newDay = today != current_date_;
+    bool tooLarge = rotation_.max_size > 0 and file_size_ > 0 and file_size_ + incoming > rotation_.max_size;
+    if(!newDay and !tooLarge) return;
+    rotate();
+    current_date_ = today;
+}
+
+void Logger::rotate() {
+    // 旧文件以它所属的日期命名，同一天内的序号递增（不复用已被清理的序号，保证名字有序）
+    int index = 1;
+    for(const auto& [date, idx, path] : list_segments()) {
+        if(date == current_date_) index = std::max(index, idx + 1);
+    }
+    std::string target = segment_path(current_date_, index);
+    if(rotation_.sync_interval_ms > 0) ::fdatasync(log_fd_);
+    ::close(log_fd_);
+    log_fd_ = -1;
+    if(::rename(log_file_.c_str(), target.c_str()) != 0) target.clear();
+    if(!open_log_file()) {
+        std::cerr << "Reopen log file " << log_file_ << " failed, log to stdout" << std::endl;
+    } else if(binary_) {
+        write_binary_header(); // 每个文件都能单独解码
+    }
+    if(target.empty()) return;
+    // 压缩与清理交给后台线程，刷盘线程只做改名与重新打开
+    if(compress_queue_) compress_queue_->push_back(std::move(target));
+    else prune_segments();
+}
+
+std::vector<std::tuple<std::string, int, std::string>> Logger::list_segments() const {
+    std::filesystem::path path(log_file_);
+    std::filesystem::path dir = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+    std::string prefix = path.stem().string() + ".";
+    std::string ext = path.extension().string();
+    std::vector<std::tuple<std::string, int, std::string>> segments;
+    std::error_code ec;
+    for(const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        // <名>.<YYYY-MM-DD>.<序号><扩展名>[.gz]
+        std::string name = entry.path().filename().string();
+        if(name.compare(0, prefix.size(), prefix) != 0) continue;
+        std::string rest = name.substr(prefix.size());
+        if(rest.size() < 12 or rest[4] != '-' or rest[7] != '-' or rest[10] != '.') continue;
+        size_t end = 11;
+        int index = 0;
+        while(end < rest.size() and std::isdigit(static_cast<unsigned char>(rest[end]))) index = index * 10 + (rest[end++] - '0');
+        std::string tail = rest.substr(end);
+        if(end == 11 or (tail != ext and tail != ext + ".gz")) continue;
+        segments.emplace_back(rest.substr(0, 10), index, entry.path().string());
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+void Logger::prune_segments() {
+    if(rotation_.max_files <= 0) return;
+    auto segments = list_segments();
+    if(segments.size() <= static_cast<size_t>(rotation_.max_files)) return;
+    std::error_code ec;
+    for(size_t i = 0; i + rotation_.max_files < segments.size(); i++) std::filesystem::remove(std::get<2>(segments[i]), ec);
+}
+
+// 把 path 压缩为 path.gz，成功后删除原文件
+static bool CompressFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return errno == ENOENT; // 排队期间已被清理
+    std::string tmp = path + ".gz.tmp";
+    gzFile gz = gzopen(tmp.c_str(), "wb6");
+    bool ok = gz != nullptr;
+    std::vector<char> buf(256 * 1024);
+    while(ok) {
+        ssize_t n = ::read(fd, buf.data(), buf.size());
+        if(n == 0) break;
+        if(n < 0) {
+            if(errno == EINTR) continue;
+            ok = false;
+            break;
+        }
+        ok = gzwrite(gz, buf.data(), static_cast<unsigned>(n)) == n;
+    }
+    ::close(fd);
+    if(gz and gzclose(gz) != Z_OK) ok = false;
+    if(ok) ok = ::rename(tmp.c_str(), (path + ".gz").c_str()) == 0;
+    if(ok) ::unlink(path.c_str());
+    else ::unlink(tmp.c_str());
+    return ok;
+}
+
+void Logger::compress_worker() {
+    // 压缩只占用空闲 CPU，不与 Reactor 与刷盘线程争抢
+    setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), 19);
+    std::vector<std::string> paths;
+    while(compress_running_.load() or !compress_queue_->empty()) {
+        // 停止时最多等待一个超时周期即可退出
+        if(compress_queue_->pop_n(paths, 16, std::chrono::milliseconds(200)) == 0) continue;
+        for(const std::string& path : paths) {
+            if(!CompressFile(path)) std::cerr << "Compress log file " << path << " failed" << std::endl;
+        }
+        paths.clear();
+        prune_segments();
+    }
+}
+
+void Logger::sync_if_due() {
+    if(rotation_.sync_interval_ms <= 0) return;
+    auto now = std::chrono::steady_clock::now();
+    if(now - last_sync_ < std::chrono::milliseconds(rotation_.sync_interval_ms)) return;
+    if(mmap_ring_) mmap_ring_->Sync();
+    if(log_fd_ >= 0) ::fdatasync(log_fd_);
+    last_sync_ = now;
+}
+
+void Logger::write_binary_header() {
+    std::string header;
+    auto wall = std::chrono::system_clock::now().time_since_epoch();
+    auto steady = std::chrono::steady_clock::now().time_since_epoch();
+    binlog::AppendSession(header,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(wall).count(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(steady).count());
+    // 新文件中也能解码已注册调用点的日志
+    std::lock_guard<std::mutex> locker(site_mtx_);
+    for(binlog::LogSite* site : sites_) binlog::AppendSite(header, *site);
+    for(size_t off = 0; off < header.size();) {
+        ssize_t n = ::write(log_fd_, header.data() + off, header.size() - off);
+        if(n < 0) {
+            if(errno == EINTR) continue;
+            break;
+        }
+        off += n;
+    }
+    file_size_ += header.size();
+}
+
+std::string& Logger::record_scratch() {
+    thread_local std::string scratch;
+    return scratch;
+}
+
+std::shared_ptr<Logger::ThreadBuffer>& Logger::thread_buffer() {
+    thread_local ThreadBufferHolder holder;
+    if(!holder.tb) {
+        holder.tb = std::make_shared<ThreadBuffer>();
+        holder.tb->current = std::make_unique<Buffer>(THREAD_BUFFER_SIZE + 1024);
+        std::lock_guard<std::mutex> locker(registry_mtx_);
+        thread_buffers_.push_back(holder.tb);
+    }
+    return holder.tb;
+}
+
+Logger::Handoff Logger::swap_out(const std::shared_ptr<ThreadBuffer>& tb, bool replace) {
+    Handoff full{tb, std::move(tb->current), tb->lines, tb->keep};
+    tb->lines = {};
+    tb->keep = false;
+    if(!replace) return full; // 线程已退出，不再需要当前块
+    if(tb->spare) tb->current = std::move(tb->spare);
+    else tb->current = std::make_unique<Buffer>(THREAD_BUFFER_SIZE + 1024); // 备用块还在刷盘线程手中
+    return full;
+}
+
+bool Logger::admit(ThreadBuffer& tb, LogLevel level) {
+    if(level >= LogLevel::ERROR or !overloaded_.load(std::memory_order_relaxed)) return true;
+    if(overflow_.load(std::memory_order_relaxed) != LogOverflow::SAMPLE) return true;
+    int idx = static_cast<int>(level);
+    uint32_t rate = sample_rates_[idx];
+    if(rate == 1 or (rate > 1 and tb.sampleSeq[idx]++ % rate == 0)) return true;
+    dropped_[idx].fetch_add(1, std::memory_order_relaxed); // rate 为 0 表示拥塞期间全部丢弃
+    return false;
+}
+
+bool Logger::try_push(Handoff& handoff) {
+    if(message_queue_->try_push(std::move(handoff))) return true;
+    overloaded_.store(true, std::memory_order_relaxed);
+    return false;
+}
+
+void Logger::hand_off(Handoff&& handoff) {
+    LogOverflow policy = overflow_.load(std::memory_order_relaxed);
+    if(policy == LogOverflow::BLOCK or handoff.keep) {
+        // 队列满时先让出 CPU 等刷盘线程消费，仍然满则短暂休眠，不占用锁
+        for(int spins = 0; !try_push(handoff); spins++) {
+            wake_worker();
+            if(spins < 64) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        wake_worker();
+        return;
+    }
+    // 非阻塞策略：先交出之前暂存的块，再交出本块，各只尝试一次
+    ThreadBuffer& tb = *handoff.owner;
+    tb.lock();
+    Handoff old{handoff.owner, std::move(tb.stalled), tb.stalledLines};
+    tb.unlock();
+    if(old.buffer and try_push(old)) old.buffer.reset();
+    if(!old.buffer and try_push(handoff)) {
+        wake_worker();
+        return;
+    }
+    // 队列仍满：暂存一块，另一块（如果有）按策略丢弃
+    Handoff* stall = &handoff;
+    Handoff* drop = nullptr;
+    if(old.buffer) {
+        if(policy == LogOverflow::DROP_OLDEST) drop = &old;
+        else {
+            stall = &old;
+            drop = &handoff;
+        }
+    }
+    if(drop) count_dropped(drop->lines);
+    tb.lock();
+    tb.stalled = std::move(stall->buffer);
+    tb.stalledLines = stall->lines;
+    if(drop and !tb.spare and !tb.exited) {
+        drop->buffer->reset();
+        tb.spare = std::move(drop->buffer); // 丢弃的块直接作为备用块复用
+    }
+    tb.unlock();
+    wake_worker();
+}
+
+void Logger::count_dropped(const LineCount& lines) {
+    for(size_t i = 0; i < lines.size(); i++) {
+        if(lines[i] > 0) dropped_[i].fetch_add(lines[i], std::memory_order_relaxed);
+    }
+}
+
+void Logger::setOverflowPolicy(LogOverflow policy, const std::array<uint32_t, 3>& sample_rates) {
+    sample_rates_ = sample_rates;
+    overflow_.store(policy);
+}
+
+uint64_t Logger::droppedLines(LogLevel level) const {
+    return dropped_[static_cast<int>(level)].load(std::memory_order_relaxed);
+}
+
+uint64_t Logger::droppedLines() const {
+    uint64_t total = 0;
+    for(const auto& d : dropped_) total += d.load(std::memory_order_relaxed);
+    return total;
+}
+
+void Logger::report_dropped() {
+    std::array<uint64_t, 4> delta{};
+    uint64_t total = 0;
+    for(size_t i = 0; i < delta.size(); i++) {
+        uint64_t now = dropped_[i].load(std::memory_order_relaxed);
+        delta[i] = now - reported_dropped_[i];
+        reported_dropped_[i] = now;
+        total += delta[i];
+    }
+    if(total == 0) return;
+    // 与普通日志走同一条路径（二进制模式下同样编码），随后的 sweep 收取
+    static const char* POLICY_NAMES[] = {"block", "drop_newest", "drop_oldest", "sample"};
+    LOG_WARN("{} log lines dropped (DEBUG {}, INFO {}, WARN {}), overflow policy {}",
+        total, delta[0], delta[1], delta[2], POLICY_NAMES[static_cast<int>(overflow_.load())]);
+}
+
+void Logger::retire(const std::shared_ptr<ThreadBuffer>& tb) {
+    tb->lock();
+    Handoff rest;
+    // 日志系统正在关闭时（如刷盘线程自身退出）留给 shutdown 的 sweep 收取
+    if(is_running_.load()) rest = swap_out(tb, false);
+    tb->exited = true;
+    tb->unlock();
+    if(rest.buffer and rest.buffer->readable_size() > 0) hand_off(std::move(rest));
+}
+
+void Logger::wake_worker() {
+    // 与刷盘线程休眠前的栅栏配对：要么它看到新入队的缓冲块，要么这里看到它在休眠
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(!worker_sleeping_.load(std::memory_order_relaxed)) return;
+    std::lock_guard<std::mutex> locker(wake_mtx_);
+    wake_cond_.notify_one();
 }
 
 std::string Logger::get_level_name(LogLevel level) {
@@ -80,57 +539,111 @@ std::string Logger::get_level_name(LogLevel level) {
 }
 
 std::string Logger::get_timestamp() {
-    auto now = std::chrono::system_clock::now();
-    // 将时间点转换为time_t以便格式化
-    time_t time_t_now = std::chrono::system_clock::to_time_t(now);
-    // 毫秒时间只能通过duration_cast计算
-    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
-    std::tm tm_now;
-    // localtime : 将time_t转换为本地时间的tm结构
-    localtime_r(&time_t_now, &tm_now); // 线程安全的localtime
-    std::ostringstream oss;
-    // 格式化输出时间戳 YYYY-MM-DD HH:MM:SS.mmm
-    oss << std::put_time(&tm_now, "%Y-%m-%d %H:%M:%S") << "." << std::setfill('0') << std::setw(3) << millis.count();
-    return oss.str();
+    // 格式 YYYY-MM-DD HH:MM:SS.mmm，秒级部分由 WallClock 按线程缓存
+    char buf[WallClock::TIMESTAMP_LEN];
+    return std::string(buf, WallClock::Timestamp(buf));
 }
 
-void Logger::flush() {
-    if(log_stream_.is_open()) 
-    {
-        log_stream_.write(write_buffer_.peek(), write_buffer_.readable_size());
-        log_stream_.flush();
-    } 
-    else std::fwrite(write_buffer_.peek(), 1, write_buffer_.readable_size(), stdout);
-    write_buffer_.reset();
-    last_flush_time_ = std::chrono::steady_clock::now();
+size_t Logger::collect() {
+    return message_queue_->drain([this](Handoff& h) {
+        pending_.push_back(std::move(h));
+    }, message_queue_->capacity());
 }
 
-void Logger::flush_if_need() {
-    int readable = write_buffer_.readable_size();
-    if(readable == 0) return; // 缓冲区为空，无需刷盘  
-    if(readable >= 4096) flush(); // 缓冲区满，立即刷盘
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - last_flush_time_).count();
-    if(elapsed >= LEAST_FLUSH_SEC_GAP) flush();                                                                                                                                                    
+void Logger::sweep() {
+    std::lock_guard<std::mutex> locker(registry_mtx_);
+    for(auto it = thread_buffers_.begin(); it != thread_buffers_.end();) {
+        std::shared_ptr<ThreadBuffer>& tb = *it;
+        tb->lock();
+        // 暂存块比当前块旧，先写
+        if(tb->stalled) pending_.push_back({tb, std::move(tb->stalled), tb->stalledLines});
+        if(tb->current and tb->current->readable_size() > 0) pending_.push_back(swap_out(tb, !tb->exited));
+        bool exited = tb->exited;
+        tb->unlock();
+        if(exited) it = thread_buffers_.erase(it);
+        else ++it;
+    }
+    last_flush_time_ = std::chrono::steady_clock::now();
 }
 
+void Logger::flush() {
+    // 每次最多 IOV_MAX 块，一次 writev 写入；处理部分写入。
+    // 按大小滚动时在会超过上限的块之前切开，积压的大批日志也会分到多个文件（单个块本身超限时除外）
+    std::vector<struct iovec> iov;
+    for(size_t begin = 0, cnt = 0; begin < pending_.size(); begin += cnt) {
+        rotate_if_needed(pending_[begin].buffer->readable_size());
+        iov.clear();
+        size_t bytes = 0;
+        for(cnt = 0; cnt < IOV_MAX and begin + cnt < pending_.size(); cnt++) {
+            Buffer& buff = *pending_[begin + cnt].buffer;
+            size_t len = buff.readable_size();
+            if(cnt > 0 and log_fd_ >= 0 and rotation_.max_size > 0 and file_size_ + bytes + len > rotation_.max_size) break;
+            iov.push_back({const_cast<char*>(buff.peek()), len});
+            bytes += len;
+        }
+        file_size_ += bytes;
+        int fd = log_fd_ >= 0 ? log_fd_ : STDOUT_FILENO;
+        struct iovec* cur = iov.data();
+        int left = static_cast<int>(cnt);
+        while(left > 0) {
+            ssize_t n = ::writev(fd, cur, left);
+            if(n < 0) {
+                if(errno == EINTR) continue;
+                break; // 磁盘错误时丢弃本批，避免刷盘线程卡死
+            }
+            while(left > 0 and static_cast<size_t>(n) >= cur->iov_len) {
+                n -= cur->iov_len;
+                cur++;
+                left--;
+            }
+            if(left > 0) {
+                cur->iov_base = static_cast<char*>(cur->iov_base) + n;
+                cur->iov_len -= n;
+            }
+        }
+    }
+    sync_if_due();
+    // 写完的块还给所属线程作为备用块
+    for(Handoff& h : pending_) {
+        h.buffer->reset();
+        h.owner->lock();
+        if(!h.owner->spare and !h.owner->exited) h.owner->spare = std::move(h.buffer);
+        h.owner->unlock();
+    }
+    pending_.clear();
+}
 
 void Logger::log_worker_thread() {
-    std::string entry;
-    while(is_running_.load() or (message_queue_ and message_queue_->size())) {
-        if(!message_queue_) break; // 队列未初始化，退出线程
-        bool ok = message_queue_->pop(entry, 1); // 带超时的pop，避免无限阻塞
-        if(!ok) {
-            flush_if_need(); // 超时，检查是否需要刷盘
+    if(!message_queue_) return; // 队列未初始化，退出线程
+    while(true) {
+        collect();
+        // 定期收取空闲线程缓冲区中残留的日志
+        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - last_flush_time_).count();
+        if(elapsed >= LEAST_FLUSH_SEC_GAP) {
+            report_dropped();
+            sweep();
+        }
+        if(!pending_.empty()) {
+            flush();
             continue;
-        }// 超时或队列已停止，检查是否需要缓冲，并继续检查is_running_标志
-        // 将日志条目追加到写入缓冲区
-        write_buffer_.append(entry.c_str(), entry.size());
-        write_buffer_.append("\n", 1);
-        flush_if_need(); // 定期刷盘
-    }
-    // 确保所有日志被写入文件
-    if(write_buffer_.readable_size() > 0) flush();
+        }
+        if(overloaded_.load(std::memory_order_relaxed)) {
+            // 已追上：解除拥塞，立即收取各线程暂存的块
+            overloaded_.store(false, std::memory_order_relaxed);
+            sweep();
+            if(!pending_.empty()) flush();
+        }
+        if(mmap_ring_) sync_if_due(); // 环形映射模式下没有刷盘，按间隔回写映射的脏页
+        if(!is_running_.load()) break; // 已关闭且队列已取空，剩余的由 shutdown 收取
+        // 队列为空时休眠，最多 1 秒，醒来检查是否需要收取
+        std::unique_lock<std::mutex> locker(wake_mtx_);
+        worker_sleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(message_queue_->empty() and is_running_.load()) {
+            wake_cond_.wait_for(locker, std::chrono::seconds(1));
+        }
+        worker_sleeping_.store(false, std::memory_order_relaxed);
+    }
 }
 
 // // 格式化字符串函数，类似于 printf 风格
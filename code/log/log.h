@@ -3,6 +3,7 @@
 
 // 实现异步日志系统，支持日志级别、文件输出和日志滚动（按日期）。
 #include <string>
+#include <vector>
 #include <queue>
 #include <memory>
 #include <mutex>
@@ -12,14 +13,22 @@
 #include <fstream>
 #include <ctime>
 #include <atomic>
+#include <array>
+#include <chrono>
+#include <tuple>
+#include <cstring>
 #include <cstdarg>   
 #include <cstdio>    
 #include <unistd.h>  
 #include <sys/stat.h>
 #include <sys/time.h>
 
+#include "mpscring.h"
 #include "blockqueue.h"
+#include "mmapring.h"
+#include "binlog.h"
 #include "../buffer/buffer.h"
+#include "../timer/clock.h"
 #include "../config/config.h"
 
 enum class LogLevel {
@@ -29,26 +38,86 @@ enum class LogLevel {
     ERROR = 3
 };
 
+// 刷盘队列满时的处理策略（日志盘卡顿时决定写日志的线程是否被拖慢）
+// - BLOCK：等待刷盘线程腾出空间，不丢日志，但磁盘卡顿会阻塞所有写日志的线程；
+// - DROP_NEWEST：每个线程最多暂存一个交不出去的整块，再有新块时丢弃新块；
+// - DROP_OLDEST：同上，但丢弃暂存的旧块，保留最新的日志；
+// - SAMPLE：队列拥塞期间按级别采样（每 N 行保留 1 行），仍交不出去时按 DROP_NEWEST 处理。
+// 含 ERROR 日志（或二进制调用点记录）的块从不丢弃，交不出去时等待。
+enum class LogOverflow {
+    BLOCK = 0,
+    DROP_NEWEST = 1,
+    DROP_OLDEST = 2,
+    SAMPLE = 3
+};
+
+// 日志滚动：跨天后第一次写入时、或文件超过 max_size 时，把当前文件改名为
+// <名>.<日期>.<序号><扩展名>（如 log/webserver.2026-10-18.001.log）并重新打开；
+// 只在刷盘线程上进行，写日志的线程不受影响
+struct LogRotation {
+    uint64_t max_size = 0;    // 单个文件的最大字节数，0 表示只按日期滚动
+    int max_files = 0;        // 保留的旧文件个数，0 表示全部保留
+    bool compress = false;    // 在低优先级后台线程中把旧文件 gzip 压缩
+    int sync_interval_ms = 0; // fdatasync 间隔，0 表示交给内核回写
+};
+
 // 日志类 单例
 // Log类是单例模式，负责日志的格式化、异步 / 同步写入、
-// 日志文件轮转，核心逻辑是 “主线程生产日志→阻塞队列中转→刷盘线程消费日志”。
+// 日志文件轮转，核心逻辑是 “生产者线程写本线程缓冲区→整块经无锁环形队列中转→刷盘线程 writev 落盘”。
+// - 每个写日志的线程有一对缓冲区（当前块 + 备用块），格式化后的日志行直接追加到当前块，
+//   只加本线程的自旋锁（仅在刷盘线程定期收取时才会竞争），不触碰任何全局锁；
+// - 当前块写满 THREAD_BUFFER_SIZE（或写入 ERROR 日志）时与备用块交换，整块交给刷盘线程；
+// - 刷盘线程把收到的块用一次 writev 写入文件，写完后把块还给所属线程作为备用块；
+// - 空闲线程缓冲区里残留的日志由刷盘线程每隔 log_flush_interval 秒主动收取。
+// 同一线程内的日志保持顺序，不同线程的日志按块交错，不保证全局时间顺序。
+// 二进制模式（log_format = binary）下写入的是调用点 id、时间戳与原始参数，
+// 格式化与时间转换推迟到离线解码工具 logdecode，记录格式见 binlog.h。
+// 环形映射模式（log_mmap_size > 0）下日志行由写日志的线程直接拷贝进 <日志文件>.ring 的共享映射，
+// 进程崩溃也能用 logrecover 取回最近的日志，见 mmapring.h。
 
 class Logger {
 public:
+    // 每个线程的日志缓冲块大小，写满后整块交给刷盘线程
+    static constexpr size_t THREAD_BUFFER_SIZE = 64 * 1024;
+
     static Logger& getInstance();
 
     // 初始化日志系统，指定日志文件路径和日志级别
+    // max_queue_size 为等待刷盘的缓冲块数上限；binary 为 true 时写二进制日志
     void initLogger(const std::string& log_file,
-         LogLevel level, int max_queue_size, int64_t log_flush_inteval);
+         LogLevel level, int max_queue_size, int64_t log_flush_inteval, bool binary = false);
     // 记录日志
     void log(LogLevel level, const std::string& message);
     void log(LogLevel level, const Buffer& buffer);
+    // 二进制模式：只记录调用点 id、时间戳与原始参数
+    template<typename... Args>
+    void logBinary(binlog::LogSite& site, const Args&... args);
     // 关闭日志系统，确保所有日志被写入文件
     void shutdown();
     // 设置日志级别
     void setLogLevel(LogLevel level);
     // 获取当前日志级别
     LogLevel getLogLevel() const;
+    // 设置队列满时的策略；sample_rates 为 SAMPLE 策略下 DEBUG / INFO / WARN 每多少行保留 1 行
+    void setOverflowPolicy(LogOverflow policy, const std::array<uint32_t, 3>& sample_rates = {100, 10, 1});
+    LogOverflow getOverflowPolicy() const { return overflow_.load(std::memory_order_relaxed); }
+    // 设置日志滚动与落盘策略，需在 initLogger 之前调用
+    void setRotation(const LogRotation& rotation) { rotation_ = rotation; }
+    // 设置环形映射文件的大小（字节），0 表示不使用；需在 initLogger 之前调用
+    void setMmapSize(size_t bytes) { mmap_size_ = bytes; }
+    // 因队列满或采样被丢弃的日志行数（按级别 / 总数）
+    uint64_t droppedLines(LogLevel level) const;
+    uint64_t droppedLines() const;
+    // 该级别的日志是否会被记录，供日志宏在格式化前判断
+    static bool isEnabled(LogLevel level) {
+        return level >= current_level_.load(std::memory_order_relaxed);
+    }
+    // 是否为二进制日志模式，由 initLogger 设置
+    static bool isBinary() {
+        return binary_.load(std::memory_order_relaxed);
+    }
+    // 刷盘线程句柄，用于绑核等线程放置
+    std::thread::native_handle_type workerHandle() { return worker_thread_.native_handle(); }
 
 private:
     Logger() = default;
@@ -56,49 +125,144 @@ private:
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
-    void log_worker_thread(); // 刷盘线程函数，负责从队列中取日志并写入文件
-    std::string get_timestamp(); // 获取当前时间戳，格式为 YYYY-MM-DD HH:MM:SS
+    struct ThreadBuffer;       // 每个线程的一对缓冲块，定义见 log.cpp
+    struct ThreadBufferHolder; // thread_local 持有者，线程退出时交出剩余日志
+    using LineCount = std::array<uint32_t, 4>; // 块中各级别的日志行数，丢弃时计数
+    // 交给刷盘线程的一整块日志，写完后还给 owner
+    struct Handoff {
+        std::shared_ptr<ThreadBuffer> owner;
+        std::unique_ptr<Buffer> buffer;
+        LineCount lines{};
+        bool keep = false; // 含 ERROR 日志或调用点记录，不能丢弃
+    };
+
+    void log_worker_thread(); // 刷盘线程函数，负责从队列中取缓冲块并写入文件
+    void append_record(LogLevel level, const char* data, size_t len, bool keep = false); // 把一条二进制记录追加到本线程缓冲块
+    uint32_t register_site(binlog::LogSite& site, const char* schema); // 调用点首次执行时分配 id
+    void write_binary_header(); // 二进制模式打开文件后写入 SESSION 与已注册的调用点
+    bool open_log_file(); // 打开 log_file_ 并记录当前大小
+    void rotate_if_needed(size_t incoming); // 刷盘线程：写入前检查日期与大小
+    void rotate(); // 刷盘线程：改名当前文件并重新打开
+    std::string segment_path(const std::string& date, int index) const;
+    // 已滚动的旧文件 (日期, 序号, 路径)，按时间先后排序
+    std::vector<std::tuple<std::string, int, std::string>> list_segments() const;
+    void prune_segments(); // 删除超出保留个数的旧文件
+    void compress_worker(); // 压缩线程函数
+    void sync_if_due(); // 按 sync_interval_ms 调用 fdatasync
+    static std::string& record_scratch(); // 本线程编码二进制记录用的临时缓冲
+    std::shared_ptr<ThreadBuffer>& thread_buffer(); // 当前线程的缓冲区，首次调用时注册
+    static Handoff swap_out(const std::shared_ptr<ThreadBuffer>& tb, bool replace = true); // 取走当前块并换上备用块，调用方持有 tb 的锁
+    bool admit(ThreadBuffer& tb, LogLevel level); // SAMPLE 策略下队列拥塞时按级别采样，调用方持有 tb 的锁
+    void hand_off(Handoff&& handoff); // 入队，队列满时按溢出策略等待或丢弃
+    bool try_push(Handoff& handoff); // 只尝试一次入队，失败时标记拥塞
+    void count_dropped(const LineCount& lines);
+    void report_dropped(); // 刷盘线程：定期汇报丢弃的行数
+    void retire(const std::shared_ptr<ThreadBuffer>& tb); // 线程退出：交出剩余日志
+    void wake_worker(); // 刷盘线程休眠时唤醒它
+    size_t collect(); // 刷盘线程：取出队列中所有缓冲块
+    void sweep(); // 刷盘线程：收取各线程未写满的缓冲块
+    void flush(); // 刷盘线程：把收到的缓冲块一次 writev 写入文件并归还
+    std::string get_timestamp(); // 获取当前时间戳，格式为 YYYY-MM-DD HH:MM:SS.mmm
     std::string get_level_name(LogLevel level);
     
     std::string log_file_; // 日志文件路径
     std::string current_date_; // 当前日志文件对应的日期，格式为 YYYY-MM-DD
-    LogLevel current_level_; // 当前日志级别，只有级别高于等于这个级别的日志才会被记录
-    std::ofstream log_stream_; // 日志文件流，用于写入日志文件
+    // 当前日志级别，只有级别高于等于这个级别的日志才会被记录；静态成员，日志宏判断时无需获取单例
+    static inline std::atomic<LogLevel> current_level_{LogLevel::DEBUG};
+    static inline std::atomic<bool> binary_{false};
+    std::mutex site_mtx_; // 保护调用点注册
+    std::vector<binlog::LogSite*> sites_; // 已注册的调用点，下标 + 1 即 id
+    int log_fd_ = -1; // 日志文件描述符，-1 表示输出到标准输出
 
-    std::unique_ptr<BlockDeque<std::string>> message_queue_; // 日志消息队列，异步写入时使用，注意是指针类型，只有在异步模式下才会初始化
-    Buffer write_buffer_; // 写入缓冲区，用于批量写入日志
+    std::unique_ptr<MpscRing<Handoff>> message_queue_; // 待刷盘的缓冲块队列，注意是指针类型，只有在异步模式下才会初始化
+    // 刷盘线程在队列为空时休眠，生产者看到 worker_sleeping_ 才去加锁通知
+    std::atomic<bool> worker_sleeping_{false};
+    std::mutex wake_mtx_;
+    std::condition_variable wake_cond_;
+    std::mutex registry_mtx_; // 只在线程首次写日志与刷盘线程收取时使用
+    std::vector<std::shared_ptr<ThreadBuffer>> thread_buffers_;
+    std::vector<Handoff> pending_; // 刷盘线程待写入的缓冲块
+    std::atomic<LogOverflow> overflow_{LogOverflow::BLOCK};
+    std::array<uint32_t, 3> sample_rates_{100, 10, 1};
+    std::atomic<bool> overloaded_{false}; // 队列拥塞：有线程入队失败，刷盘线程追上后清除
+    std::array<std::atomic<uint64_t>, 4> dropped_{}; // 各级别丢弃的行数
+    std::array<uint64_t, 4> reported_dropped_{}; // 上次汇报时的丢弃行数，只由刷盘线程访问
+    size_t mmap_size_ = 0;
+    // 环形映射文件；关闭日志系统时不解除映射，避免与仍在写日志的线程竞争，重新初始化时才替换
+    std::unique_ptr<MmapRingFile> mmap_ring_;
+    LogRotation rotation_;
+    uint64_t file_size_ = 0; // 当前文件已写入的字节数
+    std::chrono::steady_clock::time_point last_sync_;
+    std::unique_ptr<BlockDeque<std::string>> compress_queue_; // 等待压缩的旧文件
+    std::atomic<bool> compress_running_{false};
+    std::thread compress_thread_;
     std::thread worker_thread_; // 刷盘线程
     std::atomic<bool> is_running_; // 标志日志系统是否正在运行
     int64_t LEAST_FLUSH_SEC_GAP; // 最小刷新间隔，单位为秒
-    std::chrono::time_point<std::chrono::steady_clock> last_flush_time_; // 上次刷新时间
-    void flush(); // 将缓冲区中的日志写入文件
-    void flush_if_need(); // 检查是否需要刷新日志文件
+    std::chrono::time_point<std::chrono::steady_clock> last_flush_time_; // 上次收取各线程缓冲区的时间
 };
 
 // C++20 std::format 实现的格式化字符串函数，支持任意类型参数，类似于 printf 风格, 占位符为 {}
+// 格式串类型为 std::format_string，占位符与参数不匹配时编译报错
 template<typename... Args>
-std::string format_string(const std::string& fmt, Args&&... args) {
-    auto args_pack = std::make_format_args(std::forward<Args>(args)...);
-    std::string msg = std::vformat(fmt, args_pack);
-    return msg;
+std::string format_string(std::format_string<Args...> fmt, Args&&... args) {
+    return std::format(fmt, std::forward<Args>(args)...);
 }
 
-// 全局日志宏，方便使用
-#define LOG_DEBUG(fmt, ...) \
-    do { \
-        Logger::getInstance().log(LogLevel::DEBUG, format_string(fmt, ##__VA_ARGS__)); \
-    } while(0)
-#define LOG_INFO(fmt, ...) \
-    do { \
-        Logger::getInstance().log(LogLevel::INFO, format_string(fmt, ##__VA_ARGS__)); \
-    } while(0)
-#define LOG_WARN(fmt, ...) \
+template<typename... Args>
+void Logger::logBinary(binlog::LogSite& site, const Args&... args) {
+    if(!is_running_.load(std::memory_order_relaxed)) {
+        // 日志系统未初始化或已关闭时退回文本输出
+        log(static_cast<LogLevel>(site.level), std::vformat(site.fmt, std::make_format_args(args...)));
+        return;
+    }
+    auto values = std::make_tuple(binlog::ToEncodable(args)...);
+    uint32_t id = site.id.load(std::memory_order_acquire);
+    if(id == 0) id = register_site(site, binlog::SCHEMA<std::decay_t<decltype(binlog::ToEncodable(args))>...>);
+
+    size_t payload = std::apply([](const auto&... v) { return (size_t(0) + ... + binlog::EncodedSize(v)); }, values);
+    std::string& rec = record_scratch();
+    rec.resize(binlog::ENTRY_HEADER_SIZE + payload);
+    char* p = rec.data();
+    *p++ = static_cast<char>(binlog::RECORD_ENTRY);
+    uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    uint32_t len = static_cast<uint32_t>(payload);
+    std::memcpy(p, &id, 4);
+    std::memcpy(p + 4, &now, 8);
+    std::memcpy(p + 12, &len, 4);
+    p += 16;
+    std::apply([&p](const auto&... v) { ((p = binlog::Encode(p, v)), ...); }, values);
+    append_record(static_cast<LogLevel>(site.level), rec.data(), rec.size());
+}
+
+// 编译期最低日志级别：低于该级别的日志语句不生成任何代码（仍做格式串检查）
+// 例如 make LOG_MIN_LEVEL=1 去掉所有 DEBUG 日志；默认保留全部级别，由运行期级别过滤
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+// 先判断级别再求值参数、格式化：被过滤的日志只有一次原子读和一个分支
+// 二进制模式下每个调用点展开一个常量初始化的静态 LogSite，首次执行时注册
+#define LOG_BASE(level, fmt, ...) \
     do { \
-        Logger::getInstance().log(LogLevel::WARN, format_string(fmt, ##__VA_ARGS__)); \
+        if constexpr (static_cast<int>(level) >= LOG_MIN_LEVEL) { \
+            if(Logger::isEnabled(level)) { \
+                if(Logger::isBinary()) { \
+                    static constinit binlog::LogSite log_site_(static_cast<int>(level), fmt, __FILE__, __LINE__); \
+                    (void)sizeof(format_string(fmt, ##__VA_ARGS__)); /* 仍在编译期检查格式串 */ \
+                    Logger::getInstance().logBinary(log_site_, ##__VA_ARGS__); \
+                } else { \
+                    Logger::getInstance().log(level, format_string(fmt, ##__VA_ARGS__)); \
+                } \
+            } \
+        } \
     } while(0)
-#define LOG_ERROR(fmt, ...) \
-    do { \
-        Logger::getInstance().log(LogLevel::ERROR, format_string(fmt, ##__VA_ARGS__)); \
-    } while(0)  
+
+// 全局日志宏，方便使用
+#define LOG_DEBUG(fmt, ...) LOG_BASE(LogLevel::DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...) LOG_BASE(LogLevel::INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...) LOG_BASE(LogLevel::WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) LOG_BASE(LogLevel::ERROR, fmt, ##__VA_ARGS__)
 
 #endif /* LOG_H */
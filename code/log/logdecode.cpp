@@ -0,0 +1,52 @@
+// 二进制日志解码工具：把 log_format = binary 写出的日志还原为文本格式
+// 用法：logdecode <日志文件> [输出文件]，不指定输出文件时写到标准输出
+//       logdecode --access <访问日志> [clf|json]，还原 access_log_format = binary 写出的访问日志
+#include "binlog.h"
+#include "accesslog.h"
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+
+int main(int argc, char* argv[]) {
+    if(argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <binary log> [output]" << std::endl;
+        std::cerr << "       " << argv[0] << " --access <binary access log> [clf|json]" << std::endl;
+        return 1;
+    }
+    if(std::string(argv[1]) == "--access") {
+        if(argc < 3) {
+            std::cerr << "Missing access log file" << std::endl;
+            return 1;
+        }
+        std::ifstream in(argv[2], std::ios::binary);
+        if(!in) {
+            std::cerr << "Open " << argv[2] << " failed" << std::endl;
+            return 1;
+        }
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        AccessLogFormat format = (argc >= 4 and std::string(argv[3]) == "json") ? AccessLogFormat::JSON : AccessLogFormat::CLF;
+        size_t n = AccessLog::Decode(data.data(), data.size(), format, std::cout);
+        std::cerr << n << " access records decoded" << std::endl;
+        return 0;
+    }
+    std::ifstream in(argv[1], std::ios::binary);
+    if(!in) {
+        std::cerr << "Open " << argv[1] << " failed" << std::endl;
+        return 1;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    std::ofstream file;
+    if(argc >= 3) {
+        file.open(argv[2]);
+        if(!file) {
+            std::cerr << "Open " << argv[2] << " failed" << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = argc >= 3 ? file : std::cout;
+    size_t n = binlog::Decode(data.data(), data.size(), out);
+    std::cerr << n << " entries decoded" << std::endl;
+    return 0;
+}
@@ -0,0 +1,33 @@
+// 环形日志恢复工具：按时间顺序导出 log_mmap_size 模式写入的 <日志文件>.ring
+// 用法：logrecover <环形文件> [输出文件]，不指定输出文件时写到标准输出
+#include "mmapring.h"
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+
+int main(int argc, char* argv[]) {
+    if(argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <ring file> [output]" << std::endl;
+        return 1;
+    }
+    std::ifstream in(argv[1], std::ios::binary);
+    if(!in) {
+        std::cerr << "Open " << argv[1] << " failed" << std::endl;
+        return 1;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    std::ofstream file;
+    if(argc >= 3) {
+        file.open(argv[2]);
+        if(!file) {
+            std::cerr << "Open " << argv[2] << " failed" << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = argc >= 3 ? file : std::cout;
+    size_t n = MmapRingFile::Recover(data.data(), data.size(), out);
+    std::cerr << n << " lines recovered" << std::endl;
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include "mmapring.h"
+
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+constexpr char MAGIC[8] = {'W', 'S', 'M', 'R', 'I', 'N', 'G', '1'};
+constexpr uint32_t PAD_FLAG = 0x80000000u;
+
+uint64_t Align8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+// 位置 pos 处记录的印记，不同圈的同一物理位置印记不同
+uint32_t Stamp(uint64_t pos) { return static_cast<uint32_t>(pos >> 3) ^ 0x5a5a5a5au; }
+
+uint64_t MakeHead(uint64_t pos, uint32_t len) { return (static_cast<uint64_t>(len) << 32) | Stamp(pos); }
+
+} // namespace
+
+MmapRingFile::~MmapRingFile() {
+    Close();
+}
+
+bool MmapRingFile::Open(const std::string& path, size_t capacity) {
+    Close();
+    size_t blocks = (capacity + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    if(blocks < 2) blocks = 2;
+    size_t cap = blocks * BLOCK_SIZE;
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(fd < 0) return false;
+    size_t len = HEADER_SIZE + cap;
+    struct stat st;
+    bool reuse = ::fstat(fd, &st) == 0 and static_cast<size_t>(st.st_size) == len;
+    if(!reuse and ::ftruncate(fd, len) != 0) {
+        ::close(fd);
+        return false;
+    }
+    void* addr = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // 映射建立后不再需要 fd
+    if(addr == MAP_FAILED) return false;
+
+    header_ = static_cast<Header*>(addr);
+    data_ = static_cast<char*>(addr) + HEADER_SIZE;
+    mapLen_ = len;
+    if(!reuse or std::memcmp(header_->magic, MAGIC, sizeof(MAGIC)) != 0
+        or header_->capacity != cap or header_->blockSize != BLOCK_SIZE) {
+        std::memset(addr, 0, HEADER_SIZE);
+        header_->capacity = cap;
+        header_->blockSize = BLOCK_SIZE;
+        header_->writePos.store(0, std::memory_order_relaxed);
+        std::memcpy(header_->magic, MAGIC, sizeof(MAGIC)); // 最后写魔数
+    } else {
+        // 上次运行的最后一块可能有未提交的记录，从下一块开始写，旧记录在恢复时仍可读
+        uint64_t pos = header_->writePos.load(std::memory_order_relaxed);
+        if(pos % BLOCK_SIZE != 0) header_->writePos.store(pos - pos % BLOCK_SIZE + BLOCK_SIZE, std::memory_order_relaxed);
+    }
+    blockCount_ = cap / BLOCK_SIZE;
+    blocks_ = std::make_unique<std::atomic<uint64_t>[]>(blockCount_);
+    for(uint64_t i = 0; i < blockCount_; i++) blocks_[i].store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void MmapRingFile::Close() {
+    if(!header_) return;
+    ::munmap(header_, mapLen_);
+    header_ = nullptr;
+    data_ = nullptr;
+    mapLen_ = 0;
+    blocks_.reset();
+    blockCount_ = 0;
+}
+
+size_t MmapRingFile::Capacity() const {
+    return header_ ? header_->capacity : 0;
+}
+
+uint64_t MmapRingFile::WritePos() const {
+    return header_ ? header_->writePos.load(std::memory_order_relaxed) : 0;
+}
+
+bool MmapRingFile::EnterBlock_(uint64_t start) {
+    constexpr uint64_t USERS = 0xffff;
+    uint64_t gen = start / BLOCK_SIZE;
+    std::atomic<uint64_t>& slot = blocks_[gen % blockCount_];
+    uint64_t cur = slot.load(std::memory_order_acquire);
+    while(true) {
+        uint64_t owner = cur >> 16;
+        if(owner > gen) return false; // 被套圈，本条已不在保留窗口内
+        uint64_t next;
+        if(owner == gen) {
+            next = cur + 1;
+        } else if((cur & USERS) == 0) {
+            next = (gen << 16) | 1; // 接管上一圈的块
+        } else {
+            std::this_thread::yield(); // 上一圈还有写线程在拷贝，等它完成
+            cur = slot.load(std::memory_order_acquire);
+            continue;
+        }
+        if(slot.compare_exchange_weak(cur, next, std::memory_order_acquire, std::memory_order_relaxed)) return true;
+    }
+}
+
+void MmapRingFile::LeaveBlock_(uint64_t start) {
+    blocks_[start / BLOCK_SIZE % blockCount_].fetch_sub(1, std::memory_order_release);
+}
+
+void MmapRingFile::Append(const char* data, size_t len) {
+    if(len > MAX_RECORD) len = MAX_RECORD;
+    uint64_t need = Align8(8 + len);
+    uint64_t cap = header_->capacity;
+    uint64_t pos = header_->writePos.load(std::memory_order_relaxed);
+    uint64_t start, end;
+    do {
+        // 当前块剩余空间不够时，从下一块开始，并把剩余部分留作填充
+        uint64_t off = pos % BLOCK_SIZE;
+        start = off + need > BLOCK_SIZE ? pos - off + BLOCK_SIZE : pos;
+        end = start + need;
+    } while(!header_->writePos.compare_exchange_weak(pos, end, std::memory_order_relaxed));
+
+    if(start != pos and EnterBlock_(pos)) {
+        uint32_t padLen = static_cast<uint32_t>(start - pos - 8);
+        std::atomic_ref<uint64_t>(*reinterpret_cast<uint64_t*>(data_ + pos % cap))
+            .store(MakeHead(pos, padLen | PAD_FLAG), std::memory_order_release);
+        LeaveBlock_(pos);
+    }
+    if(!EnterBlock_(start)) return;
+    char* rec = data_ + start % cap;
+    std::memcpy(rec + 8, data, len);
+    // 内容写完后再提交记录头
+    std::atomic_ref<uint64_t>(*reinterpret_cast<uint64_t*>(rec))
+        .store(MakeHead(start, static_cast<uint32_t>(len)), std::memory_order_release);
+    LeaveBlock_(start);
+}
+
+void MmapRingFile::Sync() {
+    if(header_) ::msync(header_, mapLen_, MS_ASYNC);
+}
+
+size_t MmapRingFile::Recover(const char* file, size_t fileLen, std::ostream& out) {
+    if(fileLen < HEADER_SIZE) return 0;
+    const Header* header = reinterpret_cast<const Header*>(file);
+    if(std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) return 0;
+    uint64_t cap = header->capacity;
+    uint64_t block = header->blockSize;
+    if(block == 0 or cap % block != 0 or fileLen < HEADER_SIZE + cap) return 0;
+    const char* data = file + HEADER_SIZE;
+    uint64_t writePos = header->writePos.load(std::memory_order_relaxed);
+
+    // 最旧的完整块：写位置往前一圈，向上对齐到块边界（该块之前的部分已被新数据覆盖）
+    uint64_t oldest = writePos > cap ? writePos - cap : 0;
+    oldest = (oldest + block - 1) / block * block;
+    size_t records = 0;
+    for(uint64_t blk = oldest; blk < writePos; blk += block) {
+        uint64_t blockEnd = std::min(blk + block, writePos);
+        for(uint64_t pos = blk; pos + 8 <= blockEnd;) {
+            uint64_t head;
+            std::memcpy(&head, data + pos % cap, sizeof(head));
+            if(static_cast<uint32_t>(head) != Stamp(pos)) break; // 未提交或旧数据，跳过本块剩余部分
+            uint32_t len = static_cast<uint32_t>(head >> 32);
+            bool pad = len & PAD_FLAG;
+            len &= ~PAD_FLAG;
+            if(pos + 8 + len > blk + block) break;
+            if(!pad) {
+                out.write(data + pos % cap + 8, len);
+                records++;
+            }
+            pos += Align8(8 + len);
+        }
+    }
+    return records;
+}
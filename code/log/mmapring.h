@@ -0,0 +1,73 @@
+#ifndef MMAPRING_H
+#define MMAPRING_H
+/*
+    MmapRingFile 是映射到文件的环形日志区，用于崩溃现场分析：
+    - 写日志的线程直接把日志行拷贝进共享映射（MAP_SHARED），不经过刷盘线程、没有 write 系统调用；
+      进程崩溃时已写入的页仍在页缓存中，由内核落盘，保留最近 capacity 字节的日志；
+    - 写位置 writePos 单调递增，位于文件头中；生产者用一次 CAS 预留空间，拷贝完成后再写记录头提交；
+    - 数据区按 BLOCK_SIZE 分块，记录不跨块（放不下时用填充记录补齐到块尾），
+      恢复时即使最旧的块被部分覆盖，也能从下一个块的开头重新对齐；
+    - 记录头 8 字节：低 32 位为由位置得到的印记，高 32 位为长度（最高位表示填充）。
+      印记与位置不符的记录（尚未提交或上一圈的旧数据）在恢复时跳过该块的剩余部分。
+    - 每个物理块有一个进程内的占用字（块号 + 正在拷贝的写线程数）。写线程拷贝前登记到所在块，
+      已被新一圈占用的块直接丢弃本条（它已在保留窗口之外）；新一圈要接管仍有旧写线程在拷贝的块时
+      让出 CPU 等待其完成，避免被挂起的写线程覆盖更新的记录。正常情况下不会等待。
+    文件布局：4KB 文件头（魔数、数据区容量、块大小、写位置），之后是数据区。
+*/
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <memory>
+
+class MmapRingFile {
+public:
+    static constexpr size_t HEADER_SIZE = 4096;
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    // 单条记录的最大长度，更长的日志行被截断
+    static constexpr size_t MAX_RECORD = BLOCK_SIZE - 8;
+
+    MmapRingFile() = default;
+    ~MmapRingFile();
+    MmapRingFile(const MmapRingFile&) = delete;
+    MmapRingFile& operator=(const MmapRingFile&) = delete;
+
+    // 打开或创建环形文件，容量向上取整到 BLOCK_SIZE 的整数倍（至少两块）；
+    // 已有文件格式与容量一致时接着上次的位置写，保留崩溃前的日志
+    bool Open(const std::string& path, size_t capacity);
+    void Close();
+    bool IsOpen() const { return header_ != nullptr; }
+
+    // 任意线程调用，无锁、无系统调用（只有套圈追上仍在拷贝的写线程时才让出 CPU）
+    void Append(const char* data, size_t len);
+    // 把映射的脏页写回磁盘（防掉电），在刷盘线程上调用
+    void Sync();
+
+    size_t Capacity() const;
+    uint64_t WritePos() const;
+
+    // 从文件内容中按时间顺序恢复日志，返回恢复的记录数
+    static size_t Recover(const char* data, size_t len, std::ostream& out);
+
+private:
+    struct Header {
+        char magic[8];
+        uint64_t capacity;
+        uint64_t blockSize;
+        std::atomic<uint64_t> writePos;
+    };
+
+    // 登记到 start 所在的块；返回 false 表示该块已被新一圈占用
+    bool EnterBlock_(uint64_t start);
+    void LeaveBlock_(uint64_t start);
+
+    Header* header_ = nullptr;
+    // 每个物理块的占用字：高 48 位为当前占用的块号（位置 / BLOCK_SIZE），低 16 位为正在拷贝的写线程数
+    std::unique_ptr<std::atomic<uint64_t>[]> blocks_;
+    uint64_t blockCount_ = 0;
+    char* data_ = nullptr;
+    size_t mapLen_ = 0;
+};
+
+#endif /* MMAPRING_H */
@@ -0,0 +1,122 @@
+#ifndef MPSCRING_H
+#define MPSCRING_H
+/*
+    MpscRing 是有界的无锁多生产者单消费者环形队列，用作异步日志的传输通道：
+    多个线程（生产者）写日志时把日志行移入预先分配好的槽位；
+    刷盘线程（唯一消费者）批量取出写入文件。
+    每个槽位带一个序号：序号 == 位置 表示槽位空闲可写，序号 == 位置 + 1 表示已写入可读。
+    生产者之间只竞争一次 tail_ 的 CAS，不加锁、不通知条件变量；队列满时 try_push 返回 false，
+    由调用方决定等待或丢弃。消费者独占 head_，取走后把槽位序号推进一圈交还给生产者。
+*/
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+
+template<class T>
+class MpscRing {
+public:
+    // 容量向上取整到 2 的幂，便于用掩码取下标
+    explicit MpscRing(size_t capacity);
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    // 任意线程调用，队列满时返回 false（item 保持不变）
+    bool try_push(T&& item);
+
+    // 以下只能由唯一的消费者线程调用
+    bool try_pop(T& item);
+    // 依次对最多 max 个元素调用 f(T&)，返回处理的个数
+    template<class F>
+    size_t drain(F&& f, size_t max);
+
+    // 近似值，仅供统计与判断是否有积压
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    // 每个槽位独占缓存行，避免相邻槽位的生产者互相失效
+    struct alignas(64) Slot {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    static size_t RoundUpPow2_(size_t n);
+
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<size_t> tail_{0}; // 下一个写入位置，生产者竞争
+    alignas(64) std::atomic<size_t> head_{0}; // 下一个读取位置，只有消费者修改
+};
+
+template<class T>
+size_t MpscRing<T>::RoundUpPow2_(size_t n) {
+    size_t cap = 2;
+    while(cap < n) cap <<= 1;
+    return cap;
+}
+
+template<class T>
+MpscRing<T>::MpscRing(size_t capacity)
+    : mask_(RoundUpPow2_(capacity) - 1), slots_(new Slot[mask_ + 1]) {
+    assert(capacity > 0);
+    for(size_t i = 0; i <= mask_; i++) {
+        slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+}
+
+template<class T>
+bool MpscRing<T>::try_push(T&& item) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while(true) {
+        slot = &slots_[pos & mask_];
+        size_t seq = slot->seq.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if(diff == 0) {
+            // 槽位空闲，抢占该位置；失败时 pos 被更新为最新的 tail_
+            if(tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if(diff < 0) {
+            return false; // 槽位还没被消费者取走，队列已满
+        } else {
+            pos = tail_.load(std::memory_order_relaxed); // 被其他生产者抢先，重试
+        }
+    }
+    slot->value = std::move(item);
+    slot->seq.store(pos + 1, std::memory_order_release); // 发布给消费者
+    return true;
+}
+
+template<class T>
+bool MpscRing<T>::try_pop(T& item) {
+    return drain([&item](T& v) { item = std::move(v); }, 1) == 1;
+}
+
+template<class T>
+template<class F>
+size_t MpscRing<T>::drain(F&& f, size_t max) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t n = 0;
+    for(; n < max; n++, head++) {
+        Slot& slot = slots_[head & mask_];
+        if(slot.seq.load(std::memory_order_acquire) != head + 1) break; // 尚未写入（或写入未完成）
+        f(slot.value);
+        // 在消费者线程释放旧值，生产者下次写入时不必承担析构开销
+        slot.value = T();
+        slot.seq.store(head + mask_ + 1, std::memory_order_release); // 交还给下一圈的生产者
+    }
+    head_.store(head, std::memory_order_relaxed);
+    return n;
+}
+
+template<class T>
+size_t MpscRing<T>::size() const {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+}
+
+#endif /* MPSCRING_H */
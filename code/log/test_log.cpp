@@ -0,0 +1,724 @@
+
+#include "log.h"
+#include "blockqueue.h"
+#include "mpscring.h"
+#include "accesslog.h"
+#include <iostream>
+#include <fstream>
+#include <cassert>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <sstream>
+#include <iterator>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include <filesystem>
+#include <algorithm>
+#include <map>
+#include <sys/wait.h>
+#include <arpa/inet.h>
+
+// 测试1：环形队列基本功能，满时入队失败，取出后可继续写入
+void testRingBasic() {
+    std::cout << "=== Test 1: MpscRing Basic ===" << std::endl;
+    MpscRing<std::string> ring(5);
+    assert(ring.capacity() == 8); // 向上取整到 2 的幂
+    for(int i = 0; i < 8; i++) {
+        std::string s = "line" + std::to_string(i);
+        assert(ring.try_push(std::move(s)));
+    }
+    std::string extra = "overflow";
+    assert(!ring.try_push(std::move(extra)));
+    assert(extra == "overflow"); // 失败时不移走参数
+    assert(ring.size() == 8);
+
+    std::string out;
+    assert(ring.try_pop(out) and out == "line0");
+    assert(ring.try_push(std::move(extra)));
+    std::vector<std::string> rest;
+    size_t n = ring.drain([&rest](std::string& s) { rest.push_back(s); }, 100);
+    assert(n == 8 and rest.front() == "line1" and rest.back() == "overflow");
+    assert(ring.empty() and !ring.try_pop(out));
+    (void)n;
+    std::cout << "✓ Test 1 passed!" << std::endl;
+}
+
+// 测试2：多生产者并发入队，不丢不重，且每个生产者内部保持顺序
+void testRingConcurrent() {
+    std::cout << "=== Test 2: MpscRing Multi-Producer ===" << std::endl;
+    const int producers = 8;
+    const uint64_t perThread = 200000;
+    MpscRing<uint64_t> ring(1024);
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; p++) {
+        threads.emplace_back([&ring, p, perThread]() {
+            for(uint64_t i = 0; i < perThread; i++) {
+                uint64_t v = (static_cast<uint64_t>(p) << 32) | i;
+                while(!ring.try_push(std::move(v))) std::this_thread::yield();
+            }
+        });
+    }
+    std::vector<uint64_t> next(producers, 0);
+    uint64_t received = 0;
+    while(received < producers * perThread) {
+        received += ring.drain([&next](uint64_t& v) {
+            int p = static_cast<int>(v >> 32);
+            assert((v & 0xffffffff) == next[p]);
+            next[p]++;
+        }, 256);
+    }
+    for(auto& t : threads) t.join();
+    for(int p = 0; p < producers; p++) assert(next[p] == perThread);
+    assert(ring.empty());
+    std::cout << "✓ Test 2 passed!" << std::endl;
+}
+
+static int countLines(const char* path);
+
+// 测试3：关闭日志系统时队列中的日志全部落盘
+void testShutdownFlushesAll() {
+    std::cout << "=== Test 3: Logger Shutdown Keeps Every Line ===" << std::endl;
+    const char* path = "log/test_log_shutdown.log";
+    std::remove(path);
+    Logger::getInstance().initLogger(path, LogLevel::INFO, 1024, 3);
+    const int threads = 4, perThread = 20000;
+    std::vector<std::thread> producers;
+    for(int t = 0; t < threads; t++) {
+        producers.emplace_back([t]() {
+            for(int i = 0; i < perThread; i++) LOG_INFO("producer {} line {}", t, i);
+        });
+    }
+    for(auto& p : producers) p.join();
+    Logger::getInstance().shutdown();
+
+    assert(countLines(path) == threads * perThread);
+    std::cout << "✓ Test 3 passed!" << std::endl;
+}
+
+// 生产者各写 perThread 条日志行，消费者批量取出，返回每秒条数
+template<class Push, class Drain>
+double runQueueBench(int producers, int perThread, Push push, Drain drain) {
+    std::atomic<bool> done{false};
+    uint64_t consumed = 0;
+    const uint64_t total = static_cast<uint64_t>(producers) * perThread;
+    auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&]() {
+        while(consumed < total) consumed += drain();
+        done.store(true);
+    });
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; p++) {
+        threads.emplace_back([&push, perThread]() {
+            for(int i = 0; i < perThread; i++) {
+                push(std::string("2026-01-01 00:00:00.000 [INFO] Client[42](127.0.0.1:50000) in, userCount: 1"));
+            }
+        });
+    }
+    for(auto& t : threads) t.join();
+    consumer.join();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total / sec;
+}
+
+// 测试4：8/16/32 个生产者下，BlockDeque（逐个取 / pop_n 批量取）与 MpscRing 的吞吐对比
+void benchQueues() {
+    std::cout << "=== Test 4: BlockDeque vs MpscRing Throughput ===" << std::endl;
+    const int totalLines = 1600000;
+    for(int producers : {8, 16, 32}) {
+        int perThread = totalLines / producers;
+
+        BlockDeque<std::string> deque(1024);
+        double dequeRate = runQueueBench(producers, perThread,
+            [&deque](std::string&& s) { deque.push_back(std::move(s)); },
+            [&deque]() -> uint64_t {
+                std::string s;
+                return deque.pop(s, std::chrono::milliseconds(100)) ? 1 : 0;
+            });
+
+        BlockDeque<std::string> batchDeque(1024);
+        std::vector<std::string> batch;
+        double batchRate = runQueueBench(producers, perThread,
+            [&batchDeque](std::string&& s) { batchDeque.push_back(std::move(s)); },
+            [&batchDeque, &batch]() -> uint64_t {
+                batch.clear();
+                return batchDeque.pop_n(batch, 512, std::chrono::milliseconds(100));
+            });
+
+        MpscRing<std::string> ring(1024);
+        double ringRate = runQueueBench(producers, perThread,
+            [&ring](std::string&& s) {
+                while(!ring.try_push(std::move(s))) std::this_thread::yield();
+            },
+            [&ring]() -> uint64_t {
+                uint64_t n = ring.drain([](std::string&) {}, 512);
+                if(n == 0) std::this_thread::yield();
+                return n;
+            });
+
+        std::cout << producers << " producers: BlockDeque " << static_cast<uint64_t>(dequeRate) << " lines/s, "
+                  << "BlockDeque pop_n " << static_cast<uint64_t>(batchRate) << " lines/s, "
+                  << "MpscRing " << static_cast<uint64_t>(ringRate) << " lines/s ("
+                  << ringRate / dequeRate << "x)" << std::endl;
+    }
+    std::cout << "✓ Test 4 done!" << std::endl;
+}
+
+// 统计文件行数
+static int countLines(const char* path) {
+    std::ifstream in(path);
+    std::string line;
+    int lines = 0;
+    while(std::getline(in, line)) lines++;
+    return lines;
+}
+
+// 测试5：错误日志不等缓冲块写满，立即交给刷盘线程
+void testErrorHandoff() {
+    std::cout << "=== Test 5: ERROR Lines Are Handed Off Immediately ===" << std::endl;
+    const char* path = "log/test_log_error.log";
+    std::remove(path);
+    Logger::getInstance().initLogger(path, LogLevel::INFO, 1024, 60);
+    LOG_INFO("buffered line");
+    LOG_ERROR("urgent line");
+    bool seen = false;
+    for(int i = 0; i < 100 and !seen; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        seen = countLines(path) == 2; // INFO 与 ERROR 在同一块中一起落盘
+    }
+    assert(seen);
+    Logger::getInstance().shutdown();
+    std::cout << "✓ Test 5 passed!" << std::endl;
+}
+
+// 测试6：多线程经 Logger 写文件的端到端吞吐
+void benchLogger() {
+    std::cout << "=== Test 6: Logger End-To-End Throughput ===" << std::endl;
+    const char* path = "log/test_log_bench.log";
+    for(int producers : {1, 8, 16}) {
+        std::remove(path);
+        Logger::getInstance().initLogger(path, LogLevel::INFO, 1024, 3);
+        const int perThread = 1600000 / producers;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for(int t = 0; t < producers; t++) {
+            threads.emplace_back([t, perThread]() {
+                for(int i = 0; i < perThread; i++) LOG_INFO("Client[{}](127.0.0.1:{}) in, userCount: {}", t, 50000 + i, i);
+            });
+        }
+        for(auto& th : threads) th.join();
+        Logger::getInstance().shutdown();
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        int lines = countLines(path);
+        assert(lines == producers * perThread);
+        std::cout << producers << " producers: " << static_cast<uint64_t>(lines / sec) << " lines/s" << std::endl;
+    }
+    std::remove(path);
+    std::cout << "✓ Test 6 done!" << std::endl;
+}
+
+// 测试7：被过滤的日志不求值参数、不格式化
+void testLevelFilter() {
+    std::cout << "=== Test 7: Level Check Before Formatting ===" << std::endl;
+    Logger::getInstance().initLogger("log/test_log_filter.log", LogLevel::WARN, 1024, 3);
+    int evaluated = 0;
+    auto expensive = [&evaluated]() { evaluated++; return std::string(256, 'x'); };
+    LOG_DEBUG("debug {}", expensive());
+    LOG_INFO("info {}", expensive());
+    assert(evaluated == 0);
+    LOG_WARN("warn {}", expensive());
+    assert(evaluated == 1);
+
+    // 被过滤的日志语句只剩一次原子读和分支
+    const int calls = 10000000;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < calls; i++) LOG_DEBUG("request {} parsed, path: {}", i, expensive());
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+    assert(evaluated == 1);
+    Logger::getInstance().shutdown();
+    std::cout << "suppressed LOG_DEBUG: " << ns << " ns/call" << std::endl;
+    std::cout << "✓ Test 7 passed!" << std::endl;
+}
+
+static std::string readFile(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+// 测试8：二进制日志经解码后与文本模式的格式化结果一致
+void testBinaryRoundTrip() {
+    std::cout << "=== Test 8: Binary Log Decodes To Text ===" << std::endl;
+    const char* path = "log/test_log_binary.log";
+    std::remove(path);
+    Logger::getInstance().initLogger(path, LogLevel::INFO, 1024, 3, true);
+    assert(Logger::isBinary());
+    std::string user = "alice";
+    const char* method = "GET";
+    for(int i = 0; i < 3; i++) {
+        LOG_INFO("Client[{}]({}:{}) in, userCount: {}", 42 + i, "127.0.0.1", 50000u + i, -i);
+    }
+    LOG_WARN("user {} {} {:.2f}ms ok={} tag={} {{literal}}", user, method, 3.14159, true, 'x');
+    LOG_DEBUG("filtered {}", 1); // 低于当前级别，不写入
+    std::thread([]() { LOG_ERROR("{1} before {0}, size {2:>5}", "b", "a", size_t(7)); }).join();
+    Logger::getInstance().shutdown();
+
+    std::string data = readFile(path);
+    std::ostringstream out;
+    size_t n = binlog::Decode(data.data(), data.size(), out);
+    assert(n == 5);
+    std::vector<std::string> lines;
+    std::istringstream in(out.str());
+    for(std::string line; std::getline(in, line);) lines.push_back(line);
+    assert(lines.size() == 5);
+    // 不同线程的缓冲块交错落盘（ERROR 所在的块先交出），按内容查找；时间戳格式与文本模式相同
+    auto has = [&lines](const std::string& levelAndMsg) {
+        for(const std::string& line : lines) {
+            if(line.size() > 23 and line[4] == '-' and line[19] == '.' and line.substr(23) == levelAndMsg) return true;
+        }
+        return false;
+    };
+    assert(has(" [INFO] Client[42](127.0.0.1:50000) in, userCount: 0"));
+    assert(has(" [INFO] Client[44](127.0.0.1:50002) in, userCount: -2"));
+    assert(has(" [WARN] user alice GET 3.14ms ok=true tag=x {literal}"));
+    assert(has(" [ERROR] a before b, size     7"));
+
+    // 截断的尾部记录被忽略
+    std::ostringstream partial;
+    assert(binlog::Decode(data.data(), data.size() - 3, partial) == 4);
+    std::remove(path);
+    (void)n;
+    std::cout << "✓ Test 8 passed!" << std::endl;
+}
+
+// 测试9：请求路径上典型日志语句的调用开销，文本模式与二进制模式对比
+void benchBinaryCall() {
+    std::cout << "=== Test 9: Text vs Binary Call Latency ===" << std::endl;
+    const char* path = "log/test_log_call.log";
+    const int calls = 2000000;
+    std::string url = "/index.html";
+    for(bool binary : {false, true}) {
+        std::remove(path);
+        Logger::getInstance().initLogger(path, LogLevel::INFO, 1024, 3, binary);
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < calls; i++) LOG_INFO("Client[{}] GET {} 200 {} bytes", i, url, 1024 + i);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+        Logger::getInstance().shutdown();
+        std::cout << (binary ? "binary" : "text  ") << " LOG_INFO: " << ns << " ns/call" << std::endl;
+    }
+    std::remove(path);
+    std::cout << "✓ Test 9 done!" << std::endl;
+}
+
+// 测试10：缓存的时间戳与 strftime 逐字段格式化结果一致，且开销远低于原实现
+void testCachedTimestamp() {
+    std::cout << "=== Test 10: Cached Timestamp ===" << std::endl;
+    char buf[WallClock::TIMESTAMP_LEN];
+    for(int i = 0; i < 3; i++) {
+        time_t before = std::time(nullptr);
+        WallClock::Timestamp(buf);
+        time_t after = std::time(nullptr);
+        if(before != after) continue; // 跨秒时重试
+        std::tm tm;
+        localtime_r(&before, &tm);
+        char expect[32];
+        std::strftime(expect, sizeof(expect), "%Y-%m-%d %H:%M:%S", &tm);
+        assert(std::string(buf, 19) == expect);
+        assert(buf[19] == '.' and isdigit(buf[20]) and isdigit(buf[21]) and isdigit(buf[22]));
+        break;
+    }
+
+    const int calls = 5000000;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < calls; i++) {
+        WallClock::Timestamp(buf);
+        asm volatile("" : : "r"(buf) : "memory");
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+    std::cout << "WallClock::Timestamp: " << ns << " ns/call" << std::endl;
+    std::cout << "✓ Test 10 passed!" << std::endl;
+}
+
+// 测试11：日志盘卡住（写入无人读取的 FIFO）时，非阻塞策略下写日志的延迟有上界，
+// 丢弃的行数被计数并汇报，ERROR 日志一条不丢
+void testOverflowPolicies() {
+    std::cout << "=== Test 11: Non-Blocking Overflow Policies ===" << std::endl;
+    const char* path = "log/test_log_overflow.fifo";
+    for(LogOverflow policy : {LogOverflow::DROP_NEWEST, LogOverflow::DROP_OLDEST, LogOverflow::SAMPLE}) {
+        std::remove(path);
+        assert(mkfifo(path, 0644) == 0);
+        int reader = ::open(path, O_RDONLY | O_NONBLOCK); // 先打开读端，Logger 打开写端时不阻塞
+        assert(reader >= 0);
+        Logger& logger = Logger::getInstance();
+        logger.setOverflowPolicy(policy, {0, 4, 1});
+        logger.initLogger(path, LogLevel::INFO, 4, 1);
+        uint64_t droppedBefore = logger.droppedLines();
+
+        // 管道写满后刷盘线程阻塞在 writev，队列随之写满
+        const int threads = 4, perThread = 50000;
+        std::atomic<int64_t> maxNs{0};
+        std::vector<std::thread> producers;
+        for(int t = 0; t < threads; t++) {
+            producers.emplace_back([t, &maxNs]() {
+                int64_t localMax = 0;
+                for(int i = 0; i < perThread; i++) {
+                    auto start = std::chrono::steady_clock::now();
+                    LOG_INFO("producer {} line {} padding {}", t, i, std::string(64, 'p'));
+                    localMax = std::max<int64_t>(localMax, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start).count());
+                }
+                int64_t cur = maxNs.load();
+                while(localMax > cur and !maxNs.compare_exchange_weak(cur, localMax)) {}
+            });
+        }
+        for(auto& p : producers) p.join();
+        uint64_t dropped = logger.droppedLines() - droppedBefore;
+        assert(dropped > 0);
+        assert(logger.droppedLines(LogLevel::ERROR) == 0);
+
+        // 磁盘恢复：开始读取，随后写入的 ERROR 必须全部落盘，并能看到丢弃汇报
+        std::atomic<bool> stop{false};
+        std::string content;
+        std::thread drainer([reader, &stop, &content]() {
+            char buf[65536];
+            while(true) {
+                ssize_t n = ::read(reader, buf, sizeof(buf));
+                if(n > 0) content.append(buf, n);
+                else if(stop.load()) break;
+                else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        for(int i = 0; i < 10; i++) LOG_ERROR("urgent {}", i);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2500)); // 等待一次定期汇报
+        logger.shutdown();
+        stop.store(true);
+        drainer.join();
+        ::close(reader);
+        for(int i = 0; i < 10; i++) assert(content.find("[ERROR] urgent " + std::to_string(i) + "\n") != std::string::npos);
+        assert(content.find("log lines dropped") != std::string::npos);
+        std::cout << "policy " << static_cast<int>(policy) << ": dropped " << dropped << " lines, max LOG_INFO latency "
+                  << maxNs.load() / 1000 << " us" << std::endl;
+        assert(maxNs.load() < 100 * 1000 * 1000);
+    }
+    Logger::getInstance().setOverflowPolicy(LogOverflow::BLOCK);
+    std::remove(path);
+    std::cout << "✓ Test 11 passed!" << std::endl;
+}
+
+// 测试12：按大小滚动，旧文件在后台压缩，只保留最近 max_files 个，所有行都能在保留的文件中找到
+void testRotation() {
+    std::cout << "=== Test 12: Size Rotation, Compression And Retention ===" << std::endl;
+    namespace fs = std::filesystem;
+    fs::path dir = "log/rotation";
+    fs::remove_all(dir);
+    LogRotation rotation;
+    rotation.max_size = 256 * 1024;
+    rotation.max_files = 3;
+    rotation.compress = true;
+    rotation.sync_interval_ms = 50;
+    Logger& logger = Logger::getInstance();
+    logger.setRotation(rotation);
+    logger.initLogger((dir / "app.log").string(), LogLevel::INFO, 1024, 1);
+    const int lines = 40000; // 约 4MB，滚动十余次
+    int64_t maxNs = 0;
+    for(int i = 0; i < lines; i++) {
+        auto start = std::chrono::steady_clock::now();
+        LOG_INFO("rotation line {} {}", i, std::string(60, 'r'));
+        maxNs = std::max<int64_t>(maxNs, std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+    logger.shutdown(); // 等待压缩完成
+    logger.setRotation(LogRotation());
+
+    std::vector<std::string> segments;
+    for(const auto& entry : fs::directory_iterator(dir)) segments.push_back(entry.path().filename().string());
+    std::sort(segments.begin(), segments.end());
+    assert(std::find(segments.begin(), segments.end(), "app.log") != segments.end());
+    assert(segments.size() == 4); // 当前文件 + 3 个旧文件
+    // 旧文件都已压缩且可以解压；最后一行在当前文件中
+    for(const std::string& name : segments) {
+        if(name == "app.log") continue;
+        assert(name.size() > 3 and name.substr(name.size() - 3) == ".gz");
+        gzFile gz = gzopen((dir / name).string().c_str(), "rb");
+        assert(gz);
+        char buf[256];
+        int count = 0;
+        while(gzgets(gz, buf, sizeof(buf))) count++;
+        gzclose(gz);
+        assert(count > 0);
+    }
+    std::ifstream in(dir / "app.log");
+    std::string line, last;
+    while(std::getline(in, line)) last = line;
+    assert(last.find("rotation line " + std::to_string(lines - 1)) != std::string::npos);
+    assert(fs::file_size(dir / "app.log") <= rotation.max_size + 64 * 1024);
+    std::cout << "segments: " << segments.size() << ", max LOG_INFO latency " << maxNs / 1000 << " us" << std::endl;
+    fs::remove_all(dir);
+    std::cout << "✓ Test 12 passed!" << std::endl;
+}
+
+// 测试13：环形映射日志。子进程写日志后直接 abort（不调用 shutdown），
+// 父进程从文件恢复出最近的日志：每个线程的日志是其序列的一段连续后缀，且包含最后一行
+void testMmapRingCrash() {
+    std::cout << "=== Test 13: Mmap Ring Survives Crash ===" << std::endl;
+    const char* path = "log/test_log_ring.log";
+    std::string ringPath = std::string(path) + ".ring";
+    std::remove(ringPath.c_str());
+    const int threads = 4, perThread = 20000;
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if(pid == 0) {
+        Logger::getInstance().setMmapSize(512 * 1024);
+        Logger::getInstance().initLogger(path, LogLevel::INFO, 1024, 3);
+        std::vector<std::thread> producers;
+        for(int t = 0; t < threads; t++) {
+            producers.emplace_back([t]() {
+                for(int i = 0; i < perThread; i++) LOG_INFO("ring producer {} line {}", t, i);
+            });
+        }
+        for(auto& p : producers) p.join();
+        std::abort(); // 模拟崩溃：不落盘、不解除映射
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    assert(WIFSIGNALED(status));
+
+    std::string data = readFile(ringPath.c_str());
+    assert(data.size() == MmapRingFile::HEADER_SIZE + 512 * 1024);
+    std::ostringstream out;
+    size_t n = MmapRingFile::Recover(data.data(), data.size(), out);
+    assert(n > 1000 and n < static_cast<size_t>(threads * perThread)); // 只保留最近 512KB
+    std::map<int, std::vector<int>> seen;
+    std::istringstream in(out.str());
+    size_t lines = 0;
+    for(std::string line; std::getline(in, line); lines++) {
+        int t, i;
+        size_t pos = line.find("ring producer ");
+        assert(pos != std::string::npos);
+        assert(std::sscanf(line.c_str() + pos, "ring producer %d line %d", &t, &i) == 2);
+        seen[t].push_back(i);
+    }
+    assert(lines == n);
+    for(auto& [t, seq] : seen) {
+        assert(seq.back() == perThread - 1);
+        for(size_t k = 1; k < seq.size(); k++) assert(seq[k] == seq[k - 1] + 1);
+    }
+    std::cout << "recovered " << n << " lines from " << seen.size() << " threads" << std::endl;
+
+    // 重新打开时接着写，之前的日志仍可恢复
+    MmapRingFile ring;
+    assert(ring.Open(ringPath, 512 * 1024));
+    uint64_t before = ring.WritePos();
+    ring.Append("after restart\n", 14);
+    assert(ring.WritePos() > before);
+    ring.Close();
+    data = readFile(ringPath.c_str());
+    std::ostringstream again;
+    assert(MmapRingFile::Recover(data.data(), data.size(), again) > 0);
+    assert(again.str().size() >= 14 and again.str().substr(again.str().size() - 14) == "after restart\n");
+    std::remove(ringPath.c_str());
+    std::cout << "✓ Test 13 passed!" << std::endl;
+}
+
+// 测试14：环形映射模式下的调用开销
+void benchMmapRing() {
+    std::cout << "=== Test 14: Mmap Ring Call Latency ===" << std::endl;
+    const char* path = "log/test_log_ring_bench.log";
+    std::string ringPath = std::string(path) + ".ring";
+    Logger::getInstance().setMmapSize(8 * 1024 * 1024);
+    Logger::getInstance().initLogger(path, LogLevel::INFO, 1024, 3);
+    const int calls = 2000000;
+    std::string url = "/index.html";
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < calls; i++) LOG_INFO("Client[{}] GET {} 200 {} bytes", i, url, 1024 + i);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+    Logger::getInstance().shutdown();
+    Logger::getInstance().setMmapSize(0);
+    std::cout << "mmap ring LOG_INFO: " << ns << " ns/call" << std::endl;
+    std::remove(ringPath.c_str());
+    std::cout << "✓ Test 14 done!" << std::endl;
+}
+
+static AccessRecord makeAccess(int i) {
+    AccessRecord rec;
+    rec.timeNs = 1790000000ull * 1000000000 + static_cast<uint64_t>(i) * 1000000;
+    rec.clientIp = htonl(0x0A000001 + i % 4); // 10.0.0.1 ~ 10.0.0.4
+    rec.status = i % 10 == 0 ? 404 : 200;
+    rec.bytes = i % 10 == 0 ? 0 : 1000 + i;
+    rec.latencyUs = 50 + i % 7;
+    rec.SetMethod(i % 2 ? "POST" : "GET");
+    rec.SetVersion("1.1");
+    rec.SetPath("/page/" + std::to_string(i) + ".html");
+    return rec;
+}
+
+void testAccessLogFormats() {
+    std::cout << "=== Test 15: Access Log Formats ===" << std::endl;
+    // 单条记录的 CLF 与 JSON 渲染
+    AccessRecord rec = makeAccess(3);
+    rec.SetPath("/a \"b\"\n");
+    std::string clf, json;
+    AccessLog::Format(rec, AccessLogFormat::CLF, clf);
+    AccessLog::Format(rec, AccessLogFormat::JSON, json);
+    std::cout << clf << json;
+    assert(clf.starts_with("10.0.0.4 - - ["));
+    assert(clf.find("\"POST /a \\x22b\\x22\\x0a HTTP/1.1\" 200 1003\n") != std::string::npos);
+    assert(json.find("\"path\":\"/a \\\"b\\\"\\u000a\"") != std::string::npos);
+    assert(json.find("\"status\":200,\"bytes\":1003,\"latency_us\":53}") != std::string::npos);
+    AccessRecord bad;
+    clf.clear();
+    AccessLog::Format(bad, AccessLogFormat::CLF, clf);
+    assert(clf.find("\"- - HTTP/-\" 0 -") != std::string::npos);
+    AccessRecord longPath;
+    longPath.SetPath(std::string(300, 'x'));
+    assert(longPath.pathLen == AccessRecord::PATH_CAP);
+
+    // 两个线程各写一部分（跨越多个批次），文本文件行数与二进制解码结果一致
+    const int perThread = AccessLog::BATCH_RECORDS * 2 + 100;
+    const char* textPath = "log/test_access.log";
+    const char* binPath = "log/test_access.bin";
+    std::remove(textPath);
+    std::remove(binPath);
+    for(AccessLogFormat format : {AccessLogFormat::CLF, AccessLogFormat::BINARY}) {
+        assert(AccessLog::getInstance().Init(format == AccessLogFormat::CLF ? textPath : binPath, format));
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 2; t++) {
+            threads.emplace_back([t, perThread]() {
+                for(int i = 0; i < perThread; i++) AccessLog::getInstance().Record(makeAccess(t * perThread + i));
+                AccessLog::getInstance().FlushThread();
+            });
+        }
+        for(auto& t : threads) t.join();
+        AccessLog::getInstance().Shutdown();
+        assert(AccessLog::getInstance().Dropped() == 0);
+    }
+    std::string text = readFile(textPath);
+    std::string bin = readFile(binPath);
+    std::ostringstream decoded;
+    size_t n = AccessLog::Decode(bin.data(), bin.size(), AccessLogFormat::CLF, decoded);
+    assert(countLines(textPath) == 2 * perThread);
+    assert(n == static_cast<size_t>(2 * perThread));
+    // 批次交错顺序可能不同，按行排序后比较
+    auto sortedLines = [](const std::string& s) {
+        std::vector<std::string> lines;
+        std::istringstream in(s);
+        for(std::string line; std::getline(in, line);) lines.push_back(line);
+        std::sort(lines.begin(), lines.end());
+        return lines;
+    };
+    assert(sortedLines(text) == sortedLines(decoded.str()));
+    std::cout << "binary " << bin.size() << " bytes vs clf " << text.size() << " bytes for " << n << " records" << std::endl;
+    std::remove(textPath);
+    std::remove(binPath);
+    std::cout << "✓ Test 15 passed!" << std::endl;
+}
+
+void benchAccessLog() {
+    std::cout << "=== Test 16: Access Log Record Cost ===" << std::endl;
+    const char* path = "log/test_access_bench.log";
+    const int calls = 500000;
+    for(AccessLogFormat format : {AccessLogFormat::CLF, AccessLogFormat::JSON, AccessLogFormat::BINARY}) {
+        std::remove(path);
+        AccessLog::getInstance().Init(path, format, 4096);
+        AccessRecord rec = makeAccess(1);
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < calls; i++) {
+            rec.bytes = 1000 + i;
+            AccessLog::getInstance().Record(rec);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+        AccessLog::getInstance().Shutdown();
+        double total = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+        static const char* NAMES[] = {"clf", "json", "binary"};
+        // 以单核约 10 万请求/秒（每请求 10µs）估算占比，包括写线程的格式化与写入在内不超过 2%
+        std::cout << NAMES[static_cast<int>(format)] << ": Record " << ns << " ns/request, including writer "
+                  << total << " ns/request (" << total / 10000 * 100 << "% of a 10us request), dropped "
+                  << AccessLog::getInstance().Dropped() << std::endl;
+        assert(total / 10000 * 100 < 2.0);
+    }
+    std::remove(path);
+    std::cout << "✓ Test 16 passed!" << std::endl;
+}
+
+// 测试17：BlockDeque 的移动语义、批量取出、毫秒级超时与停止唤醒
+void testBlockDequeApi() {
+    std::cout << "=== Test 17: BlockDeque Move, Batch And Timed APIs ===" << std::endl;
+    // 只能移动的元素
+    BlockDeque<std::unique_ptr<int>> q(4);
+    for(int i = 0; i < 3; i++) assert(q.push_back(std::make_unique<int>(i)));
+    assert(q.emplace_back(new int(3)));
+    assert(q.full());
+    std::vector<std::unique_ptr<int>> out;
+    assert(q.pop_n(out, 2) == 2);
+    assert(*out[0] == 0 and *out[1] == 1);
+    assert(q.drain_into(out) == 2 and *out[3] == 3);
+    assert(q.drain_into(out) == 0);
+
+    // 毫秒级超时
+    std::unique_ptr<int> item;
+    auto start = std::chrono::steady_clock::now();
+    assert(!q.pop(item, std::chrono::milliseconds(20)));
+    assert(q.pop_n(out, 8, std::chrono::milliseconds(20)) == 0);
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    assert(waited >= 40 and waited < 900);
+
+    // 队列满时阻塞的多个生产者在消费者逐个取出时都能完成
+    BlockDeque<int> small(2);
+    std::atomic<int> pushed{0};
+    std::vector<std::thread> producers;
+    for(int p = 0; p < 4; p++) {
+        producers.emplace_back([&small, &pushed, p]() {
+            for(int i = 0; i < 100; i++) {
+                small.push_back(p * 100 + i);
+                pushed.fetch_add(1);
+            }
+        });
+    }
+    int sum = 0;
+    for(int i = 0; i < 400; i++) {
+        int v;
+        assert(small.pop(v));
+        sum += v;
+    }
+    for(auto& t : producers) t.join();
+    assert(pushed.load() == 400 and sum == 399 * 400 / 2);
+
+    // stop 唤醒阻塞的消费者，之后的 pop 与 push 立即返回 false
+    BlockDeque<int> stopping(2);
+    std::thread waiter([&stopping]() {
+        int v;
+        assert(!stopping.pop(v));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    stopping.stop();
+    waiter.join();
+    int v;
+    assert(!stopping.pop(v));
+    assert(!stopping.push_back(1));
+    std::cout << "✓ Test 17 passed!" << std::endl;
+}
+
+int main() {
+    std::cout << "Starting Logger Transport Tests..." << std::endl;
+    testRingBasic();
+    testRingConcurrent();
+    testShutdownFlushesAll();
+    benchQueues();
+    testErrorHandoff();
+    benchLogger();
+    testLevelFilter();
+    testBinaryRoundTrip();
+    benchBinaryCall();
+    testCachedTimestamp();
+    testOverflowPolicies();
+    testRotation();
+    testMmapRingCrash();
+    benchMmapRing();
+    testAccessLogFormats();
+    benchAccessLog();
+    testBlockDequeApi();
+    std::cout << "All tests passed successfully! ✓" << std::endl;
+    return 0;
+}
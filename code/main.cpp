@@ -1,10 +1,21 @@
 #include <iostream>
 #include <string>
+#include <algorithm>
 #include <cstring>
 #include <unistd.h>
 
 #include "config/config.h"
 #include "log/log.h"
+#include "log/accesslog.h"
+#include "pool/sqlconnpool.h"
+#include "pool/regbatcher.h"
+#include "auth/credcache.h"
+#include "auth/session.h"
+#include "auth/sqliteuserstore.h"
+#include "auth/memuserstore.h"
+#include "pool/lanescheduler.h"
+#include "server/webserver.h"
+#include "server/affinity.h"
 
 int main(int argc, char* argv[]) {
 
@@ -18,25 +29,96 @@ int main(int argc, char* argv[]) {
     config.parse_args(argc, argv);
 
     // 初始化日志系统（使用 config 中的配置）
+    LogRotation rotation;
+    rotation.max_size = static_cast<uint64_t>(config.c_log_max_size) * 1024 * 1024;
+    rotation.max_files = config.c_log_max_files;
+    rotation.compress = config.c_log_compress;
+    rotation.sync_interval_ms = config.c_log_sync_interval;
+    Logger::getInstance().setRotation(rotation);
+    Logger::getInstance().setMmapSize(static_cast<size_t>(config.c_log_mmap_size) * 1024 * 1024);
+    Logger::getInstance().setOverflowPolicy(static_cast<LogOverflow>(config.c_log_overflow),
+        {static_cast<uint32_t>(config.c_log_sample_rates[0]), static_cast<uint32_t>(config.c_log_sample_rates[1]),
+         static_cast<uint32_t>(config.c_log_sample_rates[2])});
     Logger::getInstance().initLogger(config.c_log_file, static_cast<LogLevel>(config.c_log_level),
-    config.c_log_queue_size, config.c_log_flush_interval);
+    config.c_log_queue_size, config.c_log_flush_interval, config.c_log_binary);
+
+    // 访问日志与运行日志分开写入
+    if(!config.c_access_log.empty() and
+       !AccessLog::getInstance().Init(config.c_access_log, static_cast<AccessLogFormat>(config.c_access_log_format))) {
+        LOG_ERROR("Open access log {} failed", config.c_access_log);
+    }
 
     // 打印启动信息
     LOG_INFO("=== WebServer Starting ===");
     config.print_config();
 
-    // 简单测试各级日志
-    LOG_DEBUG("This is a debug message");
-    LOG_INFO("This is an info message");
-    LOG_WARN("This is a warning");
-    LOG_ERROR("This is an error");
+    // 用户存储：默认 MySQL（连接池 + 批量注册）；本地后端不需要 MySQL，不建立连接池
+    if(config.c_user_store == "mysql") {
+        SqlPoolOptions poolOptions;
+        poolOptions.minConn = config.c_db_pool_min;
+        poolOptions.acquireTimeout = config.c_db_acquire_timeout;
+        poolOptions.idleTimeout = config.c_db_idle_timeout;
+        poolOptions.pingInterval = config.c_db_ping_interval;
+        SqlConnPool::getInstance().SetOptions(poolOptions);
+        SqlConnPool::getInstance().Init(config.c_db_host.c_str(), config.c_db_port,
+            config.c_db_user.c_str(), config.c_db_password.c_str(), config.c_db_name.c_str(), config.c_conn_pool_num,
+            config.c_db_nonblocking);
+        // 批量注册（使用独立连接），等待中的注册数与 DB 通道的队列共用上限
+        RegisterBatcher::getInstance().Init(config.c_db_host.c_str(), config.c_db_port,
+            config.c_db_user.c_str(), config.c_db_password.c_str(), config.c_db_name.c_str(),
+            config.c_register_batch_window, static_cast<size_t>(config.c_register_batch_size),
+            static_cast<size_t>(config.c_lane_db_queue));
+    } else if(config.c_user_store == "sqlite") {
+        auto store = std::make_unique<SqliteUserStore>();
+        // 每个 Reactor（查询）与 DB 通道工作线程（注册）各一个句柄，请求路径上不再打开数据库
+        size_t handles = static_cast<size_t>(std::max(config.c_thread_cnt, 1) + std::max(config.c_lane_db_workers, 0));
+        if(!store->Open(config.c_user_store_path.empty() ? "log/users.db" : config.c_user_store_path, handles)) {
+            LOG_ERROR("Open sqlite user store failed");
+            Logger::getInstance().shutdown();
+            return 1;
+        }
+        UserStore::SetActive(std::move(store));
+    } else if(config.c_user_store == "memory") {
+        auto store = std::make_unique<MemUserStore>();
+        if(!store->Open(config.c_user_store_path.empty() ? "log/users.bin" : config.c_user_store_path,
+                        static_cast<size_t>(config.c_user_store_capacity))) {
+            LOG_ERROR("Open memory user store failed");
+            Logger::getInstance().shutdown();
+            return 1;
+        }
+        UserStore::SetActive(std::move(store));
+    } else {
+        LOG_ERROR("Unknown user_store: {}", config.c_user_store);
+        Logger::getInstance().shutdown();
+        return 1;
+    }
+
+    // 登录凭据缓存
+    CredCache::getInstance().Init(config.c_cred_cache_ttl, config.c_cred_cache_negative_ttl,
+        static_cast<size_t>(config.c_cred_cache_size));
+    // 登录会话
+    SessionStore::getInstance().Init(config.c_session_ttl, static_cast<size_t>(config.c_session_capacity),
+        config.c_session_file);
+
+    // 初始化请求调度通道（静态 / 数据库 / 管理）
+    LaneScheduler::getInstance().Init();
 
-    // 占位循环（短时测试可用 timeout 运行）
-    LOG_INFO("Placeholder loop. Press Ctrl+C to exit.");
-    while (true) {
-        sleep(1);
+    // 线程放置：日志刷盘线程放到杂务核心，通道工作线程限制在 worker_cpus 内
+    if(config.c_log_cpu >= 0) PinThreadToCpu(Logger::getInstance().workerHandle(), config.c_log_cpu);
+    std::vector<int> workerCpus = ParseCpuList(config.c_worker_cpus);
+    if(!workerCpus.empty()) {
+        for(auto handle : LaneScheduler::getInstance().NativeHandles()) PinThreadToCpus(handle, workerCpus);
     }
 
+    // 启动主从 Reactor，阻塞直到服务器停止
+    WebServer server;
+    server.Start();
+
+    LaneScheduler::getInstance().Shutdown();
+    RegisterBatcher::getInstance().Close();
+    AccessLog::getInstance().Shutdown();
+    SessionStore::getInstance().Close();
+    UserStore::SetActive(nullptr); // 本地后端关闭时落盘
     Logger::getInstance().shutdown();
     return 0;
 }
@@ -0,0 +1,1117 @@
+#include "fakemysql.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <random>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../log/log.h"
+
+// 协议常量，取值与 mysql_com.h / mysqld_error.h 一致
+namespace {
+constexpr uint32_t CLIENT_LONG_PASSWORD = 1;
+constexpr uint32_t CLIENT_FOUND_ROWS = 2;
+constexpr uint32_t CLIENT_LONG_FLAG = 4;
+constexpr uint32_t CLIENT_CONNECT_WITH_DB = 8;
+constexpr uint32_t CLIENT_PROTOCOL_41 = 0x200;
+constexpr uint32_t CLIENT_SSL = 0x800;
+constexpr uint32_t CLIENT_TRANSACTIONS = 0x2000;
+constexpr uint32_t CLIENT_SECURE_CONNECTION = 0x8000;
+constexpr uint32_t CLIENT_MULTI_RESULTS = 0x20000;
+constexpr uint32_t CLIENT_PS_MULTI_RESULTS = 0x40000;
+constexpr uint32_t CLIENT_PLUGIN_AUTH = 0x80000;
+constexpr uint32_t CLIENT_CONNECT_ATTRS = 0x100000;
+constexpr uint32_t CLIENT_PLUGIN_AUTH_LENENC_CLIENT_DATA = 0x200000;
+// 不支持 SSL、多语句、查询属性，也不声明 CLIENT_DEPRECATE_EOF（结果集以 EOF 包结束）
+constexpr uint32_t SERVER_CAPABILITIES = CLIENT_LONG_PASSWORD | CLIENT_FOUND_ROWS | CLIENT_LONG_FLAG |
+    CLIENT_CONNECT_WITH_DB | CLIENT_PROTOCOL_41 | CLIENT_TRANSACTIONS | CLIENT_SECURE_CONNECTION |
+    CLIENT_MULTI_RESULTS | CLIENT_PS_MULTI_RESULTS | CLIENT_PLUGIN_AUTH | CLIENT_CONNECT_ATTRS |
+    CLIENT_PLUGIN_AUTH_LENENC_CLIENT_DATA;
+
+constexpr uint16_t SERVER_STATUS_IN_TRANS = 1;
+constexpr uint16_t SERVER_STATUS_AUTOCOMMIT = 2;
+
+constexpr uint8_t COM_QUIT = 0x01;
+constexpr uint8_t COM_INIT_DB = 0x02;
+constexpr uint8_t COM_QUERY = 0x03;
+constexpr uint8_t COM_PING = 0x0e;
+constexpr uint8_t COM_STMT_PREPARE = 0x16;
+constexpr uint8_t COM_STMT_EXECUTE = 0x17;
+constexpr uint8_t COM_STMT_SEND_LONG_DATA = 0x18;
+constexpr uint8_t COM_STMT_CLOSE = 0x19;
+constexpr uint8_t COM_STMT_RESET = 0x1a;
+constexpr uint8_t COM_SET_OPTION = 0x1b;
+constexpr uint8_t COM_RESET_CONNECTION = 0x1f;
+
+constexpr uint8_t TYPE_VAR_STRING = 0xfd;
+constexpr uint8_t CHARSET_UTF8MB4 = 255; // utf8mb4_0900_ai_ci
+constexpr uint8_t CHARSET_BINARY = 63;
+
+constexpr uint16_t ER_CON_COUNT_ERROR = 1040;
+constexpr uint16_t ER_UNKNOWN_COM_ERROR = 1047;
+constexpr uint16_t ER_PARSE_ERROR = 1064;
+constexpr uint16_t ER_LOCK_WAIT_TIMEOUT = 1205;
+constexpr uint16_t ER_UNKNOWN_STMT_HANDLER = 1243;
+constexpr uint16_t ER_WRONG_ARGUMENTS = 1210;
+
+constexpr const char* SERVER_VERSION = "8.0.36-fakemysql";
+constexpr size_t MAX_PACKET = 0xffffff;
+
+bool ReadFull(int fd, void* buf, size_t n) {
+    char* p = static_cast<char*>(buf);
+    while(n > 0) {
+        ssize_t r = read(fd, p, n);
+        if(r > 0) {
+            p += r;
+            n -= r;
+        } else if(r < 0 and errno == EINTR) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WriteFull(int fd, const char* p, size_t n) {
+    while(n > 0) {
+        ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+        if(w > 0) {
+            p += w;
+            n -= w;
+        } else if(w < 0 and errno == EINTR) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PutInt(std::string& out, uint64_t v, int bytes) {
+    for(int i = 0; i < bytes; i++) out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+}
+
+void PutLenenc(std::string& out, uint64_t v) {
+    if(v < 251) {
+        out.push_back(static_cast<char>(v));
+    } else if(v < (1 << 16)) {
+        out.push_back(static_cast<char>(0xfc));
+        PutInt(out, v, 2);
+    } else if(v < (1 << 24)) {
+        out.push_back(static_cast<char>(0xfd));
+        PutInt(out, v, 3);
+    } else {
+        out.push_back(static_cast<char>(0xfe));
+        PutInt(out, v, 8);
+    }
+}
+
+void PutLenencStr(std::string& out, std::string_view s) {
+    PutLenenc(out, s.size());
+    out.append(s);
+}
+
+// 按顺序读取包内字段，越界时 ok 置为 false 并返回零值
+struct Reader {
+    const std::string& data;
+    size_t pos = 0;
+    bool ok = true;
+
+    bool Need(size_t n) {
+        if(pos + n > data.size()) ok = false;
+        return ok;
+    }
+    uint64_t Int(int bytes) {
+        if(!Need(bytes)) return 0;
+        uint64_t v = 0;
+        for(int i = 0; i < bytes; i++) v |= static_cast<uint64_t>(static_cast<uint8_t>(data[pos + i])) << (8 * i);
+        pos += bytes;
+        return v;
+    }
+    uint64_t Lenenc() {
+        uint8_t first = static_cast<uint8_t>(Int(1));
+        if(first < 0xfb) return first;
+        if(first == 0xfc) return Int(2);
+        if(first == 0xfd) return Int(3);
+        if(first == 0xfe) return Int(8);
+        ok = false;
+        return 0;
+    }
+    std::string Bytes(size_t n) {
+        if(!Need(n)) return {};
+        std::string s = data.substr(pos, n);
+        pos += n;
+        return s;
+    }
+    std::string NulStr() {
+        size_t end = data.find('\0', pos);
+        if(end == std::string::npos) end = data.size();
+        std::string s = data.substr(pos, end - pos);
+        pos = std::min(end + 1, data.size());
+        return s;
+    }
+};
+
+bool IEquals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() and std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        return tolower(static_cast<unsigned char>(x)) == tolower(static_cast<unsigned char>(y));
+    });
+}
+
+// SQL LIKE：% 匹配任意串，_ 匹配单个字符，\ 转义；与默认排序规则一致不区分大小写
+bool LikeMatch(std::string_view s, std::string_view pat) {
+    size_t si = 0, pi = 0, starP = std::string_view::npos, starS = 0;
+    while(si < s.size()) {
+        if(pi < pat.size() and pat[pi] == '%') {
+            starP = pi++;
+            starS = si;
+            continue;
+        }
+        if(pi < pat.size()) {
+            char c = pat[pi];
+            size_t step = 1;
+            if(c == '\\' and pi + 1 < pat.size()) {
+                c = pat[pi + 1];
+                step = 2;
+            } else if(c == '_') {
+                si++;
+                pi++;
+                continue;
+            }
+            if(tolower(static_cast<unsigned char>(c)) == tolower(static_cast<unsigned char>(s[si]))) {
+                si++;
+                pi += step;
+                continue;
+            }
+        }
+        if(starP == std::string_view::npos) return false;
+        pi = starP + 1;
+        si = ++starS;
+    }
+    while(pi < pat.size() and pat[pi] == '%') pi++;
+    return pi == pat.size();
+}
+} // namespace
+
+struct fakemysql::Token {
+    enum Type { WORD, STRING, NUMBER, SYMBOL, PARAM, NUL, END } type = END;
+    std::string text;
+};
+
+using fakemysql::Token;
+
+struct FakeMySql::Result {
+    enum Kind { OK, ROWS, ERR } kind = OK;
+    uint64_t affected = 0;
+    std::vector<std::string> columns;
+    std::vector<std::vector<std::optional<std::string>>> rows;
+    uint16_t errCode = 0;
+    std::string sqlState;
+    std::string message;
+
+    static Result Error(uint16_t code, const char* state, std::string msg) {
+        Result r;
+        r.kind = ERR;
+        r.errCode = code;
+        r.sqlState = state;
+        r.message = std::move(msg);
+        return r;
+    }
+};
+
+struct FakeMySql::Session {
+    struct Stmt {
+        std::vector<Token> tokens;
+        uint16_t params = 0;
+        std::vector<uint16_t> types; // 上一次 COM_STMT_EXECUTE 发送的参数类型
+    };
+
+    int fd = -1;
+    uint64_t id = 0;
+    uint8_t seq = 0;
+    std::string out; // 一个响应的所有包，一次写出
+    std::mt19937 rng;
+    bool autocommit = true;
+    bool inTxn = false;
+    std::vector<std::pair<std::string, std::string>> pending; // 事务中尚未提交的 INSERT
+    std::unordered_map<uint32_t, Stmt> stmts;
+    uint32_t nextStmt = 1;
+
+    uint16_t Status() const {
+        uint16_t status = autocommit ? SERVER_STATUS_AUTOCOMMIT : 0;
+        if(inTxn or !pending.empty()) status |= SERVER_STATUS_IN_TRANS;
+        return status;
+    }
+    void Packet(const std::string& payload) {
+        PutInt(out, payload.size(), 3);
+        out.push_back(static_cast<char>(seq++));
+        out.append(payload);
+    }
+    void Ok(uint64_t affected = 0) {
+        std::string p(1, '\0');
+        PutLenenc(p, affected);
+        PutLenenc(p, 0); // last_insert_id
+        PutInt(p, Status(), 2);
+        PutInt(p, 0, 2); // warnings
+        Packet(p);
+    }
+    void Eof() {
+        std::string p(1, static_cast<char>(0xfe));
+        PutInt(p, 0, 2);
+        PutInt(p, Status(), 2);
+        Packet(p);
+    }
+    void Err(uint16_t code, const std::string& state, const std::string& msg) {
+        std::string p(1, static_cast<char>(0xff));
+        PutInt(p, code, 2);
+        p += '#';
+        p += state;
+        p += msg;
+        Packet(p);
+    }
+    void Column(const std::string& name, bool binary = false) {
+        std::string p;
+        PutLenencStr(p, "def");
+        PutLenencStr(p, "webserver");
+        PutLenencStr(p, "user");
+        PutLenencStr(p, "user");
+        PutLenencStr(p, name);
+        PutLenencStr(p, name);
+        p.push_back(0x0c);
+        PutInt(p, binary ? CHARSET_BINARY : CHARSET_UTF8MB4, 2);
+        PutInt(p, 200, 4); // 列宽：char(50) * 4 字节
+        p.push_back(static_cast<char>(TYPE_VAR_STRING));
+        PutInt(p, 0, 2); // flags
+        p.push_back(0);  // decimals
+        PutInt(p, 0, 2);
+        Packet(p);
+    }
+    bool Flush() {
+        bool ok = WriteFull(fd, out.data(), out.size());
+        out.clear();
+        return ok;
+    }
+};
+
+namespace {
+
+std::vector<Token> Tokenize(std::string_view sql) {
+    std::vector<Token> tokens;
+    size_t i = 0;
+    while(i < sql.size()) {
+        char c = sql[i];
+        if(isspace(static_cast<unsigned char>(c))) {
+            i++;
+        } else if(c == '\'' or c == '"') {
+            // 字符串：支持 \ 转义与连续两个引号
+            std::string s;
+            char quote = c;
+            for(i++; i < sql.size(); i++) {
+                if(sql[i] == '\\' and i + 1 < sql.size()) {
+                    char e = sql[++i];
+                    s += e == 'n' ? '\n' : e == 't' ? '\t' : e == 'r' ? '\r' : e == '0' ? '\0' : e;
+                } else if(sql[i] == quote) {
+                    if(i + 1 < sql.size() and sql[i + 1] == quote) {
+                        s += quote;
+                        i++;
+                    } else {
+                        break;
+                    }
+                } else {
+                    s += sql[i];
+                }
+            }
+            i++;
+            tokens.push_back({Token::STRING, std::move(s)});
+        } else if(c == '`') {
+            size_t end = sql.find('`', i + 1);
+            if(end == std::string_view::npos) end = sql.size();
+            tokens.push_back({Token::WORD, std::string(sql.substr(i + 1, end - i - 1))});
+            i = end + 1;
+        } else if(isdigit(static_cast<unsigned char>(c))) {
+            size_t start = i;
+            while(i < sql.size() and (isdigit(static_cast<unsigned char>(sql[i])) or sql[i] == '.')) i++;
+            tokens.push_back({Token::NUMBER, std::string(sql.substr(start, i - start))});
+        } else if(isalpha(static_cast<unsigned char>(c)) or c == '_' or c == '@') {
+            size_t start = i;
+            while(i < sql.size() and (isalnum(static_cast<unsigned char>(sql[i])) or
+                  sql[i] == '_' or sql[i] == '@' or sql[i] == '.' or sql[i] == '$')) i++;
+            std::string word(sql.substr(start, i - start));
+            tokens.push_back({IEquals(word, "NULL") ? Token::NUL : Token::WORD, std::move(word)});
+        } else if(c == '?') {
+            tokens.push_back({Token::PARAM, "?"});
+            i++;
+        } else {
+            tokens.push_back({Token::SYMBOL, std::string(1, c)});
+            i++;
+        }
+    }
+    tokens.push_back({Token::END, ""});
+    return tokens;
+}
+
+// 在词法单元上做递归下降解析，只认识本文件开头注释中列出的语句
+class Parser {
+public:
+    explicit Parser(const std::vector<Token>& tokens) : tokens_(tokens) {}
+
+    const Token& Peek() const { return tokens_[pos_]; }
+    const Token& Next() { return pos_ + 1 < tokens_.size() ? tokens_[pos_++] : tokens_.back(); }
+    bool AtEnd() const {
+        const Token& t = Peek();
+        return t.type == Token::END or (t.type == Token::SYMBOL and t.text == ";");
+    }
+    // 关键字（不区分大小写）或符号
+    bool Accept(std::string_view word) {
+        const Token& t = Peek();
+        if((t.type == Token::WORD and IEquals(t.text, word)) or (t.type == Token::SYMBOL and t.text == word)) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+    bool Is(std::string_view word, size_t ahead = 0) const {
+        const Token& t = tokens_[std::min(pos_ + ahead, tokens_.size() - 1)];
+        return (t.type == Token::WORD and IEquals(t.text, word)) or (t.type == Token::SYMBOL and t.text == word);
+    }
+    // 字面量：字符串、数字、NULL 或预处理语句的参数占位（dryRun 时按空串处理）
+    bool Literal(std::optional<std::string>& value) {
+        const Token& t = Peek();
+        if(t.type == Token::STRING or t.type == Token::NUMBER) value = t.text;
+        else if(t.type == Token::PARAM) value = std::string();
+        else if(t.type == Token::NUL) value.reset();
+        else if(t.type == Token::SYMBOL and t.text == "-" and tokens_[pos_ + 1].type == Token::NUMBER) {
+            pos_++;
+            value = "-" + Peek().text;
+        } else return false;
+        pos_++;
+        return true;
+    }
+    // 表名 user，允许带库名前缀
+    bool Table() {
+        const Token& t = Peek();
+        if(t.type != Token::WORD) return false;
+        std::string_view name = t.text;
+        size_t dot = name.rfind('.');
+        if(dot != std::string_view::npos) name = name.substr(dot + 1);
+        if(!IEquals(name, "user")) return false;
+        pos_++;
+        return true;
+    }
+    // username -> 0，password -> 1，其他 -> -1
+    int ColumnIndex() {
+        const Token& t = Peek();
+        if(t.type != Token::WORD) return -1;
+        int col = IEquals(t.text, "username") ? 0 : IEquals(t.text, "password") ? 1 : -1;
+        if(col >= 0) pos_++;
+        return col;
+    }
+
+private:
+    const std::vector<Token>& tokens_;
+    size_t pos_ = 0;
+};
+
+// WHERE 中的一个条件：列 =、LIKE、IN (...)
+struct Condition {
+    enum Op { EQ, LIKE, IN } op = EQ;
+    int column = 0;
+    std::vector<std::optional<std::string>> values;
+
+    bool Match(const std::string& name, const std::string& password) const {
+        const std::string& v = column == 0 ? name : password;
+        for(const auto& value : values) {
+            if(!value) continue; // 与 NULL 比较不成立
+            if(op == LIKE ? LikeMatch(v, *value) : IEquals(v, *value)) return true;
+        }
+        return false;
+    }
+};
+
+bool ParseWhere(Parser& p, std::vector<Condition>& conds) {
+    if(!p.Accept("WHERE")) return true;
+    do {
+        Condition cond;
+        cond.column = p.ColumnIndex();
+        if(cond.column < 0) return false;
+        std::optional<std::string> v;
+        if(p.Accept("=")) {
+            cond.op = Condition::EQ;
+            if(!p.Literal(v)) return false;
+            cond.values.push_back(v);
+        } else if(p.Accept("LIKE")) {
+            cond.op = Condition::LIKE;
+            if(!p.Literal(v)) return false;
+            cond.values.push_back(v);
+        } else if(p.Accept("IN")) {
+            cond.op = Condition::IN;
+            if(!p.Accept("(")) return false;
+            do {
+                if(!p.Literal(v)) return false;
+                cond.values.push_back(v);
+            } while(p.Accept(","));
+            if(!p.Accept(")")) return false;
+        } else {
+            return false;
+        }
+        conds.push_back(std::move(cond));
+    } while(p.Accept("AND"));
+    return true;
+}
+
+std::string FormatCount(uint64_t n) {
+    char buf[24];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), n);
+    (void)ec;
+    return std::string(buf, end);
+}
+} // namespace
+
+size_t FakeMySql::NameHash::operator()(const std::string& name) const {
+    size_t h = 14695981039346656037ull; // FNV-1a
+    for(char c : name) h = (h ^ static_cast<size_t>(tolower(static_cast<unsigned char>(c)))) * 1099511628211ull;
+    return h;
+}
+
+bool FakeMySql::NameEqual::operator()(const std::string& a, const std::string& b) const {
+    return IEquals(a, b);
+}
+
+FakeMySql::FakeMySql(const FakeMySqlOptions& options)
+    : options_(options), latencyMs_(options.latencyMs), jitterMs_(options.jitterMs),
+      errorRate_(options.errorRate), dropRate_(options.dropRate) {}
+
+bool FakeMySql::Start() {
+    if(running_) return true;
+    listenFd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(listenFd_ < 0) return false;
+    int on = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(options_.port));
+    socklen_t len = sizeof(addr);
+    if(bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 or listen(listenFd_, 1024) < 0 or
+       getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+        LOG_ERROR("FakeMySql: listen on port {} failed: {}", options_.port, strerror(errno));
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    port_ = ntohs(addr.sin_port);
+    running_ = true;
+    acceptor_ = std::thread(&FakeMySql::Accept_, this);
+    LOG_INFO("FakeMySql listening on 127.0.0.1:{}, latency {}±{} ms, error rate {}, drop rate {}",
+             port_, latencyMs_.load(), jitterMs_.load(), errorRate_.load(), dropRate_.load());
+    return true;
+}
+
+void FakeMySql::Stop() {
+    if(!running_.exchange(false)) return;
+    shutdown(listenFd_, SHUT_RDWR); // 唤醒阻塞在 accept 上的线程
+    if(acceptor_.joinable()) acceptor_.join();
+    close(listenFd_);
+    listenFd_ = -1;
+    std::unique_lock<std::mutex> lock(connMtx_);
+    for(int fd : fds_) shutdown(fd, SHUT_RDWR);
+    connCv_.wait(lock, [this]() { return active_ == 0; });
+}
+
+void FakeMySql::AddUser(const std::string& name, const std::string& password) {
+    std::lock_guard<std::mutex> lock(tableMtx_);
+    users_.emplace(name, password);
+}
+
+size_t FakeMySql::UserCount() {
+    std::lock_guard<std::mutex> lock(tableMtx_);
+    return users_.size();
+}
+
+void FakeMySql::SetLatency(int latencyMs, int jitterMs) {
+    latencyMs_ = latencyMs;
+    jitterMs_ = jitterMs;
+}
+
+void FakeMySql::SetErrorRate(double rate) { errorRate_ = rate; }
+void FakeMySql::SetDropRate(double rate) { dropRate_ = rate; }
+
+void FakeMySql::Accept_() {
+    uint64_t nextId = 1;
+    while(running_) {
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if(fd < 0) {
+            if(errno == EINTR or errno == ECONNABORTED) continue;
+            break; // Stop 关闭了监听 socket
+        }
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        {
+            std::lock_guard<std::mutex> lock(connMtx_);
+            fds_.insert(fd);
+            active_++;
+        }
+        connections_.fetch_add(1, std::memory_order_relaxed);
+        std::thread([this, fd, id = nextId++]() {
+            Serve_(fd, id);
+            std::lock_guard<std::mutex> lock(connMtx_);
+            fds_.erase(fd);
+            close(fd);
+            if(--active_ == 0) connCv_.notify_all();
+        }).detach();
+    }
+}
+
+void FakeMySql::Serve_(int fd, uint64_t id) {
+    Session s;
+    s.fd = fd;
+    s.id = id;
+    s.rng.seed(options_.seed + static_cast<uint32_t>(id));
+    if(options_.connectLatencyMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(options_.connectLatencyMs));
+    if(options_.maxConnections > 0) {
+        std::unique_lock<std::mutex> lock(connMtx_);
+        if(active_ > options_.maxConnections) {
+            lock.unlock();
+            s.Err(ER_CON_COUNT_ERROR, "08004", "Too many connections");
+            s.Flush();
+            return;
+        }
+    }
+    if(!Handshake_(s)) return;
+    std::string packet;
+    while(running_) {
+        unsigned char header[4];
+        if(!ReadFull(fd, header, sizeof(header))) break;
+        size_t len = header[0] | (header[1] << 8) | (header[2] << 16);
+        if(len == 0 or len >= MAX_PACKET) break; // 不支持拆分成多个包的超长命令
+        packet.resize(len);
+        if(!ReadFull(fd, packet.data(), len)) break;
+        s.seq = static_cast<uint8_t>(header[3] + 1);
+        if(!Dispatch_(s, packet)) break;
+        if(!s.out.empty() and !s.Flush()) break;
+    }
+    if(!s.pending.empty()) LOG_DEBUG("FakeMySql: connection {} closed with uncommitted transaction", id);
+}
+
+bool FakeMySql::Handshake_(Session& s) {
+    // 20 字节随机挑战，不含 0 字节
+    char scramble[20];
+    for(char& c : scramble) c = static_cast<char>(1 + s.rng() % 127);
+
+    std::string p(1, 0x0a); // protocol version 10
+    p += SERVER_VERSION;
+    p.push_back('\0');
+    PutInt(p, s.id & 0xffffffff, 4);
+    p.append(scramble, 8);
+    p.push_back('\0');
+    PutInt(p, SERVER_CAPABILITIES & 0xffff, 2);
+    p.push_back(static_cast<char>(CHARSET_UTF8MB4));
+    PutInt(p, s.Status(), 2);
+    PutInt(p, SERVER_CAPABILITIES >> 16, 2);
+    p.push_back(21);
+    p.append(10, '\0');
+    p.append(scramble + 8, 12);
+    p.push_back('\0');
+    p += "caching_sha2_password";
+    p.push_back('\0');
+    s.seq = 0;
+    s.Packet(p);
+    if(!s.Flush()) return false;
+
+    unsigned char header[4];
+    if(!ReadFull(s.fd, header, sizeof(header))) return false;
+    std::string resp(header[0] | (header[1] << 8) | (header[2] << 16), '\0');
+    if(!ReadFull(s.fd, resp.data(), resp.size())) return false;
+    s.seq = static_cast<uint8_t>(header[3] + 1);
+
+    Reader r{resp};
+    uint32_t caps = static_cast<uint32_t>(r.Int(4));
+    r.Int(4); // max packet
+    r.Int(1); // charset
+    r.Bytes(23);
+    if(!r.ok or !(caps & CLIENT_PROTOCOL_41) or (caps & CLIENT_SSL)) {
+        s.Err(ER_WRONG_ARGUMENTS, "08S01", "fakemysql: only plain-text protocol 4.1 clients are supported");
+        s.Flush();
+        return false;
+    }
+    std::string user = r.NulStr();
+    std::string auth;
+    if(caps & CLIENT_PLUGIN_AUTH_LENENC_CLIENT_DATA) auth = r.Bytes(r.Lenenc());
+    else if(caps & CLIENT_SECURE_CONNECTION) auth = r.Bytes(r.Int(1));
+    else auth = r.NulStr();
+    if(caps & CLIENT_CONNECT_WITH_DB) r.NulStr();
+    std::string plugin = (caps & CLIENT_PLUGIN_AUTH) ? r.NulStr() : "mysql_native_password";
+
+    // 不校验密码：caching_sha2_password 按快速认证成功（0x01 0x03）处理，其余插件直接 OK
+    if(plugin == "caching_sha2_password" and !auth.empty()) s.Packet(std::string("\x01\x03", 2));
+    s.Ok();
+    LOG_DEBUG("FakeMySql: connection {} user {} plugin {}", s.id, user, plugin);
+    return s.Flush();
+}
+
+int FakeMySql::Inject_(Session& s) {
+    queries_.fetch_add(1, std::memory_order_relaxed);
+    int latency = latencyMs_.load(std::memory_order_relaxed);
+    int jitter = jitterMs_.load(std::memory_order_relaxed);
+    if(jitter > 0) latency += static_cast<int>(s.rng() % (2 * jitter + 1)) - jitter;
+    if(latency > 0) std::this_thread::sleep_for(std::chrono::milliseconds(latency));
+    double dice = std::uniform_real_distribution<double>(0, 1)(s.rng);
+    double drop = dropRate_.load(std::memory_order_relaxed);
+    if(dice < drop) {
+        drops_.fetch_add(1, std::memory_order_relaxed);
+        return 2;
+    }
+    if(dice < drop + errorRate_.load(std::memory_order_relaxed)) {
+        errors_.fetch_add(1, std::memory_order_relaxed);
+        return 1;
+    }
+    return 0;
+}
+
+bool FakeMySql::Dispatch_(Session& s, const std::string& packet) {
+    uint8_t cmd = static_cast<uint8_t>(packet[0]);
+    auto injected = [&]() -> std::optional<bool> {
+        switch(Inject_(s)) {
+        case 1:
+            s.Err(ER_LOCK_WAIT_TIMEOUT, "HY000", "Lock wait timeout exceeded; try restarting transaction (injected)");
+            return true;
+        case 2:
+            return false;
+        default:
+            return std::nullopt;
+        }
+    };
+
+    switch(cmd) {
+    case COM_QUIT:
+        return false;
+    case COM_INIT_DB:
+    case COM_STMT_RESET:
+    case COM_RESET_CONNECTION:
+        if(cmd == COM_RESET_CONNECTION) {
+            s.stmts.clear();
+            s.pending.clear();
+            s.inTxn = false;
+            s.autocommit = true;
+        }
+        s.Ok();
+        return true;
+    case COM_SET_OPTION:
+        s.Eof();
+        return true;
+    case COM_PING:
+        if(auto r = injected()) return *r;
+        s.Ok();
+        return true;
+    case COM_STMT_CLOSE:
+        if(packet.size() >= 5) s.stmts.erase(static_cast<uint32_t>(Reader{packet, 1}.Int(4)));
+        return true; // 没有响应
+    case COM_STMT_SEND_LONG_DATA:
+        return true; // 没有响应；本项目的参数都很短，不会分块发送
+    case COM_QUERY: {
+        if(auto r = injected()) return *r;
+        Result res = Execute_(s, Tokenize(std::string_view(packet).substr(1)), false);
+        if(res.kind == Result::ERR) {
+            s.Err(res.errCode, res.sqlState, res.message);
+        } else if(res.kind == Result::OK) {
+            s.Ok(res.affected);
+        } else {
+            std::string count;
+            PutLenenc(count, res.columns.size());
+            s.Packet(count);
+            for(const std::string& col : res.columns) s.Column(col);
+            s.Eof();
+            for(const auto& row : res.rows) {
+                std::string p;
+                for(const auto& v : row) {
+                    if(v) PutLenencStr(p, *v);
+                    else p.push_back(static_cast<char>(0xfb));
+                }
+                s.Packet(p);
+            }
+            s.Eof();
+        }
+        return true;
+    }
+    case COM_STMT_PREPARE: {
+        Session::Stmt stmt;
+        stmt.tokens = Tokenize(std::string_view(packet).substr(1));
+        for(const Token& t : stmt.tokens) stmt.params += t.type == Token::PARAM;
+        Result res = Execute_(s, stmt.tokens, true);
+        if(res.kind == Result::ERR) {
+            s.Err(res.errCode, res.sqlState, res.message);
+            return true;
+        }
+        uint32_t id = s.nextStmt++;
+        std::string p(1, '\0');
+        PutInt(p, id, 4);
+        PutInt(p, res.columns.size(), 2);
+        PutInt(p, stmt.params, 2);
+        p.push_back('\0');
+        PutInt(p, 0, 2);
+        s.Packet(p);
+        for(uint16_t i = 0; i < stmt.params; i++) s.Column("?", true);
+        if(stmt.params > 0) s.Eof();
+        for(const std::string& col : res.columns) s.Column(col);
+        if(!res.columns.empty()) s.Eof();
+        s.stmts.emplace(id, std::move(stmt));
+        return true;
+    }
+    case COM_STMT_EXECUTE: {
+        Reader r{packet, 1};
+        uint32_t id = static_cast<uint32_t>(r.Int(4));
+        auto it = s.stmts.find(id);
+        if(it == s.stmts.end()) {
+            s.Err(ER_UNKNOWN_STMT_HANDLER, "HY000", "Unknown prepared statement handler (" + FormatCount(id) + ") given to mysqld_stmt_execute");
+            return true;
+        }
+        Session::Stmt& stmt = it->second;
+        r.Int(1); // flags（游标），只支持一次性返回
+        r.Int(4); // iteration count
+        std::vector<Token> tokens = stmt.tokens;
+        if(stmt.params > 0) {
+            std::string nulls = r.Bytes((stmt.params + 7) / 8);
+            if(r.Int(1) == 1) {
+                stmt.types.resize(stmt.params);
+                for(uint16_t& type : stmt.types) type = static_cast<uint16_t>(r.Int(2));
+            }
+            if(stmt.types.size() != stmt.params) r.ok = false;
+            size_t k = 0;
+            for(Token& t : tokens) {
+                if(t.type != Token::PARAM or !r.ok) continue;
+                if(static_cast<uint8_t>(nulls[k / 8]) & (1 << (k % 8))) {
+                    t = {Token::NUL, "NULL"};
+                    k++;
+                    continue;
+                }
+                uint8_t type = stmt.types[k] & 0xff;
+                bool isUnsigned = stmt.types[k] & 0x8000;
+                int width = type == 0x01 ? 1 : (type == 0x02 or type == 0x0d) ? 2 : (type == 0x03 or type == 0x09) ? 4 : type == 0x08 ? 8 : 0;
+                if(width > 0) {
+                    uint64_t v = r.Int(width);
+                    int64_t sv = width == 8 ? static_cast<int64_t>(v)
+                                            : static_cast<int64_t>(v << (64 - 8 * width)) >> (64 - 8 * width);
+                    t = {Token::NUMBER, isUnsigned ? FormatCount(v) : std::to_string(sv)};
+                } else if(type == 0x04 or type == 0x05) {
+                    uint64_t bits = r.Int(type == 0x04 ? 4 : 8);
+                    double d;
+                    if(type == 0x04) {
+                        float f;
+                        uint32_t b32 = static_cast<uint32_t>(bits);
+                        memcpy(&f, &b32, sizeof(f));
+                        d = f;
+                    } else {
+                        memcpy(&d, &bits, sizeof(d));
+                    }
+                    t = {Token::NUMBER, std::to_string(d)};
+                } else if(type == 0x06) {
+                    t = {Token::NUL, "NULL"};
+                } else {
+                    // 字符串、BLOB、DECIMAL 等按长度编码字符串发送；日期时间类型本项目不使用
+                    t = {Token::STRING, r.Bytes(r.Lenenc())};
+                }
+                k++;
+            }
+        }
+        if(!r.ok) {
+            s.Err(ER_WRONG_ARGUMENTS, "HY000", "Incorrect arguments to mysqld_stmt_execute");
+            return true;
+        }
+        if(auto inj = injected()) return *inj;
+        Result res = Execute_(s, tokens, false);
+        if(res.kind == Result::ERR) {
+            s.Err(res.errCode, res.sqlState, res.message);
+        } else if(res.kind == Result::OK) {
+            s.Ok(res.affected);
+        } else {
+            // 二进制结果集：行首 0x00，NULL 位图从第 2 位开始，所有列都是 VAR_STRING
+            std::string count;
+            PutLenenc(count, res.columns.size());
+            s.Packet(count);
+            for(const std::string& col : res.columns) s.Column(col);
+            s.Eof();
+            for(const auto& row : res.rows) {
+                std::string p(1, '\0');
+                size_t bitmapAt = p.size();
+                p.append((row.size() + 7 + 2) / 8, '\0');
+                for(size_t c = 0; c < row.size(); c++) {
+                    if(row[c]) PutLenencStr(p, *row[c]);
+                    else p[bitmapAt + (c + 2) / 8] |= static_cast<char>(1 << ((c + 2) % 8));
+                }
+                s.Packet(p);
+            }
+            s.Eof();
+        }
+        return true;
+    }
+    default:
+        s.Err(ER_UNKNOWN_COM_ERROR, "08S01", "Unknown command");
+        return true;
+    }
+}
+
+void FakeMySql::Commit_(Session& s) {
+    if(!s.pending.empty()) {
+        std::lock_guard<std::mutex> lock(tableMtx_);
+        for(auto& [name, pwd] : s.pending) users_.emplace(std::move(name), std::move(pwd));
+    }
+    s.pending.clear();
+    s.inTxn = false;
+}
+
+FakeMySql::Result FakeMySql::Execute_(Session& s, const std::vector<Token>& tokens, bool dryRun) {
+    Parser p(tokens);
+    auto syntaxError = [&tokens]() {
+        std::string text;
+        for(const Token& t : tokens) {
+            if(t.type == Token::END) break;
+            if(!text.empty()) text += ' ';
+            text += t.type == Token::STRING ? "'" + t.text + "'" : t.text;
+        }
+        return Result::Error(ER_PARSE_ERROR, "42000",
+                             "You have an error in your SQL syntax; fakemysql does not support: " + text);
+    };
+    Result res;
+
+    if(p.Accept("SELECT")) {
+        // 选择列表：user 表的列、*、COUNT(*)，或不需要 FROM 的 VERSION()、SLEEP(n)、DATABASE()、字面量
+        struct Item {
+            enum Kind { COLUMN, COUNT, VALUE, SLEEP } kind = VALUE;
+            int column = 0;
+            std::optional<std::string> value;
+        };
+        std::vector<Item> items;
+        do {
+            Item item;
+            std::string name;
+            std::optional<std::string> literal;
+            if(p.Accept("*")) {
+                items.push_back({Item::COLUMN, 0, {}});
+                items.push_back({Item::COLUMN, 1, {}});
+                res.columns.push_back("username");
+                res.columns.push_back("password");
+                continue;
+            } else if((item.column = p.ColumnIndex()) >= 0) {
+                item.kind = Item::COLUMN;
+                name = item.column == 0 ? "username" : "password";
+            } else if(p.Is("COUNT") and p.Is("(", 1)) {
+                p.Next();
+                p.Next();
+                if(!p.Accept("*") or !p.Accept(")")) return syntaxError();
+                item.kind = Item::COUNT;
+                name = "COUNT(*)";
+            } else if(p.Is("VERSION") and p.Is("(", 1)) {
+                p.Next();
+                p.Next();
+                if(!p.Accept(")")) return syntaxError();
+                item.value = SERVER_VERSION;
+                name = "VERSION()";
+            } else if(p.Is("DATABASE") and p.Is("(", 1)) {
+                p.Next();
+                p.Next();
+                if(!p.Accept(")")) return syntaxError();
+                item.value = "webserver";
+                name = "DATABASE()";
+            } else if(p.Is("SLEEP") and p.Is("(", 1)) {
+                p.Next();
+                p.Next();
+                if(!p.Literal(literal) or !p.Accept(")")) return syntaxError();
+                item.kind = Item::SLEEP;
+                item.value = literal.value_or("0");
+                name = "SLEEP(" + *item.value + ")";
+            } else if(p.Literal(literal)) {
+                item.value = literal;
+                name = literal.value_or("NULL");
+            } else if(p.Peek().type == Token::WORD and p.Peek().text.starts_with("@@")) {
+                item.value = ""; // 系统变量一律返回空串
+                name = p.Next().text;
+            } else {
+                return syntaxError();
+            }
+            if(p.Accept("AS")) {
+                if(p.Peek().type != Token::WORD and p.Peek().type != Token::STRING) return syntaxError();
+                name = p.Next().text;
+            }
+            items.push_back(item);
+            res.columns.push_back(name);
+        } while(p.Accept(","));
+
+        bool fromUser = false;
+        std::vector<Condition> conds;
+        if(p.Accept("FROM")) {
+            if(!p.Table() or !ParseWhere(p, conds)) return syntaxError();
+            fromUser = true;
+        }
+        uint64_t limit = UINT64_MAX;
+        if(p.Accept("LIMIT")) {
+            if(p.Peek().type != Token::NUMBER and p.Peek().type != Token::PARAM) return syntaxError();
+            const Token& t = p.Next();
+            limit = t.type == Token::NUMBER ? std::stoull(t.text) : UINT64_MAX;
+        }
+        if(!p.AtEnd()) return syntaxError();
+        for(const Item& item : items) {
+            if(item.kind == Item::COLUMN and !fromUser) return Result::Error(1054, "42S22", "Unknown column in 'field list'");
+        }
+        res.kind = Result::ROWS;
+        if(dryRun) return res;
+
+        auto makeRow = [&items](const std::string* name, const std::string* pwd, uint64_t count) {
+            std::vector<std::optional<std::string>> row;
+            for(const Item& item : items) {
+                if(item.kind == Item::COLUMN) row.emplace_back(item.column == 0 ? *name : *pwd);
+                else if(item.kind == Item::COUNT) row.emplace_back(FormatCount(count));
+                else if(item.kind == Item::SLEEP) row.emplace_back("0");
+                else row.push_back(item.value);
+            }
+            return row;
+        };
+        for(const Item& item : items) {
+            if(item.kind == Item::SLEEP) {
+                double seconds = std::strtod(item.value->c_str(), nullptr);
+                if(seconds > 0) std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+            }
+        }
+        if(!fromUser) {
+            res.rows.push_back(makeRow(nullptr, nullptr, 1));
+            return res;
+        }
+        bool aggregate = std::any_of(items.begin(), items.end(), [](const Item& i) { return i.kind == Item::COUNT; });
+        std::vector<std::pair<std::string, std::string>> matched;
+        {
+            std::lock_guard<std::mutex> lock(tableMtx_);
+            auto visit = [&](const std::string& name, const std::string& pwd) {
+                if(matched.size() >= limit and !aggregate) return;
+                for(const Condition& c : conds) {
+                    if(!c.Match(name, pwd)) return;
+                }
+                matched.emplace_back(name, pwd);
+            };
+            // 按用户名等值 / IN 查询时走哈希索引，其余条件全表扫描
+            const Condition* byName = nullptr;
+            for(const Condition& c : conds) {
+                if(c.column == 0 and c.op != Condition::LIKE) byName = &c;
+            }
+            if(byName) {
+                for(const auto& v : byName->values) {
+                    if(!v) continue;
+                    auto [first, last] = users_.equal_range(*v);
+                    for(auto it = first; it != last; ++it) visit(it->first, it->second);
+                }
+            } else {
+                for(const auto& [name, pwd] : users_) visit(name, pwd);
+            }
+        }
+        if(aggregate) {
+            const std::string empty;
+            const std::string* name = matched.empty() ? &empty : &matched[0].first;
+            const std::string* pwd = matched.empty() ? &empty : &matched[0].second;
+            if(limit > 0) res.rows.push_back(makeRow(name, pwd, matched.size()));
+        } else {
+            for(const auto& [name, pwd] : matched) res.rows.push_back(makeRow(&name, &pwd, 0));
+        }
+        return res;
+    }
+
+    if(p.Accept("INSERT")) {
+        p.Accept("IGNORE");
+        if(!p.Accept("INTO") or !p.Table()) return syntaxError();
+        int order[2] = {0, 1};
+        if(p.Accept("(")) {
+            for(int i = 0; i < 2; i++) {
+                if((order[i] = p.ColumnIndex()) < 0) return syntaxError();
+                if(i == 0 and !p.Accept(",")) return syntaxError();
+            }
+            if(order[0] == order[1] or !p.Accept(")")) return syntaxError();
+        }
+        if(!p.Accept("VALUES") and !p.Accept("VALUE")) return syntaxError();
+        std::vector<std::pair<std::string, std::string>> rows;
+        do {
+            std::optional<std::string> v[2];
+            if(!p.Accept("(") or !p.Literal(v[0]) or !p.Accept(",") or !p.Literal(v[1]) or !p.Accept(")")) {
+                return syntaxError();
+            }
+            std::string cols[2];
+            cols[order[0]] = v[0].value_or("");
+            cols[order[1]] = v[1].value_or("");
+            rows.emplace_back(std::move(cols[0]), std::move(cols[1]));
+        } while(p.Accept(","));
+        if(!p.AtEnd()) return syntaxError();
+        if(dryRun) return res;
+        res.affected = rows.size();
+        if(!s.autocommit or s.inTxn) {
+            for(auto& row : rows) s.pending.push_back(std::move(row));
+        } else {
+            std::lock_guard<std::mutex> lock(tableMtx_);
+            for(auto& [name, pwd] : rows) users_.emplace(std::move(name), std::move(pwd));
+        }
+        return res;
+    }
+
+    if(p.Accept("DELETE")) {
+        std::vector<Condition> conds;
+        if(!p.Accept("FROM") or !p.Table() or !ParseWhere(p, conds) or !p.AtEnd()) return syntaxError();
+        if(dryRun) return res;
+        std::lock_guard<std::mutex> lock(tableMtx_);
+        for(auto it = users_.begin(); it != users_.end();) {
+            bool match = std::all_of(conds.begin(), conds.end(), [&it](const Condition& c) {
+                return c.Match(it->first, it->second);
+            });
+            if(match) {
+                it = users_.erase(it);
+                res.affected++;
+            } else {
+                ++it;
+            }
+        }
+        return res;
+    }
+
+    if(p.Accept("SET")) {
+        // SET autocommit = 0/1 影响事务，其余（SET NAMES 等）直接成功
+        p.Accept("SESSION");
+        const Token& t = p.Peek();
+        if(t.type == Token::WORD and (IEquals(t.text, "autocommit") or IEquals(t.text, "@@autocommit") or
+                                      IEquals(t.text, "@@session.autocommit"))) {
+            p.Next();
+            std::optional<std::string> v;
+            if(!p.Accept("=")) return syntaxError();
+            if(p.Peek().type == Token::WORD) v = p.Next().text; // ON / OFF
+            else if(!p.Literal(v)) return syntaxError();
+            bool on = v and *v != "0" and !IEquals(*v, "OFF") and !IEquals(*v, "FALSE");
+            if(!dryRun) {
+                if(on and !s.autocommit) Commit_(s); // 打开自动提交会提交当前事务
+                s.autocommit = on;
+            }
+        }
+        return res;
+    }
+    if(p.Accept("BEGIN") or (p.Accept("START") and p.Accept("TRANSACTION"))) {
+        if(!dryRun) {
+            Commit_(s); // 开始新事务前隐式提交
+            s.inTxn = true;
+        }
+        return res;
+    }
+    if(p.Accept("COMMIT")) {
+        if(!dryRun) Commit_(s);
+        return res;
+    }
+    if(p.Accept("ROLLBACK")) {
+        if(!dryRun) {
+            s.pending.clear();
+            s.inTxn = false;
+        }
+        return res;
+    }
+    if(p.Accept("USE")) return res;
+    return syntaxError();
+}
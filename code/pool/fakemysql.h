@@ -0,0 +1,120 @@
+#ifndef FAKEMYSQL_H
+#define FAKEMYSQL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*
+    本地 MySQL 替身：实现 MySQL 客户端/服务器协议中本项目用到的部分，数据是内存中的 user 表，
+    用于在没有数据库服务的机器上测试、压测连接池和登录/注册路径。
+    - 握手使用 caching_sha2_password 快速认证（也接受 mysql_native_password），不校验密码、不支持 TLS；
+    - 命令：COM_QUERY、COM_PING、COM_INIT_DB、COM_STMT_PREPARE / EXECUTE / RESET / CLOSE、COM_QUIT；
+    - SQL：SELECT（VERSION()、SLEEP(n)、COUNT(*)、字面量，或 user 表上按 username / password 的
+      =、LIKE、IN 条件和 LIMIT），INSERT [IGNORE] INTO user ... VALUES 多行，DELETE FROM user，
+      SET（含 autocommit）、BEGIN / COMMIT / ROLLBACK、USE；其他语句返回语法错误；
+    - 与项目中的表结构一致，username 上没有唯一索引，重复 INSERT 会插入多行；
+      列比较与 MySQL 8 的默认排序规则一致，不区分大小写（只处理 ASCII）；
+      事务只缓冲 INSERT（COMMIT 时写入、ROLLBACK 时丢弃），其他语句立即生效；
+    - 每个连接一个线程、阻塞读写，替身自身不是被测对象，延迟注入直接 sleep；
+    - 查询（COM_QUERY / COM_STMT_EXECUTE / COM_PING）前按 latencyMs ± jitterMs 延迟，
+      按 errorRate 返回 ER_LOCK_WAIT_TIMEOUT，按 dropRate 直接断开连接（客户端得到 CR_SERVER_LOST）；
+      随机数按 seed 与连接序号生成，同样的参数与请求顺序得到同样的注入结果。
+    延迟与注入概率可在运行中修改，用于观察连接池在数据库变慢或抖动时的表现。
+*/
+struct FakeMySqlOptions {
+    int port = 3306;            // 0 表示由内核分配，Start 之后用 Port() 取得
+    int latencyMs = 0;          // 每条查询的固定延迟
+    int jitterMs = 0;           // 在 [latencyMs - jitterMs, latencyMs + jitterMs] 内均匀分布
+    int connectLatencyMs = 0;   // 握手前的延迟（建连耗时）
+    double errorRate = 0;       // 查询返回错误的概率
+    double dropRate = 0;        // 查询时断开连接的概率
+    int maxConnections = 0;     // 超过时新连接收到 ER_CON_COUNT_ERROR，0 表示不限制
+    uint32_t seed = 1;
+};
+
+namespace fakemysql {
+struct Token; // SQL 词法单元
+}
+
+class FakeMySql {
+public:
+    explicit FakeMySql(const FakeMySqlOptions& options = FakeMySqlOptions());
+    ~FakeMySql() { Stop(); }
+    FakeMySql(const FakeMySql&) = delete;
+    FakeMySql& operator=(const FakeMySql&) = delete;
+
+    // 监听 127.0.0.1:port 并启动接收线程；端口被占用时返回 false
+    bool Start();
+    // 关闭监听和所有连接，等待连接线程退出
+    void Stop();
+    int Port() const { return port_; }
+
+    void AddUser(const std::string& name, const std::string& password);
+    size_t UserCount();
+
+    void SetLatency(int latencyMs, int jitterMs);
+    void SetErrorRate(double rate);
+    void SetDropRate(double rate);
+
+    uint64_t Connections() const { return connections_.load(std::memory_order_relaxed); }
+    uint64_t Queries() const { return queries_.load(std::memory_order_relaxed); }
+    uint64_t InjectedErrors() const { return errors_.load(std::memory_order_relaxed); }
+    uint64_t Drops() const { return drops_.load(std::memory_order_relaxed); }
+
+private:
+    struct Session;
+    struct Result;
+
+    void Accept_();
+    void Serve_(int fd, uint64_t id);
+    bool Handshake_(Session& s);
+    // 处理一条命令，返回 false 表示关闭连接
+    bool Dispatch_(Session& s, const std::string& packet);
+    // 执行一条 SQL（预处理语句已代入参数），dryRun 时只求出结果集的列、不修改数据也不等待
+    Result Execute_(Session& s, const std::vector<fakemysql::Token>& tokens, bool dryRun);
+    void Commit_(Session& s);
+    // 延迟与故障注入，返回 0 正常执行、1 返回错误、2 断开连接
+    int Inject_(Session& s);
+
+    FakeMySqlOptions options_;
+    int port_ = 0;
+    int listenFd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread acceptor_;
+
+    std::atomic<int> latencyMs_;
+    std::atomic<int> jitterMs_;
+    std::atomic<double> errorRate_;
+    std::atomic<double> dropRate_;
+
+    // 连接线程分离运行，Stop 关闭所有连接后等待 active_ 归零
+    std::mutex connMtx_;
+    std::condition_variable connCv_;
+    std::unordered_set<int> fds_;
+    int active_ = 0;
+
+    // 用户名按 ASCII 不区分大小写地散列与比较
+    struct NameHash {
+        size_t operator()(const std::string& name) const;
+    };
+    struct NameEqual {
+        bool operator()(const std::string& a, const std::string& b) const;
+    };
+
+    std::mutex tableMtx_;
+    std::unordered_multimap<std::string, std::string, NameHash, NameEqual> users_;
+
+    std::atomic<uint64_t> connections_{0};
+    std::atomic<uint64_t> queries_{0};
+    std::atomic<uint64_t> errors_{0};
+    std::atomic<uint64_t> drops_{0};
+};
+
+#endif /* FAKEMYSQL_H */
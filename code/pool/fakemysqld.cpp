@@ -0,0 +1,72 @@
+// 本地 MySQL 替身：在没有数据库服务的机器上给服务器、连接池测试提供一个可控的 "数据库"
+// 用法：fakemysql [-p 端口] [-l 延迟ms] [-j 抖动ms] [-c 建连延迟ms] [-e 错误率] [-d 断连率]
+//                 [-m 最大连接数] [-s 随机种子] [-u 用户名:密码]... [-n 预置用户数]
+// -n N 预置 user0 ~ user<N-1>，密码与用户名相同；Ctrl-C 退出时打印统计
+#include "fakemysql.h"
+#include "../log/log.h"
+
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+int main(int argc, char* argv[]) {
+    FakeMySqlOptions options;
+    std::vector<std::pair<std::string, std::string>> users;
+    int seedUsers = 0;
+    int opt;
+    while((opt = getopt(argc, argv, "p:l:j:c:e:d:m:s:u:n:")) != -1) {
+        switch(opt) {
+            case 'p': options.port = std::stoi(optarg); break;
+            case 'l': options.latencyMs = std::stoi(optarg); break;
+            case 'j': options.jitterMs = std::stoi(optarg); break;
+            case 'c': options.connectLatencyMs = std::stoi(optarg); break;
+            case 'e': options.errorRate = std::stod(optarg); break;
+            case 'd': options.dropRate = std::stod(optarg); break;
+            case 'm': options.maxConnections = std::stoi(optarg); break;
+            case 's': options.seed = static_cast<uint32_t>(std::stoul(optarg)); break;
+            case 'n': seedUsers = std::stoi(optarg); break;
+            case 'u': {
+                std::string arg = optarg;
+                size_t colon = arg.find(':');
+                if(colon == std::string::npos) {
+                    std::cerr << "Invalid user (expect name:password): " << arg << std::endl;
+                    return 1;
+                }
+                users.emplace_back(arg.substr(0, colon), arg.substr(colon + 1));
+                break;
+            }
+            default:
+                std::cerr << "Usage: " << argv[0] << " [-p port] [-l latency_ms] [-j jitter_ms] [-c connect_ms]"
+                          << " [-e error_rate] [-d drop_rate] [-m max_conn] [-s seed] [-u name:password]... [-n users]"
+                          << std::endl;
+                return 1;
+        }
+    }
+
+    // 在启动任何线程之前屏蔽信号，由主线程 sigwait 等待退出
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    Logger::getInstance().initLogger("log/fakemysql.log", LogLevel::INFO, 1024, 3);
+    FakeMySql server(options);
+    for(const auto& [name, password] : users) server.AddUser(name, password);
+    for(int i = 0; i < seedUsers; i++) server.AddUser("user" + std::to_string(i), "user" + std::to_string(i));
+    if(!server.Start()) {
+        std::cerr << "Listen on port " << options.port << " failed" << std::endl;
+        Logger::getInstance().shutdown();
+        return 1;
+    }
+    std::cerr << "fakemysql listening on 127.0.0.1:" << server.Port() << ", " << server.UserCount() << " users" << std::endl;
+
+    int sig = 0;
+    sigwait(&signals, &sig);
+    server.Stop();
+    std::cerr << server.Connections() << " connections, " << server.Queries() << " queries, "
+              << server.InjectedErrors() << " injected errors, " << server.Drops() << " drops" << std::endl;
+    Logger::getInstance().shutdown();
+    return 0;
+}
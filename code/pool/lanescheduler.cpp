@@ -0,0 +1,108 @@
+#include "lanescheduler.h"
+
+#include "../config/config.h"
+#include "../log/log.h"
+
+LaneScheduler& LaneScheduler::getInstance() {
+    static LaneScheduler instance;
+    return instance;
+}
+
+LaneScheduler::~LaneScheduler() {
+    Shutdown();
+}
+
+void LaneScheduler::Init() {
+    Config& config = Config::getInstance();
+    LaneConfig configs[static_cast<int>(RequestLane::COUNT)];
+    configs[static_cast<int>(RequestLane::STATIC)] = {config.c_lane_static_workers, config.c_lane_static_queue};
+    configs[static_cast<int>(RequestLane::DB)] = {config.c_lane_db_workers, config.c_lane_db_queue};
+    configs[static_cast<int>(RequestLane::ADMIN)] = {config.c_lane_admin_workers, config.c_lane_admin_queue};
+    Init(configs);
+}
+
+void LaneScheduler::Init(const LaneConfig (&configs)[static_cast<int>(RequestLane::COUNT)]) {
+    Shutdown();
+    for(int i = 0; i < static_cast<int>(RequestLane::COUNT); i++) {
+        Lane& lane = lanes_[i];
+        lane.config = configs[i];
+        if(lane.config.workers < 0) lane.config.workers = 0;
+        if(lane.config.queueSize < 0) lane.config.queueSize = 0;
+        lane.inflight.store(0);
+        lane.shed.store(0);
+        if(lane.config.workers > 0) {
+            lane.pool = std::make_unique<ThreadPool>(lane.config.workers);
+        }
+        LOG_INFO("Lane {} init | workers: {}, queue: {}",
+            LaneName(static_cast<RequestLane>(i)), lane.config.workers, lane.config.queueSize);
+    }
+}
+
+void LaneScheduler::Shutdown() {
+    for(auto& lane : lanes_) {
+        if(lane.pool) {
+            lane.pool->Shutdown();
+            lane.pool.reset();
+        }
+    }
+}
+
+bool LaneScheduler::Admit_(Lane& lane) {
+    // 内联执行的通道不排队，只受调用线程自身约束
+    if(!lane.pool) return true;
+    int limit = lane.config.workers + lane.config.queueSize;
+    int cur = lane.inflight.load();
+    do {
+        if(cur >= limit) return false;
+    } while(!lane.inflight.compare_exchange_weak(cur, cur + 1));
+    return true;
+}
+
+bool LaneScheduler::Dispatch(RequestLane lane, std::function<void()> task) {
+    Lane& l = lanes_[static_cast<int>(lane)];
+    if(!Admit_(l)) {
+        uint64_t shed = l.shed.fetch_add(1) + 1;
+        // 每 1024 次拒绝记录一次，避免拥塞时日志本身成为负担
+        if((shed & 1023) == 1) {
+            LOG_WARN("Lane {} saturated, shed {} tasks so far", LaneName(lane), shed);
+        }
+        return false;
+    }
+    if(!l.pool) {
+        task();
+        return true;
+    }
+    bool queued = l.pool->AddTask([&l, task = std::move(task)]() {
+        task();
+        l.inflight.fetch_sub(1);
+    });
+    if(!queued) l.inflight.fetch_sub(1); // 通道已关闭
+    return queued;
+}
+
+int LaneScheduler::InFlight(RequestLane lane) const {
+    return lanes_[static_cast<int>(lane)].inflight.load();
+}
+
+uint64_t LaneScheduler::ShedCount(RequestLane lane) const {
+    return lanes_[static_cast<int>(lane)].shed.load();
+}
+
+std::vector<std::thread::native_handle_type> LaneScheduler::NativeHandles() {
+    std::vector<std::thread::native_handle_type> handles;
+    for(auto& lane : lanes_) {
+        if(!lane.pool) continue;
+        auto h = lane.pool->NativeHandles();
+        handles.insert(handles.end(), h.begin(), h.end());
+    }
+    return handles;
+}
+
+const char* LaneScheduler::LaneName(RequestLane lane) {
+    switch(lane) {
+        case RequestLane::STATIC: return "static";
+        case RequestLane::DB: return "db";
+        case RequestLane::ADMIN: return "admin";
+        default: return "unknown";
+    }
+}
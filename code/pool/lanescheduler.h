@@ -0,0 +1,85 @@
+#ifndef LANESCHEDULER_H
+#define LANESCHEDULER_H
+
+#include <atomic>
+#include <memory>
+#include <functional>
+
+#include "threadpool.h"
+
+/*
+    舱壁（Bulkhead）调度：按请求类别划分互相隔离的执行通道，
+    每个通道有独立的工作线程（并发上限）和有界等待队列。
+    - STATIC：静态文件请求，workers 为 0 时直接在 Reactor 线程内执行；
+    - DB：登录/注册等需要访问数据库的请求，SqlConnPool::getConnection 阻塞时只会占满本通道；
+    - ADMIN：管理类请求，保证在业务拥塞时仍可访问。
+    某通道已满（运行中 + 排队 达到上限）时，新任务被拒绝（shed），调用方返回 503，
+    其他通道不受影响。
+*/
+enum class RequestLane {
+    STATIC = 0,
+    DB,
+    ADMIN,
+    COUNT
+};
+
+class LaneScheduler {
+public:
+    struct LaneConfig {
+        int workers = 0;     // 工作线程数，即并发上限；0 表示在调用线程内执行
+        int queueSize = 0;   // 等待队列长度，超过后拒绝新任务
+    };
+
+    static LaneScheduler& getInstance();
+
+    // 按 Config 中的 lane_* 配置初始化各通道
+    void Init();
+    void Init(const LaneConfig (&configs)[static_cast<int>(RequestLane::COUNT)]);
+    void Shutdown();
+
+    // 投递任务，通道已满或已关闭时返回 false（任务未执行）
+    bool Dispatch(RequestLane lane, std::function<void()> task);
+
+    // 在通道中执行 work，结果经 cq 回到 Reactor 线程交给 done；通道已满时返回 false
+    template<class Work, class Done>
+    bool Dispatch(RequestLane lane, CompletionQueue& cq, Work&& work, Done&& done);
+
+    // 通道的工作线程数，0 表示任务在调用线程内执行
+    int Workers(RequestLane lane) const { return lanes_[static_cast<int>(lane)].config.workers; }
+    int InFlight(RequestLane lane) const;   // 运行中 + 排队中的任务数
+    uint64_t ShedCount(RequestLane lane) const; // 被拒绝的任务数
+
+    static const char* LaneName(RequestLane lane);
+
+    // 所有通道工作线程的句柄，用于绑核等线程放置
+    std::vector<std::thread::native_handle_type> NativeHandles();
+
+private:
+    LaneScheduler() = default;
+    ~LaneScheduler();
+    LaneScheduler(const LaneScheduler&) = delete;
+    LaneScheduler& operator=(const LaneScheduler&) = delete;
+
+    struct Lane {
+        LaneConfig config;
+        std::unique_ptr<ThreadPool> pool; // workers 为 0 时为空
+        std::atomic<int> inflight{0};
+        std::atomic<uint64_t> shed{0};
+    };
+
+    bool Admit_(Lane& lane);
+
+    Lane lanes_[static_cast<int>(RequestLane::COUNT)];
+};
+
+template<class Work, class Done>
+bool LaneScheduler::Dispatch(RequestLane lane, CompletionQueue& cq, Work&& work, Done&& done) {
+    return Dispatch(lane, [&cq, work = std::forward<Work>(work), done = std::forward<Done>(done)]() mutable {
+        auto result = work();
+        cq.Post([done = std::move(done), result = std::move(result)]() mutable {
+            done(std::move(result));
+        });
+    });
+}
+
+#endif /* LANESCHEDULER_H */
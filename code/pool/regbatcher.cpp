@@ -0,0 +1,237 @@
+#include "regbatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "sqlstmt.h"
+#include "../log/log.h"
+
+// 与 errmsg.h 中的取值一致
+static constexpr unsigned int SQL_ERR_SERVER_GONE = 2006;
+static constexpr unsigned int SQL_ERR_SERVER_LOST = 2013;
+
+// 用户名的比较键：username 列使用默认排序规则（MySQL 8 不区分大小写），SELECT ... IN 查到的
+// 可能是 Alice 而请求的是 alice。ValidCredential 只允许 ASCII 用户名，按 ASCII 折叠大小写即可
+static std::string NameKey(std::string_view name) {
+    std::string key(name);
+    for(char& c : key) {
+        if(c >= 'A' and c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return key;
+}
+
+RegisterBatcher& RegisterBatcher::getInstance() {
+    static RegisterBatcher batcher;
+    return batcher;
+}
+
+void RegisterBatcher::Init(const char* host, int port, const char* user, const char* pwd, const char* dbName,
+                           int windowMs, size_t maxBatch, size_t maxPending) {
+    Close();
+    if(windowMs <= 0) return;
+    host_ = host;
+    user_ = user;
+    pwd_ = pwd;
+    dbName_ = dbName;
+    port_ = port;
+    windowMs_ = windowMs;
+    maxBatch_ = std::max<size_t>(maxBatch, 1);
+    maxPending_ = std::max(maxPending, maxBatch_);
+    running_.store(true, std::memory_order_release);
+    worker_ = std::thread(&RegisterBatcher::Run_, this);
+    LOG_INFO("RegisterBatcher Init | window: {} ms, max batch: {}, max pending: {}", windowMs_, maxBatch_, maxPending_);
+}
+
+void RegisterBatcher::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        running_.store(false, std::memory_order_release);
+    }
+    cv_.notify_all();
+    // 批处理线程处理完队列中剩余的请求后退出
+    if(worker_.joinable()) worker_.join();
+}
+
+bool RegisterBatcher::Submit(std::string name, std::string password, std::function<void(Result)> done) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if(!running_.load(std::memory_order_relaxed) or queue_.size() >= maxPending_) return false;
+    queue_.push_back({std::move(name), std::move(password), std::move(done)});
+    // 只在批处理线程可能在等待时唤醒：队列从空变为非空，或攒满一批
+    if(queue_.size() == 1 or queue_.size() >= maxBatch_) cv_.notify_one();
+    return true;
+}
+
+RegisterBatcher::Result RegisterBatcher::Register(const std::string& name, const std::string& password) {
+    std::promise<Result> promise;
+    std::future<Result> future = promise.get_future();
+    if(!Submit(name, password, [&promise](Result r) { promise.set_value(r); })) return Result::BUSY;
+    return future.get();
+}
+
+void RegisterBatcher::Run_() {
+    std::vector<Pending> batch;
+    std::vector<Result> results;
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            bool idle = queue_.empty();
+            cv_.wait(lock, [this]() { return !queue_.empty() or !running_.load(std::memory_order_relaxed); });
+            if(queue_.empty()) break;
+            // 空闲时收到第一个请求：再等一个窗口，让并发的注册加入同一批；
+            // 上一批提交期间已经积压的请求直接提交，不再额外等待
+            if(idle and queue_.size() < maxBatch_) {
+                cv_.wait_for(lock, std::chrono::milliseconds(windowMs_), [this]() {
+                    return queue_.size() >= maxBatch_ or !running_.load(std::memory_order_relaxed);
+                });
+            }
+            size_t n = std::min(queue_.size(), maxBatch_);
+            batch.assign(std::make_move_iterator(queue_.begin()), std::make_move_iterator(queue_.begin() + n));
+            queue_.erase(queue_.begin(), queue_.begin() + n);
+        }
+        results.assign(batch.size(), Result::FAILED);
+        Flush_(batch, results);
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        requests_.fetch_add(batch.size(), std::memory_order_relaxed);
+        LOG_DEBUG("RegisterBatcher: committed a batch of {}", batch.size());
+        for(size_t i = 0; i < batch.size(); i++) batch[i].done(results[i]);
+        batch.clear();
+    }
+    Disconnect_();
+    mysql_thread_end();
+}
+
+bool RegisterBatcher::Connect_() {
+    if(!mysql_init(&sql_)) {
+        LOG_ERROR("RegisterBatcher: mysql_init error");
+        return false;
+    }
+    if(!mysql_real_connect(&sql_, host_.c_str(), user_.c_str(), pwd_.c_str(), dbName_.c_str(), port_, nullptr, 0)) {
+        LOG_ERROR("RegisterBatcher: mysql_real_connect error: {}", mysql_error(&sql_));
+        mysql_close(&sql_);
+        return false;
+    }
+    mysql_set_character_set(&sql_, "utf8mb4");
+    mysql_autocommit(&sql_, false); // 每批一个事务，由 Execute_ 显式提交
+    connected_ = true;
+    return true;
+}
+
+void RegisterBatcher::Disconnect_() {
+    if(!connected_) return;
+    for(auto* cache : {&selects_, &inserts_}) {
+        for(MYSQL_STMT*& stmt : *cache) {
+            if(stmt) mysql_stmt_close(stmt);
+            stmt = nullptr;
+        }
+    }
+    mysql_close(&sql_);
+    connected_ = false;
+}
+
+MYSQL_STMT* RegisterBatcher::Stmt_(std::vector<MYSQL_STMT*>& cache, bool insert, size_t n) {
+    if(cache.size() <= n) cache.resize(n + 1, nullptr);
+    if(cache[n]) return cache[n];
+    std::string text = insert ? "INSERT INTO user(username, password) VALUES " : "SELECT username FROM user WHERE username IN (";
+    for(size_t i = 0; i < n; i++) {
+        if(i > 0) text += ", ";
+        text += insert ? "(?, ?)" : "?";
+    }
+    if(!insert) text += ")";
+    MYSQL_STMT* stmt = mysql_stmt_init(&sql_);
+    if(!stmt) return nullptr;
+    if(mysql_stmt_prepare(stmt, text.data(), text.size()) != 0) {
+        LOG_ERROR("RegisterBatcher: prepare failed: {}", mysql_stmt_error(stmt));
+        mysql_stmt_close(stmt);
+        return nullptr;
+    }
+    cache[n] = stmt;
+    return stmt;
+}
+
+void RegisterBatcher::Flush_(const std::vector<Pending>& batch, std::vector<Result>& results) {
+    for(int attempt = 0; attempt < 2; attempt++) {
+        if(!connected_ and !Connect_()) return;
+        unsigned int err = Execute_(batch, results);
+        if(err == 0) return;
+        mysql_rollback(&sql_);
+        if(err != SQL_ERR_SERVER_GONE and err != SQL_ERR_SERVER_LOST) {
+            LOG_ERROR("RegisterBatcher: batch of {} failed: {}", batch.size(), mysql_error(&sql_));
+            return;
+        }
+        // 连接断开：事务没有提交，重连后整批重试一次
+        LOG_WARN("RegisterBatcher: connection lost ({}), reconnect and retry", err);
+        Disconnect_();
+    }
+}
+
+unsigned int RegisterBatcher::Execute_(const std::vector<Pending>& batch, std::vector<Result>& results) {
+    auto errorOf = [this](MYSQL_STMT* stmt) {
+        unsigned int err = stmt ? mysql_stmt_errno(stmt) : mysql_errno(&sql_);
+        return err != 0 ? err : 1u;
+    };
+    // 批内去重：同名（不区分大小写）请求只有第一个参与查重与插入
+    std::vector<std::string> keys(batch.size());
+    std::unordered_map<std::string_view, size_t> first;
+    std::vector<size_t> unique;
+    for(size_t i = 0; i < batch.size(); i++) {
+        keys[i] = NameKey(batch[i].name);
+        if(first.emplace(keys[i], i).second) unique.push_back(i);
+    }
+
+    // 1. 一条 SELECT 查出已存在的用户名
+    MYSQL_STMT* select = Stmt_(selects_, false, unique.size());
+    if(!select) return errorOf(nullptr);
+    std::vector<MYSQL_BIND> params(unique.size() * 2);
+    for(size_t k = 0; k < unique.size(); k++) SqlBindString(params[k], batch[unique[k]].name);
+    if(mysql_stmt_bind_param(select, params.data()) or mysql_stmt_execute(select) != 0 or
+       mysql_stmt_store_result(select) != 0) {
+        LOG_WARN("RegisterBatcher: select failed: {}", mysql_stmt_error(select));
+        return errorOf(select);
+    }
+    char name[64] = {0}; // 表结构为 char(50)
+    unsigned long nameLen = 0;
+    MYSQL_BIND result;
+    memset(&result, 0, sizeof(result));
+    result.buffer_type = MYSQL_TYPE_STRING;
+    result.buffer = name;
+    result.buffer_length = sizeof(name);
+    result.length = &nameLen;
+    if(mysql_stmt_bind_result(select, &result)) {
+        mysql_stmt_free_result(select);
+        return errorOf(select);
+    }
+    std::unordered_set<std::string> existing;
+    while(mysql_stmt_fetch(select) == 0) existing.emplace(NameKey(std::string_view(name, std::min<size_t>(nameLen, sizeof(name)))));
+    mysql_stmt_free_result(select);
+
+    // 2. 一条多行 INSERT 插入其余用户
+    std::vector<size_t> fresh;
+    for(size_t i : unique) {
+        if(!existing.count(keys[i])) fresh.push_back(i);
+    }
+    if(!fresh.empty()) {
+        MYSQL_STMT* insert = Stmt_(inserts_, true, fresh.size());
+        if(!insert) return errorOf(nullptr);
+        for(size_t k = 0; k < fresh.size(); k++) {
+            SqlBindString(params[k * 2], batch[fresh[k]].name);
+            SqlBindString(params[k * 2 + 1], batch[fresh[k]].password);
+        }
+        if(mysql_stmt_bind_param(insert, params.data()) or mysql_stmt_execute(insert) != 0) {
+            LOG_WARN("RegisterBatcher: insert failed: {}", mysql_stmt_error(insert));
+            return errorOf(insert);
+        }
+    }
+
+    // 3. 整批一次提交
+    if(mysql_commit(&sql_) != 0) return errorOf(nullptr);
+    for(size_t i = 0; i < batch.size(); i++) {
+        bool created = first[keys[i]] == i and !existing.count(keys[i]);
+        results[i] = created ? Result::CREATED : Result::EXISTS;
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+#ifndef REGBATCHER_H
+#define REGBATCHER_H
+
+#include <mysql/mysql.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+    注册请求的批量提交（group commit）：
+    - 各连接提交的注册请求进入队列，批处理线程收到第一个后再等 windowMs 毫秒（或攒满 maxBatch 个），
+      整批在一个事务中完成：一条 SELECT ... IN 查出已存在的用户名，一条多行 INSERT 插入其余的，一次 COMMIT；
+    - 提交期间到达的请求自然组成下一批，注册吞吐随批大小增长，而不是受每次提交（redo 刷盘）限制；
+    - 用户名按 username 列的默认排序规则比较（不区分大小写），同一批内的重名请求只有第一个成功；所有注册都经过批处理线程这一个写者，查重与插入之间不会被其他注册插入；
+    - 批处理线程使用独立的阻塞连接，不占用连接池，非阻塞模式（db_nonblocking）下同样可用；
+    - 结果在批处理线程中逐个回调给等待者，Reactor 协程经 RunInLoop 恢复（server/asyncsql.h AsyncRegister）。
+    user 表没有唯一索引，因此不使用 INSERT ... ON DUPLICATE KEY，查重由批内的 SELECT 完成。
+*/
+class RegisterBatcher {
+public:
+    enum class Result {
+        CREATED, // 注册成功
+        EXISTS,  // 用户名已被占用
+        FAILED,  // 数据库错误
+        BUSY,    // 等待中的请求已达上限，调用方按过载处理
+    };
+
+    static RegisterBatcher& getInstance();
+
+    // windowMs 为 0 时关闭批量注册（Enabled 为 false），注册仍由各请求单独执行
+    void Init(const char* host, int port, const char* user, const char* pwd, const char* dbName,
+              int windowMs, size_t maxBatch, size_t maxPending);
+    void Close();
+    bool Enabled() const { return running_.load(std::memory_order_acquire); }
+
+    // 提交注册请求，结果在批处理线程中通过 done 返回；返回 false 表示队列已满（done 不会被调用）
+    bool Submit(std::string name, std::string password, std::function<void(Result)> done);
+    // 提交并阻塞等待结果（工作线程使用）
+    Result Register(const std::string& name, const std::string& password);
+
+    uint64_t Batches() const { return batches_.load(std::memory_order_relaxed); }
+    uint64_t Requests() const { return requests_.load(std::memory_order_relaxed); }
+
+private:
+    struct Pending {
+        std::string name;
+        std::string password;
+        std::function<void(Result)> done;
+    };
+
+    RegisterBatcher() = default;
+    ~RegisterBatcher() { Close(); }
+    RegisterBatcher(const RegisterBatcher&) = delete;
+    RegisterBatcher& operator=(const RegisterBatcher&) = delete;
+
+    void Run_();
+    // 执行一批注册，results 与 batch 一一对应；连接断开时重连后重试一次
+    void Flush_(const std::vector<Pending>& batch, std::vector<Result>& results);
+    // 在一个事务中执行一批，成功返回 0，否则返回错误码（事务未提交）
+    unsigned int Execute_(const std::vector<Pending>& batch, std::vector<Result>& results);
+    bool Connect_();
+    void Disconnect_();
+    // 按参数个数缓存的预处理语句：n 个用户名的 SELECT ... IN、n 行 INSERT
+    MYSQL_STMT* Stmt_(std::vector<MYSQL_STMT*>& cache, bool insert, size_t n);
+
+    std::string host_, user_, pwd_, dbName_;
+    int port_ = 0;
+    int windowMs_ = 0;
+    size_t maxBatch_ = 1;
+    size_t maxPending_ = 0;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::vector<Pending> queue_;
+    std::thread worker_;
+    std::atomic<bool> running_{false};
+
+    // 以下只在批处理线程中使用
+    MYSQL sql_;
+    bool connected_ = false;
+    std::vector<MYSQL_STMT*> selects_; // 下标为参数个数
+    std::vector<MYSQL_STMT*> inserts_;
+
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> requests_{0};
+};
+
+#endif /* REGBATCHER_H */
@@ -1,8 +1,17 @@
 #include "sqlconnpool.h"
 
+#include <poll.h>
+#include <algorithm>
+#include <cstddef>
+
+// 维护线程的巡检周期；建连失败后的重试间隔从 CONNECT_RETRY_MIN 开始翻倍，最长 CONNECT_RETRY_MAX
+static constexpr std::chrono::milliseconds MAINTAIN_TICK{1000};
+static constexpr std::chrono::milliseconds CONNECT_RETRY_MIN{500};
+static constexpr std::chrono::milliseconds CONNECT_RETRY_MAX{30000};
+
 SqlConnPool::SqlConnPool() {
-    useCount_.store(0);
-    freeCount_.store(0);
+    // 借出的 MYSQL* 与 PooledConn* 互相换算依赖 mysql 是首成员
+    static_assert(offsetof(PooledConn, mysql) == 0, "MYSQL must be the first member of PooledConn");
 }
 
 SqlConnPool& SqlConnPool::getInstance() {
@@ -10,78 +19,449 @@ SqlConnPool& SqlConnPool::getInstance() {
     return connPool;
 }
 
+int64_t SqlConnPool::NowNs_() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+size_t SqlConnPool::LocalIndex_() {
+    thread_local size_t index = nextLocal_.fetch_add(1, std::memory_order_relaxed) % LOCAL_SLOTS;
+    return index;
+}
+
+#ifdef SQL_NONBLOCKING_API
+// 以非阻塞方式建立连接（之后该连接的 mysql_*_nonblocking 调用不会阻塞），启动阶段用 poll 驱动到完成
+static MYSQL* ConnectNonblocking(MYSQL* sql, const char* host, int port,
+    const char* user, const char* pwd, const char* dbName) {
+    net_async_status status;
+    while((status = mysql_real_connect_nonblocking(sql, host, user, pwd, dbName, port, nullptr, 0)) == NET_ASYNC_NOT_READY) {
+        struct pollfd pfd = {sql->net.fd, POLLIN | POLLOUT, 0};
+        poll(&pfd, sql->net.fd >= 0 ? 1 : 0, 100);
+    }
+    return status == NET_ASYNC_COMPLETE ? sql : nullptr;
+}
+#endif
+
 void SqlConnPool::Init(const char* host, int port,
     const char* user, const char* pwd, const char* dbName
-    , int connSize) {
+    , int connSize, bool nonblocking) {
     assert(connSize > 0);
-    int created = 0;
-    for(int i=1;i<=connSize;i++) {
-        MYSQL* sql = nullptr;
-        sql = mysql_init(sql);
-        if(!sql) {
-            LOG_ERROR("mysql_init error");
-            continue;
-        }
-        sql = mysql_real_connect(sql, host, user, pwd, dbName, port, nullptr, 0);
-        if(!sql) {
-            LOG_ERROR("mysql_real_connect error");
-            mysql_close(sql);
-            continue;
-        }
-        if(mysql_set_character_set(sql, "utf8mb4") != 0) {
-            LOG_WARN(
-                "SqlConnPool Init: set charset utf8mb4 failed (index: {}) | err: %s",
-                i, mysql_error(sql)
-            );
-            // 字符集设置失败不影响连接使用，仅打印警告
-        }
-        created++;
-        connQue_.push(sql); // 将连接放入队列
+    assert(!running_);
+#ifndef SQL_NONBLOCKING_API
+    if(nonblocking) {
+        LOG_WARN("SqlConnPool: mysql client library has no nonblocking API, fall back to blocking connections");
+        nonblocking = false;
+    }
+#endif
+    nonblocking_ = nonblocking;
+    host_ = host;
+    user_ = user;
+    pwd_ = pwd;
+    dbName_ = dbName;
+    port_ = port;
+    maxConn_ = connSize;
+    minConn_ = options_.minConn > 0 ? std::min(options_.minConn, connSize) : connSize;
+
+    // 连接结构一次分配到最大连接数，之后只复用不释放
+    conns_ = std::make_unique<PooledConn[]>(maxConn_);
+    freeIndex_.clear();
+    for(int i = maxConn_ - 1; i >= 0; i--) {
+        conns_[i].index = static_cast<uint32_t>(i);
+        freeIndex_.push_back(static_cast<uint32_t>(i));
     }
-    MAX_CONN_ = created; // 设置最大连接数
-    freeCount_.store(created); // 设置空闲连接数
+    for(LocalSlot& slot : local_) slot.conn.store(nullptr);
+    sharedHead_.store(NIL);
+    sharedCount_.store(0);
+
+    // 并行建立常驻连接：每条连接的握手与认证要若干个往返，串行建立时启动耗时随连接数线性增长
+    mysql_library_init(0, nullptr, nullptr); // 多线程调用 mysql_init 之前必须先初始化客户端库
+    auto start = std::chrono::steady_clock::now();
+    std::vector<char> ok(minConn_, 0); // 各线程写不同元素，不能用 vector<bool>
+    std::vector<std::thread> openers;
+    for(int i = 0; i < minConn_; i++) {
+        openers.emplace_back([this, &ok, i]() {
+            ok[i] = Connect_(&conns_[i].mysql);
+            mysql_thread_end();
+        });
+    }
+    for(auto& t : openers) t.join();
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    int64_t now = NowNs_();
+    for(int i = 0; i < minConn_; i++) {
+        if(!ok[i]) continue;
+        PooledConn& conn = conns_[i];
+        conn.open = true;
+        conn.lastUsed.store(now);
+        conn.lastCheck.store(now);
+        freeIndex_.erase(std::find(freeIndex_.begin(), freeIndex_.end(), conn.index));
+        PushShared_(&conn);
+        total_++;
+    }
+    nextConnectAttempt_ = std::chrono::steady_clock::now();
+    connectBackoff_ = CONNECT_RETRY_MIN;
+    running_ = true;
+    maintainer_ = std::thread(&SqlConnPool::Maintain_, this);
     LOG_INFO(
-        "SqlConnPool Init success | total conn: {}, created: {}, sem init: {}",
-        MAX_CONN_, created, created);
+        "SqlConnPool Init success | created: {}/{} in {} ms, max: {}, acquire timeout: {} ms, nonblocking: {}",
+        total_, minConn_, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count(),
+        maxConn_, options_.acquireTimeout, nonblocking_);
+}
+
+bool SqlConnPool::Connect_(MYSQL* sql) {
+    if(!mysql_init(sql)) {
+        LOG_ERROR("mysql_init error");
+        return false;
+    }
+#ifdef SQL_NONBLOCKING_API
+    MYSQL* conn = nonblocking_ ? ConnectNonblocking(sql, host_.c_str(), port_, user_.c_str(), pwd_.c_str(), dbName_.c_str())
+                               : mysql_real_connect(sql, host_.c_str(), user_.c_str(), pwd_.c_str(), dbName_.c_str(), port_, nullptr, 0);
+#else
+    MYSQL* conn = mysql_real_connect(sql, host_.c_str(), user_.c_str(), pwd_.c_str(), dbName_.c_str(), port_, nullptr, 0);
+#endif
+    if(!conn) {
+        LOG_ERROR("mysql_real_connect error: {}", mysql_error(sql));
+        mysql_close(sql);
+        return false;
+    }
+    if(mysql_set_character_set(sql, "utf8mb4") != 0) {
+        // 字符集设置失败不影响连接使用，仅打印警告
+        LOG_WARN("SqlConnPool: set charset utf8mb4 failed | err: {}", mysql_error(sql));
+    }
+    return true;
+}
+
+void SqlConnPool::Close_(PooledConn* conn) {
+    conn->open = false;
+    closing_.push_back(conn);
+    maintCv_.notify_one();
+}
+
+void SqlConnPool::DrainClosing_(std::unique_lock<std::mutex>& lock) {
+    if(closing_.empty()) return;
+    std::vector<PooledConn*> batch;
+    batch.swap(closing_);
+    lock.unlock();
+    for(PooledConn* conn : batch) {
+        conn->stmts.Reset(); // 语句要在连接关闭前关闭
+        mysql_close(&conn->mysql);
+    }
+    lock.lock();
+    // 关闭完成后结构才能被新连接复用
+    for(PooledConn* conn : batch) freeIndex_.push_back(conn->index);
+}
+
+bool SqlConnPool::Reconnect(MYSQL* sql) {
+    assert(!nonblocking_);
+    StmtCache(sql).Reset(); // 旧连接上的语句随连接一起失效
+    mysql_close(sql);
+    if(!Connect_(sql)) {
+        // 保持已初始化但未连接的状态，下次使用时报 CR_SERVER_GONE_ERROR 并再次重连
+        mysql_init(sql);
+        return false;
+    }
+    LOG_INFO("SqlConnPool: reconnected to {}:{}", host_, port_);
+    return true;
+}
+
+void SqlConnPool::PushShared_(PooledConn* conn) {
+    uint64_t head = sharedHead_.load();
+    uint64_t desired;
+    do {
+        conn->next.store(static_cast<uint32_t>(head));
+        desired = (((head >> 32) + 1) << 32) | conn->index;
+    } while(!sharedHead_.compare_exchange_weak(head, desired));
+    sharedCount_.fetch_add(1, std::memory_order_relaxed);
+}
+
+SqlConnPool::PooledConn* SqlConnPool::PopShared_() {
+    uint64_t head = sharedHead_.load();
+    while(true) {
+        uint32_t index = static_cast<uint32_t>(head);
+        if(index == NIL) return nullptr;
+        // 连接结构不会释放，即使栈顶已被其他线程取走，读到的 next 也只会让下面的 CAS 因版本号不同而失败
+        PooledConn* conn = &conns_[index];
+        uint64_t desired = (((head >> 32) + 1) << 32) | conn->next.load();
+        if(sharedHead_.compare_exchange_weak(head, desired)) {
+            sharedCount_.fetch_sub(1, std::memory_order_relaxed);
+            return conn;
+        }
+    }
+}
+
+SqlConnPool::PooledConn* SqlConnPool::TryAcquire_() {
+    if(!conns_) return nullptr;
+    size_t me = LocalIndex_();
+    if(PooledConn* conn = local_[me].conn.exchange(nullptr)) return conn;
+    if(PooledConn* conn = PopShared_()) return conn;
+    // 连接都停在其他线程的槽位里（负载不均）：逐个取
+    size_t used = std::min(nextLocal_.load(std::memory_order_relaxed), LOCAL_SLOTS);
+    for(size_t i = 0; i < used; i++) {
+        if(i == me or !local_[i].conn.load()) continue;
+        if(PooledConn* conn = local_[i].conn.exchange(nullptr)) return conn;
+    }
+    return nullptr;
+}
+
+void SqlConnPool::Stash_(PooledConn* conn) {
+    PooledConn* expected = nullptr;
+    // 多个线程共用一个槽位时用 CAS，不会覆盖别人放入的连接
+    if(local_[LocalIndex_()].conn.compare_exchange_strong(expected, conn)) return;
+    PushShared_(conn);
 }
+
 // 获取连接
 MYSQL* SqlConnPool::getConnection() {
-    MYSQL* sql = nullptr;
+    return getConnection(std::chrono::milliseconds(options_.acquireTimeout));
+}
+
+MYSQL* SqlConnPool::getConnection(std::chrono::milliseconds timeout) {
+    // 已有线程在等待时不走快路径插队，排到锁上，避免等待者长时间抢不到连接
+    if(waiting_.load() == 0) {
+        if(PooledConn* conn = TryAcquire_()) return &conn->mysql;
+    }
+
+    // 没有空闲连接：登记为等待者后再试一次（与归还方的「放入后检查等待者」配对，不会漏掉唤醒）
+    auto deadline = std::chrono::steady_clock::now() + timeout;
     std::unique_lock<std::mutex> lock(mtx_);
-    cv_.wait(lock, [this](){return freeCount_ > 0 and !connQue_.empty();});
-    assert(!connQue_.empty());
-    sql = connQue_.front();
-    connQue_.pop();
-    freeCount_.fetch_sub(1); // 空闲连接数减1
-    useCount_.fetch_add(1); // 使用连接数加1
-    LOG_DEBUG("Get sql connection success! free: {}, use: {}", freeCount_.load(), useCount_.load());
-    return sql; // 返回连接
+    blockedWaiters_++;
+    waiting_.fetch_add(1);
+    if(NeedGrow_()) maintCv_.notify_one();
+    PooledConn* conn = nullptr;
+    while(!(conn = TryAcquire_())) {
+        if(timeout.count() < 0) {
+            cv_.wait(lock);
+        } else if(cv_.wait_until(lock, deadline) == std::cv_status::timeout) {
+            conn = TryAcquire_();
+            break;
+        }
+    }
+    blockedWaiters_--;
+    waiting_.fetch_sub(1);
+    if(!conn) {
+        LOG_WARN("SqlConnPool: no free connection within {} ms | total: {}, max: {}", timeout.count(), total_, maxConn_);
+        return nullptr;
+    }
+    return &conn->mysql;
+}
+
+MYSQL* SqlConnPool::getConnectionOrWait(std::function<void(MYSQL*)> onFree, size_t maxWaiters, uint64_t& ticket) {
+    ticket = 0;
+    if(waiting_.load() == 0) {
+        if(PooledConn* conn = TryAcquire_()) return &conn->mysql;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    if(waiters_.size() >= maxWaiters) return nullptr;
+    waiters_.push_back({nextTicket_++, std::move(onFree)});
+    waiting_.fetch_add(1);
+    // 登记后再试一次，期间归还到无锁路径上的连接不会被错过
+    if(PooledConn* conn = TryAcquire_()) {
+        waiters_.pop_back();
+        waiting_.fetch_sub(1);
+        return &conn->mysql;
+    }
+    ticket = waiters_.back().ticket;
+    if(NeedGrow_()) maintCv_.notify_one();
+    return nullptr;
+}
+
+bool SqlConnPool::cancelWait(uint64_t ticket) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = std::find_if(waiters_.begin(), waiters_.end(), [ticket](const Waiter& w) { return w.ticket == ticket; });
+    if(it == waiters_.end()) return false;
+    waiters_.erase(it);
+    waiting_.fetch_sub(1);
+    return true;
+}
+
+void SqlConnPool::Release_(PooledConn* conn, std::unique_lock<std::mutex>& lock) {
+    if(!waiters_.empty()) {
+        std::function<void(MYSQL*)> onFree = std::move(waiters_.front().onFree);
+        waiters_.pop_front();
+        waiting_.fetch_sub(1);
+        lock.unlock();
+        onFree(&conn->mysql); // 连接仍处于借出状态
+        return;
+    }
+    PushShared_(conn);
+    cv_.notify_one(); // 唤醒一个等待的线程
 }
 
-// 释放连接进入连接池复用
+// 释放连接进入连接池复用；没有等待者时不加锁放回本线程槽位，有协程在等待时直接交给最早的等待者
 void SqlConnPool::freeConnection(MYSQL* sql) {
     assert(sql);
+    PooledConn* conn = ConnOf_(sql);
+    int64_t now = NowNs_();
+    conn->lastUsed.store(now, std::memory_order_relaxed);
+    conn->lastCheck.store(now, std::memory_order_relaxed);
+    if(waiting_.load() == 0) {
+        Stash_(conn);
+        if(waiting_.load() == 0) return;
+        // 放入之后出现了等待者，它可能在我们放入之前已检查过无锁路径：取回一条连接交给它
+        std::unique_lock<std::mutex> lock(mtx_);
+        if(PooledConn* any = TryAcquire_()) Release_(any, lock);
+        return;
+    }
     std::unique_lock<std::mutex> lock(mtx_);
-    connQue_.push(sql);
-    freeCount_.fetch_add(1);
-    useCount_.fetch_sub(1); 
-    cv_.notify_one(); // 唤醒一个等待的线程
-    LOG_DEBUG("Free sql connection success! free: {}, use: {}", freeCount_.load(), useCount_.load());
+    Release_(conn, lock);
 }
 
-void SqlConnPool::ClosePool() {
+void SqlConnPool::discardConnection(MYSQL* sql) {
+    assert(sql);
     std::lock_guard<std::mutex> lock(mtx_);
-    while(!connQue_.empty()) {
-        auto sql = connQue_.front();
-        connQue_.pop();
-        mysql_close(sql);
+    Close_(ConnOf_(sql)); // 维护线程在锁外关闭它，并按需补足
+    total_--;
+    LOG_WARN("Discard sql connection, pool size: {}", total_);
+}
+
+bool SqlConnPool::NeedGrow_() const {
+    // 空闲结构都在等待关闭时，维护线程先关闭再建连
+    if(!running_ or total_ >= maxConn_ or freeIndex_.empty()) return false;
+    // 共享栈中尚未被唤醒的线程取走的连接也算供给，避免多建
+    return total_ < minConn_ or
+           blockedWaiters_ + static_cast<int>(waiters_.size()) > opening_ + sharedCount_.load(std::memory_order_relaxed);
+}
+
+void SqlConnPool::Maintain_() {
+    auto nextTick = std::chrono::steady_clock::now() + MAINTAIN_TICK;
+    std::unique_lock<std::mutex> lock(mtx_);
+    while(running_) {
+        if(!closing_.empty()) {
+            DrainClosing_(lock);
+            continue;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if(NeedGrow_() and now >= nextConnectAttempt_) {
+            // 建连在锁外进行；一次建一条，等待者多时循环继续建，直到没有缺口或到达上限
+            PooledConn* conn = &conns_[freeIndex_.back()];
+            freeIndex_.pop_back();
+            opening_++;
+            total_++;
+            lock.unlock();
+            bool ok = Connect_(&conn->mysql);
+            lock.lock();
+            opening_--;
+            if(ok) {
+                conn->open = true;
+                conn->lastUsed.store(NowNs_());
+                conn->lastCheck.store(NowNs_());
+                connectBackoff_ = CONNECT_RETRY_MIN;
+                LOG_INFO("SqlConnPool: opened connection, pool size: {}", total_);
+                Release_(conn, lock);
+                if(!lock.owns_lock()) lock.lock();
+            } else {
+                // 数据库不可用时按指数退避重试，等待者到期后按超时失败
+                total_--;
+                freeIndex_.push_back(conn->index);
+                nextConnectAttempt_ = std::chrono::steady_clock::now() + connectBackoff_;
+                connectBackoff_ = std::min(connectBackoff_ * 2, CONNECT_RETRY_MAX);
+            }
+            continue;
+        }
+        if(now >= nextTick) {
+            ShrinkAndPing_(lock);
+            nextTick = std::chrono::steady_clock::now() + MAINTAIN_TICK;
+            continue;
+        }
+        auto wakeAt = nextTick;
+        if(NeedGrow_()) wakeAt = std::min(wakeAt, nextConnectAttempt_);
+        maintCv_.wait_until(lock, wakeAt);
+    }
+    lock.unlock();
+    mysql_thread_end();
+}
+
+void SqlConnPool::ShrinkAndPing_(std::unique_lock<std::mutex>& lock) {
+    bool shrink = options_.idleTimeout > 0 and total_ > minConn_;
+    // 非阻塞方式建立的连接不能用阻塞调用，它们出错时由使用方 Discard，再由维护线程补足
+    bool ping = !nonblocking_ and options_.pingInterval > 0;
+    if(!shrink and !ping) return;
+    int64_t now = NowNs_();
+    int64_t idleNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::seconds(options_.idleTimeout)).count();
+    int64_t pingNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::seconds(options_.pingInterval)).count();
+    auto idleTooLong = [&](PooledConn* c) { return shrink and now - c->lastUsed.load(std::memory_order_relaxed) >= idleNs; };
+    auto needCheck = [&](PooledConn* c) { return ping and now - c->lastCheck.load(std::memory_order_relaxed) >= pingNs; };
+
+    // 取出需要处理的空闲连接：本地槽位只取到期的，共享栈全部取出后把其余的放回
+    std::vector<PooledConn*> stale, fresh;
+    size_t used = std::min(nextLocal_.load(std::memory_order_relaxed), LOCAL_SLOTS);
+    for(size_t i = 0; i < used; i++) {
+        PooledConn* c = local_[i].conn.load();
+        if(c and (idleTooLong(c) or needCheck(c)) and local_[i].conn.compare_exchange_strong(c, nullptr)) stale.push_back(c);
+    }
+    while(PooledConn* c = PopShared_()) (idleTooLong(c) or needCheck(c) ? stale : fresh).push_back(c);
+    for(auto it = fresh.rbegin(); it != fresh.rend(); ++it) PushShared_(*it);
+    if(stale.empty()) return;
+
+    // 收缩：关闭超过 minConn 部分中空闲太久的连接
+    int closable = total_ - minConn_, closed = 0;
+    std::erase_if(stale, [&](PooledConn* c) {
+        if(closed >= closable or !idleTooLong(c)) return false;
+        Close_(c);
+        closed++;
+        return true;
+    });
+    if(closed > 0) {
+        total_ -= closed;
+        LOG_INFO("SqlConnPool: closed {} idle connections, pool size: {}", closed, total_);
+    }
+
+    // 健康检查在锁外 ping，失败时原地重连
+    std::vector<bool> alive(stale.size(), true);
+    if(ping) {
+        lock.unlock();
+        for(size_t i = 0; i < stale.size(); i++) {
+            if(!needCheck(stale[i])) continue;
+            MYSQL* sql = &stale[i]->mysql;
+            if(mysql_ping(sql) != 0) {
+                LOG_WARN("SqlConnPool: ping failed: {}, reconnecting", mysql_error(sql));
+                alive[i] = Reconnect(sql);
+            }
+            if(alive[i]) stale[i]->lastCheck.store(NowNs_(), std::memory_order_relaxed);
+        }
+        lock.lock();
     }
-    LOG_INFO("SqlConnPool Close success! total conn: {}", MAX_CONN_);
+    for(size_t i = 0; i < stale.size(); i++) {
+        if(!alive[i]) {
+            Close_(stale[i]);
+            total_--;
+            continue;
+        }
+        Release_(stale[i], lock);
+        if(!lock.owns_lock()) lock.lock();
+    }
+}
+
+void SqlConnPool::ClosePool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        running_ = false;
+    }
+    maintCv_.notify_all();
+    if(maintainer_.joinable()) maintainer_.join();
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    int closed = 0;
+    while(PooledConn* conn = TryAcquire_()) {
+        Close_(conn);
+        closed++;
+    }
+    total_ -= closed;
+    DrainClosing_(lock); // 维护线程已退出，由本线程关闭
+    LOG_INFO("SqlConnPool Close success! remaining conn: {}", total_);
     mysql_library_end(); // 关闭mysql库
 }
 
 int SqlConnPool::GetFreeConnCnt() const {
-    return freeCount_.load();
+    int n = sharedCount_.load(std::memory_order_relaxed);
+    size_t used = std::min(nextLocal_.load(std::memory_order_relaxed), LOCAL_SLOTS);
+    for(size_t i = 0; i < used; i++) n += local_[i].conn.load(std::memory_order_relaxed) != nullptr;
+    return n;
+}
+
+int SqlConnPool::GetConnCnt() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return total_;
 }
 
 SqlConnPool::~SqlConnPool() {
@@ -4,34 +4,92 @@
 #include <mysql/mysql.h>
 #include <mutex>
 #include <string>
-#include <queue>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <array>
+#include <deque>
+#include <functional>
 #include <condition_variable>
 #include <thread>
 #include <atomic>
 
 #include "../log/log.h"
+#include "sqlstmt.h"
+
+// libmysqlclient 8.0.16 起提供 mysql_*_nonblocking 接口；MariaDB 的客户端库接口不同，不支持
+#if defined(MYSQL_VERSION_ID) && MYSQL_VERSION_ID >= 80016 && !defined(MARIADB_BASE_VERSION) && !defined(MARIADB_VERSION_ID)
+#define SQL_NONBLOCKING_API 1
+#endif
 /*
     为什么需要SQL连接池？
     1. 数据库连接是一种稀缺资源，频繁的创建和销毁连接会带来额外的开销
     2. 连接池可以复用已经创建的连接，减少创建和销毁连接的开销
     3. 连接池可以限制连接的数量，防止过多的连接占用系统资源
     4. 连接池可以提供连接的负载均衡，提高系统的并发性能
+    非阻塞模式（db_nonblocking）下连接以非阻塞方式建立，只能由 Reactor 协程通过
+    server/asyncsql.h 借用：没有空闲连接时登记回调而不是阻塞线程，连接释放时直接交给等待者。
+    每个连接带一份预处理语句缓存（sqlstmt.h）；连接的 MYSQL 结构由连接池分配，
+    断线后可以原地重连，借出方持有的 MYSQL* 始终有效。
+    弹性伸缩（SqlPoolOptions）：
+    - 启动时并行建立 minConn 条连接，之后按需增长到 connSize（最大连接数）；
+    - 连接的建立、关闭、收缩与健康检查都在后台维护线程中完成，借连接的线程只等待、不建连；
+    - 超过 minConn 的连接空闲 idleTimeout 秒后关闭；空闲连接每 pingInterval 秒 mysql_ping 一次，
+      失败时原地重连，重连失败则关闭，由维护线程补足到 minConn；
+    - 借连接最多等待 acquireTimeout 毫秒，超时返回空连接，上层按过载处理（503）。
+    借还快路径不加锁：
+    - 每个线程（Reactor / 工作线程）有一个本地槽位，归还的连接优先放回本线程槽位，下次借用直接取回；
+    - 槽位已占用时放入共享的无锁栈；本地与共享都没有时从其他线程的槽位中取；
+    - 只有需要等待（池中没有空闲连接）或有等待者需要交接时才进入 mtx_。
 */
 
+struct SqlPoolOptions {
+    int minConn = 0;         // 常驻连接数，0 表示与最大连接数相同（固定大小）
+    int acquireTimeout = -1; // 借连接的最长等待时间（毫秒），-1 表示一直等待
+    int idleTimeout = 0;     // 超过 minConn 的空闲连接保留时间（秒），0 表示不收缩
+    int pingInterval = 0;    // 空闲连接健康检查间隔（秒），0 表示不检查
+};
+
 class SqlConnPool {
 
 public:
     static SqlConnPool& getInstance(); // 获取单例
 
-    MYSQL* getConnection(); // 获取连接
+    MYSQL* getConnection(); // 获取连接，最多等待 acquireTimeout 毫秒，超时返回 nullptr
+    MYSQL* getConnection(std::chrono::milliseconds timeout); // timeout 为负表示一直等待
+
+    // 不阻塞地获取连接：有空闲连接时直接返回；否则在等待者少于 maxWaiters 时登记 onFree 并返回 nullptr，
+    // 之后有连接释放时在释放方线程调用 onFree(conn) 把连接直接交给等待者；
+    // ticket 非零表示已登记，可用 cancelWait(ticket) 撤销
+    MYSQL* getConnectionOrWait(std::function<void(MYSQL*)> onFree, size_t maxWaiters, uint64_t& ticket);
+    // 撤销尚未得到连接的等待者，返回 false 表示连接已经交出（onFree 已调用或即将调用）
+    bool cancelWait(uint64_t ticket);
 
     void freeConnection(MYSQL* conn); // 释放连接
 
+    // 连接已不可用（如查询超时后协议状态未知）：移出连接池，由维护线程关闭并补足到 minConn，调用方不会阻塞
+    void discardConnection(MYSQL* conn);
+
     int GetFreeConnCnt() const; // 获取空闲连接数
+    int GetConnCnt() const; // 获取连接总数（含借出与正在建立的）
+
+    // 在 Init 之前设置，不设置时为固定大小、一直等待
+    void SetOptions(const SqlPoolOptions& options) { options_ = options; }
+    int AcquireTimeout() const { return options_.acquireTimeout; }
 
     void Init(const char* host, int port,
             const char* user,const char* pwd, 
-            const char* dbName, int connSize); // 初始化连接池
+            const char* dbName, int connSize, bool nonblocking = false); // 初始化连接池
+
+    // 连接是否以非阻塞方式建立（需要 SQL_NONBLOCKING_API）
+    bool IsNonblocking() const { return nonblocking_; }
+    // 连接的 socket，用于注册到 Reactor
+    static int SocketOf(MYSQL* conn) { return conn->net.fd; }
+
+    // 连接上的预处理语句缓存，由借到连接的线程独占使用
+    SqlStmtCache& StmtCache(MYSQL* conn) { return ConnOf_(conn)->stmts; }
+    // 断线后原地重连（MYSQL* 不变）并清空语句缓存；只用于阻塞模式的连接
+    bool Reconnect(MYSQL* conn);
 
     void ClosePool(); // 关闭连接池
 
@@ -42,13 +100,87 @@ private:
     SqlConnPool(const SqlConnPool&) = delete;
     SqlConnPool& operator=(const SqlConnPool&) = delete;
 
-    int MAX_CONN_;
-    std::atomic<int> useCount_;
-    std::atomic<int> freeCount_;
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr size_t LOCAL_SLOTS = 64; // 线程多于槽位时按线程序号取模共用
+
+    // 池中的一条连接，Init 时按最大连接数一次分配，关闭后结构保留供新连接复用（无锁栈不会访问到已释放的内存）；
+    // 借出的 MYSQL* 就是首成员 mysql 的地址，归还时直接换算回 PooledConn，不需要查表
+    struct PooledConn {
+        MYSQL mysql;
+        SqlStmtCache stmts;
+        std::atomic<uint32_t> next{NIL};    // 共享栈中下一个连接的下标
+        std::atomic<int64_t> lastUsed{0};   // 最近归还的时间（steady_clock 纳秒），用于收缩
+        std::atomic<int64_t> lastCheck{0};  // 最近归还或 ping 成功的时间，用于健康检查
+        uint32_t index = 0;
+        bool open = false;                  // 持有 mtx_ 访问
+    };
+    struct alignas(64) LocalSlot {
+        std::atomic<PooledConn*> conn{nullptr};
+    };
+    struct Waiter {
+        uint64_t ticket;
+        std::function<void(MYSQL*)> onFree;
+    };
+
+    static PooledConn* ConnOf_(MYSQL* sql) { return reinterpret_cast<PooledConn*>(sql); }
+    static int64_t NowNs_();
+    // 本线程的本地槽位下标
+    size_t LocalIndex_();
+
+    // 无锁快路径：依次取本线程槽位、共享栈、其他线程槽位，没有空闲连接时返回 nullptr
+    PooledConn* TryAcquire_();
+    // 放回本线程槽位，已占用时放入共享栈
+    void Stash_(PooledConn* conn);
+    // 共享栈：下标 + 版本号打包在一个 64 位原子量中，避免 ABA
+    void PushShared_(PooledConn* conn);
+    PooledConn* PopShared_();
+
+    // 在已分配的 conn 上建立连接，失败时 conn 已 mysql_close，可以重试
+    bool Connect_(MYSQL* conn);
+    // 连接移出连接池，交给维护线程关闭，调用方持有 mtx_。
+    // mysql_close / mysql_stmt_close 要发送 COM_QUIT / COM_STMT_CLOSE，数据库慢时会阻塞，不能在锁内或 Reactor 上执行
+    void Close_(PooledConn* conn);
+    // 在锁外关闭 closing_ 中的连接并释放语句缓存，再把结构放回空闲下标；lock 持有 mtx_，返回时仍持有
+    void DrainClosing_(std::unique_lock<std::mutex>& lock);
+    // 连接交给最早的等待者，没有等待者时放入共享栈并唤醒一个阻塞的线程；
+    // lock 持有 mtx_，交给等待者时会先释放锁
+    void Release_(PooledConn* conn, std::unique_lock<std::mutex>& lock);
+    // 是否需要新建连接：低于 minConn，或有等待者且未到上限；调用方持有 mtx_
+    bool NeedGrow_() const;
+    // 维护线程：按需建连、收缩空闲连接、健康检查
+    void Maintain_();
+    void ShrinkAndPing_(std::unique_lock<std::mutex>& lock);
+
+    SqlPoolOptions options_;
+    int minConn_ = 0;
+    int maxConn_ = 0;
+    int total_ = 0;          // 连接总数，含借出与正在建立的
+    int opening_ = 0;        // 维护线程正在建立的连接数
+    int blockedWaiters_ = 0; // 在 getConnection 中阻塞等待的线程数
+    // 阻塞等待的线程与登记的协程总数，归还快路径据此判断是否需要加锁交接
+    std::atomic<int> waiting_{0};
+
+    std::unique_ptr<PooledConn[]> conns_; // maxConn_ 个连接结构
+    std::vector<uint32_t> freeIndex_;     // 未使用的连接结构下标，持有 mtx_ 访问
+    std::vector<PooledConn*> closing_;    // 已移出连接池、等待维护线程关闭的连接，持有 mtx_ 访问
+    std::array<LocalSlot, LOCAL_SLOTS> local_;
+    std::atomic<size_t> nextLocal_{0};    // 已分配的本地槽位序号
+    alignas(64) std::atomic<uint64_t> sharedHead_{NIL}; // 高 32 位版本号，低 32 位栈顶下标
+    std::atomic<int> sharedCount_{0};
 
-    std::queue<MYSQL*> connQue_;
+    std::deque<Waiter> waiters_; // 等待连接的协程回调（非阻塞模式）
+    uint64_t nextTicket_ = 1;
+    std::chrono::steady_clock::time_point nextConnectAttempt_; // 建连失败后的退避
+    std::chrono::milliseconds connectBackoff_{0};
+    bool nonblocking_ = false;
+    // 重连用的连接参数
+    std::string host_, user_, pwd_, dbName_;
+    int port_ = 0;
     mutable std::mutex mtx_;
     std::condition_variable cv_;// 信号量：控制可获取的空闲连接数，实现「无连接时线程阻塞等待」
+    std::condition_variable maintCv_; // 唤醒维护线程
+    bool running_ = false;
+    std::thread maintainer_;
 };
 
 #endif /* SQLCONNPOOL_H */
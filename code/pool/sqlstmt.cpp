@@ -0,0 +1,77 @@
+#include "sqlstmt.h"
+#include "sqlconnpool.h"
+
+#include <cstring>
+
+// 与 errmsg.h / mysqld_error.h 中的取值一致，MySQL 与 MariaDB 客户端相同
+static constexpr unsigned int SQL_ERR_UNKNOWN_STMT_HANDLER = 1243;
+static constexpr unsigned int SQL_ERR_SERVER_GONE = 2006;
+static constexpr unsigned int SQL_ERR_SERVER_LOST = 2013;
+
+static const char* const STMT_TEXT[] = {
+    "SELECT password FROM user WHERE username = ? LIMIT 1",
+    "INSERT INTO user(username, password) VALUES(?, ?)",
+};
+static_assert(sizeof(STMT_TEXT) / sizeof(STMT_TEXT[0]) == static_cast<size_t>(SqlStmtId::COUNT),
+              "every SqlStmtId needs its SQL text");
+
+const char* SqlStmtCache::Text(SqlStmtId id) {
+    return STMT_TEXT[static_cast<size_t>(id)];
+}
+
+MYSQL_STMT* SqlStmtCache::Get(MYSQL* sql, SqlStmtId id) {
+    MYSQL_STMT*& stmt = stmts_[static_cast<size_t>(id)];
+    if(stmt) return stmt;
+    MYSQL_STMT* fresh = mysql_stmt_init(sql);
+    if(!fresh) {
+        prepareErrno_ = mysql_errno(sql);
+        return nullptr;
+    }
+    const char* text = Text(id);
+    if(mysql_stmt_prepare(fresh, text, strlen(text)) != 0) {
+        prepareErrno_ = mysql_stmt_errno(fresh);
+        LOG_ERROR("Prepare \"{}\" failed: {}", text, mysql_stmt_error(fresh));
+        mysql_stmt_close(fresh);
+        return nullptr;
+    }
+    LOG_DEBUG("Prepared \"{}\"", text);
+    stmt = fresh;
+    return stmt;
+}
+
+void SqlStmtCache::Reset() {
+    for(MYSQL_STMT*& stmt : stmts_) {
+        if(stmt) mysql_stmt_close(stmt);
+        stmt = nullptr;
+    }
+}
+
+void SqlBindString(MYSQL_BIND& bind, const std::string& s) {
+    memset(&bind, 0, sizeof(bind));
+    bind.buffer_type = MYSQL_TYPE_STRING;
+    bind.buffer = const_cast<char*>(s.data());
+    bind.buffer_length = s.size(); // length 为空时按 buffer_length 发送
+}
+
+MYSQL_STMT* SqlExecute(MYSQL* sql, SqlStmtId id, MYSQL_BIND* params) {
+    SqlConnPool& pool = SqlConnPool::getInstance();
+    SqlStmtCache& cache = pool.StmtCache(sql);
+    for(int attempt = 0; ; attempt++) {
+        MYSQL_STMT* stmt = cache.Get(sql, id);
+        if(stmt and !mysql_stmt_bind_param(stmt, params) and mysql_stmt_execute(stmt) == 0 and
+           (mysql_stmt_field_count(stmt) == 0 or mysql_stmt_store_result(stmt) == 0)) {
+            return stmt;
+        }
+        unsigned int err = stmt ? mysql_stmt_errno(stmt) : cache.PrepareErrno();
+        bool lost = err == SQL_ERR_SERVER_GONE or err == SQL_ERR_SERVER_LOST;
+        if(attempt > 0 or !(lost or err == SQL_ERR_UNKNOWN_STMT_HANDLER)) {
+            // prepare 失败时 Get 中已打印错误信息
+            if(stmt) LOG_ERROR("Execute \"{}\" failed: {}", SqlStmtCache::Text(id), mysql_stmt_error(stmt));
+            return nullptr;
+        }
+        LOG_WARN("Execute \"{}\" failed ({}), {} and retry", SqlStmtCache::Text(id), err,
+                 lost ? "reconnect" : "re-prepare");
+        if(!lost) cache.Reset();
+        else if(!pool.Reconnect(sql)) return nullptr;
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef SQLSTMT_H
+#define SQLSTMT_H
+
+#include <mysql/mysql.h>
+#include <array>
+#include <string>
+#include <cstdint>
+
+/*
+    连接池中每个连接的预处理语句缓存：
+    - 语句按 SqlStmtId 编号，第一次在某个连接上使用时 prepare，之后只发送参数（二进制协议），
+      服务端不再重复解析 SQL 和生成执行计划，参数也不会被当作 SQL 解释（杜绝注入）；
+    - 缓存属于连接，借到连接的线程独占使用，不需要加锁；
+    - 连接断开时 SqlExecute 原地重连（MYSQL* 不变）并清空缓存，语句在新连接上重新 prepare 后重试一次。
+    MySQL 8 的非阻塞接口没有预处理语句版本，非阻塞模式（db_nonblocking）仍使用校验过的文本查询。
+*/
+
+enum class SqlStmtId : uint8_t {
+    USER_PASSWORD = 0, // SELECT password FROM user WHERE username = ? LIMIT 1
+    USER_INSERT,       // INSERT INTO user(username, password) VALUES(?, ?)
+    COUNT
+};
+
+class SqlStmtCache {
+public:
+    SqlStmtCache() = default;
+    ~SqlStmtCache() { Reset(); }
+
+    SqlStmtCache(const SqlStmtCache&) = delete;
+    SqlStmtCache& operator=(const SqlStmtCache&) = delete;
+
+    // 取出已 prepare 的语句，第一次使用时在 sql 上 prepare；失败返回 nullptr，错误码由 PrepareErrno 取得
+    MYSQL_STMT* Get(MYSQL* sql, SqlStmtId id);
+    // 最近一次 Get 失败的错误码。prepare 的错误记录在语句句柄上、不在 mysql_errno(sql) 中，
+    // 句柄关闭前先保存下来，连接断开时调用方据此重连
+    unsigned int PrepareErrno() const { return prepareErrno_; }
+    // 关闭所有语句；重连前调用，旧连接上的语句句柄已失效
+    void Reset();
+
+    static const char* Text(SqlStmtId id);
+
+private:
+    std::array<MYSQL_STMT*, static_cast<size_t>(SqlStmtId::COUNT)> stmts_{};
+    unsigned int prepareErrno_ = 0;
+};
+
+// 以字符串参数绑定 s（不拷贝，执行结束前 s 必须有效）
+void SqlBindString(MYSQL_BIND& bind, const std::string& s);
+
+// 绑定参数并执行语句，有结果集时整体读入客户端（mysql_stmt_store_result）；
+// 连接断开（CR_SERVER_GONE_ERROR / CR_SERVER_LOST）时重连、语句失效（ER_UNKNOWN_STMT_HANDLER）时
+// 重新 prepare，然后重试一次。成功返回可 bind_result / fetch 的语句，用完调用 mysql_stmt_free_result；
+// 失败返回 nullptr。sql 必须是从 SqlConnPool 借出的阻塞模式连接
+MYSQL_STMT* SqlExecute(MYSQL* sql, SqlStmtId id, MYSQL_BIND* params);
+
+#endif /* SQLSTMT_H */
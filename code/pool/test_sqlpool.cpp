@@ -1,11 +1,22 @@
 
 #include "sqlconnpool.h"
 #include "sqlconnRAII.h"
+#include "regbatcher.h"
+#include "fakemysql.h"
+#include "../auth/mysqluserstore.h"
 #include "../log/log.h"
+#include "../server/asyncsql.h"
 #include <iostream>
 #include <thread>
 #include <vector>
 #include <chrono>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <latch>
+#include <memory>
 
 // 测试函数：使用连接池执行查询
 void test_query(int thread_id) {
@@ -71,10 +82,307 @@ void test_concurrent_queries(int num_threads, int queries_per_thread) {
 // 测试函数：测试连接池状态
 void test_pool_status() {
     LOG_INFO("=== Connection Pool Status ===");
-    LOG_INFO("Free connections: {}", SqlConnPool::getInstance().GetFreeConnCnt());
+    LOG_INFO("Free connections: {}, total: {}", SqlConnPool::getInstance().GetFreeConnCnt(),
+             SqlConnPool::getInstance().GetConnCnt());
 }
 
-int main() {
+// 测试函数：弹性伸缩与借连接超时（Init 前已设置 minConn = 2、idleTimeout = 1s）
+void test_elastic(int max_conn) {
+    SqlConnPool& pool = SqlConnPool::getInstance();
+    if (pool.GetConnCnt() == 0) {
+        LOG_ERROR("No MySQL connection available, skip elastic test");
+        return;
+    }
+    // 借满到上限：空闲连接不够时由维护线程新建
+    std::vector<MYSQL*> held;
+    for (int i = 0; i < max_conn; ++i) {
+        MYSQL* sql = pool.getConnection(std::chrono::milliseconds(5000));
+        assert(sql);
+        held.push_back(sql);
+    }
+    assert(pool.GetConnCnt() == max_conn);
+
+    // 已到上限：等待 200ms 后失败返回，而不是一直阻塞
+    auto start_time = std::chrono::steady_clock::now();
+    assert(pool.getConnection(std::chrono::milliseconds(200)) == nullptr);
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+    assert(waited >= 200 and waited < 1000);
+    LOG_INFO("Exhausted pool failed fast after {} ms", waited);
+
+    for (MYSQL* sql : held) pool.freeConnection(sql);
+    assert(pool.GetFreeConnCnt() == max_conn);
+
+    // 空闲超过 idleTimeout 后收缩回常驻连接数
+    std::this_thread::sleep_for(std::chrono::milliseconds(3000));
+    LOG_INFO("Pool size after idle timeout: {}", pool.GetConnCnt());
+    assert(pool.GetConnCnt() == 2);
+    assert(pool.GetFreeConnCnt() == 2);
+}
+
+// 测试函数：借还竞争基准。每个线程在 duration_ms 内反复借出、归还连接（不执行查询），
+// 统计总吞吐与单次借连接耗时的分位数；线程数超过连接数后等待时间主要由排队决定
+void test_contention(const std::vector<int>& thread_counts, int duration_ms) {
+    SqlConnPool& pool = SqlConnPool::getInstance();
+    if (pool.GetConnCnt() == 0) {
+        LOG_ERROR("No MySQL connection available, skip contention benchmark");
+        return;
+    }
+    std::cout << "threads   ops/s        p50(ns)  p99(ns)  p99.9(ns)  max(ns)      timeouts" << std::endl;
+    for (int n : thread_counts) {
+        std::vector<std::vector<int64_t>> waits(n);
+        std::atomic<int> timeouts{0};
+        std::atomic<bool> stop{false};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < n; ++i) {
+            threads.emplace_back([&, i]() {
+                waits[i].reserve(1 << 20);
+                while (!stop.load(std::memory_order_relaxed)) {
+                    auto t0 = std::chrono::steady_clock::now();
+                    MYSQL* sql = pool.getConnection();
+                    auto t1 = std::chrono::steady_clock::now();
+                    if (!sql) {
+                        timeouts++;
+                        continue;
+                    }
+                    waits[i].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+                    pool.freeConnection(sql);
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+        stop = true;
+        for (auto& t : threads) t.join();
+
+        std::vector<int64_t> all;
+        for (auto& w : waits) all.insert(all.end(), w.begin(), w.end());
+        std::sort(all.begin(), all.end());
+        auto pct = [&all](double p) { return all.empty() ? 0 : all[static_cast<size_t>(p * (all.size() - 1))]; };
+        double ops = all.size() * 1000.0 / duration_ms;
+        LOG_INFO("Contention: {} threads, {:.0f} ops/s, wait p50 {} ns, p99 {} ns, p99.9 {} ns, max {} ns, timeouts {}",
+                 n, ops, pct(0.5), pct(0.99), pct(0.999), all.empty() ? 0 : all.back(), timeouts.load());
+        std::cout << std::left << std::setw(10) << n << std::setw(13) << static_cast<int64_t>(ops)
+                  << std::setw(9) << pct(0.5) << std::setw(9) << pct(0.99) << std::setw(11) << pct(0.999)
+                  << std::setw(13) << (all.empty() ? 0 : all.back()) << timeouts.load() << std::endl;
+    }
+    assert(pool.GetFreeConnCnt() == pool.GetConnCnt());
+}
+
+// 测试函数：批量注册。多个线程同时注册，合并提交的批数应少于请求数；
+// 同一批内的重名注册只有一个成功，已存在的用户名返回 EXISTS；协程经 AsyncRegister 注册
+void test_register_batch(const char* host, int port, const char* user, const char* pwd, const char* dbName) {
+    SqlConnPool& pool = SqlConnPool::getInstance();
+    if (pool.GetConnCnt() == 0) {
+        LOG_ERROR("No MySQL connection available, skip register batch test");
+        return;
+    }
+    using R = RegisterBatcher::Result;
+    RegisterBatcher& batcher = RegisterBatcher::getInstance();
+    batcher.Init(host, port, user, pwd, dbName, 5, 64, 1024);
+    assert(batcher.Enabled());
+    const std::string prefix = "rb" + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count() % 100000000) + "_";
+
+    // 32 个不同用户名 + 8 个同名注册
+    const int unique = 32, dup = 8;
+    std::atomic<int> created{0}, exists{0}, failed{0};
+    auto count = [&](R r) {
+        if (r == R::CREATED) created++;
+        else if (r == R::EXISTS) exists++;
+        else failed++;
+    };
+    std::vector<std::thread> threads;
+    std::latch start(unique + dup); // 所有线程就绪后同时提交
+    for (int i = 0; i < unique + dup; ++i) {
+        std::string name = prefix + (i < unique ? std::to_string(i) : "dup");
+        threads.emplace_back([&, name]() {
+            start.arrive_and_wait();
+            count(batcher.Register(name, "pw"));
+        });
+    }
+    for (auto& t : threads) t.join();
+    LOG_INFO("Register batch: {} requests in {} batches, created {}, exists {}, failed {}",
+             batcher.Requests(), batcher.Batches(), created.load(), exists.load(), failed.load());
+    assert(failed == 0);
+    assert(created == unique + 1 and exists == dup - 1);
+    assert(batcher.Batches() < batcher.Requests());
+
+    // 再次注册已存在的用户名
+    assert(batcher.Register(prefix + "0", "pw") == R::EXISTS);
+
+    // username 列按默认排序规则比较（MySQL 8 不区分大小写）：已有 Alice 时 alice 已被占用；
+    // 同时提交只差大小写的两个名字，无论是否同批都只有一个成功
+    assert(batcher.Register(prefix + "Alice", "pw") == R::CREATED);
+    assert(batcher.Register(prefix + "alice", "pw") == R::EXISTS);
+    std::atomic<int> caseCreated{0}, caseExists{0};
+    std::latch caseStart(2);
+    std::vector<std::thread> caseThreads;
+    for (const char* name : {"Bob", "BOB"}) {
+        caseThreads.emplace_back([&, name]() {
+            caseStart.arrive_and_wait();
+            R r = batcher.Register(prefix + name, "pw");
+            if (r == R::CREATED) caseCreated++;
+            else if (r == R::EXISTS) caseExists++;
+        });
+    }
+    for (auto& t : caseThreads) t.join();
+    assert(caseCreated == 1 and caseExists == 1);
+
+    // 协程注册：挂起期间不占用线程，结果经 RunInLoop 回到 Reactor
+    EventLoop loop;
+    const int tasks = 16;
+    int done = 0;
+    auto task = [&](int id) -> Task<void> {
+        const std::string name = prefix + "co" + std::to_string(id), password = "pw";
+        count(co_await AsyncRegister(loop, name, password));
+        if (++done == tasks) loop.Quit();
+    };
+    loop.RunInLoop([&]() {
+        for (int i = 0; i < tasks; ++i) Spawn(task(i));
+    });
+    loop.Loop();
+    assert(failed == 0 and created == unique + 1 + tasks);
+    std::cout << "RegisterBatcher: " << batcher.Requests() << " registrations in " << batcher.Batches()
+              << " batches" << std::endl;
+    batcher.Close();
+    assert(!batcher.Enabled());
+
+    // 清理测试用户
+    MYSQL* sql = nullptr;
+    SqlConnRAII raii(&sql, &pool);
+    assert(sql);
+    std::string query = "DELETE FROM user WHERE username LIKE '" + prefix + "%'";
+    if (mysql_query(sql, query.c_str()) == 0) {
+        LOG_INFO("Removed {} test users", mysql_affected_rows(sql));
+    }
+}
+
+// 测试函数：单个 Reactor 线程上的协程并发执行非阻塞查询（需以 --nonblocking 启动）
+// 每条语句 SLEEP 50ms：串行执行需要 n * 50ms，连接池有 connSize 条连接时约 n / connSize * 50ms
+void test_async_queries(int num_tasks) {
+    LOG_INFO("Starting async test with {} coroutines on one reactor", num_tasks);
+    if (SqlConnPool::getInstance().GetFreeConnCnt() == 0) {
+        LOG_ERROR("No MySQL connection available, skip async test");
+        return;
+    }
+    EventLoop loop;
+    int done = 0, ok = 0;
+    auto start_time = std::chrono::steady_clock::now();
+
+    auto task = [&](int id) -> Task<void> {
+        SqlLease sql = co_await AcquireSql(loop, num_tasks);
+        if(sql and co_await AsyncSqlQuery(loop, sql.get(), "SELECT SLEEP(0.05), VERSION()", 2000)) {
+            MYSQL_RES* res = co_await AsyncStoreResult(loop, sql.get(), 2000);
+            if(res) {
+                MYSQL_ROW row = mysql_fetch_row(res);
+                if(row) {
+                    LOG_DEBUG("Coroutine {}: MySQL Version: {}", id, row[1]);
+                    ok++;
+                }
+                mysql_free_result(res);
+            }
+        } else if(sql and !SqlConnUsable(sql.get())) {
+            sql.Discard();
+        }
+        sql.Release();
+        if(++done == num_tasks) loop.Quit();
+    };
+    loop.RunInLoop([&]() {
+        for(int i = 0; i < num_tasks; ++i) Spawn(task(i));
+    });
+    loop.Loop();
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+    LOG_INFO("Async test completed in {} ms, {}/{} queries succeeded (serial would take {} ms)",
+             duration.count(), ok, num_tasks, num_tasks * 50);
+    std::cout << "Async: " << ok << "/" << num_tasks << " queries in " << duration.count() << " ms" << std::endl;
+}
+
+// 测试函数：登录查询吞吐。threads 个线程在 duration_ms 内反复经 MySqlUserStore 查询用户密码
+// （借连接、执行预处理语句、归还，与登录路径相同），统计吞吐与单次查询耗时的分位数。
+// 连接数小于线程数时，数据库延迟越高，等待连接的时间占比越大
+void test_login_throughput(int threads_num, int duration_ms, int users, int latency_ms) {
+    if (SqlConnPool::getInstance().GetConnCnt() == 0) {
+        LOG_ERROR("No MySQL connection available, skip login throughput benchmark");
+        return;
+    }
+    MySqlUserStore& store = MySqlUserStore::getInstance();
+    std::vector<std::vector<int64_t>> costs(threads_num);
+    std::atomic<int> failed{0};
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threads_num; ++i) {
+        threads.emplace_back([&, i]() {
+            std::string password;
+            for (int k = i; !stop.load(std::memory_order_relaxed); k += threads_num) {
+                std::string name = "user" + std::to_string(users > 0 ? k % users : k);
+                auto t0 = std::chrono::steady_clock::now();
+                UserStore::Status status = store.Lookup(name, password);
+                auto t1 = std::chrono::steady_clock::now();
+                if (status != UserStore::Status::OK and status != UserStore::Status::NOT_FOUND) failed++;
+                costs[i].push_back(std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count());
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    stop = true;
+    for (auto& t : threads) t.join();
+
+    std::vector<int64_t> all;
+    for (auto& c : costs) all.insert(all.end(), c.begin(), c.end());
+    std::sort(all.begin(), all.end());
+    auto pct = [&all](double p) { return all.empty() ? 0 : all[static_cast<size_t>(p * (all.size() - 1))]; };
+    double ops = all.size() * 1000.0 / duration_ms;
+    LOG_INFO("Login lookup: db latency {} ms, {} threads, {:.0f} ops/s, p50 {} us, p99 {} us, failed {}",
+             latency_ms, threads_num, ops, pct(0.5), pct(0.99), failed.load());
+    std::cout << std::left << std::setw(12) << latency_ms << std::setw(10) << threads_num
+              << std::setw(13) << static_cast<int64_t>(ops) << std::setw(9) << pct(0.5)
+              << std::setw(9) << pct(0.99) << failed.load() << std::endl;
+}
+
+// 测试函数：故障注入（只在 --fake 下运行）。查询时断连由 SqlExecute 重连后重试，
+// 注入的数据库错误不重试、直接返回 FAILED，连接池在故障结束后仍然可用
+void test_fault_injection(FakeMySql& fake, int users) {
+    MySqlUserStore& store = MySqlUserStore::getInstance();
+    std::string password;
+    const int n = 400;
+    fake.SetLatency(0, 0);
+
+    fake.SetDropRate(0.05);
+    uint64_t drops = fake.Drops();
+    int ok = 0;
+    for (int i = 0; i < n; ++i) {
+        if (store.Lookup("user" + std::to_string(i % users), password) == UserStore::Status::OK) ok++;
+    }
+    fake.SetDropRate(0);
+    LOG_INFO("Drop rate 5%: {} drops, {}/{} lookups succeeded after reconnect", fake.Drops() - drops, ok, n);
+    assert(fake.Drops() > drops);
+    assert(ok >= n * 95 / 100); // 连续两次断连才会失败
+
+    fake.SetErrorRate(0.1);
+    uint64_t errors = fake.InjectedErrors();
+    int failed = 0;
+    for (int i = 0; i < n; ++i) {
+        if (store.Lookup("user" + std::to_string(i % users), password) == UserStore::Status::FAILED) failed++;
+    }
+    fake.SetErrorRate(0);
+    LOG_INFO("Error rate 10%: {} injected errors, {}/{} lookups failed", fake.InjectedErrors() - errors, failed, n);
+    assert(failed > 0 and failed < n / 4);
+
+    assert(store.Lookup("user0", password) == UserStore::Status::OK and password == "user0");
+    assert(store.Lookup("nobody", password) == UserStore::Status::NOT_FOUND);
+    std::cout << "Fault injection: " << ok << "/" << n << " lookups survived 5% drops, "
+              << failed << "/" << n << " failed under 10% errors" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    bool nonblocking = false, useFake = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--nonblocking") == 0) nonblocking = true;
+        else if (strcmp(argv[i], "--fake") == 0) useFake = true;
+    }
+
     // 初始化日志系统
     Logger::getInstance().initLogger("log/test_sqlpool.log", LogLevel::DEBUG, 1024, 3);
 
@@ -88,30 +396,100 @@ int main() {
     int port = 3306;
     int connSize = 10;
 
+    // --fake：在本进程中启动 MySQL 替身（内核分配端口，预置 user0 ~ user999，每条查询延迟 1ms），
+    // 不需要数据库服务，结果可复现
+    const int fakeUsers = 1000;
+    std::unique_ptr<FakeMySql> fake;
+    if (useFake) {
+        FakeMySqlOptions fakeOptions;
+        fakeOptions.port = 0;
+        fakeOptions.latencyMs = 1;
+        fake = std::make_unique<FakeMySql>(fakeOptions);
+        for (int i = 0; i < fakeUsers; ++i) fake->AddUser("user" + std::to_string(i), "user" + std::to_string(i));
+        if (!fake->Start()) {
+            std::cerr << "Start fake MySQL failed" << std::endl;
+            return 1;
+        }
+        port = fake->Port();
+    }
+
     LOG_INFO("Initializing connection pool...");
     LOG_INFO("Host: {}, Port: {}, User: {}, Database: {}, Pool Size: {}",
              host, port, user, dbName, connSize);
 
-    SqlConnPool::getInstance().Init(host, port, user, pwd, dbName, connSize);
+    // 常驻 2 条连接，按需增长到 connSize，空闲 1 秒收缩，每秒 ping 一次空闲连接
+    SqlPoolOptions options;
+    options.minConn = 2;
+    options.acquireTimeout = 5000;
+    options.idleTimeout = 1;
+    options.pingInterval = 1;
+    SqlConnPool::getInstance().SetOptions(options);
+    SqlConnPool::getInstance().Init(host, port, user, pwd, dbName, connSize, nonblocking);
+
+    // 非阻塞方式建立的连接不能再给阻塞调用使用，只跑协程测试
+    if (SqlConnPool::getInstance().IsNonblocking()) {
+        LOG_INFO("\n=== Test 4: Nonblocking Queries On One Reactor ===");
+        test_async_queries(40);
+        test_pool_status();
+    } else {
+        // 测试1：单线程查询
+        LOG_INFO("\n=== Test 1: Single Thread Query ===");
+        test_query(0);
+        test_pool_status();
+
+        // 测试2：并发查询
+        LOG_INFO("\n=== Test 2: Concurrent Queries ===");
+        test_concurrent_queries(5, 3);
+        test_pool_status();
 
-    // 测试1：单线程查询
-    LOG_INFO("\n=== Test 1: Single Thread Query ===");
-    test_query(0);
-    test_pool_status();
+        // 测试3：高并发压力测试
+        LOG_INFO("\n=== Test 3: High Concurrency Stress Test ===");
+        test_concurrent_queries(20, 5);
+        test_pool_status();
 
-    // 测试2：并发查询
-    LOG_INFO("\n=== Test 2: Concurrent Queries ===");
-    test_concurrent_queries(5, 3);
-    test_pool_status();
+        // 测试5：按需增长、借连接超时、空闲收缩
+        LOG_INFO("\n=== Test 5: Elastic Sizing & Acquire Timeout ===");
+        test_elastic(connSize);
+        test_pool_status();
 
-    // 测试3：高并发压力测试
-    LOG_INFO("\n=== Test 3: High Concurrency Stress Test ===");
-    test_concurrent_queries(20, 5);
-    test_pool_status();
+        // 测试6：借还竞争基准（1 ~ 32 线程）
+        LOG_INFO("\n=== Test 6: Acquire/Release Contention Benchmark ===");
+        test_contention({1, 2, 4, 8, 16, 32}, 500);
+        test_pool_status();
+
+        // 测试7：批量注册（group commit）
+        LOG_INFO("\n=== Test 7: Register Group Commit ===");
+        test_register_batch(host, port, user, pwd, dbName);
+        test_pool_status();
+
+        // 测试8：登录查询吞吐，替身模式下依次注入 0 / 1 / 5 ms 的数据库延迟
+        LOG_INFO("\n=== Test 8: Login Lookup Throughput ===");
+        std::cout << "latency(ms) threads   ops/s        p50(us)  p99(us)  failed" << std::endl;
+        if (fake) {
+            for (int latency : {0, 1, 5}) {
+                fake->SetLatency(latency, 0);
+                test_login_throughput(32, 500, fakeUsers, latency);
+            }
+        } else {
+            test_login_throughput(32, 500, 0, -1);
+        }
+        test_pool_status();
+
+        // 测试9：断连与错误注入
+        if (fake) {
+            LOG_INFO("\n=== Test 9: Fault Injection ===");
+            test_fault_injection(*fake, fakeUsers);
+            test_pool_status();
+        }
+    }
 
     // 关闭连接池
     LOG_INFO("\n=== Closing Connection Pool ===");
     SqlConnPool::getInstance().ClosePool();
+    if (fake) {
+        fake->Stop();
+        LOG_INFO("Fake MySQL: {} connections, {} queries", fake->Connections(), fake->Queries());
+    }
 
     // 关闭日志系统
     Logger::getInstance().shutdown();
@@ -0,0 +1,164 @@
+
+#include "threadpool.h"
+#include "lanescheduler.h"
+#include "../log/log.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <poll.h>
+#include <unordered_set>
+
+// 测试1：所有任务都会被执行
+void testAllTasksRun() {
+    LOG_INFO("=== Test 1: All Tasks Run ===");
+    std::atomic<int> counter{0};
+    {
+        ThreadPool pool(4);
+        for(int i = 0; i < 10000; i++) {
+            pool.AddTask([&counter]() { counter.fetch_add(1); });
+        }
+        pool.Shutdown(); // Shutdown 会先执行完已入队的任务
+        assert(pool.PendingCount() == 0);
+        // 关闭后投递被拒绝，任务不执行
+        assert(!pool.AddTask([&counter]() { counter.fetch_add(1); }));
+    }
+    assert(counter.load() == 10000);
+    LOG_INFO("✓ Test 1 passed!");
+}
+
+// 测试2：工作线程内投递的子任务会被其他线程窃取执行
+void testWorkStealing() {
+    LOG_INFO("=== Test 2: Work Stealing ===");
+    ThreadPool pool(4);
+    std::mutex mtx;
+    std::unordered_set<std::thread::id> executors;
+    std::atomic<int> done{0};
+    // 一个任务在工作线程内派生大量耗时子任务，全部进入同一个本地队列
+    pool.AddTask([&]() {
+        for(int i = 0; i < 64; i++) {
+            pool.AddTask([&]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                {
+                    std::lock_guard<std::mutex> locker(mtx);
+                    executors.insert(std::this_thread::get_id());
+                }
+                done.fetch_add(1);
+            });
+        }
+    });
+    while(done.load() < 64) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    pool.Shutdown();
+    LOG_INFO("Sub tasks executed by {} threads", executors.size());
+    assert(executors.size() > 1);
+    LOG_INFO("✓ Test 2 passed!");
+}
+
+// 测试3：结果通过 eventfd 回到调用线程
+void testCompletionQueue() {
+    LOG_INFO("=== Test 3: Completion Through Eventfd ===");
+    ThreadPool pool(2);
+    CompletionQueue cq;
+    assert(cq.Fd() >= 0);
+    std::thread::id caller = std::this_thread::get_id();
+    int sum = 0;
+    int completed = 0;
+    for(int i = 1; i <= 100; i++) {
+        Submit(pool, cq, [i]() { return i * 2; }, [&, caller](int r) {
+            assert(std::this_thread::get_id() == caller); // 回调在 Drain 的线程执行
+            sum += r;
+            completed++;
+        });
+    }
+    while(completed < 100) {
+        pollfd pfd{cq.Fd(), POLLIN, 0};
+        int n = poll(&pfd, 1, 1000);
+        assert(n == 1);
+        cq.Drain();
+    }
+    assert(sum == 100 * 101);
+    pool.Shutdown();
+    LOG_INFO("✓ Test 3 passed!");
+}
+
+// 测试4：慢任务占满部分线程时，其他任务仍能被快速执行
+void testSlowTasksDoNotStarve() {
+    LOG_INFO("=== Test 4: Slow Tasks Do Not Starve Fast Tasks ===");
+    ThreadPool pool(4);
+    std::atomic<bool> release{false};
+    for(int i = 0; i < 2; i++) {
+        pool.AddTask([&release]() {
+            while(!release.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+    }
+    std::atomic<int> fast{0};
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < 1000; i++) pool.AddTask([&fast]() { fast.fetch_add(1); });
+    while(fast.load() < 1000) std::this_thread::yield();
+    auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("1000 fast tasks finished in {} ms while 2 workers are blocked", cost.count());
+    // 空闲的 2 个线程执行 1000 个空任务只需不到 1ms，上限留足调度与 sanitizer 的余量；
+    // 任务若被分到阻塞线程的队列而没有被窃取，要等到 release 才会执行，这里会一直等不到
+    assert(cost.count() < 200);
+    assert(pool.PendingCount() == 0);
+    release.store(true);
+    pool.Shutdown();
+    LOG_INFO("✓ Test 4 passed!");
+}
+
+// 测试5：DB 通道饱和时拒绝新任务，静态通道不受影响
+void testLaneIsolation() {
+    LOG_INFO("=== Test 5: Lane Isolation ===");
+    LaneScheduler& sched = LaneScheduler::getInstance();
+    LaneScheduler::LaneConfig configs[static_cast<int>(RequestLane::COUNT)];
+    configs[static_cast<int>(RequestLane::STATIC)] = {0, 0};
+    configs[static_cast<int>(RequestLane::DB)] = {2, 2};
+    configs[static_cast<int>(RequestLane::ADMIN)] = {1, 1};
+    sched.Init(configs);
+
+    // 模拟数据库卡顿：占满 DB 通道的 2 个线程和 2 个队列位置
+    std::atomic<bool> release{false};
+    for(int i = 0; i < 4; i++) {
+        bool ok = sched.Dispatch(RequestLane::DB, [&release]() {
+            while(!release.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+        assert(ok);
+    }
+    assert(sched.Dispatch(RequestLane::DB, []() {}) == false);
+    assert(sched.ShedCount(RequestLane::DB) == 1);
+
+    // 静态通道内联执行，不受 DB 通道拥塞影响
+    int staticDone = 0;
+    for(int i = 0; i < 1000; i++) {
+        assert(sched.Dispatch(RequestLane::STATIC, [&staticDone]() { staticDone++; }));
+    }
+    assert(staticDone == 1000);
+
+    // 管理通道仍可用
+    std::atomic<bool> adminDone{false};
+    assert(sched.Dispatch(RequestLane::ADMIN, [&adminDone]() { adminDone.store(true); }));
+    while(!adminDone.load()) std::this_thread::yield();
+
+    release.store(true);
+    while(sched.InFlight(RequestLane::DB) > 0) std::this_thread::yield();
+    assert(sched.Dispatch(RequestLane::DB, []() {}));
+    sched.Shutdown();
+    LOG_INFO("✓ Test 5 passed!");
+}
+
+int main() {
+    Logger::getInstance().initLogger("log/test_threadpool.log", LogLevel::INFO, 1024, 3);
+    LOG_INFO("Starting ThreadPool Tests...");
+    LOG_INFO("===============================");
+
+    testAllTasksRun();
+    testWorkStealing();
+    testCompletionQueue();
+    testSlowTasksDoNotStarve();
+    testLaneIsolation();
+
+    LOG_INFO("================================");
+    LOG_INFO("All tests passed successfully! ✓");
+    Logger::getInstance().shutdown();
+    std::cout << "Test completed. Check test_threadpool.log for details." << std::endl;
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include "threadpool.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+
+#include "../log/log.h"
+
+thread_local ThreadPool* ThreadPool::tlsPool_ = nullptr;
+thread_local int ThreadPool::tlsIndex_ = -1;
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if(threadCount == 0) threadCount = 1;
+    queues_.reserve(threadCount);
+    for(size_t i = 0; i < threadCount; i++) {
+        queues_.emplace_back(std::make_unique<WorkQueue>());
+    }
+    workers_.reserve(threadCount);
+    for(size_t i = 0; i < threadCount; i++) {
+        workers_.emplace_back(&ThreadPool::WorkerLoop_, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    Shutdown();
+}
+
+void ThreadPool::Shutdown() {
+    if(isClosed_.exchange(true)) return; // 已经关闭
+    {
+        std::lock_guard<std::mutex> locker(sleepMtx_);
+    }
+    sleepCond_.notify_all();
+    for(auto& t : workers_) {
+        if(t.joinable()) t.join();
+    }
+}
+
+std::vector<std::thread::native_handle_type> ThreadPool::NativeHandles() {
+    std::vector<std::thread::native_handle_type> handles;
+    for(auto& t : workers_) handles.push_back(t.native_handle());
+    return handles;
+}
+
+bool ThreadPool::Push_(Task task) {
+    // 先计数再入队：工作线程取到任务后才 fetch_sub，pending_ 不会小于 0（回绕成 SIZE_MAX）。
+    // 计数之后再检查关闭标志，与 WorkerLoop_ 中先看关闭标志、再看 pending_ 的退出条件配合，
+    // 通过检查的任务一定有工作线程执行
+    pending_.fetch_add(1);
+    if(isClosed_.load()) {
+        pending_.fetch_sub(1);
+        return false;
+    }
+    size_t idx;
+    if(tlsPool_ == this) idx = static_cast<size_t>(tlsIndex_); // 工作线程内投递：放入自身队列
+    else idx = nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+        std::lock_guard<std::mutex> locker(queues_[idx]->mtx);
+        queues_[idx]->tasks.push_back(std::move(task));
+    }
+    // pending_ 与 idleCount_ 均为 seq_cst，保证投递方与将要休眠的工作线程至少有一方看到对方
+    if(idleCount_.load() > 0) {
+        // 短暂持锁，防止通知落在工作线程检查条件与真正休眠之间而丢失
+        { std::lock_guard<std::mutex> locker(sleepMtx_); }
+        sleepCond_.notify_one();
+    }
+    return true;
+}
+
+bool ThreadPool::PopLocal_(size_t idx, Task& task) {
+    WorkQueue& q = *queues_[idx];
+    std::lock_guard<std::mutex> locker(q.mtx);
+    if(q.tasks.empty()) return false;
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::Steal_(size_t idx, Task& task) {
+    size_t n = queues_.size();
+    for(size_t i = 1; i < n; i++) {
+        WorkQueue& q = *queues_[(idx + i) % n];
+        std::unique_lock<std::mutex> locker(q.mtx, std::try_to_lock);
+        if(!locker.owns_lock() or q.tasks.empty()) continue;
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop_(size_t idx) {
+    tlsPool_ = this;
+    tlsIndex_ = static_cast<int>(idx);
+    Task task;
+    while(true) {
+        if(PopLocal_(idx, task) or Steal_(idx, task)) {
+            pending_.fetch_sub(1);
+            task();
+            task = nullptr; // 尽早释放任务捕获的资源
+            continue;
+        }
+        // 有任务但窃取时恰好遇到锁竞争，或投递方已计数、尚未入队，让出 CPU 后重试
+        if(pending_.load() > 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        // 已关闭且任务全部完成；关闭后重新检查 pending_，不丢下关闭前刚通过检查的投递
+        if(isClosed_.load() and pending_.load() == 0) break;
+        std::unique_lock<std::mutex> locker(sleepMtx_);
+        idleCount_.fetch_add(1);
+        sleepCond_.wait(locker, [this]() {
+            return pending_.load() > 0 or isClosed_.load();
+        });
+        idleCount_.fetch_sub(1);
+    }
+    tlsPool_ = nullptr;
+    tlsIndex_ = -1;
+}
+
+CompletionQueue::CompletionQueue() {
+    eventFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(eventFd_ < 0) {
+        LOG_ERROR("CompletionQueue eventfd create failed, errno: {}", errno);
+    }
+}
+
+CompletionQueue::~CompletionQueue() {
+    if(eventFd_ >= 0) close(eventFd_);
+}
+
+void CompletionQueue::Post(std::function<void()> callback) {
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        callbacks_.push_back(std::move(callback));
+    }
+    // 只有 eventfd 从未触发变为触发时才写入，合并多次唤醒
+    if(!signaled_.exchange(true)) {
+        uint64_t one = 1;
+        ssize_t n = write(eventFd_, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+size_t CompletionQueue::Drain() {
+    uint64_t cnt = 0;
+    ssize_t n = read(eventFd_, &cnt, sizeof(cnt)); // 清除可读状态（非阻塞）
+    (void)n;
+    // 先清标志再取回调：之后的 Post 一定会重新写 eventfd
+    signaled_.store(false);
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        ready.swap(callbacks_);
+    }
+    for(auto& cb : ready) cb();
+    return ready.size();
+}
@@ -0,0 +1,131 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+#include <type_traits>
+
+/*
+    ThreadPool 是工作窃取（work-stealing）线程池，用于承载不能在 Reactor 线程上执行的任务：
+    1. 阻塞型任务：如 UserVerify 中的 MySQL 往返；
+    2. CPU 密集型任务：如压缩、哈希、大文件预处理等。
+    每个工作线程拥有自己的双端队列：
+    - 工作线程自己投递的任务压入自身队列尾部，并从尾部取（LIFO，缓存友好）；
+    - 外部线程（Reactor）投递的任务轮询分发到各个队列；
+    - 自身队列为空时，从其他线程队列的头部窃取（FIFO，减少与所有者竞争）。
+    唤醒开销：只有存在休眠线程时才 notify，繁忙时投递任务只需一次加锁入队。
+*/
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // 投递任务，可在任意线程调用；线程池已关闭时不执行任务并返回 false
+    template<class F>
+    bool AddTask(F&& task);
+
+    // 停止线程池：已入队的任务会被执行完，然后所有工作线程退出；之后的 AddTask 返回 false
+    void Shutdown();
+
+    size_t ThreadCount() const { return workers_.size(); }
+
+    // 工作线程句柄，用于绑核等线程放置
+    std::vector<std::thread::native_handle_type> NativeHandles();
+
+    // 当前排队中的任务数（近似值）
+    size_t PendingCount() const { return pending_.load(std::memory_order_relaxed); }
+
+private:
+    // 每个工作线程独占的任务队列，alignas 避免相邻队列的伪共享
+    struct alignas(64) WorkQueue {
+        std::mutex mtx;
+        std::deque<Task> tasks;
+    };
+
+    bool Push_(Task task);
+    bool PopLocal_(size_t idx, Task& task);
+    bool Steal_(size_t idx, Task& task);
+    void WorkerLoop_(size_t idx);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::atomic<size_t> pending_{0};   // 所有队列中的任务总数
+    std::atomic<size_t> nextQueue_{0}; // 外部投递时的轮询下标
+    std::atomic<bool> isClosed_{false};
+
+    std::mutex sleepMtx_;
+    std::condition_variable sleepCond_;
+    std::atomic<int> idleCount_{0};    // 正在休眠的工作线程数
+
+    // 当前线程在本线程池中的下标，非工作线程为 -1
+    static thread_local ThreadPool* tlsPool_;
+    static thread_local int tlsIndex_;
+};
+
+template<class F>
+bool ThreadPool::AddTask(F&& task) {
+    return Push_(Task(std::forward<F>(task)));
+}
+
+/*
+    CompletionQueue 把线程池中任务的结果投递回 Reactor 线程：
+    - 工作线程调用 Post 把回调放入队列，并通过 eventfd 唤醒 Reactor；
+    - Reactor 将 Fd() 注册到 epoll，可读时调用 Drain 在本线程执行所有回调。
+    多次 Post 在 Reactor 处理前只会写一次 eventfd，减少系统调用。
+*/
+class CompletionQueue {
+public:
+    CompletionQueue();
+    ~CompletionQueue();
+
+    CompletionQueue(const CompletionQueue&) = delete;
+    CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+    int Fd() const { return eventFd_; }
+
+    // 可在任意线程调用
+    void Post(std::function<void()> callback);
+
+    // 只在所属 Reactor 线程调用，返回执行的回调数量
+    size_t Drain();
+
+private:
+    int eventFd_;
+    std::mutex mtx_;
+    std::vector<std::function<void()>> callbacks_;
+    std::atomic<bool> signaled_{false}; // eventfd 是否已处于可读状态
+};
+
+/*
+    在线程池中执行 work，并把结果通过 CompletionQueue 交给 done 在 Reactor 线程执行：
+        Submit(pool, cq, [=]{ return UserVerify(...); }, [=](bool ok){ ... });
+    线程池已关闭时 work 与 done 都不执行，返回 false
+*/
+template<class Work, class Done>
+bool Submit(ThreadPool& pool, CompletionQueue& cq, Work&& work, Done&& done) {
+    return pool.AddTask([&cq, work = std::forward<Work>(work), done = std::forward<Done>(done)]() mutable {
+        if constexpr (std::is_void_v<std::invoke_result_t<Work&>>) {
+            work();
+            cq.Post(std::move(done));
+        } else {
+            auto result = work();
+            cq.Post([done = std::move(done), result = std::move(result)]() mutable {
+                done(std::move(result));
+            });
+        }
+    });
+}
+
+#endif /* THREADPOOL_H */
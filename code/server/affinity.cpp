@@ -0,0 +1,94 @@
+#include "affinity.h"
+
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <dirent.h>
+#include <cstring>
+#include <sstream>
+
+#include "../log/log.h"
+
+#ifndef MPOL_LOCAL
+#define MPOL_LOCAL 4
+#endif
+
+#ifndef SO_INCOMING_CPU
+#define SO_INCOMING_CPU 49
+#endif
+
+std::vector<int> ParseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::istringstream iss(list);
+    std::string item;
+    while(std::getline(iss, item, ',')) {
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        if(item.empty()) continue;
+        try {
+            size_t dash = item.find('-');
+            if(dash == std::string::npos) {
+                cpus.push_back(std::stoi(item));
+            } else {
+                int lo = std::stoi(item.substr(0, dash));
+                int hi = std::stoi(item.substr(dash + 1));
+                for(int c = lo; c <= hi; c++) cpus.push_back(c);
+            }
+        } catch(const std::exception&) {
+            LOG_WARN("Invalid cpu list item: {}", item);
+        }
+    }
+    return cpus;
+}
+
+bool PinThreadToCpu(pthread_t thread, int cpu) {
+    return PinThreadToCpus(thread, std::vector<int>{cpu});
+}
+
+bool PinThreadToCpus(pthread_t thread, const std::vector<int>& cpus) {
+    if(cpus.empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(int cpu : cpus) {
+        if(cpu >= 0 and cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    int ret = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if(ret != 0) {
+        LOG_WARN("pthread_setaffinity_np failed, cpu: {}, err: {}", cpus.front(), ret);
+        return false;
+    }
+    return true;
+}
+
+bool BindMemoryToLocalNode() {
+    // 直接使用系统调用，避免引入 libnuma 依赖；非 NUMA 内核返回 ENOSYS 时忽略
+    if(syscall(SYS_set_mempolicy, MPOL_LOCAL, nullptr, 0) != 0) {
+        LOG_DEBUG("set_mempolicy(MPOL_LOCAL) failed, errno: {}", errno);
+        return false;
+    }
+    return true;
+}
+
+int NumaNodeOfCpu(int cpu) {
+    // /sys/devices/system/cpu/cpuN/ 下存在 nodeM 目录项
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR* dir = opendir(path.c_str());
+    if(!dir) return 0;
+    int node = 0;
+    while(struct dirent* ent = readdir(dir)) {
+        if(strncmp(ent->d_name, "node", 4) == 0 and ent->d_name[4] >= '0' and ent->d_name[4] <= '9') {
+            node = atoi(ent->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+int GetIncomingCpu(int fd) {
+    int cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if(getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) != 0) return -1;
+    return cpu;
+}
@@ -0,0 +1,34 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+/*
+    线程绑核与 NUMA 本地内存：
+    - Reactor 线程绑定到配置的核心，日志刷盘线程放到单独的“杂务”核心，避免与请求处理抢占；
+    - Reactor 线程设置 MPOL_LOCAL 内存策略后，连接的协程帧（FramePool 为每线程内存池）
+      与读写缓冲区都在所属 Reactor 线程上首次分配，因而落在该线程所在的 NUMA 节点；
+    - 通过 SO_INCOMING_CPU 查询处理该连接收包的 CPU，把连接交给绑定在同一核心上的 Reactor，
+      使网卡中断/软中断与协议栈处理、应用处理在同一核心（同一 socket）上完成。
+    所有函数失败时只记录日志并返回 false，不影响服务器运行。
+*/
+
+// 解析 CPU 列表，格式如 "0-3,8,10-11"，非法片段被忽略
+std::vector<int> ParseCpuList(const std::string& list);
+
+// 将线程绑定到单个 CPU / 一组 CPU
+bool PinThreadToCpu(pthread_t thread, int cpu);
+bool PinThreadToCpus(pthread_t thread, const std::vector<int>& cpus);
+
+// 当前线程之后的内存分配优先使用本地 NUMA 节点
+bool BindMemoryToLocalNode();
+
+// CPU 所在的 NUMA 节点，无法确定时返回 0
+int NumaNodeOfCpu(int cpu);
+
+// 查询处理该 socket 收包的 CPU，失败返回 -1
+int GetIncomingCpu(int fd);
+
+#endif /* AFFINITY_H */
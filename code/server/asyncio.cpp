@@ -0,0 +1,94 @@
+#include "asyncio.h"
+
+#include <sys/sendfile.h>
+#include <errno.h>
+
+bool IoAwaiter::await_suspend(std::coroutine_handle<> h) {
+    if(!loop_.SetWaiter(fd_, write_, h)) return false;
+    if(timeoutMs_ >= 0) {
+        timer_ = loop_.AddTimer(timeoutMs_, [this, h]() {
+            timedOut_ = true;
+            timer_ = 0;
+            loop_.ClearWaiter(fd_, write_);
+            h.resume();
+        });
+    }
+    return true;
+}
+
+bool IoAwaiter::await_resume() {
+    if(timedOut_) return false;
+    if(timer_) loop_.CancelTimer(timer_);
+    return true;
+}
+
+// read_from_socket 一次最多读入 可写空间 + 64KB 临时缓冲
+static constexpr size_t READ_EXTRA = 65536;
+
+Task<ssize_t> AsyncRead(EventLoop& loop, int fd, Buffer& buff, int timeoutMs, FairnessBudget* budget) {
+    if(budget and budget->Exhausted()) co_await Yield(loop);
+    // 本轮已读空且对端未关闭时，直接等待下一个可读事件
+    bool skipRead = budget and budget->Drained() and !loop.PeerClosed(fd);
+    while(true) {
+        if(!skipRead) {
+            size_t capacity = buff.writable_size() + READ_EXTRA;
+            ssize_t n = buff.read_from_socket(fd);
+            if(n >= 0) {
+                if(budget) {
+                    budget->ChargeBytes(n);
+                    if(n > 0 and static_cast<size_t>(n) < capacity) budget->MarkDrained();
+                }
+                co_return n;
+            }
+            if(errno == EINTR) continue;
+            if(errno != EAGAIN and errno != EWOULDBLOCK) co_return -1;
+        }
+        skipRead = false;
+        if(!co_await WaitReadable(loop, fd, timeoutMs)) {
+            errno = ETIMEDOUT;
+            co_return -1;
+        }
+    }
+}
+
+Task<ssize_t> AsyncWrite(EventLoop& loop, int fd, Buffer& buff, int timeoutMs, FairnessBudget* budget) {
+    ssize_t total = 0;
+    while(buff.readable_size() > 0) {
+        if(budget and budget->Exhausted()) co_await Yield(loop);
+        ssize_t n = buff.write_to_socket(fd);
+        if(n > 0) {
+            total += n;
+            if(budget) budget->ChargeBytes(n);
+            continue;
+        }
+        if(n < 0 and errno == EINTR) continue;
+        if(n < 0 and errno != EAGAIN and errno != EWOULDBLOCK) co_return -1;
+        if(!co_await WaitWritable(loop, fd, timeoutMs)) {
+            errno = ETIMEDOUT;
+            co_return -1;
+        }
+    }
+    co_return total;
+}
+
+Task<ssize_t> AsyncSendfile(EventLoop& loop, int outFd, int inFd, off_t offset, size_t count, int timeoutMs,
+                            FairnessBudget* budget) {
+    size_t sent = 0;
+    while(sent < count) {
+        if(budget and budget->Exhausted()) co_await Yield(loop);
+        ssize_t n = ::sendfile(outFd, inFd, &offset, count - sent);
+        if(n > 0) {
+            sent += n;
+            if(budget) budget->ChargeBytes(n);
+            continue;
+        }
+        if(n == 0) break; // 文件被截断
+        if(errno == EINTR) continue;
+        if(errno != EAGAIN and errno != EWOULDBLOCK) co_return -1;
+        if(!co_await WaitWritable(loop, outFd, timeoutMs)) {
+            errno = ETIMEDOUT;
+            co_return -1;
+        }
+    }
+    co_return static_cast<ssize_t>(sent);
+}
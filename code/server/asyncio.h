@@ -0,0 +1,177 @@
+#ifndef ASYNCIO_H
+#define ASYNCIO_H
+
+#include <sys/types.h>
+#include <optional>
+#include <type_traits>
+
+#include "coroutine.h"
+#include "eventloop.h"
+#include "../buffer/buffer.h"
+#include "../pool/lanescheduler.h"
+
+/*
+    Reactor 上的可等待操作，全部只能在 EventLoop 线程内的协程中使用。
+    I/O 操作先直接尝试系统调用，只有遇到 EAGAIN 才挂起等待 epoll 事件；
+    超时参数单位为毫秒，-1 表示不超时，超时时返回 -1 且 errno 为 ETIMEDOUT。
+*/
+
+// 挂起直到 fd 可读/可写，超时返回 false
+class IoAwaiter {
+public:
+    IoAwaiter(EventLoop& loop, int fd, bool write, int timeoutMs)
+        : loop_(loop), fd_(fd), write_(write), timeoutMs_(timeoutMs) {}
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> h);
+    bool await_resume();
+
+private:
+    EventLoop& loop_;
+    int fd_;
+    bool write_;
+    int timeoutMs_;
+    uint64_t timer_ = 0;
+    bool timedOut_ = false;
+};
+
+inline IoAwaiter WaitReadable(EventLoop& loop, int fd, int timeoutMs = -1) {
+    return IoAwaiter(loop, fd, false, timeoutMs);
+}
+
+inline IoAwaiter WaitWritable(EventLoop& loop, int fd, int timeoutMs = -1) {
+    return IoAwaiter(loop, fd, true, timeoutMs);
+}
+
+// 挂起指定毫秒数，不占用线程
+class SleepAwaiter {
+public:
+    SleepAwaiter(EventLoop& loop, int ms) : loop_(loop), ms_(ms) {}
+    bool await_ready() const noexcept { return ms_ <= 0; }
+    void await_suspend(std::coroutine_handle<> h) {
+        loop_.AddTimer(ms_, [h]() { h.resume(); });
+    }
+    void await_resume() const noexcept {}
+
+private:
+    EventLoop& loop_;
+    int ms_;
+};
+
+inline SleepAwaiter Sleep(EventLoop& loop, int ms) {
+    return SleepAwaiter(loop, ms);
+}
+
+// 让出 Reactor：进入就绪队列，在下一轮循环处理完新事件后恢复
+class YieldAwaiter {
+public:
+    explicit YieldAwaiter(EventLoop& loop) : loop_(loop) {}
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) { loop_.Schedule(h); }
+    void await_resume() const noexcept {}
+
+private:
+    EventLoop& loop_;
+};
+
+inline YieldAwaiter Yield(EventLoop& loop) {
+    return YieldAwaiter(loop);
+}
+
+/*
+    每个连接在一轮事件循环中的公平预算：最多读写 maxBytes 字节、处理 maxRequests 个请求，
+    用完后连接让出 Reactor，下一轮自动恢复额度。<= 0 表示不限制。
+    同时记录本轮是否已把 socket 读空（短读），同一轮内再读可直接等待事件，省去一次 EAGAIN 的系统调用。
+*/
+class FairnessBudget {
+public:
+    FairnessBudget(EventLoop& loop, int maxBytes, int maxRequests)
+        : loop_(loop), maxBytes_(maxBytes), maxRequests_(maxRequests) {}
+
+    void ChargeBytes(size_t n) { Refresh_(); bytes_ += n; }
+    void ChargeRequest() { Refresh_(); requests_++; }
+    bool Exhausted() {
+        Refresh_();
+        return (maxBytes_ > 0 and bytes_ >= static_cast<size_t>(maxBytes_))
+            or (maxRequests_ > 0 and requests_ >= maxRequests_);
+    }
+
+    // 短读说明内核缓冲区已空；此后没有经过 epoll_wait 就不会有新的可读边沿被错过
+    //（对端关闭事件已被取走时除外，由 AsyncRead 通过 EventLoop::PeerClosed 排除）
+    void MarkDrained() { drainedIter_ = loop_.Iteration() + 1; }
+    bool Drained() const { return drainedIter_ == loop_.Iteration() + 1; }
+
+private:
+    void Refresh_() {
+        if(iter_ != loop_.Iteration()) {
+            iter_ = loop_.Iteration();
+            bytes_ = 0;
+            requests_ = 0;
+        }
+    }
+
+    EventLoop& loop_;
+    int maxBytes_;
+    int maxRequests_;
+    uint64_t iter_ = 0;
+    size_t bytes_ = 0;
+    int requests_ = 0;
+    uint64_t drainedIter_ = 0; // 轮次 + 1，0 表示未读空
+};
+
+// 读取一次数据追加到 buff：返回读到的字节数，0 表示对端关闭，-1 表示出错
+// 传入 budget 时，额度用完先让出一轮再读
+Task<ssize_t> AsyncRead(EventLoop& loop, int fd, Buffer& buff, int timeoutMs = -1, FairnessBudget* budget = nullptr);
+
+// 写出 buff 中全部可读数据：返回写出的字节数，-1 表示出错
+// 传入 budget 时，额度用完先让出一轮再继续写
+Task<ssize_t> AsyncWrite(EventLoop& loop, int fd, Buffer& buff, int timeoutMs = -1, FairnessBudget* budget = nullptr);
+
+// 零拷贝发送文件 inFd 从 offset 开始的 count 字节：返回发送的字节数，-1 表示出错
+// 不移动 inFd 的文件位置，多个连接可以同时发送同一个 fd；传入 budget 时与 AsyncWrite 一样按额度让出
+Task<ssize_t> AsyncSendfile(EventLoop& loop, int outFd, int inFd, off_t offset, size_t count, int timeoutMs = -1,
+                            FairnessBudget* budget = nullptr);
+
+/*
+    在指定调度通道的线程池中执行 work，完成后在 EventLoop 线程恢复协程：
+        std::optional<bool> ok = co_await RunInLane(loop, RequestLane::DB, task);
+    通道已满被拒绝时立即返回 std::nullopt。
+*/
+template<class F>
+class LaneAwaiter {
+public:
+    using Result = std::invoke_result_t<F&>;
+
+    LaneAwaiter(EventLoop& loop, RequestLane lane, F work)
+        : loop_(loop), lane_(lane), work_(std::move(work)) {}
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> h) {
+        // 返回 false 表示未挂起（任务被拒绝），协程立即继续
+        return LaneScheduler::getInstance().Dispatch(lane_, loop_.Completions(), std::move(work_),
+            [this, h](Result r) {
+                result_.emplace(std::move(r));
+                h.resume();
+            });
+    }
+    std::optional<Result> await_resume() { return std::move(result_); }
+
+private:
+    EventLoop& loop_;
+    RequestLane lane_;
+    F work_;
+    std::optional<Result> result_;
+};
+
+template<class F>
+LaneAwaiter<F> RunInLane(EventLoop& loop, RequestLane lane, F work) {
+    return LaneAwaiter<F>(loop, lane, std::move(work));
+}
+
+// 数据库查询：在 DB 通道执行，Reactor 线程不阻塞
+template<class F>
+LaneAwaiter<F> DbQuery(EventLoop& loop, F work) {
+    return LaneAwaiter<F>(loop, RequestLane::DB, std::move(work));
+}
+
+#endif /* ASYNCIO_H */
@@ -0,0 +1,171 @@
+#include "asyncsql.h"
+
+#include <chrono>
+#include <algorithm>
+
+// 等待 socket 可读的最长时间，到时即重试客户端库的状态机
+static constexpr int SQL_POLL_MS = 10;
+
+SqlLease::SqlLease(EventLoop& loop, MYSQL* sql) : loop_(&loop), sql_(sql) {
+    if(sql_ and !loop_->Register(SqlConnPool::SocketOf(sql_))) {
+        LOG_ERROR("Register sql socket {} failed", SqlConnPool::SocketOf(sql_));
+    }
+}
+
+SqlLease::SqlLease(SqlLease&& other) noexcept : loop_(other.loop_), sql_(other.sql_) {
+    other.sql_ = nullptr;
+}
+
+SqlLease& SqlLease::operator=(SqlLease&& other) noexcept {
+    if(this != &other) {
+        Release();
+        loop_ = other.loop_;
+        sql_ = other.sql_;
+        other.sql_ = nullptr;
+    }
+    return *this;
+}
+
+void SqlLease::Release() {
+    if(!sql_) return;
+    loop_->Unregister(SqlConnPool::SocketOf(sql_));
+    SqlConnPool::getInstance().freeConnection(sql_);
+    sql_ = nullptr;
+}
+
+void SqlLease::Discard() {
+    if(!sql_) return;
+    loop_->Unregister(SqlConnPool::SocketOf(sql_));
+    SqlConnPool::getInstance().discardConnection(sql_);
+    sql_ = nullptr;
+}
+
+namespace {
+
+// 没有空闲连接时挂起，释放连接的线程经 RunInLoop 把连接交回本 Reactor 再恢复协程；
+// 超过 timeoutMs 仍未等到时撤销登记，以空连接恢复
+class SqlAcquireAwaiter {
+public:
+    SqlAcquireAwaiter(EventLoop& loop, size_t maxWaiters, int timeoutMs)
+        : loop_(loop), maxWaiters_(maxWaiters), timeoutMs_(timeoutMs) {}
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> h) {
+        sql_ = SqlConnPool::getInstance().getConnectionOrWait([this, h](MYSQL* sql) {
+            loop_.RunInLoop([this, h, sql]() {
+                if(timer_) loop_.CancelTimer(timer_);
+                sql_ = sql;
+                h.resume();
+            });
+        }, maxWaiters_, ticket_);
+        if(!ticket_) return false;
+        // onFree 经 RunInLoop 回到本线程执行，一定在 await_suspend 返回之后，timer_ 已经设置
+        if(timeoutMs_ >= 0) {
+            timer_ = loop_.AddTimer(timeoutMs_, [this, h]() {
+                timer_ = 0;
+                // 撤销失败说明连接已经交出，恢复由 RunInLoop 中的回调完成
+                if(SqlConnPool::getInstance().cancelWait(ticket_)) {
+                    LOG_WARN("No free sql connection within {} ms", timeoutMs_);
+                    h.resume();
+                }
+            });
+        }
+        return true;
+    }
+    MYSQL* await_resume() const noexcept { return sql_; }
+
+private:
+    EventLoop& loop_;
+    size_t maxWaiters_;
+    int timeoutMs_;
+    uint64_t ticket_ = 0;
+    uint64_t timer_ = 0;
+    MYSQL* sql_ = nullptr;
+};
+
+// 提交注册后挂起，批处理线程经 RunInLoop 把结果交回本 Reactor 再恢复协程
+class RegisterAwaiter {
+public:
+    RegisterAwaiter(EventLoop& loop, std::string name, std::string password)
+        : loop_(loop), name_(std::move(name)), password_(std::move(password)) {}
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> h) {
+        bool queued = RegisterBatcher::getInstance().Submit(std::move(name_), std::move(password_),
+            [this, h](RegisterBatcher::Result r) {
+                loop_.RunInLoop([this, h, r]() {
+                    result_ = r;
+                    h.resume();
+                });
+            });
+        return queued; // 队列已满时不挂起，直接返回 BUSY
+    }
+    RegisterBatcher::Result await_resume() const noexcept { return result_; }
+
+private:
+    EventLoop& loop_;
+    std::string name_, password_;
+    RegisterBatcher::Result result_ = RegisterBatcher::Result::BUSY;
+};
+
+// 超时剩余毫秒数，-1 表示不超时，0 表示已超时
+int Remaining(std::chrono::steady_clock::time_point deadline, int timeoutMs) {
+    if(timeoutMs < 0) return -1;
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+    return left > 0 ? static_cast<int>(left) : 0;
+}
+
+} // namespace
+
+Task<SqlLease> AcquireSql(EventLoop& loop, size_t maxWaiters) {
+    MYSQL* sql = co_await SqlAcquireAwaiter(loop, maxWaiters, SqlConnPool::getInstance().AcquireTimeout());
+    if(!sql) co_return SqlLease();
+    co_return SqlLease(loop, sql);
+}
+
+Task<RegisterBatcher::Result> AsyncRegister(EventLoop& loop, const std::string& name, const std::string& password) {
+    RegisterAwaiter awaiter(loop, name, password);
+    co_return co_await awaiter;
+}
+
+#ifdef SQL_NONBLOCKING_API
+
+Task<bool> AsyncSqlQuery(EventLoop& loop, MYSQL* sql, std::string_view query, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    net_async_status status;
+    while((status = mysql_real_query_nonblocking(sql, query.data(), query.size())) == NET_ASYNC_NOT_READY) {
+        int left = Remaining(deadline, timeoutMs);
+        if(left == 0) {
+            LOG_WARN("Sql query timeout after {} ms", timeoutMs);
+            co_return false;
+        }
+        co_await WaitReadable(loop, SqlConnPool::SocketOf(sql), left < 0 ? SQL_POLL_MS : std::min(left, SQL_POLL_MS));
+    }
+    if(status != NET_ASYNC_COMPLETE) LOG_DEBUG("Sql query failed: {}", mysql_error(sql));
+    co_return status == NET_ASYNC_COMPLETE;
+}
+
+Task<MYSQL_RES*> AsyncStoreResult(EventLoop& loop, MYSQL* sql, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    MYSQL_RES* res = nullptr;
+    net_async_status status;
+    while((status = mysql_store_result_nonblocking(sql, &res)) == NET_ASYNC_NOT_READY) {
+        int left = Remaining(deadline, timeoutMs);
+        if(left == 0) co_return nullptr;
+        co_await WaitReadable(loop, SqlConnPool::SocketOf(sql), left < 0 ? SQL_POLL_MS : std::min(left, SQL_POLL_MS));
+    }
+    co_return status == NET_ASYNC_COMPLETE ? res : nullptr;
+}
+
+#else
+
+// 客户端库没有非阻塞接口时连接池不会进入非阻塞模式，这里只是同步执行的兜底
+Task<bool> AsyncSqlQuery(EventLoop&, MYSQL* sql, std::string_view query, int) {
+    co_return mysql_real_query(sql, query.data(), query.size()) == 0;
+}
+
+Task<MYSQL_RES*> AsyncStoreResult(EventLoop&, MYSQL* sql, int) {
+    co_return mysql_store_result(sql);
+}
+
+#endif
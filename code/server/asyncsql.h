@@ -0,0 +1,64 @@
+#ifndef ASYNCSQL_H
+#define ASYNCSQL_H
+
+#include <string_view>
+
+#include "asyncio.h"
+#include "../pool/sqlconnpool.h"
+#include "../pool/regbatcher.h"
+
+/*
+    Reactor 协程中的非阻塞 MySQL 访问（libmysqlclient 8.0.16+，db_nonblocking = true）：
+    - AcquireSql：有空闲连接立即返回，否则挂起等待其他请求释放连接，不占用任何线程；
+    - 借出的连接 socket 注册到当前 EventLoop，语句用 mysql_*_nonblocking 发起，
+      返回 NET_ASYNC_NOT_READY 时挂起等待 socket 可读后继续；
+    - 一个 Reactor 上的多个协程可以同时占满连接池中的所有连接。
+    客户端库不区分等待读还是写，也可能在不需要网络时返回 NOT_READY，
+    因此每次最多等待 SQL_POLL_MS 就重试一次，不会因为等错方向而卡住。
+*/
+
+// 借出的连接：析构时从 EventLoop 注销 socket 并归还连接池；出错时调用 Discard 关闭连接而不归还
+class SqlLease {
+public:
+    SqlLease() = default;
+    SqlLease(EventLoop& loop, MYSQL* sql);
+    ~SqlLease() { Release(); }
+
+    SqlLease(SqlLease&& other) noexcept;
+    SqlLease& operator=(SqlLease&& other) noexcept;
+    SqlLease(const SqlLease&) = delete;
+    SqlLease& operator=(const SqlLease&) = delete;
+
+    MYSQL* get() const { return sql_; }
+    explicit operator bool() const { return sql_ != nullptr; }
+
+    void Release();
+    void Discard();
+
+private:
+    EventLoop* loop_ = nullptr;
+    MYSQL* sql_ = nullptr;
+};
+
+// 借用一个连接；已有 maxWaiters 个协程在等待，或等待超过连接池的 acquireTimeout 时，
+// 返回空的 SqlLease（调用方按过载处理）
+Task<SqlLease> AcquireSql(EventLoop& loop, size_t maxWaiters);
+
+// 执行一条语句，成功返回 true；timeoutMs 为整条语句的超时，-1 表示不超时
+// 超时或网络错误后连接的协议状态未知，调用方应 Discard
+Task<bool> AsyncSqlQuery(EventLoop& loop, MYSQL* sql, std::string_view query, int timeoutMs = -1);
+
+// 取回上一条语句的结果集，出错或超时返回 nullptr
+Task<MYSQL_RES*> AsyncStoreResult(EventLoop& loop, MYSQL* sql, int timeoutMs = -1);
+
+// 把注册请求交给批量注册线程，挂起到整批提交后恢复；等待中的注册过多时返回 BUSY
+Task<RegisterBatcher::Result> AsyncRegister(EventLoop& loop, const std::string& name, const std::string& password);
+
+// 语句失败后连接能否继续使用：服务端报错（如约束冲突）可以；
+// 超时（没有错误码）或客户端/网络错误（CR_*，2000~2999）时协议状态未知，应 Discard
+inline bool SqlConnUsable(MYSQL* sql) {
+    unsigned int err = mysql_errno(sql);
+    return err != 0 and (err < 2000 or err >= 3000);
+}
+
+#endif /* ASYNCSQL_H */
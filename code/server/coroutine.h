@@ -0,0 +1,196 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <optional>
+#include <cstddef>
+#include <new>
+
+/*
+    基于 C++20 无栈协程的连接处理：每个连接是一个顺序书写的 co_await 处理函数，
+    协程帧只保存跨越挂起点的局部变量（通常几百字节），而有栈协程每个需要几十 KB 的栈。
+
+    FramePool：协程帧的每线程分级内存池。
+    - 按 64 字节对齐分级（64 ~ 2048 字节），每级一个空闲链表，释放的帧直接挂回链表复用；
+    - 线程局部，分配/释放无锁；帧在其他线程释放时归还到该线程的链表，同样安全；
+    - 超过最大级别的帧退化为 ::operator new。
+*/
+class FramePool {
+public:
+    static constexpr size_t ALIGN = 64;
+    static constexpr size_t MAX_FRAME = 2048;
+    static constexpr size_t CLASS_COUNT = MAX_FRAME / ALIGN;
+
+    static void* Allocate(size_t size) {
+        if(size > MAX_FRAME) return ::operator new(size);
+        FreeNode*& head = Local_().heads[ClassOf_(size)];
+        if(head) {
+            FreeNode* node = head;
+            head = node->next;
+            return node;
+        }
+        return ::operator new((ClassOf_(size) + 1) * ALIGN);
+    }
+
+    static void Deallocate(void* p, size_t size) {
+        if(size > MAX_FRAME) {
+            ::operator delete(p);
+            return;
+        }
+        FreeNode*& head = Local_().heads[ClassOf_(size)];
+        FreeNode* node = static_cast<FreeNode*>(p);
+        node->next = head;
+        head = node;
+    }
+
+private:
+    struct FreeNode { FreeNode* next; };
+
+    struct Lists {
+        FreeNode* heads[CLASS_COUNT] = {};
+        ~Lists() {
+            for(auto head : heads) {
+                while(head) {
+                    FreeNode* next = head->next;
+                    ::operator delete(head);
+                    head = next;
+                }
+            }
+        }
+    };
+
+    static size_t ClassOf_(size_t size) { return size == 0 ? 0 : (size - 1) / ALIGN; }
+
+    static Lists& Local_() {
+        static thread_local Lists lists;
+        return lists;
+    }
+};
+
+template<class T = void>
+class Task;
+
+namespace detail {
+
+// 所有 promise 共用：帧内存来自 FramePool，结束时对称转移回等待者
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    static void* operator new(size_t size) { return FramePool::Allocate(size); }
+    static void operator delete(void* p, size_t size) { FramePool::Deallocate(p, size); }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template<class P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            auto next = h.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template<class T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+    Task<T> get_return_object();
+    template<class U>
+    void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+    T result() {
+        if(exception) std::rethrow_exception(exception);
+        return std::move(*value);
+    }
+};
+
+template<>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void result() {
+        if(exception) std::rethrow_exception(exception);
+    }
+};
+
+} // namespace detail
+
+/*
+    Task<T>：惰性启动的协程，被 co_await 时才开始执行，结束后返回到等待者。
+    只能移动，析构时销毁协程帧。
+    GCC 12 会把 co_await 表达式中的部分临时对象析构两次（如按值捕获 string 的 lambda、
+    聚合初始化的按值参数），因此 co_await 表达式中只出现具名局部变量、引用和平凡类型的值：
+    字符串、鉴权参数、可调用对象先放进具名局部变量，被立即 co_await 的协程按 const 引用接收参数。
+*/
+template<class T>
+class Task {
+public:
+    using promise_type = detail::Promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(handle_type h) : handle_(h) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if(this != &other) {
+            if(handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { if(handle_) handle_.destroy(); }
+
+    bool await_ready() const noexcept { return !handle_ or handle_.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+    T await_resume() { return handle_.promise().result(); }
+
+private:
+    handle_type handle_;
+};
+
+namespace detail {
+
+template<class T>
+Task<T> Promise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// 分离执行的顶层协程：立即开始，结束时自行销毁
+struct Detached {
+    struct promise_type {
+        static void* operator new(size_t size) { return FramePool::Allocate(size); }
+        static void operator delete(void* p, size_t size) { FramePool::Deallocate(p, size); }
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+inline Detached RunDetached(Task<void> task) {
+    co_await task;
+}
+
+} // namespace detail
+
+// 启动一个顶层协程（如一个连接的处理函数），不等待其结束
+inline void Spawn(Task<void> task) {
+    detail::RunDetached(std::move(task));
+}
+
+#endif /* COROUTINE_H */
@@ -0,0 +1,36 @@
+#ifndef EPOLLER_H
+#define EPOLLER_H
+
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <errno.h>
+
+// epoll 的简单封装，每个 EventLoop 持有一个
+class Epoller {
+public:
+    explicit Epoller(int maxEvent = 1024);
+    ~Epoller();
+
+    Epoller(const Epoller&) = delete;
+    Epoller& operator=(const Epoller&) = delete;
+
+    bool AddFd(int fd, uint32_t events);
+    bool ModFd(int fd, uint32_t events);
+    bool DelFd(int fd);
+
+    // 返回就绪事件数，timeoutMs 为 -1 时一直阻塞
+    int Wait(int timeoutMs = -1);
+
+    int GetEventFd(size_t i) const;
+    uint32_t GetEvents(size_t i) const;
+
+private:
+    int epollFd_;
+    std::vector<struct epoll_event> events_;
+};
+
+#endif /* EPOLLER_H */
@@ -0,0 +1,165 @@
+#include "eventloop.h"
+
+#include "../log/log.h"
+
+namespace {
+thread_local EventLoop* tlsLoop = nullptr;
+}
+
+EventLoop::EventLoop(bool edgeTriggered) : edgeTriggered_(edgeTriggered), threadId_(std::this_thread::get_id()) {
+    epoller_.AddFd(completions_.Fd(), EPOLLIN);
+}
+
+EventLoop::~EventLoop() {
+    epoller_.DelFd(completions_.Fd());
+}
+
+EventLoop* EventLoop::Current() {
+    return tlsLoop;
+}
+
+void EventLoop::Loop() {
+    threadId_ = std::this_thread::get_id();
+    tlsLoop = this;
+    while(!quit_.load()) {
+        int timeMs = timer_.GetNextTick(); // 先处理到期定时器，再得到 epoll 的等待时间
+        if(!ready_.empty()) timeMs = 0;    // 有待继续的连接时只轮询新事件
+        int n = epoller_.Wait(timeMs);
+        if(n < 0) {
+            if(errno == EINTR) continue;
+            LOG_ERROR("EventLoop epoll_wait error, errno: {}", errno);
+            break;
+        }
+        iteration_++;
+        // 上一轮让出的连接，本轮新让出的留到下一轮，避免同一轮内反复让出
+        size_t readyCnt = ready_.size();
+        for(int i = 0; i < n; i++) {
+            int fd = epoller_.GetEventFd(i);
+            uint32_t events = epoller_.GetEvents(i);
+            if(fd == completions_.Fd()) completions_.Drain();
+            else HandleEvent_(fd, events);
+        }
+        // 新事件处理完后，再让上一轮让出的连接继续
+        RunReady_(readyCnt);
+    }
+    // 退出前执行剩余的投递回调
+    completions_.Drain();
+    tlsLoop = nullptr;
+}
+
+void EventLoop::Quit() {
+    quit_.store(true);
+    // 唤醒阻塞在 epoll_wait 上的线程；本线程内（如定时器回调中）调用时也需要，
+    // 否则处理完定时器后可能以 -1 超时进入 epoll_wait
+    RunInLoop([]() {});
+}
+
+void EventLoop::RunInLoop(std::function<void()> cb) {
+    completions_.Post(std::move(cb));
+}
+
+EventLoop::FdState& EventLoop::State_(int fd) {
+    assert(fd >= 0);
+    if(static_cast<size_t>(fd) >= fds_.size()) fds_.resize(fd + 1);
+    return fds_[fd];
+}
+
+void EventLoop::RunReady_(size_t n) {
+    for(size_t i = 0; i < n and !ready_.empty(); i++) {
+        std::coroutine_handle<> h = ready_.front();
+        ready_.pop_front();
+        h.resume();
+    }
+}
+
+bool EventLoop::Register(int fd) {
+    FdState& st = State_(fd);
+    if(st.registered) return true;
+    // ET：只注册一次，之后等待方总是先尝试 I/O，遇到 EAGAIN 才挂起
+    // LT：先不关注任何事件，等有协程等待时再打开
+    uint32_t events = edgeTriggered_ ? (EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET) : 0;
+    if(!epoller_.AddFd(fd, events)) {
+        LOG_ERROR("EventLoop register fd {} failed, errno: {}", fd, errno);
+        return false;
+    }
+    st.registered = true;
+    st.armed = events;
+    return true;
+}
+
+void EventLoop::Rearm_(int fd, FdState& st, uint32_t events) {
+    if(st.armed == events) return;
+    if(epoller_.ModFd(fd, events)) st.armed = events;
+}
+
+void EventLoop::Unregister(int fd) {
+    FdState& st = State_(fd);
+    if(st.registered) epoller_.DelFd(fd);
+    st = FdState();
+}
+
+bool EventLoop::SetWaiter(int fd, bool write, std::coroutine_handle<> h) {
+    FdState& st = State_(fd);
+    // 连接已出错且移出了 epoll，不再有事件，等待方应直接重试 I/O 以拿到错误
+    if(st.broken) return false;
+    (write ? st.writer : st.reader) = h;
+    if(!edgeTriggered_ and st.registered) {
+        Rearm_(fd, st, st.armed | (write ? EPOLLOUT : (EPOLLIN | EPOLLRDHUP)));
+    }
+    return true;
+}
+
+void EventLoop::ClearWaiter(int fd, bool write) {
+    if(static_cast<size_t>(fd) >= fds_.size()) return;
+    FdState& st = fds_[fd];
+    (write ? st.writer : st.reader) = nullptr;
+}
+
+bool EventLoop::PeerClosed(int fd) const {
+    return static_cast<size_t>(fd) < fds_.size() and fds_[fd].peerClosed;
+}
+
+void EventLoop::HandleEvent_(int fd, uint32_t events) {
+    if(static_cast<size_t>(fd) >= fds_.size()) return;
+    // 出错或对端关闭时同时唤醒读写双方，由它们在重试 I/O 时发现错误
+    const uint32_t errEvents = EPOLLERR | EPOLLHUP;
+    if(events & (EPOLLRDHUP | errEvents)) fds_[fd].peerClosed = true;
+    if(events & (EPOLLIN | EPOLLRDHUP | errEvents)) {
+        std::coroutine_handle<> h = fds_[fd].reader;
+        fds_[fd].reader = nullptr;
+        if(h) h.resume();
+    }
+    // 恢复读协程时 fds_ 可能扩容或 fd 已被注销，需重新取下标
+    if(static_cast<size_t>(fd) >= fds_.size()) return;
+    if(events & (EPOLLOUT | errEvents)) {
+        std::coroutine_handle<> h = fds_[fd].writer;
+        fds_[fd].writer = nullptr;
+        if(h) h.resume();
+    }
+    if(edgeTriggered_ or static_cast<size_t>(fd) >= fds_.size()) return;
+    FdState& st = fds_[fd];
+    if(!st.registered) return;
+    if(events & errEvents) {
+        // 水平触发下错误/挂断会持续上报且无法取消关注，移出 epoll，后续等待直接重试
+        if(!st.reader and !st.writer) {
+            epoller_.DelFd(fd);
+            st.registered = false;
+            st.armed = 0;
+            st.broken = true;
+        }
+        return;
+    }
+    // 惰性取消关注：只有事件到达时该方向无人等待，才关闭该方向
+    uint32_t want = st.armed;
+    if(!st.reader) want &= ~(EPOLLIN | EPOLLRDHUP);
+    if(!st.writer) want &= ~EPOLLOUT;
+    Rearm_(fd, st, want);
+}
+
+uint64_t EventLoop::AddTimer(int timeoutMs, std::function<void()> cb) {
+    return timer_.add(timeoutMs, std::move(cb));
+}
+
+void EventLoop::CancelTimer(uint64_t id) {
+    timer_.cancel(id);
+}
@@ -0,0 +1,97 @@
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <coroutine>
+
+#include "epoller.h"
+#include "../timer/heaptimer.h"
+#include "../pool/threadpool.h"
+
+/*
+    EventLoop 即一个 Reactor：一个线程 + 一个 epoll + 一个定时器堆。
+    - 连接 fd 注册后由挂起在其上的协程等待可读/可写事件，事件到达时在本线程恢复协程；
+    - 其他线程通过 RunInLoop 投递回调，复用 CompletionQueue 的 eventfd 唤醒本线程；
+    - 线程池任务完成后也经同一个 CompletionQueue 回到本线程。
+    协程恢复可能是虚假唤醒（如 fd 被复用），等待方需要重试 I/O 并在 EAGAIN 时再次挂起。
+
+    触发模式（Config 中 trigger_mode）：
+    - ET：fd 只在 Register 时注册一次（读写都关注），之后不再 epoll_ctl；
+      等待方总是先尝试 I/O，遇到 EAGAIN 才挂起，新数据到达会产生新的边沿。
+    - LT：只在有协程等待时关注对应方向；事件到达时若该方向没有等待者才取消关注（惰性），
+      避免连接忙于其他事情（如等待数据库）时被水平触发反复唤醒。
+    就绪队列：用完本轮公平预算但还没读/写完的连接通过 Yield 进入就绪队列，
+    在下一轮循环处理完新的 epoll 事件后恢复，不需要重新 epoll_ctl，
+    保证少数大流量连接不会独占 Reactor。
+*/
+class EventLoop {
+public:
+    explicit EventLoop(bool edgeTriggered = true);
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // 在当前线程运行事件循环，直到 Quit 被调用
+    void Loop();
+    // 可在任意线程调用
+    void Quit();
+    // 将回调投递到本线程执行，可在任意线程调用
+    void RunInLoop(std::function<void()> cb);
+
+    // 以下接口只能在本线程调用
+    bool Register(int fd);
+    void Unregister(int fd);
+    // 返回 false 表示 fd 已出错、不会再有事件，调用方不应挂起
+    bool SetWaiter(int fd, bool write, std::coroutine_handle<> h);
+    void ClearWaiter(int fd, bool write);
+    // 是否已收到过对端关闭（RDHUP/HUP）事件；此后不会再有新的可读边沿
+    bool PeerClosed(int fd) const;
+
+    // 将协程放入就绪队列，下一轮循环恢复
+    void Schedule(std::coroutine_handle<> h) { ready_.push_back(h); }
+    // 循环轮次，每次 epoll_wait 返回后加一，用于重置每连接的公平预算
+    uint64_t Iteration() const { return iteration_; }
+    bool EdgeTriggered() const { return edgeTriggered_; }
+
+    uint64_t AddTimer(int timeoutMs, std::function<void()> cb);
+    void CancelTimer(uint64_t id);
+
+    CompletionQueue& Completions() { return completions_; }
+
+    bool IsInLoopThread() const { return threadId_ == std::this_thread::get_id(); }
+    // 当前线程正在运行的 EventLoop，非 Reactor 线程返回 nullptr
+    static EventLoop* Current();
+
+private:
+    // 挂起在某个 fd 上的读/写协程
+    struct FdState {
+        std::coroutine_handle<> reader;
+        std::coroutine_handle<> writer;
+        bool registered = false;
+        uint32_t armed = 0;  // LT 模式下当前关注的事件
+        bool broken = false; // LT 模式下出错/挂断后已从 epoll 移除
+        bool peerClosed = false; // 已收到对端关闭事件
+    };
+
+    FdState& State_(int fd);
+    void HandleEvent_(int fd, uint32_t events);
+    void Rearm_(int fd, FdState& st, uint32_t events);
+    void RunReady_(size_t n);
+
+    Epoller epoller_;
+    HeapTimer timer_;
+    CompletionQueue completions_;
+    std::vector<FdState> fds_; // 以 fd 为下标
+    std::deque<std::coroutine_handle<>> ready_;
+    bool edgeTriggered_;
+    uint64_t iteration_ = 0;
+    std::atomic<bool> quit_{false};
+    std::thread::id threadId_;
+};
+
+#endif /* EVENTLOOP_H */
@@ -0,0 +1,98 @@
+#ifndef SINGLEFLIGHT_H
+#define SINGLEFLIGHT_H
+
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "coroutine.h"
+#include "eventloop.h"
+
+/*
+    请求合并（single-flight）：同一个 key 同一时刻只执行一次加载。
+    - 第一个请求者（leader）执行 load，加载期间到达的同 key 请求挂起等待同一个结果，不占用线程；
+    - 加载完成后 leader 把结果交给每个等待者，经等待者所在 EventLoop 的 RunInLoop 在原 Reactor 上恢复，
+      等待者可以来自不同的 Reactor；
+    - 只合并正在进行的加载，不保存结果：加载结束后到达的请求重新加载；
+    - 按 key 的哈希分为 SHARDS 个分片，各自一把锁，只在登记/摘下等待者时持有。
+    T 必须可拷贝（每个等待者一份），大对象用 shared_ptr 共享；load 不应抛出异常。
+*/
+template<class T>
+class SingleFlight {
+public:
+    static constexpr size_t SHARDS = 16;
+
+    // load 为无参可调用对象，返回 Task<T>；在调用者（leader）的协程中执行。
+    // key 按引用保存，调用方应立即 co_await 返回的 Task
+    template<class F>
+    Task<T> Do(EventLoop& loop, const std::string& key, F load) {
+        Shard& shard = shards_[std::hash<std::string>{}(key) % SHARDS];
+        Waiter self{&loop};
+        bool leader = false;
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            auto [it, inserted] = shard.calls.try_emplace(key);
+            leader = inserted;
+            if(!leader) it->second.push_back(&self);
+        }
+        if(!leader) {
+            coalesced_.fetch_add(1, std::memory_order_relaxed);
+            // leader 经 RunInLoop 恢复本协程，回调一定在本协程挂起之后才在本线程执行
+            co_await Suspend{self};
+            co_return std::move(*self.result);
+        }
+
+        loads_.fetch_add(1, std::memory_order_relaxed);
+        T result = co_await load();
+        std::vector<Waiter*> waiters;
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            auto it = shard.calls.find(key);
+            waiters = std::move(it->second);
+            shard.calls.erase(it);
+        }
+        for(Waiter* w : waiters) {
+            w->loop->RunInLoop([w, r = result]() mutable {
+                w->result.emplace(std::move(r));
+                w->handle.resume();
+            });
+        }
+        co_return result;
+    }
+
+    // 实际执行的加载次数、合并掉（等待他人结果）的请求数
+    uint64_t Loads() const { return loads_.load(std::memory_order_relaxed); }
+    uint64_t Coalesced() const { return coalesced_.load(std::memory_order_relaxed); }
+
+private:
+    // 等待者位于其协程帧中，在被恢复之前一直有效
+    struct Waiter {
+        EventLoop* loop = nullptr;
+        std::coroutine_handle<> handle = nullptr;
+        std::optional<T> result = std::nullopt;
+    };
+
+    struct Suspend {
+        Waiter& w;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) noexcept { w.handle = h; }
+        void await_resume() const noexcept {}
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mtx;
+        std::unordered_map<std::string, std::vector<Waiter*>> calls;
+    };
+
+    std::array<Shard, SHARDS> shards_;
+    std::atomic<uint64_t> loads_{0};
+    std::atomic<uint64_t> coalesced_{0};
+};
+
+#endif /* SINGLEFLIGHT_H */
@@ -0,0 +1,354 @@
+
+#include "asyncio.h"
+#include "singleflight.h"
+#include "../log/log.h"
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <chrono>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <poll.h>
+
+// 创建一对非阻塞的本地 socket
+static void makeSocketPair(int fds[2]) {
+    int ret = socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds);
+    assert(ret == 0);
+    (void)ret;
+}
+
+// 测试1：Sleep 不阻塞线程，多个协程并发等待
+void testSleep() {
+    LOG_INFO("=== Test 1: Sleep ===");
+    EventLoop loop;
+    int finished = 0;
+    auto sleeper = [&](int ms) -> Task<void> {
+        co_await Sleep(loop, ms);
+        finished++;
+        if(finished == 100) loop.Quit();
+    };
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < 100; i++) Spawn(sleeper(20));
+    loop.Loop();
+    auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    assert(finished == 100);
+    assert(cost < 1000); // 100 个 20ms 的等待并发进行
+    LOG_INFO("✓ Test 1 passed! ({} ms)", cost);
+}
+
+// 测试2：协程间通过 socket 读写（ET 与 LT 两种触发模式）
+void testReadWrite(bool edgeTriggered) {
+    LOG_INFO("=== Test 2: Async Read / Write ({}) ===", edgeTriggered ? "ET" : "LT");
+    EventLoop loop(edgeTriggered);
+    int fds[2];
+    makeSocketPair(fds);
+    loop.Register(fds[0]);
+    loop.Register(fds[1]);
+
+    const size_t total = 4 * 1024 * 1024; // 超过 socket 缓冲区，写方必然挂起
+    size_t received = 0;
+    auto writer = [&]() -> Task<void> {
+        Buffer buff;
+        std::string chunk(total, 'x');
+        buff.append(chunk);
+        ssize_t n = co_await AsyncWrite(loop, fds[0], buff);
+        assert(n == static_cast<ssize_t>(total));
+        (void)n;
+    };
+    auto reader = [&]() -> Task<void> {
+        Buffer buff;
+        while(received < total) {
+            ssize_t n = co_await AsyncRead(loop, fds[1], buff);
+            assert(n > 0);
+            received += n;
+            buff.reset();
+        }
+        loop.Quit();
+    };
+    Spawn(reader());
+    Spawn(writer());
+    loop.Loop();
+    assert(received == total);
+    close(fds[0]);
+    close(fds[1]);
+    LOG_INFO("✓ Test 2 passed!");
+}
+
+// 测试3：读超时
+void testReadTimeout() {
+    LOG_INFO("=== Test 3: Read Timeout ===");
+    EventLoop loop;
+    int fds[2];
+    makeSocketPair(fds);
+    loop.Register(fds[1]);
+    bool timedOut = false;
+    auto reader = [&]() -> Task<void> {
+        Buffer buff;
+        ssize_t n = co_await AsyncRead(loop, fds[1], buff, 50);
+        timedOut = (n == -1 and errno == ETIMEDOUT);
+        loop.Quit();
+    };
+    Spawn(reader());
+    loop.Loop();
+    assert(timedOut);
+    close(fds[0]);
+    close(fds[1]);
+    LOG_INFO("✓ Test 3 passed!");
+}
+
+// 测试4：sendfile
+void testSendfile() {
+    LOG_INFO("=== Test 4: Async Sendfile ===");
+    const char* path = "test_sendfile.tmp";
+    std::string content(1024 * 1024, 'y');
+    int fileFd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    assert(fileFd >= 0);
+    ssize_t w = write(fileFd, content.data(), content.size());
+    assert(w == static_cast<ssize_t>(content.size()));
+    (void)w;
+
+    EventLoop loop;
+    int fds[2];
+    makeSocketPair(fds);
+    loop.Register(fds[0]);
+    loop.Register(fds[1]);
+    size_t received = 0;
+    auto sender = [&]() -> Task<void> {
+        ssize_t n = co_await AsyncSendfile(loop, fds[0], fileFd, 0, content.size());
+        assert(n == static_cast<ssize_t>(content.size()));
+        (void)n;
+    };
+    auto reader = [&]() -> Task<void> {
+        Buffer buff;
+        while(received < content.size()) {
+            ssize_t n = co_await AsyncRead(loop, fds[1], buff);
+            assert(n > 0);
+            received += n;
+            buff.reset();
+        }
+        loop.Quit();
+    };
+    Spawn(reader());
+    Spawn(sender());
+    loop.Loop();
+    assert(received == content.size());
+    close(fds[0]);
+    close(fds[1]);
+    close(fileFd);
+    unlink(path);
+    LOG_INFO("✓ Test 4 passed!");
+}
+
+// 测试5：DB 查询在通道线程执行，完成后回到 Reactor 线程；通道满时立即返回
+void testDbQuery() {
+    LOG_INFO("=== Test 5: DbQuery Through Lane ===");
+    LaneScheduler::LaneConfig configs[static_cast<int>(RequestLane::COUNT)];
+    configs[static_cast<int>(RequestLane::DB)] = {1, 0};
+    LaneScheduler::getInstance().Init(configs);
+
+    EventLoop loop;
+    std::thread::id loopThread = std::this_thread::get_id();
+    int done = 0;
+    bool shed = false;
+    auto query = [&]() -> Task<void> {
+        std::optional<int> r = co_await DbQuery(loop, [loopThread]() {
+            assert(std::this_thread::get_id() != loopThread); // 在通道线程执行
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            return 42;
+        });
+        assert(std::this_thread::get_id() == loopThread); // 在 Reactor 线程恢复
+        assert(r and *r == 42);
+        done++;
+        loop.Quit();
+    };
+    auto rejected = [&]() -> Task<void> {
+        std::optional<int> r = co_await DbQuery(loop, []() { return 1; });
+        shed = !r;
+    };
+    Spawn(query());
+    Spawn(rejected()); // 通道只有 1 个线程且无队列，第二个查询被拒绝
+    loop.Loop();
+    assert(done == 1 and shed);
+    LaneScheduler::getInstance().Shutdown();
+    LOG_INFO("✓ Test 5 passed!");
+}
+
+// 测试6：大量挂起的慢连接只占用协程帧内存
+void testManySuspended() {
+    LOG_INFO("=== Test 6: Many Suspended Coroutines ===");
+    EventLoop loop;
+    // 每个连接占用 2 个 fd，受进程 fd 上限约束
+    struct rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    const int N = std::min<int>(5000, (static_cast<int>(rl.rlim_cur) - 64) / 2);
+    std::vector<int> fds(2 * N);
+    for(int i = 0; i < N; i++) {
+        makeSocketPair(&fds[2 * i]);
+        loop.Register(fds[2 * i + 1]);
+    }
+    int finished = 0;
+    auto reader = [&](int fd) -> Task<void> {
+        Buffer buff(64);
+        ssize_t n = co_await AsyncRead(loop, fd, buff);
+        assert(n == 1);
+        (void)n;
+        if(++finished == N) loop.Quit();
+    };
+    for(int i = 0; i < N; i++) Spawn(reader(fds[2 * i + 1]));
+    // 所有协程挂起后再逐个唤醒
+    loop.RunInLoop([&]() {
+        for(int i = 0; i < N; i++) {
+            ssize_t w = write(fds[2 * i], "z", 1);
+            (void)w;
+        }
+    });
+    loop.Loop();
+    assert(finished == N);
+    for(int fd : fds) close(fd);
+    LOG_INFO("✓ Test 6 passed! ({} coroutines)", N);
+}
+
+// 测试7：公平预算，大流量连接不会饿死同一 Reactor 上的小请求
+void testFairness() {
+    LOG_INFO("=== Test 7: Per-Connection Fairness Budget ===");
+    EventLoop loop;
+    int big[2], small[2];
+    makeSocketPair(big);
+    makeSocketPair(small);
+    loop.Register(big[1]);
+    loop.Register(small[1]);
+
+    // 持续灌入大量数据的客户端
+    const size_t streamTotal = 64 * 1024 * 1024;
+    std::thread feeder([&]() {
+        std::string chunk(256 * 1024, 'u');
+        size_t sent = 0;
+        while(sent < streamTotal) {
+            ssize_t n = write(big[0], chunk.data(), std::min(chunk.size(), streamTotal - sent));
+            if(n > 0) sent += n;
+            else {
+                struct pollfd p = {big[0], POLLOUT, 0};
+                poll(&p, 1, 100);
+            }
+        }
+        shutdown(big[0], SHUT_WR);
+    });
+    // 只发送小请求并测量往返时延的客户端
+    std::atomic<bool> streamDone{false};
+    long maxRttUs = 0;
+    int rounds = 0;
+    std::thread pinger([&]() {
+        while(!streamDone.load()) {
+            auto start = std::chrono::steady_clock::now();
+            ssize_t w = write(small[0], "p", 1);
+            assert(w == 1);
+            (void)w;
+            char c;
+            struct pollfd p = {small[0], POLLIN, 0};
+            while(read(small[0], &c, 1) != 1) poll(&p, 1, 100);
+            long us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            maxRttUs = std::max(maxRttUs, us);
+            rounds++;
+        }
+        shutdown(small[0], SHUT_WR);
+    });
+
+    int finished = 0;
+    size_t streamed = 0;
+    auto greedy = [&]() -> Task<void> {
+        FairnessBudget budget(loop, 64 * 1024, 4);
+        Buffer buff;
+        while(true) {
+            ssize_t n = co_await AsyncRead(loop, big[1], buff, -1, &budget);
+            if(n <= 0) break;
+            streamed += n;
+            buff.reset();
+            // 模拟解析开销，使读方跟不上写方，socket 一直有数据
+            auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(50);
+            while(std::chrono::steady_clock::now() < until) {}
+        }
+        streamDone.store(true);
+        if(++finished == 2) loop.Quit();
+    };
+    auto echo = [&]() -> Task<void> {
+        FairnessBudget budget(loop, 64 * 1024, 4);
+        Buffer buff;
+        while(true) {
+            ssize_t n = co_await AsyncRead(loop, small[1], buff, -1, &budget);
+            if(n <= 0) break;
+            if(co_await AsyncWrite(loop, small[1], buff, -1, &budget) < 0) break;
+        }
+        if(++finished == 2) loop.Quit();
+    };
+    Spawn(greedy());
+    Spawn(echo());
+    loop.Loop();
+    feeder.join();
+    pinger.join();
+    assert(streamed == streamTotal);
+    assert(rounds > 0);
+    assert(maxRttUs < 200 * 1000); // 每轮大流量连接最多占用 64KB 的处理时间
+    for(int fd : {big[0], big[1], small[0], small[1]}) close(fd);
+    LOG_INFO("✓ Test 7 passed! ({} round trips, max rtt {} us)", rounds, maxRttUs);
+}
+
+// 测试8：请求合并，并发的同 key 请求只加载一次，等待者在各自的 Reactor 上恢复
+void testSingleFlight() {
+    LOG_INFO("=== Test 8: Single-Flight Coalescing ===");
+    const int N = 100;
+    SingleFlight<std::string> flight;
+    EventLoop loopA, loopB;
+    std::atomic<int> done{0};
+    auto load = [&]() -> Task<std::string> {
+        co_await Sleep(loopA, 100); // leader 在 loopA 上，加载期间不阻塞线程
+        co_return std::string("value");
+    };
+    const std::string key = "key";
+    auto requester = [&](EventLoop& loop) -> Task<void> {
+        std::string v = co_await flight.Do(loop, key, load);
+        assert(v == "value");
+        assert(loop.IsInLoopThread()); // 在发起请求的 Reactor 上恢复
+        (void)v;
+        if(++done == 2 * N) {
+            loopA.Quit();
+            loopB.Quit();
+        }
+    };
+    // 第一个请求成为 leader 并开始加载，其余请求都在加载期间到达
+    for(int i = 0; i < N; i++) Spawn(requester(loopA));
+    loopB.RunInLoop([&]() {
+        for(int i = 0; i < N; i++) Spawn(requester(loopB));
+    });
+    std::thread other([&]() { loopB.Loop(); });
+    loopA.Loop();
+    other.join();
+    assert(done == 2 * N);
+    assert(flight.Loads() == 1 and flight.Coalesced() == 2 * N - 1);
+    LOG_INFO("✓ Test 8 passed! ({} loads, {} coalesced)", flight.Loads(), flight.Coalesced());
+}
+
+int main() {
+    Logger::getInstance().initLogger("log/test_eventloop.log", LogLevel::INFO, 1024, 3);
+    LOG_INFO("Starting EventLoop / Coroutine Tests...");
+    LOG_INFO("===============================");
+
+    testSleep();
+    testReadWrite(true);
+    testReadWrite(false);
+    testReadTimeout();
+    testSendfile();
+    testDbQuery();
+    testManySuspended();
+    testFairness();
+    testSingleFlight();
+
+    LOG_INFO("================================");
+    LOG_INFO("All tests passed successfully! ✓");
+    Logger::getInstance().shutdown();
+    std::cout << "Test completed. Check test_eventloop.log for details." << std::endl;
+    return 0;
+}
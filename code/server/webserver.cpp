@@ -0,0 +1,194 @@
+#include "webserver.h"
+
+#include <csignal>
+#include <cstring>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "asyncio.h"
+#include "affinity.h"
+#include "../config/config.h"
+#include "../http/httpconn.h"
+#include "../auth/session.h"
+#include "../log/log.h"
+#include "../log/accesslog.h"
+
+WebServer::WebServer() : listenFd_(-1) {
+    Config& config = Config::getInstance();
+    port_ = static_cast<int>(config.c_port);
+    openLinger_ = config.c_isOptLinger;
+    // 对端关闭后继续写 socket 会触发 SIGPIPE，默认行为是终止进程
+    signal(SIGPIPE, SIG_IGN);
+}
+
+WebServer::~WebServer() {
+    Stop();
+    for(auto& t : threads_) {
+        if(t.joinable()) t.join();
+    }
+    if(listenFd_ >= 0) close(listenFd_);
+}
+
+bool WebServer::InitSocket_() {
+    if(port_ > 65535 or port_ < 1024) {
+        LOG_ERROR("Port: {} error!", port_);
+        return false;
+    }
+    listenFd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(listenFd_ < 0) {
+        LOG_ERROR("Create socket error! port: {}", port_);
+        return false;
+    }
+
+    // 优雅关闭：直到所剩数据发送完毕或超时
+    struct linger optLinger = {};
+    if(openLinger_) {
+        optLinger.l_onoff = 1;
+        optLinger.l_linger = 1;
+    }
+    if(setsockopt(listenFd_, SOL_SOCKET, SO_LINGER, &optLinger, sizeof(optLinger)) < 0) {
+        LOG_ERROR("Init linger error! port: {}", port_);
+        return false;
+    }
+
+    // 端口复用，只有最后一个套接字会正常接收数据
+    int optval = 1;
+    if(setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)) < 0) {
+        LOG_ERROR("Set socket setsockopt error! port: {}", port_);
+        return false;
+    }
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port_);
+    if(bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        LOG_ERROR("Bind port: {} error, errno: {}", port_, errno);
+        return false;
+    }
+    if(listen(listenFd_, SOMAXCONN) < 0) {
+        LOG_ERROR("Listen port: {} error!", port_);
+        return false;
+    }
+    if(!mainLoop_.Register(listenFd_)) return false;
+    LOG_INFO("Server listen on port: {}", port_);
+    return true;
+}
+
+EventLoop* WebServer::NextLoop_() {
+    EventLoop* loop = subLoops_[next_].get();
+    next_ = (next_ + 1) % subLoops_.size();
+    return loop;
+}
+
+// 收包 CPU 上绑定了 Reactor 时交给它处理，否则轮询分配
+EventLoop* WebServer::LoopForFd_(int fd) {
+    if(!cpuToLoop_.empty()) {
+        int cpu = GetIncomingCpu(fd);
+        auto it = cpuToLoop_.find(cpu);
+        if(it != cpuToLoop_.end()) return subLoops_[it->second].get();
+    }
+    return NextLoop_();
+}
+
+void WebServer::RunReactor_(size_t idx) {
+    Config& config = Config::getInstance();
+    if(!reactorCpus_.empty()) {
+        int cpu = reactorCpus_[idx % reactorCpus_.size()];
+        if(PinThreadToCpu(pthread_self(), cpu)) {
+            LOG_INFO("Reactor {} pinned to cpu {} (numa node {})", idx, cpu, NumaNodeOfCpu(cpu));
+        }
+    }
+    // 连接的协程帧与缓冲区都在本线程分配，设置本地策略后落在本线程所在的 NUMA 节点
+    if(config.c_numa_local) BindMemoryToLocalNode();
+    if(AccessLog::Enabled()) ArmAccessLogFlush_(*subLoops_[idx]);
+    subLoops_[idx]->Loop();
+    AccessLog::getInstance().FlushThread();
+}
+
+void WebServer::ArmAccessLogFlush_(EventLoop& loop) {
+    loop.AddTimer(AccessLog::FLUSH_INTERVAL_MS, [&loop]() {
+        AccessLog::getInstance().FlushThread();
+        ArmAccessLogFlush_(loop);
+    });
+}
+
+// 每次清理一个分片的过期会话，工作量有界，不会拖慢主 Reactor 的 accept
+void WebServer::ArmSessionSweep_(EventLoop& loop) {
+    loop.AddTimer(SessionStore::SWEEP_INTERVAL_MS, [&loop]() {
+        size_t n = SessionStore::getInstance().SweepNext();
+        if(n > 0) LOG_DEBUG("Swept {} expired sessions", n);
+        ArmSessionSweep_(loop);
+    });
+}
+
+Task<void> WebServer::AcceptLoop_() {
+    const int maxConn = Config::getInstance().c_maxConnection;
+    while(!isClose_.load()) {
+        co_await WaitReadable(mainLoop_, listenFd_);
+        // 边缘触发：一次唤醒内 accept 直到 EAGAIN
+        while(true) {
+            struct sockaddr_in addr;
+            socklen_t len = sizeof(addr);
+            int fd = accept4(listenFd_, reinterpret_cast<sockaddr*>(&addr), &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if(fd < 0) {
+                if(errno == EINTR) continue;
+                if(errno != EAGAIN and errno != EWOULDBLOCK) LOG_ERROR("Accept error, errno: {}", errno);
+                break;
+            }
+            if(HttpConn::userCount.load() >= maxConn) {
+                const char* info = "Server busy!";
+                send(fd, info, strlen(info), MSG_NOSIGNAL);
+                close(fd);
+                LOG_WARN("Clients is full!");
+                continue;
+            }
+            HttpConn::userCount.fetch_add(1);
+            EventLoop* loop = LoopForFd_(fd);
+            loop->RunInLoop([loop, fd, addr]() {
+                if(!loop->Register(fd)) {
+                    close(fd);
+                    HttpConn::userCount.fetch_sub(1);
+                    return;
+                }
+                Spawn(HttpConn::Serve(*loop, fd, addr));
+            });
+        }
+    }
+}
+
+void WebServer::Start() {
+    if(!InitSocket_()) {
+        LOG_ERROR("========== Server init error! ==========");
+        return;
+    }
+    Config& config = Config::getInstance();
+    int threadNum = std::max(1, config.c_thread_cnt);
+    reactorCpus_ = ParseCpuList(config.c_reactor_cpus);
+    // 每个核心只对应一个 Reactor 时，才能按收包 CPU 唯一确定连接归属
+    if(config.c_incoming_cpu and !reactorCpus_.empty() and static_cast<int>(reactorCpus_.size()) >= threadNum) {
+        for(int i = 0; i < threadNum; i++) cpuToLoop_[reactorCpus_[i]] = i;
+    }
+    for(int i = 0; i < threadNum; i++) {
+        subLoops_.emplace_back(std::make_unique<EventLoop>(config.c_trigMode != 1));
+    }
+    for(int i = 0; i < threadNum; i++) {
+        threads_.emplace_back(&WebServer::RunReactor_, this, static_cast<size_t>(i));
+    }
+    LOG_INFO("========== Server start, {} reactors ==========", threadNum);
+    Spawn(AcceptLoop_());
+    if(SessionStore::getInstance().Enabled()) ArmSessionSweep_(mainLoop_);
+    mainLoop_.Loop();
+
+    for(auto& loop : subLoops_) loop->Quit();
+    for(auto& t : threads_) {
+        if(t.joinable()) t.join();
+    }
+    LOG_INFO("========== Server stop ==========");
+}
+
+void WebServer::Stop() {
+    if(isClose_.exchange(true)) return;
+    mainLoop_.Quit();
+}
@@ -0,0 +1,54 @@
+#ifndef WEBSERVER_H
+#define WEBSERVER_H
+
+#include <vector>
+#include <thread>
+#include <memory>
+#include <atomic>
+#include <unordered_map>
+#include <netinet/in.h>
+
+#include "eventloop.h"
+#include "coroutine.h"
+
+/*
+    主从 Reactor：
+    - 主 Reactor（调用 Start 的线程）只负责 accept；
+    - thread_num 个从 Reactor 各自运行一个 EventLoop，新连接按轮询分配，
+      连接的整个生命周期都在所属从 Reactor 内以协程形式处理。
+*/
+class WebServer {
+public:
+    WebServer();
+    ~WebServer();
+
+    // 初始化监听 socket 与从 Reactor 线程，然后在当前线程运行主 Reactor，直到 Stop
+    void Start();
+    // 可在任意线程调用
+    void Stop();
+
+private:
+    bool InitSocket_();
+    Task<void> AcceptLoop_();
+    EventLoop* NextLoop_();
+    EventLoop* LoopForFd_(int fd);
+    void RunReactor_(size_t idx);
+    // 定时把本 Reactor 未写满的访问日志批次交给写线程
+    static void ArmAccessLogFlush_(EventLoop& loop);
+    static void ArmSessionSweep_(EventLoop& loop);
+
+    int port_;
+    bool openLinger_;
+    int listenFd_;
+    std::atomic<bool> isClose_{false};
+
+    EventLoop mainLoop_;
+    std::vector<std::unique_ptr<EventLoop>> subLoops_;
+    std::vector<std::thread> threads_;
+    size_t next_ = 0;
+
+    std::vector<int> reactorCpus_;                // 第 i 个从 Reactor 绑定的核心，为空则不绑核
+    std::unordered_map<int, size_t> cpuToLoop_;   // 核心 → 绑定在该核心上的从 Reactor 下标
+};
+
+#endif /* WEBSERVER_H */
@@ -0,0 +1,79 @@
+#include "clock.h"
+
+#include <ctime>
+#include <cstring>
+
+namespace {
+
+// 本线程缓存的本地时间前缀 "YYYY-MM-DD HH:MM:SS"
+struct LocalCache {
+    time_t sec = -1;
+    char prefix[20];
+};
+
+// 本线程缓存的 HTTP 日期
+struct HttpCache {
+    time_t sec = -1;
+    char date[WallClock::HTTP_DATE_LEN + 1];
+};
+
+thread_local LocalCache localCache;
+thread_local HttpCache httpCache;
+
+} // namespace
+
+size_t WallClock::Timestamp(char* out) {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    if(ts.tv_sec != localCache.sec) {
+        std::tm tm;
+        localtime_r(&ts.tv_sec, &tm);
+        std::strftime(localCache.prefix, sizeof(localCache.prefix), "%Y-%m-%d %H:%M:%S", &tm);
+        localCache.sec = ts.tv_sec;
+    }
+    std::memcpy(out, localCache.prefix, 19);
+    int millis = static_cast<int>(ts.tv_nsec / 1000000);
+    out[19] = '.';
+    out[20] = static_cast<char>('0' + millis / 100);
+    out[21] = static_cast<char>('0' + millis / 10 % 10);
+    out[22] = static_cast<char>('0' + millis % 10);
+    return TIMESTAMP_LEN;
+}
+
+std::string_view WallClock::HttpDate() {
+    // 秒级精度即可，用粗粒度时钟进一步降低开销
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    if(ts.tv_sec != httpCache.sec) {
+        // RFC 7231 要求固定使用英文星期与月份，不能依赖 strftime 的 locale
+        static const char* DAYS[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+        static const char* MONTHS[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                       "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+        std::tm tm;
+        gmtime_r(&ts.tv_sec, &tm);
+        // 逐字段按固定宽度写入，长度恒为 HTTP_DATE_LEN（年份取 4 位）
+        char* p = httpCache.date;
+        auto put = [&p](const char* s, size_t n) { std::memcpy(p, s, n); p += n; };
+        auto putNum = [&p](int v, int width) {
+            for(int i = width - 1; i >= 0; i--, v /= 10) p[i] = static_cast<char>('0' + v % 10);
+            p += width;
+        };
+        put(DAYS[tm.tm_wday], 3);
+        put(", ", 2);
+        putNum(tm.tm_mday, 2);
+        put(" ", 1);
+        put(MONTHS[tm.tm_mon], 3);
+        put(" ", 1);
+        putNum(tm.tm_year + 1900, 4);
+        put(" ", 1);
+        putNum(tm.tm_hour, 2);
+        put(":", 1);
+        putNum(tm.tm_min, 2);
+        put(":", 1);
+        putNum(tm.tm_sec, 2);
+        put(" GMT", 4);
+        *p = '\0';
+        httpCache.sec = ts.tv_sec;
+    }
+    return std::string_view(httpCache.date, HTTP_DATE_LEN);
+}
@@ -0,0 +1,26 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <cstddef>
+#include <string_view>
+
+/*
+    WallClock 是日志与 HTTP 共用的墙上时间格式化服务。
+    - 每个线程缓存当前这一秒的格式化结果，秒数变化时才调用 localtime_r / gmtime_r 重新格式化；
+    - 同一秒内只需一次 clock_gettime（vDSO，不陷入内核）和几次 memcpy，日志时间戳的毫秒部分直接拼接；
+    - 线程各自缓存，没有共享状态，不需要加锁或 RCU。
+*/
+class WallClock {
+public:
+    // 日志时间戳 "YYYY-MM-DD HH:MM:SS.mmm"（本地时间）的长度
+    static constexpr size_t TIMESTAMP_LEN = 23;
+    // HTTP 日期 "Sun, 06 Nov 1994 08:49:37 GMT"（RFC 7231 IMF-fixdate）的长度
+    static constexpr size_t HTTP_DATE_LEN = 29;
+
+    // 向 out 写入 TIMESTAMP_LEN 个字符（不含 '\0'），返回写入的长度
+    static size_t Timestamp(char* out);
+    // 当前 HTTP 日期，返回的视图指向本线程的缓存，在本线程下一次调用前有效
+    static std::string_view HttpDate();
+};
+
+#endif /* CLOCK_H */
@@ -0,0 +1,87 @@
+#include "heaptimer.h"
+
+void HeapTimer::swapNode_(size_t i, size_t j) {
+    assert(i < heap_.size() and j < heap_.size());
+    std::swap(heap_[i], heap_[j]);
+    ref_[heap_[i].id] = i;
+    ref_[heap_[j].id] = j;
+}
+
+void HeapTimer::siftup_(size_t i) {
+    while(i > 0) {
+        size_t parent = (i - 1) / 2;
+        if(heap_[parent].expires <= heap_[i].expires) break;
+        swapNode_(i, parent);
+        i = parent;
+    }
+}
+
+// 下沉节点，返回节点是否发生了移动
+bool HeapTimer::siftdown_(size_t i, size_t n) {
+    size_t idx = i;
+    size_t child = idx * 2 + 1;
+    while(child < n) {
+        if(child + 1 < n and heap_[child + 1].expires < heap_[child].expires) child++;
+        if(heap_[idx].expires <= heap_[child].expires) break;
+        swapNode_(idx, child);
+        idx = child;
+        child = idx * 2 + 1;
+    }
+    return idx > i;
+}
+
+uint64_t HeapTimer::add(int timeoutMs, TimeoutCallBack cb) {
+    uint64_t id = nextId_++;
+    size_t i = heap_.size();
+    ref_[id] = i;
+    heap_.push_back({id, Clock::now() + std::chrono::milliseconds(timeoutMs), std::move(cb)});
+    siftup_(i);
+    return id;
+}
+
+void HeapTimer::adjust(uint64_t id, int timeoutMs) {
+    auto it = ref_.find(id);
+    if(it == ref_.end()) return;
+    size_t i = it->second;
+    heap_[i].expires = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    if(!siftdown_(i, heap_.size())) siftup_(i);
+}
+
+void HeapTimer::cancel(uint64_t id) {
+    auto it = ref_.find(id);
+    if(it == ref_.end()) return;
+    del_(it->second);
+}
+
+// 删除指定位置的节点：与队尾交换后调整堆，再删除队尾
+void HeapTimer::del_(size_t i) {
+    assert(i < heap_.size());
+    size_t n = heap_.size() - 1;
+    if(i < n) {
+        swapNode_(i, n);
+        if(!siftdown_(i, n)) siftup_(i);
+    }
+    ref_.erase(heap_.back().id);
+    heap_.pop_back();
+}
+
+void HeapTimer::tick() {
+    auto now = Clock::now();
+    while(!heap_.empty()) {
+        TimerNode& node = heap_.front();
+        if(node.expires > now) break;
+        // 先出堆再执行回调：回调中可能再次 add/cancel 定时器
+        TimeoutCallBack cb = std::move(node.cb);
+        del_(0);
+        if(cb) cb();
+    }
+}
+
+int HeapTimer::GetNextTick() {
+    tick();
+    if(heap_.empty()) return -1;
+    // 向上取整，避免剩余不足 1ms 时 epoll_wait(0) 空转
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(
+        heap_.front().expires - Clock::now()).count();
+    return ms < 0 ? 0 : static_cast<int>(ms);
+}
@@ -0,0 +1,57 @@
+#ifndef HEAPTIMER_H
+#define HEAPTIMER_H
+
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include <cassert>
+
+/*
+    HeapTimer 基于小根堆实现定时器：堆顶为最早到期的定时器。
+    - add / adjust / cancel 时间复杂度 O(logN)，通过 id → 堆下标 的哈希表定位节点；
+    - tick 执行所有已到期的回调；
+    - GetNextTick 返回距离最近一个定时器到期的毫秒数，作为 epoll_wait 的超时时间。
+    非线程安全，只在所属 EventLoop 线程内使用。
+*/
+class HeapTimer {
+public:
+    using TimeoutCallBack = std::function<void()>;
+    using Clock = std::chrono::steady_clock;
+    using TimeStamp = Clock::time_point;
+
+    HeapTimer() { heap_.reserve(64); }
+    ~HeapTimer() = default;
+
+    // 添加定时器，返回定时器 id
+    uint64_t add(int timeoutMs, TimeoutCallBack cb);
+    // 重新设置定时器的超时时间
+    void adjust(uint64_t id, int timeoutMs);
+    // 取消定时器（不执行回调），id 不存在时忽略
+    void cancel(uint64_t id);
+    // 执行所有到期的定时器回调
+    void tick();
+    // 距离下一个定时器到期的毫秒数，没有定时器时返回 -1
+    int GetNextTick();
+
+    size_t size() const { return heap_.size(); }
+
+private:
+    struct TimerNode {
+        uint64_t id;
+        TimeStamp expires;
+        TimeoutCallBack cb;
+    };
+
+    void del_(size_t i);
+    void siftup_(size_t i);
+    bool siftdown_(size_t i, size_t n);
+    void swapNode_(size_t i, size_t j);
+
+    std::vector<TimerNode> heap_;
+    std::unordered_map<uint64_t, size_t> ref_; // id → 堆下标
+    uint64_t nextId_ = 1;
+};
+
+#endif /* HEAPTIMER_H */
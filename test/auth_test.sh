@@ -0,0 +1,22 @@
+#!/bin/bash
+
+# 鉴权模块（SHA-256、凭据缓存、会话、本地用户存储）测试程序
+
+g++ -std=c++23 -Wall -Wextra -O2 -pthread \
+    -I./code \
+    -o bin/test_auth \
+    code/auth/test_auth.cpp \
+    code/auth/sha256.cpp \
+    code/auth/credcache.cpp \
+    code/auth/session.cpp \
+    code/auth/memuserstore.cpp \
+    code/auth/sqliteuserstore.cpp \
+    code/config/config.cpp \
+    code/log/log.cpp \
+    code/log/mmapring.cpp \
+    code/timer/clock.cpp \
+    code/buffer/buffer.cpp \
+    -lpthread -lsqlite3 -lz
+
+echo "编译完成！运行测试程序："
+echo "./bin/test_auth"
@@ -0,0 +1,23 @@
+#!/bin/bash
+
+# Reactor 与协程可等待操作测试程序
+
+g++ -std=c++23 -Wall -Wextra -O2 -pthread \
+    -I./code \
+    -o bin/test_eventloop \
+    code/server/test_eventloop.cpp \
+    code/server/epoller.cpp \
+    code/server/eventloop.cpp \
+    code/server/asyncio.cpp \
+    code/timer/heaptimer.cpp \
+    code/pool/threadpool.cpp \
+    code/pool/lanescheduler.cpp \
+    code/config/config.cpp \
+    code/log/log.cpp \
+    code/log/mmapring.cpp \
+    code/timer/clock.cpp \
+    code/buffer/buffer.cpp \
+    -lpthread -lz
+
+echo "编译完成！运行测试程序："
+echo "./bin/test_eventloop"
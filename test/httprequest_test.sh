@@ -7,11 +7,19 @@ g++ -std=c++23 -Wall -Wextra -O2 -pthread \
     -o bin/test_httprequest \
     code/http/test_httprequest.cpp \
     code/pool/sqlconnpool.cpp \
+    code/pool/regbatcher.cpp \
+    code/auth/mysqluserstore.cpp \
+    code/pool/sqlstmt.cpp \
     code/config/config.cpp \
     code/log/log.cpp \
+    code/log/mmapring.cpp \
+    code/timer/clock.cpp \
     code/http/httprequest.cpp \
+    code/auth/sha256.cpp \
+    code/auth/credcache.cpp \
+    code/auth/session.cpp \
     code/buffer/buffer.cpp \
-    -lmysqlclient -lpthread 
+    -lmysqlclient -lpthread -lz
 
 echo "编译完成！运行测试程序："
 echo "./bin/test_httprequest"
@@ -7,11 +7,20 @@ g++ -std=c++23 -Wall -Wextra -O2 -pthread \
     -o bin/test_httpresponse \
     code/http/test_httpresponse.cpp \
     code/pool/sqlconnpool.cpp \
+    code/pool/regbatcher.cpp \
+    code/auth/mysqluserstore.cpp \
+    code/pool/sqlstmt.cpp \
     code/config/config.cpp \
     code/log/log.cpp \
+    code/log/mmapring.cpp \
+    code/timer/clock.cpp \
     code/http/httprequest.cpp \
+    code/auth/sha256.cpp \
+    code/auth/credcache.cpp \
+    code/auth/session.cpp \
+    code/http/httpresponse.cpp \
     code/buffer/buffer.cpp \
-    -lmysqlclient -lpthread 
+    -lmysqlclient -lpthread -lz
 
 echo "编译完成！运行测试程序："
 echo "./bin/test_httpresponse"
@@ -0,0 +1,19 @@
+#!/bin/bash
+
+# 异步日志传输队列测试程序（含 BlockDeque 与 MpscRing 吞吐对比）
+
+g++ -std=c++23 -Wall -Wextra -O2 -pthread \
+    -I./code \
+    -o bin/test_log \
+    code/log/test_log.cpp \
+    code/config/config.cpp \
+    code/log/log.cpp \
+    code/log/mmapring.cpp \
+    code/log/accesslog.cpp \
+    code/timer/clock.cpp \
+    code/log/binlog.cpp \
+    code/buffer/buffer.cpp \
+    -lpthread -lz
+
+echo "编译完成！运行测试程序："
+echo "./bin/test_log"
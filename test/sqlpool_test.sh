@@ -7,10 +7,25 @@ g++ -std=c++23 -Wall -Wextra -O2 -pthread \
     -o bin/test_sqlpool \
     code/pool/test_sqlpool.cpp \
     code/pool/sqlconnpool.cpp \
+    code/pool/regbatcher.cpp \
+    code/pool/sqlstmt.cpp \
+    code/pool/fakemysql.cpp \
+    code/auth/mysqluserstore.cpp \
+    code/server/asyncsql.cpp \
+    code/server/asyncio.cpp \
+    code/server/eventloop.cpp \
+    code/server/epoller.cpp \
+    code/timer/heaptimer.cpp \
+    code/pool/threadpool.cpp \
+    code/pool/lanescheduler.cpp \
     code/config/config.cpp \
     code/log/log.cpp \
+    code/log/mmapring.cpp \
+    code/timer/clock.cpp \
     code/buffer/buffer.cpp \
-    -lmysqlclient
+    -lmysqlclient -lz
 
 echo "编译完成！运行测试程序："
-echo "./bin/test_sqlpool"
+echo "./bin/test_sqlpool              # 阻塞连接，多线程测试"
+echo "./bin/test_sqlpool --nonblocking # 非阻塞连接，单 Reactor 协程测试（需 libmysqlclient 8.0.16+）"
+echo "./bin/test_sqlpool --fake        # 使用进程内的 MySQL 替身，不需要数据库服务（可与 --nonblocking 同用）"
@@ -0,0 +1,19 @@
+#!/bin/bash
+
+# 工作窃取线程池与调度通道测试程序
+
+g++ -std=c++23 -Wall -Wextra -O2 -pthread \
+    -I./code \
+    -o bin/test_threadpool \
+    code/pool/test_threadpool.cpp \
+    code/pool/threadpool.cpp \
+    code/pool/lanescheduler.cpp \
+    code/config/config.cpp \
+    code/log/log.cpp \
+    code/log/mmapring.cpp \
+    code/timer/clock.cpp \
+    code/buffer/buffer.cpp \
+    -lpthread -lz
+
+echo "编译完成！运行测试程序："
+echo "./bin/test_threadpool"